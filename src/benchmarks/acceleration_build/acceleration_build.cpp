@@ -0,0 +1,229 @@
+#include <recore/core/application.h>
+#include <recore/core/thread_pool.h>
+
+#include <recore/scene/scene.h>
+#include <recore/vulkan/api/acceleration.h>
+
+#include <argparse/argparse.hpp>
+
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <limits>
+
+namespace recore {
+
+using Clock = std::chrono::high_resolution_clock;
+
+struct BenchmarkResult {
+  double minTime = std::numeric_limits<double>::max();
+  double avgTime = 0.0;
+};
+
+static void printResult(const std::string& name,
+                        const BenchmarkResult& result,
+                        uint64_t triangleCount) {
+  std::cout << std::format("{:<24} min {:8.2f} ms, avg {:8.2f} ms, {:8.2f} "
+                           "MTris/s",
+                           name,
+                           result.minTime,
+                           result.avgTime,
+                           triangleCount / (result.minTime * 1e3))
+            << std::endl;
+}
+
+template <typename BuildFunction>
+static BenchmarkResult measure(uint32_t iterations, BuildFunction&& build) {
+  BenchmarkResult result;
+  for (uint32_t i = 0; i < iterations; i++) {
+    auto time = build();
+    result.minTime = std::min(result.minTime, time);
+    result.avgTime += time / iterations;
+  }
+  return result;
+}
+
+static double buildOnDevice(const vulkan::Device& device,
+                            const scene::Scene& scene,
+                            const vulkan::Buffer& vertices,
+                            const vulkan::Buffer& indices,
+                            const vulkan::Buffer& transform) {
+  std::vector<uPtr<vulkan::BLAS>> blases;
+  for (const auto& mesh : scene.getMeshes()) {
+    blases.push_back(makeUnique<vulkan::BLAS>({
+        .device = device,
+        .mesh =
+            {
+                .vertices = vertices,
+                .indices = indices,
+                .transforms = transform,
+                .firstIndex = mesh.firstIndex,
+                .indexCount = mesh.indexCount,
+                .vertexSize = sizeof(Vertex),
+            },
+    }));
+  }
+
+  auto start = Clock::now();
+  device.getImmediateContext().submitAndWait([&](const auto& commandBuffer) {
+    for (auto& blas : blases) {
+      blas->build(commandBuffer);
+    }
+  });
+  auto end = Clock::now();
+
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+static double buildOnHost(const vulkan::Device& device,
+                          const scene::Scene& scene,
+                          const VkTransformMatrixKHR& transform,
+                          core::ThreadPool& threadPool) {
+  std::vector<uPtr<vulkan::BLAS>> blases;
+  std::vector<vulkan::AccelerationStructure*> accelerationStructures;
+  for (const auto& mesh : scene.getMeshes()) {
+    blases.push_back(makeUnique<vulkan::BLAS>(vulkan::BLAS::HostDesc{
+        .device = device,
+        .mesh =
+            {
+                .vertices = scene.getVertices().data(),
+                .indices = scene.getIndices().data(),
+                .transform = &transform,
+                .vertexCount =
+                    static_cast<uint32_t>(scene.getVertices().size()),
+                .firstIndex = mesh.firstIndex,
+                .indexCount = mesh.indexCount,
+                .vertexSize = sizeof(Vertex),
+            },
+    }));
+    accelerationStructures.push_back(&*blases.back());
+  }
+
+  auto start = Clock::now();
+  vulkan::AccelerationStructure::buildOnHost(accelerationStructures,
+                                             threadPool);
+  auto end = Clock::now();
+
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+}  // namespace recore
+
+void runAccelerationBuildBenchmark(const std::string& scenePath,
+                                   uint32_t iterations,
+                                   uint32_t threadCount) {
+  using namespace recore;
+  using namespace recore::core;
+
+  ApplicationSettings appSettings = {
+      .vulkan = {
+          .instance = {.enableValidation = false},
+          .device =
+              {
+                  .deviceExtensions =
+                      {
+                          VK_KHR_ACCELERATION_STRUCTURE_EXTENSION_NAME,
+                          VK_KHR_DEFERRED_HOST_OPERATIONS_EXTENSION_NAME,
+                      },
+                  .features =
+                      {
+                          .features12 =
+                              {
+                                  .bufferDeviceAddress = VK_TRUE,
+                              },
+                          .featureMap =
+                              []() {
+                                vulkan::FeatureMap featureMap;
+                                featureMap.addFeatures<
+                                    VkPhysicalDeviceAccelerationStructureFeaturesKHR,
+                                    VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ACCELERATION_STRUCTURE_FEATURES_KHR>(
+                                    {
+                                        &VkPhysicalDeviceAccelerationStructureFeaturesKHR::
+                                            accelerationStructure,
+                                        &VkPhysicalDeviceAccelerationStructureFeaturesKHR::
+                                            accelerationStructureHostCommands,
+                                    });
+                                return featureMap;
+                              }(),
+                      },
+              },
+      }};
+
+  auto app = makeUnique<HeadlessApplication>(appSettings);
+  const auto& device = app->getDevice();
+
+  scene::Scene scene;
+  scene.loadGLTF({.path = scenePath});
+
+  uint64_t triangleCount = scene.getIndices().size() / 3;
+  std::cout << std::format("Scene: {} ({} meshes, {} triangles)",
+                           scenePath,
+                           scene.getMeshes().size(),
+                           triangleCount)
+            << std::endl;
+
+  VkTransformMatrixKHR identity = {
+      1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f};
+
+  auto genBuffer = [&]<typename T>(const std::vector<T>& data) {
+    auto buffer = makeUnique<vulkan::Buffer>({
+        .device = device,
+        .size = sizeof(T) * data.size(),
+        .usage =
+            VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR |
+            VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+        .memoryUsage = VMA_MEMORY_USAGE_CPU_TO_GPU,
+    });
+    buffer->upload(data.data());
+    return buffer;
+  };
+
+  auto vertices = genBuffer(scene.getVertices());
+  auto indices = genBuffer(scene.getIndices());
+  auto transform = genBuffer(std::vector{identity});
+
+  auto deviceResult = measure(iterations, [&]() {
+    return buildOnDevice(device, scene, *vertices, *indices, *transform);
+  });
+  printResult("Device", deviceResult, triangleCount);
+
+  // Single worker first to see how well the deferred operations scale
+  for (auto threads : {1u, threadCount}) {
+    ThreadPool threadPool{threads};
+    auto hostResult = measure(iterations, [&]() {
+      return buildOnHost(device, scene, identity, threadPool);
+    });
+    printResult(std::format("Host ({} threads)", threads),
+                hostResult,
+                triangleCount);
+  }
+
+  app->terminate();
+}
+
+int main(int argc, char* argv[]) {
+  argparse::ArgumentParser program("acceleration_build");
+  program.add_description(
+      "Compares host and device BLAS build throughput for a glTF scene.");
+  program.add_argument("scene").default_value(
+      std::string{"sponza/Sponza.gltf"});
+  program.add_argument("-i", "--iterations")
+      .default_value(10u)
+      .scan<'u', uint32_t>();
+  program.add_argument("-t", "--threads")
+      .default_value(std::max(std::thread::hardware_concurrency(), 1u))
+      .scan<'u', uint32_t>();
+
+  try {
+    program.parse_args(argc, argv);
+
+    runAccelerationBuildBenchmark(program.get<std::string>("scene"),
+                                  program.get<uint32_t>("--iterations"),
+                                  program.get<uint32_t>("--threads"));
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
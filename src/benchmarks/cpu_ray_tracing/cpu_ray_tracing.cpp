@@ -0,0 +1,183 @@
+#include <recore/core/thread_pool.h>
+
+#include <recore/scene/cpu_scene.h>
+#include <recore/scene/scene.h>
+
+#include <argparse/argparse.hpp>
+
+#include <chrono>
+#include <format>
+#include <future>
+#include <iostream>
+#include <random>
+
+namespace recore {
+
+using Clock = std::chrono::high_resolution_clock;
+
+template <typename Function>
+static double measure(Function&& function) {
+  auto start = Clock::now();
+  function();
+  auto end = Clock::now();
+  return std::chrono::duration<double>(end - start).count();
+}
+
+static void printResult(const std::string& name,
+                        size_t rayCount,
+                        size_t hitCount,
+                        double seconds) {
+  std::cout << std::format("{:<10} {:>10} rays, {:6.2f}% hit, {:8.2f} ms, "
+                           "{:8.2f} MRays/s",
+                           name,
+                           rayCount,
+                           100.0 * hitCount / rayCount,
+                           seconds * 1e3,
+                           rayCount / seconds * 1e-6)
+            << std::endl;
+}
+
+static std::vector<scene::CPUScene::Ray> generatePrimaryRays(
+    const scene::Camera& camera,
+    uint32_t width,
+    uint32_t height) {
+  auto invViewProjection = glm::inverse(camera.getViewProjection());
+
+  std::vector<scene::CPUScene::Ray> rays;
+  rays.reserve(static_cast<size_t>(width) * height);
+  for (uint32_t y = 0; y < height; y++) {
+    for (uint32_t x = 0; x < width; x++) {
+      glm::vec2 ndc = 2.f * glm::vec2((x + 0.5f) / width, (y + 0.5f) / height) -
+                      1.f;
+      auto target = invViewProjection * glm::vec4(ndc, 1.f, 1.f);
+      auto direction =
+          glm::normalize(glm::vec3(target) / target.w - camera.getPosition());
+      rays.push_back({.origin = camera.getPosition(), .direction = direction});
+    }
+  }
+  return rays;
+}
+
+}  // namespace recore
+
+void runCPURayTracingBenchmark(const std::string& scenePath,
+                               uint32_t width,
+                               uint32_t height,
+                               uint32_t threadCount) {
+  using namespace recore;
+
+  core::ThreadPool threadPool{threadCount};
+
+  scene::Scene scene;
+  scene.loadGLTF({.path = scenePath});
+
+  // Look at the scene from its center
+  auto aabb = scene.getAABB();
+  scene.setCamera(
+      scene::Camera{{.position = 0.5f * (aabb.min + aabb.max), .fov = 60}});
+  auto& camera = scene.getCamera();
+  camera.setAspect(width, height);
+
+  std::cout << std::format("Scene: {} ({} triangles, {} instances), {} threads",
+                           scenePath,
+                           scene.getIndices().size() / 3,
+                           scene.getGeometryInstances().size(),
+                           threadPool.getThreadCount())
+            << std::endl;
+
+  scene::CPUScene cpuScene{scene};
+  auto buildTime = measure([&]() { cpuScene.build(&threadPool); });
+  std::cout << std::format("BVH build: {:.2f} ms", buildTime * 1e3)
+            << std::endl;
+
+  auto countHits = [](const auto& hits) {
+    return std::count_if(hits.begin(), hits.end(), [](const auto& hit) {
+      return hit.has_value();
+    });
+  };
+
+  // Coherent primary rays
+  auto primaryRays = generatePrimaryRays(camera, width, height);
+  std::vector<std::optional<scene::CPUScene::Hit>> primaryHits;
+  auto primaryTime = measure(
+      [&]() { primaryHits = cpuScene.traceRays(primaryRays, threadPool); });
+  printResult("Primary", primaryRays.size(), countHits(primaryHits),
+              primaryTime);
+
+  // Incoherent rays from the primary hits in random directions
+  std::mt19937 rng{42};
+  std::normal_distribution<float> normal;
+
+  std::vector<scene::CPUScene::Ray> diffuseRays;
+  std::vector<scene::CPUScene::Ray> shadowRays;
+  auto lightDirection = scene.getLights().empty()
+                            ? glm::vec3{0.f, 1.f, 0.f}
+                            : -glm::normalize(scene.getLights()[0].direction);
+  for (size_t i = 0; i < primaryRays.size(); i++) {
+    if (!primaryHits[i]) {
+      continue;
+    }
+    const auto& ray = primaryRays[i];
+    auto position = ray.origin + primaryHits[i]->t * ray.direction;
+
+    auto direction =
+        glm::normalize(glm::vec3{normal(rng), normal(rng), normal(rng)});
+    diffuseRays.push_back(
+        {.origin = position, .direction = direction, .tMin = 1e-3f});
+    shadowRays.push_back(
+        {.origin = position, .direction = lightDirection, .tMin = 1e-3f});
+  }
+
+  std::vector<std::optional<scene::CPUScene::Hit>> diffuseHits;
+  auto diffuseTime = measure(
+      [&]() { diffuseHits = cpuScene.traceRays(diffuseRays, threadPool); });
+  printResult("Diffuse", diffuseRays.size(), countHits(diffuseHits),
+              diffuseTime);
+
+  // Any hit queries
+  std::vector<uint8_t> occluded(shadowRays.size());
+  auto shadowTime = measure([&]() {
+    constexpr size_t kChunkSize = 1024;
+    std::vector<std::future<void>> futures;
+    for (size_t begin = 0; begin < shadowRays.size(); begin += kChunkSize) {
+      auto end = std::min(begin + kChunkSize, shadowRays.size());
+      futures.push_back(threadPool.submit([&, begin, end]() {
+        for (size_t i = begin; i < end; i++) {
+          occluded[i] = cpuScene.traceShadowRay(shadowRays[i]);
+        }
+      }));
+    }
+    for (auto& future : futures) {
+      future.get();
+    }
+  });
+  printResult("Shadow", shadowRays.size(),
+              std::count(occluded.begin(), occluded.end(), 1), shadowTime);
+}
+
+int main(int argc, char* argv[]) {
+  argparse::ArgumentParser program("cpu_ray_tracing");
+  program.add_description(
+      "Measures build time and ray throughput of the CPU ray tracing backend.");
+  program.add_argument("scene").default_value(
+      std::string{"sponza/Sponza.gltf"});
+  program.add_argument("--width").default_value(1280u).scan<'u', uint32_t>();
+  program.add_argument("--height").default_value(720u).scan<'u', uint32_t>();
+  program.add_argument("-t", "--threads")
+      .default_value(std::max(std::thread::hardware_concurrency(), 1u))
+      .scan<'u', uint32_t>();
+
+  try {
+    program.parse_args(argc, argv);
+
+    runCPURayTracingBenchmark(program.get<std::string>("scene"),
+                              program.get<uint32_t>("--width"),
+                              program.get<uint32_t>("--height"),
+                              program.get<uint32_t>("--threads"));
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
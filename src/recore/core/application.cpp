@@ -4,6 +4,45 @@
 
 namespace recore::core {
 
+// Pipeline statistics are a debugging aid, only enable them on request and
+// where available
+static void enablePipelineStatistics(const vulkan::PhysicalDevice& gpu,
+                                     std::vector<std::string>& extensions,
+                                     vulkan::Device::Features& features) {
+  if (!gpu.isExtensionSupported(
+          VK_KHR_PIPELINE_EXECUTABLE_PROPERTIES_EXTENSION_NAME)) {
+    return;
+  }
+  auto supported = gpu.getFeatures<
+      VkPhysicalDevicePipelineExecutablePropertiesFeaturesKHR,
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PIPELINE_EXECUTABLE_PROPERTIES_FEATURES_KHR>();
+  if (supported.pipelineExecutableInfo == VK_FALSE) {
+    return;
+  }
+  extensions.emplace_back(VK_KHR_PIPELINE_EXECUTABLE_PROPERTIES_EXTENSION_NAME);
+  features.featureMap.addFeature<
+      VkPhysicalDevicePipelineExecutablePropertiesFeaturesKHR,
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PIPELINE_EXECUTABLE_PROPERTIES_FEATURES_KHR>(
+      &VkPhysicalDevicePipelineExecutablePropertiesFeaturesKHR::
+          pipelineExecutableInfo);
+}
+
+// Reports when frames reached the display, for the latency of the context
+static void enableDisplayTiming(const vulkan::PhysicalDevice& gpu,
+                                std::vector<std::string>& extensions) {
+  if (gpu.isExtensionSupported(VK_GOOGLE_DISPLAY_TIMING_EXTENSION_NAME)) {
+    extensions.emplace_back(VK_GOOGLE_DISPLAY_TIMING_EXTENSION_NAME);
+  }
+}
+
+// Puts the GPU scopes on the timeline of the CPU scopes
+static void enableCalibratedTimestamps(const vulkan::PhysicalDevice& gpu,
+                                       std::vector<std::string>& extensions) {
+  if (gpu.isExtensionSupported(VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME)) {
+    extensions.emplace_back(VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME);
+  }
+}
+
 HeadlessApplication::HeadlessApplication(const ApplicationSettings& settings)
     : Application{settings} {
   std::vector<std::string> instanceExtensions = {
@@ -21,11 +60,17 @@ HeadlessApplication::HeadlessApplication(const ApplicationSettings& settings)
   const auto& gpus = mInstance->getPhysicalDevices();
 
   auto deviceExtensions = settings.vulkan.device.deviceExtensions;
+  auto deviceFeatures = settings.vulkan.device.features;
+  enableCalibratedTimestamps(gpus[0], deviceExtensions);
+  if (settings.vulkan.device.pipelineStatistics) {
+    enablePipelineStatistics(gpus[0], deviceExtensions, deviceFeatures);
+  }
   mDevice = makeUnique<vulkan::Device>({
       .instance = *mInstance,
       .physicalDevice = gpus[0],
       .extensions = deviceExtensions,
-      .features = settings.vulkan.device.features,
+      .features = deviceFeatures,
+      .pipelineCachePath = settings.vulkan.device.pipelineCachePath,
   });
 
   mRenderContext = makeUnique<vulkan::HeadlessContext>({
@@ -33,10 +78,13 @@ HeadlessApplication::HeadlessApplication(const ApplicationSettings& settings)
       .width = mResolution.width,
       .height = mResolution.height,
       .numFramesInFlight = settings.vulkan.numFramesInFlight,
+      .threadPool = mRecordingThreadPool.get(),
   });
 }
 
 void HeadlessApplication::update() {
+  RECORE_CPU_PROFILE_SCOPE("Application::update");
+
   // TODO: time for headless applications
   // mRenderer->update(0.5f);
   // mRenderer->update(0.25f);
@@ -47,15 +95,28 @@ void HeadlessApplication::update() {
 }
 
 void HeadlessApplication::render() {
+  RECORE_CPU_PROFILE_SCOPE("Application::render");
+
   auto& frame = mRenderContext->beginFrame();
 
-  mRenderContext->submit([&](const auto& commandBuffer) {
-    mRenderer->render(commandBuffer, frame);
-  });
+  mRenderer->render(
+      [&](auto&& recorder) { mRenderContext->submit(std::move(recorder)); },
+      frame);
+
+  if (mRenderer->hasAsyncCompute()) {
+    mRenderContext->submitAsyncCompute([&](const auto& commandBuffer) {
+      mRenderer->renderAsyncCompute(commandBuffer, frame);
+    });
+  }
 
   mRenderContext->endFrame(mRenderer->getResultImage());
 }
 
+void HeadlessApplication::terminate() {
+  Application::terminate();
+  exportProfile(mRenderContext->getGPUProfiler());
+}
+
 void HeadlessApplication::run(const ApplicationController& controller) {
   bool running = true;
 
@@ -95,12 +156,19 @@ GUIApplication::GUIApplication(const ApplicationSettings& settings)
 
   auto deviceExtensions = settings.vulkan.device.deviceExtensions;
   deviceExtensions.emplace_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+  enableDisplayTiming(gpus[0], deviceExtensions);
+  auto deviceFeatures = settings.vulkan.device.features;
+  enableCalibratedTimestamps(gpus[0], deviceExtensions);
+  if (settings.vulkan.device.pipelineStatistics) {
+    enablePipelineStatistics(gpus[0], deviceExtensions, deviceFeatures);
+  }
   mDevice = makeUnique<vulkan::Device>({
       .instance = *mInstance,
       .physicalDevice = gpus[0],
       .surface = mSurface->vkHandle(),
       .extensions = deviceExtensions,
-      .features = settings.vulkan.device.features,
+      .features = deviceFeatures,
+      .pipelineCachePath = settings.vulkan.device.pipelineCachePath,
   });
 
   mRenderContext = makeUnique<vulkan::RenderContext>({
@@ -108,6 +176,9 @@ GUIApplication::GUIApplication(const ApplicationSettings& settings)
       .surface = *mSurface,
       .width = mResolution.width,
       .height = mResolution.height,
+      .numFramesInFlight = settings.vulkan.numFramesInFlight,
+      .presentMode = settings.vulkan.presentMode,
+      .threadPool = mRecordingThreadPool.get(),
   });
 }
 
@@ -132,11 +203,21 @@ void GUIApplication::run() {
   terminate();
 }
 
+void GUIApplication::terminate() {
+  Application::terminate();
+  exportProfile(mRenderContext->getGPUProfiler());
+}
+
 void GUIApplication::update(float deltaTime) {
   if (mResolution.width == 0 || mResolution.height == 0) {
     return;
   }
 
+  // The input was just polled, everything from here on is latency
+  mRenderContext->markInput();
+
+  RECORE_CPU_PROFILE_SCOPE("Application::update");
+
   if (mGui != nullptr) {
     mGui->update();
   }
@@ -149,36 +230,47 @@ void GUIApplication::render() {
     return;
   }
 
+  RECORE_CPU_PROFILE_SCOPE("Application::render");
+
   auto& frame = mRenderContext->beginFrame();
 
-  mRenderContext->submit([&](const auto& commandBuffer) {
-    mRenderer->render(commandBuffer, frame);
+  // All resize events since the last frame are applied at once
+  if (mResizePending) {
+    mResizePending = false;
+    std::cout << "Resize: " << mResolution.width << "x" << mResolution.height
+              << std::endl;
+
+    mRenderContext->resize(mResolution.width, mResolution.height);
+    mRenderer->resize(mResolution.width, mResolution.height, frame);
 
     if (mGui != nullptr) {
-      mGui->render(commandBuffer, frame);
+      mGui->setFramebuffer(mRenderer->getResultImage(), &frame);
     }
-  });
-
-  mRenderContext->endFrame(mRenderer->getResultImage());
-}
-
-void GUIApplication::resize(uint32_t width, uint32_t height) {
-  std::cout << "Resize: " << width << "x" << height << std::endl;
-  mResolution = {width, height};
+  }
 
-  vulkan::checkResult(mDevice->waitIdle());
+  mRenderer->render(
+      [&](auto&& recorder) { mRenderContext->submit(std::move(recorder)); },
+      frame);
 
-  if (width == 0 || height == 0) {
-    return;
+  // Recorded in parallel with the renderer, drawn on top of its result
+  if (mGui != nullptr) {
+    mRenderContext->submit([&](const auto& commandBuffer) {
+      mGui->render(commandBuffer, frame);
+    });
   }
 
-  mRenderContext->resize(width, height);
+  if (mRenderer->hasAsyncCompute()) {
+    mRenderContext->submitAsyncCompute([&](const auto& commandBuffer) {
+      mRenderer->renderAsyncCompute(commandBuffer, frame);
+    });
+  }
 
-  mRenderer->resize(width, height);
+  mRenderContext->endFrame(mRenderer->getResultImage());
+}
 
-  if (mGui != nullptr) {
-    mGui->setFramebuffer(mRenderer->getResultImage());
-  }
+void GUIApplication::resize(uint32_t width, uint32_t height) {
+  mResolution = {width, height};
+  mResizePending = true;
 }
 
 }  // namespace recore::core
@@ -4,6 +4,8 @@
 #include <string>
 
 #include "base.h"
+#include "cpu_profiler.h"
+#include "thread_pool.h"
 #include "utils.h"
 #include "window.h"
 
@@ -32,16 +34,41 @@ struct ApplicationSettings {
     struct {
       std::vector<std::string> deviceExtensions;
       vulkan::Device::Features features;
+      std::filesystem::path pipelineCachePath = RECORE_PIPELINE_CACHE_PATH;
+      // Enables VK_KHR_pipeline_executable_properties where supported,
+      // pipelines capture statistics while vulkan::Device::
+      // setCaptureStatistics() is set
+      bool pipelineStatistics{false};
     } device;
 
     uint32_t numFramesInFlight = 2;
+    // Only for windows, see vulkan::RenderContext
+    VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR;
+    // Threads recording command buffers besides the main thread, 0 records
+    // everything serially
+    uint32_t numRecordingThreads = 2;
   } vulkan;
+
+  // GPU profile written on terminate, nothing if empty
+  struct {
+    std::filesystem::path tracePath;
+    std::filesystem::path csvPath;
+  } profiling;
 };
 
 class Application : public NoCopyMove {
  public:
   explicit Application(const ApplicationSettings& settings)
-      : mTitle{settings.title}, mResolution{settings.resolution} {}
+      : mTitle{settings.title},
+        mResolution{settings.resolution},
+        mTracePath{settings.profiling.tracePath},
+        mCSVPath{settings.profiling.csvPath} {
+    CPUProfiler::get().setThreadName("Main");
+    if (settings.vulkan.numRecordingThreads > 0) {
+      mRecordingThreadPool = makeUnique<ThreadPool>(
+          settings.vulkan.numRecordingThreads);
+    }
+  }
 
   virtual ~Application() = default;
 
@@ -57,12 +84,26 @@ class Application : public NoCopyMove {
   [[nodiscard]] const vulkan::Device& getDevice() const { return *mDevice; }
 
  protected:
+  void exportProfile(const vulkan::GPUProfiler& profiler) const {
+    if (!mTracePath.empty()) {
+      profiler.exportTrace(mTracePath);
+    }
+    if (!mCSVPath.empty()) {
+      profiler.exportCSV(mCSVPath);
+    }
+  }
+
   std::string mTitle;
 
   Resolution mResolution;
 
+  std::filesystem::path mTracePath;
+  std::filesystem::path mCSVPath;
+
   uPtr<vulkan::Instance> mInstance;
   uPtr<vulkan::Device> mDevice;
+
+  uPtr<ThreadPool> mRecordingThreadPool;
 };
 
 using ApplicationController = std::function<bool()>;
@@ -73,6 +114,8 @@ class HeadlessApplication : public Application {
 
   ~HeadlessApplication() override = default;
 
+  void terminate() override;
+
   void update();
 
   void render();
@@ -93,12 +136,15 @@ class GUIApplication : public Application {
 
   ~GUIApplication() override = default;
 
+  void terminate() override;
+
   void run();
 
   void update(float deltaTime);
 
   void render();
 
+  // Only records the new size, render() applies it at the next frame
   void resize(uint32_t width, uint32_t height);
 
   void setRenderer(Renderer* renderer) { mRenderer = renderer; }
@@ -118,6 +164,8 @@ class GUIApplication : public Application {
 
   Renderer* mRenderer{nullptr};
   GUI* mGui{nullptr};
+
+  bool mResizePending{false};
 };
 
 }  // namespace recore::core
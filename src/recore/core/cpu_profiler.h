@@ -0,0 +1,114 @@
+#pragma once
+
+#include "base.h"
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace recore::core {
+
+// Scopes of CPU work on all threads, exported with the GPU scopes of
+// vulkan::GPUProfiler on one timeline. Global, so that any code can profile
+// without access to the application. Header-only so it can be shared by
+// recore-vulkan and recore.
+class CPUProfiler : public NoCopyMove {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  // Nanoseconds of the steady clock
+  struct Event {
+    std::string name;
+    uint32_t thread;
+    int64_t begin;
+    int64_t end;
+  };
+
+  [[nodiscard]] static CPUProfiler& get() {
+    static CPUProfiler profiler;
+    return profiler;
+  }
+
+  [[nodiscard]] static int64_t toNanoseconds(Clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               time.time_since_epoch())
+        .count();
+  }
+
+  // Of the calling thread, threads without a name are numbered
+  void setThreadName(const std::string& name) {
+    std::scoped_lock lock{mMutex};
+    mThreadNames.insert_or_assign(getThreadIndex(), name);
+  }
+
+  void addEvent(const std::string& name,
+                Clock::time_point begin,
+                Clock::time_point end) {
+    std::scoped_lock lock{mMutex};
+    mEvents.push_back({
+        .name = name,
+        .thread = getThreadIndex(),
+        .begin = toNanoseconds(begin),
+        .end = toNanoseconds(end),
+    });
+    if (mEvents.size() > kMaxEvents) {
+      mEvents.pop_front();
+    }
+  }
+
+  // Copies, recording threads keep adding events
+  [[nodiscard]] std::vector<Event> getEvents() const {
+    std::scoped_lock lock{mMutex};
+    return {mEvents.begin(), mEvents.end()};
+  }
+
+  [[nodiscard]] std::unordered_map<uint32_t, std::string> getThreadNames()
+      const {
+    std::scoped_lock lock{mMutex};
+    auto names = mThreadNames;
+    for (uint32_t thread = 0; thread < mThreadCount; thread++) {
+      names.try_emplace(thread, "Thread " + std::to_string(thread));
+    }
+    return names;
+  }
+
+ private:
+  CPUProfiler() = default;
+
+  static constexpr size_t kMaxEvents = 1 << 16;
+
+  // Requires the lock
+  uint32_t getThreadIndex() {
+    thread_local uint32_t index = mThreadCount++;
+    return index;
+  }
+
+  std::deque<Event> mEvents;
+  std::unordered_map<uint32_t, std::string> mThreadNames;
+  uint32_t mThreadCount{0};
+  mutable std::mutex mMutex;
+};
+
+class ScopedCPUProfile : public NoCopyMove {
+ public:
+  explicit ScopedCPUProfile(std::string name)
+      : mName{std::move(name)}, mBegin{CPUProfiler::Clock::now()} {}
+
+  ~ScopedCPUProfile() {
+    CPUProfiler::get().addEvent(mName, mBegin, CPUProfiler::Clock::now());
+  }
+
+ private:
+  std::string mName;
+  CPUProfiler::Clock::time_point mBegin;
+};
+
+}  // namespace recore::core
+
+// NOLINTNEXTLINE(cppcoreguidelines-macro-usage)
+#define RECORE_CPU_PROFILE_SCOPE(NAME) \
+  recore::core::ScopedCPUProfile ___cpuProfileScope{NAME};
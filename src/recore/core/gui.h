@@ -15,7 +15,10 @@ class GUI : public NoCopyMove {
   virtual void render(const vulkan::CommandBuffer& commandBuffer,
                       vulkan::RenderFrame& frame) = 0;
 
-  virtual void setFramebuffer(const vulkan::Image& image) = 0;
+  // Replaced resources are retired into the frame, without one the device has
+  // to be idle
+  virtual void setFramebuffer(const vulkan::Image& image,
+                              vulkan::RenderFrame* frame) = 0;
 };
 
 }  // namespace recore::core
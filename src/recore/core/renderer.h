@@ -12,10 +12,23 @@ class Renderer : public NoCopyMove {
 
   virtual void update(float deltaTime) = 0;
 
-  virtual void render(const vulkan::CommandBuffer& commandBuffer,
+  // Submits the graphics work of the frame. Every recorder gets its own
+  // command buffer, they are recorded in parallel and run in submit order.
+  virtual void render(const vulkan::FrameSubmit& submit,
                       vulkan::RenderFrame& frame) = 0;
 
-  virtual void resize(uint32_t width, uint32_t height) = 0;
+  // Optional work for the async compute queue. It runs after the graphics
+  // work of its frame and overlaps with the start of the next frame.
+  [[nodiscard]] virtual bool hasAsyncCompute() const { return false; }
+
+  virtual void renderAsyncCompute(const vulkan::CommandBuffer& commandBuffer,
+                                  vulkan::RenderFrame& frame) {}
+
+  // Called at the start of a frame, before render(). Replaced resources can be
+  // retired into the frame instead of waiting for the device.
+  virtual void resize(uint32_t width,
+                      uint32_t height,
+                      vulkan::RenderFrame& frame) = 0;
 
   [[nodiscard]] virtual const vulkan::Image& getResultImage() const = 0;
 };
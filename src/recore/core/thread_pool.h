@@ -0,0 +1,87 @@
+#pragma once
+
+#include "base.h"
+#include "cpu_profiler.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace recore::core {
+
+// Header-only so it can be shared by recore-vulkan and recore
+class ThreadPool : public NoCopyMove {
+ public:
+  explicit ThreadPool(
+      uint32_t threadCount = std::thread::hardware_concurrency()) {
+    threadCount = std::max(threadCount, 1u);
+    mWorkers.reserve(threadCount);
+    for (uint32_t i = 0; i < threadCount; i++) {
+      mWorkers.emplace_back([this, i]() {
+        CPUProfiler::get().setThreadName("Worker " + std::to_string(i));
+        workerLoop();
+      });
+    }
+  }
+
+  ~ThreadPool() {
+    {
+      std::scoped_lock lock{mMutex};
+      mStop = true;
+    }
+    mCondition.notify_all();
+    for (auto& worker : mWorkers) {
+      worker.join();
+    }
+  }
+
+  template <typename F>
+  auto submit(F&& task) -> std::future<std::invoke_result_t<F>> {
+    using Result = std::invoke_result_t<F>;
+
+    auto packagedTask =
+        makeShared<std::packaged_task<Result()>>(std::forward<F>(task));
+    auto future = packagedTask->get_future();
+    {
+      std::scoped_lock lock{mMutex};
+      mTasks.emplace([packagedTask]() { (*packagedTask)(); });
+    }
+    mCondition.notify_one();
+    return future;
+  }
+
+  [[nodiscard]] uint32_t getThreadCount() const {
+    return static_cast<uint32_t>(mWorkers.size());
+  }
+
+ private:
+  void workerLoop() {
+    while (true) {
+      std::function<void()> task;
+      {
+        std::unique_lock lock{mMutex};
+        mCondition.wait(lock, [this]() { return mStop || !mTasks.empty(); });
+        if (mStop && mTasks.empty()) {
+          return;
+        }
+        task = std::move(mTasks.front());
+        mTasks.pop();
+      }
+      task();
+    }
+  }
+
+  std::vector<std::thread> mWorkers;
+  std::queue<std::function<void()>> mTasks;
+  std::mutex mMutex;
+  std::condition_variable mCondition;
+  bool mStop = false;
+};
+
+}  // namespace recore::core
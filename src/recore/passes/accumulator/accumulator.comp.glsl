@@ -2,16 +2,21 @@
 
 #include "accumulator.glslh"
 
+#include <recore/shaders/bindless.glsl>
 #include <recore/shaders/math.glsl>
 
-layout(local_size_x = 32, local_size_y = 32, local_size_z = 1) in;
+#include <recore/shaders/workgroup_size.glslh>
 
-layout(set = 0, binding = 0, rgba32f) uniform readonly image2D gInputImage;
-layout(set = 0, binding = 1, rgba32f) uniform image2D gOutputImage;
-layout(set = 0, binding = 2, rgba32f) uniform image2D gVarianceImage;
+layout(local_size_x = 32, local_size_y = 32, local_size_z = 1,
+       local_size_x_id = WORKGROUP_SIZE_X_ID,
+       local_size_y_id = WORKGROUP_SIZE_Y_ID) in;
 
 PUSH_CONSTANT(AccumulatorPush);
 
+#define gInputImage bindlessImage2D(p.inputImage)
+#define gOutputImage bindlessImage2D(p.outputImage)
+#define gVarianceImage bindlessImage2D(p.varianceImage)
+
 void main() {
   if (p.maxSamples > 0 && p.frameCount > p.maxSamples) {
     return;
@@ -9,68 +9,29 @@ constexpr auto kAccumulatorShader =
 
 AccumulatorPass::AccumulatorPass(const vulkan::Device& device,
                                  const scene::Scene& scene)
-    : Pass{device}, mScene{scene} {
-  mDescriptors.pool = makeUnique<vulkan::DescriptorPool>({
-      .device = mDevice,
-      .poolSizes =
-          {
-              {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 3},
-          },
-  });
-
-  mDescriptors.layout = makeUnique<vulkan::DescriptorSetLayout>({
-      .device = mDevice,
-      .bindings =
-          {
-              {
-                  {.binding = 0,
-                   .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
-                   .descriptorCount = 1,
-                   .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT},
-              },
-              {
-                  {.binding = 1,
-                   .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
-                   .descriptorCount = 1,
-                   .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT},
-              },
-              {
-                  {.binding = 2,
-                   .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
-                   .descriptorCount = 1,
-                   .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT},
-              },
-          },
-  });
+    : Pass{device}, mScene{scene} {}
 
-  mDescriptors.set = makeUnique<vulkan::DescriptorSet>({
-      .device = mDevice,
-      .pool = *mDescriptors.pool,
-      .layout = *mDescriptors.layout,
-  });
+void AccumulatorPass::registerShaders(vulkan::ShaderLibrary& shaderLibrary) {
+  requestShader(shaderLibrary, kAccumulatorShader);
 }
 
-void AccumulatorPass::reloadShaders(vulkan::ShaderLibrary& shaderLibrary) {
-  mPipelineLayout = makeUnique<vulkan::PipelineLayout>({
-      .device = mDevice,
-      .descriptorSetLayouts = {&*mDescriptors.layout},
-      .pushConstants = {{
-          .stageFlags = VK_SHADER_STAGE_ALL,
-          .size = sizeof(AccumulatorPush),
-      }},
-  });
-
+PipelineUpdate AccumulatorPass::createPipelines(
+    vulkan::ShaderLibrary& shaderLibrary) {
   const auto& shaderData = shaderLibrary.loadShader(kAccumulatorShader);
-  mPipeline = makeUnique<vulkan::ComputePipeline>({
+  auto pipeline = makeUnique<vulkan::ComputePipeline>({
       .device = mDevice,
-      .layout = *mPipelineLayout,
+      .layout = mDevice.getBindlessHeap().getPipelineLayout(),
       .shader = *shaderData.shader,
   });
-  mWorkgroupSize = shaderData.reflection.workgroupSize.value();
+
+  PipelineUpdate update;
+  update.set(mPipeline, std::move(pipeline));
+  update.set(mWorkgroupSize, shaderData.reflection.workgroupSize.value());
+  return update;
 }
 
-void AccumulatorPass::resize(uint32_t width, uint32_t height) {
-  mAccumulatorImage = makeUnique<vulkan::Image>({
+PipelineUpdate AccumulatorPass::resize(uint32_t width, uint32_t height) {
+  auto accumulatorImage = makeUnique<vulkan::Image>({
       .device = mDevice,
       .format = VK_FORMAT_R32G32B32A32_SFLOAT,
       .extent = {width, height, 1},
@@ -79,7 +40,7 @@ void AccumulatorPass::resize(uint32_t width, uint32_t height) {
       .memoryUsage = VMA_MEMORY_USAGE_GPU_ONLY,
   });
 
-  mMomentImage = makeUnique<vulkan::Image>({
+  auto momentImage = makeUnique<vulkan::Image>({
       .device = mDevice,
       .format = VK_FORMAT_R32G32B32A32_SFLOAT,
       .extent = {width, height, 1},
@@ -88,13 +49,17 @@ void AccumulatorPass::resize(uint32_t width, uint32_t height) {
       .memoryUsage = VMA_MEMORY_USAGE_GPU_ONLY,
   });
 
-  mDevice.submitAndWait([&](const auto& commandBuffer) {
-    commandBuffer.transitionImageLayout({&*mAccumulatorImage, &*mMomentImage},
-                                        VK_IMAGE_LAYOUT_UNDEFINED,
-                                        VK_IMAGE_LAYOUT_GENERAL,
-                                        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-                                        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+  mDevice.getImmediateContext().record([&](const auto& commandBuffer) {
+    using namespace vulkan::access;
+    vulkan::BarrierBatch{commandBuffer}
+        .image(*accumulatorImage, kNone, kComputeReadWrite)
+        .image(*momentImage, kNone, kComputeReadWrite);
   });
+
+  PipelineUpdate update;
+  update.set(mAccumulatorImage, std::move(accumulatorImage));
+  update.set(mMomentImage, std::move(momentImage));
+  return update;
 }
 
 void AccumulatorPass::execute(const vulkan::CommandBuffer& commandBuffer,
@@ -106,15 +71,19 @@ void AccumulatorPass::execute(const vulkan::CommandBuffer& commandBuffer,
     reset();
   }
 
+  mDevice.getBindlessHeap().bind(commandBuffer,
+                                 VK_PIPELINE_BIND_POINT_COMPUTE);
   commandBuffer.bindPipeline(*mPipeline);
-  commandBuffer.bindDescriptorSet(*mPipeline, *mDescriptors.set, 0);
 
   AccumulatorPush p{
       // .frameCount = mSettings.enabled ? mScene.getStaticFrameCount() : 0,
       .frameCount = mFrameCount,
       .maxSamples = mSettings.maxSamples,
+      .inputImage = mInputImage->getStorageHandle(),
+      .outputImage = mAccumulatorImage->getStorageHandle(),
+      .varianceImage = mMomentImage->getStorageHandle(),
   };
-  commandBuffer.pushConstants(*mPipelineLayout, p);
+  commandBuffer.pushConstants(mPipeline->getLayout(), p);
 
   vulkan::CommandBuffer::DispatchDim dispatchDim = {
       vulkan::dispatchSize(mWorkgroupSize.x, mAccumulatorImage->getWidth()),
@@ -130,27 +99,7 @@ void AccumulatorPass::execute(const vulkan::CommandBuffer& commandBuffer,
 }
 
 void AccumulatorPass::setInput(const vulkan::Image& inputImage) {
-  vulkan::DescriptorSet::Resources resources;
-
-  resources.images[0][0] = {
-      .sampler = VK_NULL_HANDLE,
-      .imageView = inputImage.getView().vkHandle(),
-      .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
-  };
-
-  resources.images[1][0] = {
-      .sampler = VK_NULL_HANDLE,
-      .imageView = mAccumulatorImage->getView().vkHandle(),
-      .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
-  };
-
-  resources.images[2][0] = {
-      .sampler = VK_NULL_HANDLE,
-      .imageView = mMomentImage->getView().vkHandle(),
-      .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
-  };
-
-  mDescriptors.set->update(resources);
+  mInputImage = &inputImage;
 }
 
 }  // namespace recore::passes
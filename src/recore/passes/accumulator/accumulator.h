@@ -18,9 +18,12 @@ class AccumulatorPass : public Pass {
   explicit AccumulatorPass(const vulkan::Device& device,
                            const scene::Scene& scene);
 
-  void reloadShaders(vulkan::ShaderLibrary& shaderLibrary) override;
+  void registerShaders(vulkan::ShaderLibrary& shaderLibrary) override;
 
-  void resize(uint32_t width, uint32_t height) override;
+  [[nodiscard]] PipelineUpdate createPipelines(
+      vulkan::ShaderLibrary& shaderLibrary) override;
+
+  [[nodiscard]] PipelineUpdate resize(uint32_t width, uint32_t height) override;
 
   void execute(const vulkan::CommandBuffer& commandBuffer,
                vulkan::RenderFrame& currentFrame) override;
@@ -47,13 +50,9 @@ class AccumulatorPass : public Pass {
   uPtr<vulkan::Image> mAccumulatorImage;
   uPtr<vulkan::Image> mMomentImage;
 
-  struct {
-    uPtr<vulkan::DescriptorPool> pool;
-    uPtr<vulkan::DescriptorSetLayout> layout;
-    uPtr<vulkan::DescriptorSet> set;
-  } mDescriptors;
+  const vulkan::Image* mInputImage{nullptr};
 
-  uPtr<vulkan::PipelineLayout> mPipelineLayout;
+  // Uses the layout of the bindless heap
   uPtr<vulkan::ComputePipeline> mPipeline;
   vulkan::ShaderReflectionData::WorkgroupSize mWorkgroupSize{};
 
@@ -103,7 +103,7 @@ DistributionVisualizationPass::DistributionVisualizationPass(
   positions.emplace_back(0.f, 0.f, 0.f);
 
   std::vector<uPtr<vulkan::Buffer>> garbage;
-  mDevice.submitAndWait([&](const auto& commandBuffer) {
+  mDevice.getImmediateContext().submitAndWait([&](const auto& commandBuffer) {
     auto genBuffer = [&]<typename T>(const std::vector<T>& data,
                                      VkBufferUsageFlags usage = 0) {
       VkDeviceSize size = sizeof(T) * data.size();
@@ -167,9 +167,15 @@ DistributionVisualizationPass::DistributionVisualizationPass(
   });
 }
 
-void DistributionVisualizationPass::reloadShaders(
+void DistributionVisualizationPass::registerShaders(
     vulkan::ShaderLibrary& shaderLibrary) {
-  mPipelineLayout = makeUnique<vulkan::PipelineLayout>({
+  requestShader(shaderLibrary, kDistributionVertexShader);
+  requestShader(shaderLibrary, kDistributionFragmentShader);
+}
+
+PipelineUpdate DistributionVisualizationPass::createPipelines(
+    vulkan::ShaderLibrary& shaderLibrary) {
+  auto pipelineLayout = makeUnique<vulkan::PipelineLayout>({
       .device = mDevice,
       .descriptorSetLayouts = {},
       .pushConstants = {{
@@ -178,9 +184,9 @@ void DistributionVisualizationPass::reloadShaders(
       }},
   });
 
-  mPipeline = makeUnique<vulkan::RasterPipeline>({
+  auto pipeline = makeUnique<vulkan::RasterPipeline>({
       .device = mDevice,
-      .layout = *mPipelineLayout,
+      .layout = *pipelineLayout,
       .renderPass = *mRenderPass,
       .state =
           {
@@ -198,6 +204,11 @@ void DistributionVisualizationPass::reloadShaders(
               shaderLibrary.loadShader(kDistributionFragmentShader),
           },
   });
+
+  PipelineUpdate update;
+  update.set(mPipelineLayout, std::move(pipelineLayout));
+  update.set(mPipeline, std::move(pipeline));
+  return update;
 }
 
 void DistributionVisualizationPass::execute(
@@ -11,7 +11,10 @@ class DistributionVisualizationPass : public Pass {
   explicit DistributionVisualizationPass(const vulkan::Device& device,
                                          const scene::Camera& camera);
 
-  void reloadShaders(vulkan::ShaderLibrary& shaderLibrary) override;
+  void registerShaders(vulkan::ShaderLibrary& shaderLibrary) override;
+
+  [[nodiscard]] PipelineUpdate createPipelines(
+      vulkan::ShaderLibrary& shaderLibrary) override;
 
   void execute(const vulkan::CommandBuffer& commandBuffer,
                vulkan::RenderFrame& currentFrame) override;
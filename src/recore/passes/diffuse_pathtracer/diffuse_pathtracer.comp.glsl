@@ -10,7 +10,11 @@
 
 #include "diffuse_pathtracer.glslh"
 
-layout(local_size_x = 32, local_size_y = 32, local_size_z = 1) in;
+#include <recore/shaders/workgroup_size.glslh>
+
+layout(local_size_x = 32, local_size_y = 32, local_size_z = 1,
+       local_size_x_id = WORKGROUP_SIZE_X_ID,
+       local_size_y_id = WORKGROUP_SIZE_Y_ID) in;
 
 layout(set = 1, binding = 0, rgba32f) uniform image2D gOutputImage;
 
@@ -31,7 +35,7 @@ vec3 evalNEE(ShadingData sd, vec3 wi) {
   vec3 wo = -sunLight.direction;
   vec3 lambert = Lambert_eval(sd, normalize(wo));
   vec3 lightWeight = DirectionalLight_eval(sunLight);
-  float shadow = float(!traceShadowRay(Ray(sd.P, 1000 * wo)));
+  float shadow = float(!traceShadowRay(p.scene, Ray(sd.P, 1000 * wo)));
 
   return lambert * lightWeight * shadow;
 }
@@ -70,7 +74,9 @@ float pdfBRDF(ShadingData sd, vec3 wi, vec3 wo) {
   return pdfSampleCosineHemisphere(max(0, dot(normalize(sd.N), normalize(wo))));
 }
 
+#ifndef PATH_TRACER_MAX_BOUNCES
 #define PATH_TRACER_MAX_BOUNCES 5
+#endif
 
 
 vec3 tracePath(inout RandomSampler rng, ivec2 pixel, ShadingData sd, vec3 wi) {
@@ -93,7 +99,7 @@ vec3 tracePath(inout RandomSampler rng, ivec2 pixel, ShadingData sd, vec3 wi) {
     // Trace path
     Ray ray = Ray(sd.P + M_EPSILON * sd.N, brdfSample.wo);
     Hit hit;
-    if(!traceRay(ray, hit)) {
+    if(!traceRay(p.scene, ray, hit)) {
       break;
     }
 
@@ -11,9 +11,12 @@ class DiffusePathTracerPass : public Pass {
   explicit DiffusePathTracerPass(const vulkan::Device& device,
                                  const scene::GPUScene& scene);
 
-  void reloadShaders(vulkan::ShaderLibrary& shaderLibrary) override;
+  void registerShaders(vulkan::ShaderLibrary& shaderLibrary) override;
 
-  void resize(uint32_t width, uint32_t height) override;
+  [[nodiscard]] PipelineUpdate createPipelines(
+      vulkan::ShaderLibrary& shaderLibrary) override;
+
+  [[nodiscard]] PipelineUpdate resize(uint32_t width, uint32_t height) override;
 
   void execute(const vulkan::CommandBuffer& commandBuffer,
                vulkan::RenderFrame& currentFrame) override;
@@ -27,6 +30,12 @@ class DiffusePathTracerPass : public Pass {
 
   void setInput(const Input& input);
 
+  // Compiled into the shader, call registerShaders() and reloadShaders()
+  // afterwards to switch to the matching permutation
+  void setMaxBounces(uint32_t maxBounces) { mMaxBounces = maxBounces; }
+
+  [[nodiscard]] uint32_t getMaxBounces() const { return mMaxBounces; }
+
   [[nodiscard]] const vulkan::Image& getOutputImage() const {
     return *mOutputImage;
   }
@@ -34,10 +43,20 @@ class DiffusePathTracerPass : public Pass {
  private:
   const scene::GPUScene& mScene;
 
+  // Set 1 in binding order, written with the update template
+  struct Descriptors {
+    VkDescriptorImageInfo outputImage;
+    VkDescriptorImageInfo gPosition;
+    VkDescriptorImageInfo gNormal;
+    VkDescriptorImageInfo gAlbedo;
+    VkDescriptorImageInfo gEmissive;
+  };
+
   struct {
     uPtr<vulkan::DescriptorPool> pool;
     uPtr<vulkan::DescriptorSetLayout> layout;
-    uPtr<vulkan::DescriptorSet> set;
+    uPtr<FrameDescriptorSet> set;
+    uPtr<vulkan::DescriptorUpdateTemplate> updateTemplate;
   } mDescriptors;
 
   uPtr<vulkan::PipelineLayout> mPipelineLayout;
@@ -47,6 +66,10 @@ class DiffusePathTracerPass : public Pass {
   uPtr<vulkan::Image> mOutputImage;
 
   uPtr<vulkan::Sampler> mSampler;
+
+  uint32_t mMaxBounces = 5;
+
+  [[nodiscard]] vulkan::ShaderLibrary::LoadData getShaderLoadData() const;
 };
 
 }  // namespace recore::passes
@@ -0,0 +1,18 @@
+#version 460
+#extension GL_EXT_ray_tracing : require
+
+#include <recore/scene/scene.glsl>
+#include <recore/scene/shading.glsl>
+
+#include "diffuse_pathtracer.glslh"
+
+PUSH_CONSTANT(DiffusePathTracerPush);
+
+hitAttributeEXT vec2 gBarycentrics;
+
+// Only part of the hit group for alpha masked materials
+void main() {
+  if (!alphaTest(p.scene, gl_InstanceID, gl_PrimitiveID, gBarycentrics)) {
+    ignoreIntersectionEXT;
+  }
+}
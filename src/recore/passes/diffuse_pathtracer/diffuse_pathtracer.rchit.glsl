@@ -0,0 +1,19 @@
+#version 460
+#extension GL_EXT_ray_tracing : require
+
+#include <recore/scene/scene.glsl>
+#include <recore/scene/shading.glsl>
+
+#include "diffuse_pathtracer.glslh"
+#include "diffuse_pathtracer_rt.glsl"
+
+PUSH_CONSTANT(DiffusePathTracerPush);
+
+layout(location = PAYLOAD_LOCATION_PATH) rayPayloadInEXT PathPayload gPathPayload;
+
+hitAttributeEXT vec2 gBarycentrics;
+
+void main() {
+  gPathPayload.sd = queryShadingData(p.scene, gl_InstanceID, gl_PrimitiveID, gBarycentrics);
+  gPathPayload.hit = true;
+}
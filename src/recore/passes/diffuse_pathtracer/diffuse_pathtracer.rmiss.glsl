@@ -0,0 +1,12 @@
+#version 460
+#extension GL_EXT_ray_tracing : require
+
+#include <recore/scene/shading.glsl>
+
+#include "diffuse_pathtracer_rt.glsl"
+
+layout(location = PAYLOAD_LOCATION_PATH) rayPayloadInEXT PathPayload gPathPayload;
+
+void main() {
+  gPathPayload.hit = false;
+}
@@ -0,0 +1,197 @@
+#include "diffuse_pathtracer_rt.h"
+
+#include "diffuse_pathtracer.glslh"
+
+namespace recore::passes {
+
+constexpr auto kRayGenShader =
+    "recore/passes/diffuse_pathtracer/diffuse_pathtracer.rgen.glsl";
+constexpr auto kMissShader =
+    "recore/passes/diffuse_pathtracer/diffuse_pathtracer.rmiss.glsl";
+constexpr auto kShadowMissShader =
+    "recore/passes/diffuse_pathtracer/diffuse_pathtracer_shadow.rmiss.glsl";
+constexpr auto kClosestHitShader =
+    "recore/passes/diffuse_pathtracer/diffuse_pathtracer.rchit.glsl";
+constexpr auto kAnyHitShader =
+    "recore/passes/diffuse_pathtracer/diffuse_pathtracer.rahit.glsl";
+
+DiffusePathTracerRTPass::DiffusePathTracerRTPass(const vulkan::Device& device,
+                                                 const scene::GPUScene& scene)
+    : Pass{device}, mScene{scene} {
+  // Initialize descriptor layout
+  {
+    mDescriptors.pool = makeUnique<vulkan::DescriptorPool>({
+        .device = mDevice,
+        .poolSizes =
+            {
+                {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1},
+                {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4},
+            },
+        .maxSets = FrameDescriptorSet::kSetCount,
+        .perSet = true,
+    });
+
+    mDescriptors.layout = makeUnique<vulkan::DescriptorSetLayout>({
+        .device = mDevice,
+        .bindings =
+            {
+                {
+                    {.binding = 0,
+                     .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+                     .descriptorCount = 1,
+                     .stageFlags = VK_SHADER_STAGE_RAYGEN_BIT_KHR},
+                },
+                {
+                    {.binding = 1,
+                     .descriptorType =
+                         VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                     .descriptorCount = 1,
+                     .stageFlags = VK_SHADER_STAGE_RAYGEN_BIT_KHR},
+                },
+                {
+                    {.binding = 2,
+                     .descriptorType =
+                         VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                     .descriptorCount = 1,
+                     .stageFlags = VK_SHADER_STAGE_RAYGEN_BIT_KHR},
+                },
+                {
+                    {.binding = 3,
+                     .descriptorType =
+                         VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                     .descriptorCount = 1,
+                     .stageFlags = VK_SHADER_STAGE_RAYGEN_BIT_KHR},
+                },
+                {
+                    {.binding = 4,
+                     .descriptorType =
+                         VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                     .descriptorCount = 1,
+                     .stageFlags = VK_SHADER_STAGE_RAYGEN_BIT_KHR},
+                },
+            },
+    });
+
+    mDescriptors.set = makeUnique<FrameDescriptorSet>({
+        .device = mDevice,
+        .pool = *mDescriptors.pool,
+        .layout = *mDescriptors.layout,
+    });
+
+    mDescriptors.updateTemplate = makeUnique<vulkan::DescriptorUpdateTemplate>({
+        .device = mDevice,
+        .layout = *mDescriptors.layout,
+        .entries = vulkan::DescriptorUpdateTemplate::getEntries<Descriptors>(),
+    });
+  }
+
+  mSampler = makeUnique<vulkan::Sampler>({.device = mDevice});
+}
+
+void DiffusePathTracerRTPass::registerShaders(
+    vulkan::ShaderLibrary& shaderLibrary) {
+  requestShader(shaderLibrary, kRayGenShader);
+  requestShader(shaderLibrary, kMissShader);
+  requestShader(shaderLibrary, kShadowMissShader);
+  requestShader(shaderLibrary, kClosestHitShader);
+  requestShader(shaderLibrary, kAnyHitShader);
+}
+
+PipelineUpdate DiffusePathTracerRTPass::createPipelines(
+    vulkan::ShaderLibrary& shaderLibrary) {
+  auto pipelineLayout = makeUnique<vulkan::PipelineLayout>({
+      .device = mDevice,
+      .descriptorSetLayouts = {&mScene.getDescriptorSetLayout(),
+                               &*mDescriptors.layout},
+      .pushConstants = {{
+          .stageFlags = VK_SHADER_STAGE_ALL,
+          .size = sizeof(DiffusePathTracerPush),
+      }},
+  });
+
+  const auto& rayGen = shaderLibrary.loadShader(kRayGenShader);
+  const auto& miss = shaderLibrary.loadShader(kMissShader);
+  const auto& shadowMiss = shaderLibrary.loadShader(kShadowMissShader);
+  const auto& closestHit = shaderLibrary.loadShader(kClosestHitShader);
+  const auto& anyHit = shaderLibrary.loadShader(kAnyHitShader);
+
+  // Hit groups are indexed by the SBT record offset of the TLAS instances
+  std::vector<vulkan::RayTracingPipeline::HitGroup> hitGroups(2);
+  hitGroups[scene::GPUScene::kOpaqueHitGroup] = {.closestHit = closestHit};
+  hitGroups[scene::GPUScene::kMaskedHitGroup] = {.closestHit = closestHit,
+                                                 .anyHit = anyHit};
+
+  auto pipeline = makeUnique<vulkan::RayTracingPipeline>({
+      .device = mDevice,
+      .layout = *pipelineLayout,
+      .rayGen = *rayGen.shader,
+      .miss = {miss, shadowMiss},
+      .hitGroups = hitGroups,
+  });
+
+  PipelineUpdate update;
+  update.set(mPipelineLayout, std::move(pipelineLayout));
+  update.set(mPipeline, std::move(pipeline));
+  return update;
+}
+
+PipelineUpdate DiffusePathTracerRTPass::resize(uint32_t width,
+                                               uint32_t height) {
+  auto outputImage = makeUnique<vulkan::Image>({
+      .device = mDevice,
+      .format = VK_FORMAT_R32G32B32A32_SFLOAT,
+      .extent = {width, height, 1},
+      .usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT |
+               VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+      .memoryUsage = VMA_MEMORY_USAGE_GPU_ONLY,
+  });
+
+  mDevice.getImmediateContext().record([&](const auto& commandBuffer) {
+    vulkan::BarrierBatch{commandBuffer}.image(*outputImage,
+                                              vulkan::access::kNone,
+                                              vulkan::access::kRayTracingWrite);
+  });
+
+  PipelineUpdate update;
+  update.set(mOutputImage, std::move(outputImage));
+  return update;
+}
+
+void DiffusePathTracerRTPass::execute(
+    const vulkan::CommandBuffer& commandBuffer,
+    vulkan::RenderFrame& currentFrame) {
+  RECORE_GPU_PROFILE_SCOPE(
+      currentFrame, commandBuffer, "DiffusePathTracerRT::execute");
+
+  uint32_t rngSeed = static_cast<uint32_t>(
+      std::chrono::system_clock::now().time_since_epoch().count());
+
+  DiffusePathTracerPush p{
+      .scene = mScene.getSceneDataDeviceAddress(),
+      .rngSeed = rngSeed,
+  };
+
+  commandBuffer.bindPipeline(*mPipeline);
+  commandBuffer.bindDescriptorSet(*mPipeline, mScene.getDescriptorSet(), 0);
+  commandBuffer.bindDescriptorSet(*mPipeline, mDescriptors.set->get(), 1);
+
+  commandBuffer.pushConstants(*mPipelineLayout, p);
+
+  commandBuffer.traceRays(
+      *mPipeline, mOutputImage->getWidth(), mOutputImage->getHeight());
+}
+
+void DiffusePathTracerRTPass::setInput(const Input& input) {
+  const Descriptors descriptors{
+      .outputImage = vulkan::getStorageImageInfo(*mOutputImage),
+      .gPosition = vulkan::getSampledImageInfo(input.gPosition, *mSampler),
+      .gNormal = vulkan::getSampledImageInfo(input.gNormal, *mSampler),
+      .gAlbedo = vulkan::getSampledImageInfo(input.gAlbedo, *mSampler),
+      .gEmissive = vulkan::getSampledImageInfo(input.gEmissive, *mSampler),
+  };
+  mDescriptors.set->write([this, descriptors](const auto& set) {
+    mDescriptors.updateTemplate->update(set, &descriptors);
+  });
+}
+
+}  // namespace recore::passes
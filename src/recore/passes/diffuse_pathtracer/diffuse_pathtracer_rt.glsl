@@ -0,0 +1,18 @@
+#ifndef DIFFUSE_PATHTRACER_RT_GLSL
+#define DIFFUSE_PATHTRACER_RT_GLSL
+
+#include <recore/scene/shading.glsl>
+
+// Miss shader indices, the order matches the miss shaders of the pipeline
+#define MISS_INDEX_PATH 0
+#define MISS_INDEX_SHADOW 1
+
+#define PAYLOAD_LOCATION_PATH 0
+#define PAYLOAD_LOCATION_SHADOW 1
+
+struct PathPayload {
+  ShadingData sd;
+  bool hit;
+};
+
+#endif // DIFFUSE_PATHTRACER_RT_GLSL
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <recore/passes/pass.h>
+
+#include <recore/scene/gpu_scene.h>
+
+namespace recore::passes {
+
+// Port of DiffusePathTracerPass to a ray tracing pipeline. Shading is done in
+// the closest hit shader and alpha testing in the any hit shader of the
+// masked hit group. Requires VK_KHR_ray_tracing_pipeline.
+class DiffusePathTracerRTPass : public Pass {
+ public:
+  explicit DiffusePathTracerRTPass(const vulkan::Device& device,
+                                   const scene::GPUScene& scene);
+
+  void registerShaders(vulkan::ShaderLibrary& shaderLibrary) override;
+
+  [[nodiscard]] PipelineUpdate createPipelines(
+      vulkan::ShaderLibrary& shaderLibrary) override;
+
+  [[nodiscard]] PipelineUpdate resize(uint32_t width, uint32_t height) override;
+
+  void execute(const vulkan::CommandBuffer& commandBuffer,
+               vulkan::RenderFrame& currentFrame) override;
+
+  struct Input {
+    const vulkan::Image& gPosition;
+    const vulkan::Image& gNormal;
+    const vulkan::Image& gAlbedo;
+    const vulkan::Image& gEmissive;
+  };
+
+  void setInput(const Input& input);
+
+  [[nodiscard]] const vulkan::Image& getOutputImage() const {
+    return *mOutputImage;
+  }
+
+ private:
+  const scene::GPUScene& mScene;
+
+  // Set 1 in binding order, written with the update template
+  struct Descriptors {
+    VkDescriptorImageInfo outputImage;
+    VkDescriptorImageInfo gPosition;
+    VkDescriptorImageInfo gNormal;
+    VkDescriptorImageInfo gAlbedo;
+    VkDescriptorImageInfo gEmissive;
+  };
+
+  struct {
+    uPtr<vulkan::DescriptorPool> pool;
+    uPtr<vulkan::DescriptorSetLayout> layout;
+    uPtr<FrameDescriptorSet> set;
+    uPtr<vulkan::DescriptorUpdateTemplate> updateTemplate;
+  } mDescriptors;
+
+  uPtr<vulkan::PipelineLayout> mPipelineLayout;
+  uPtr<vulkan::RayTracingPipeline> mPipeline;
+
+  uPtr<vulkan::Image> mOutputImage;
+
+  uPtr<vulkan::Sampler> mSampler;
+};
+
+}  // namespace recore::passes
@@ -0,0 +1,10 @@
+#version 460
+#extension GL_EXT_ray_tracing : require
+
+#include "diffuse_pathtracer_rt.glsl"
+
+layout(location = PAYLOAD_LOCATION_SHADOW) rayPayloadInEXT bool gOccluded;
+
+void main() {
+  gOccluded = false;
+}
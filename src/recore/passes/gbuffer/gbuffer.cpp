@@ -31,7 +31,7 @@ GBufferPass::GBufferPass(const vulkan::Device& device,
        }});
 }
 
-void GBufferPass::resize(uint32_t width, uint32_t height) {
+PipelineUpdate GBufferPass::resize(uint32_t width, uint32_t height) {
   auto genImage = [&](VkFormat format, VkImageUsageFlags usage = 0) {
     return makeUnique<vulkan::Image>({
         .device = mDevice,
@@ -47,31 +47,49 @@ void GBufferPass::resize(uint32_t width, uint32_t height) {
   constexpr VkImageUsageFlags GBUFFER_USAGE =
       VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
 
-  mGBuffer.position = genImage(GBUFFER_FORMAT, GBUFFER_USAGE);
-  mGBuffer.normal = genImage(GBUFFER_FORMAT, GBUFFER_USAGE);
-  mGBuffer.albedo = genImage(GBUFFER_FORMAT, GBUFFER_USAGE);
-  mGBuffer.emission = genImage(GBUFFER_FORMAT, GBUFFER_USAGE);
-  mGBuffer.motion = genImage(VK_FORMAT_R32G32_SFLOAT, GBUFFER_USAGE);
-  mGBuffer.material = genImage(GBUFFER_FORMAT, GBUFFER_USAGE);
-  mGBuffer.depth = genImage(VK_FORMAT_D32_SFLOAT,
-                            VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT);
-
-  mFramebuffer = makeUnique<vulkan::Framebuffer>(
+  GBuffer gBuffer;
+  gBuffer.position = genImage(GBUFFER_FORMAT, GBUFFER_USAGE);
+  gBuffer.normal = genImage(GBUFFER_FORMAT, GBUFFER_USAGE);
+  gBuffer.albedo = genImage(GBUFFER_FORMAT, GBUFFER_USAGE);
+  gBuffer.emission = genImage(GBUFFER_FORMAT, GBUFFER_USAGE);
+  gBuffer.motion = genImage(VK_FORMAT_R32G32_SFLOAT, GBUFFER_USAGE);
+  gBuffer.material = genImage(GBUFFER_FORMAT, GBUFFER_USAGE);
+  gBuffer.depth = genImage(VK_FORMAT_D32_SFLOAT,
+                           VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT);
+
+  auto framebuffer = makeUnique<vulkan::Framebuffer>(
       {.device = mDevice,
        .renderPass = *mRenderPass,
-       .attachments = {&mGBuffer.position->getView(),
-                       &mGBuffer.normal->getView(),
-                       &mGBuffer.albedo->getView(),
-                       &mGBuffer.emission->getView(),
-                       &mGBuffer.motion->getView(),
-                       &mGBuffer.material->getView(),
-                       &mGBuffer.depth->getView()},
+       .attachments = {&gBuffer.position->getView(),
+                       &gBuffer.normal->getView(),
+                       &gBuffer.albedo->getView(),
+                       &gBuffer.emission->getView(),
+                       &gBuffer.motion->getView(),
+                       &gBuffer.material->getView(),
+                       &gBuffer.depth->getView()},
        .width = width,
        .height = height});
+
+  PipelineUpdate update;
+  update.set(mGBuffer.position, std::move(gBuffer.position));
+  update.set(mGBuffer.normal, std::move(gBuffer.normal));
+  update.set(mGBuffer.albedo, std::move(gBuffer.albedo));
+  update.set(mGBuffer.emission, std::move(gBuffer.emission));
+  update.set(mGBuffer.motion, std::move(gBuffer.motion));
+  update.set(mGBuffer.material, std::move(gBuffer.material));
+  update.set(mGBuffer.depth, std::move(gBuffer.depth));
+  update.set(mFramebuffer, std::move(framebuffer));
+  return update;
 }
 
-void GBufferPass::reloadShaders(vulkan::ShaderLibrary& shaderLibrary) {
-  mPipelineLayout = makeUnique<vulkan::PipelineLayout>(
+void GBufferPass::registerShaders(vulkan::ShaderLibrary& shaderLibrary) {
+  requestShader(shaderLibrary, kGBufferVertexShader);
+  requestShader(shaderLibrary, kGBufferFragmentShader);
+}
+
+PipelineUpdate GBufferPass::createPipelines(
+    vulkan::ShaderLibrary& shaderLibrary) {
+  auto pipelineLayout = makeUnique<vulkan::PipelineLayout>(
       {.device = mDevice,
        .descriptorSetLayouts = {&mScene.getDescriptorSetLayout()},
        .pushConstants = {
@@ -80,9 +98,9 @@ void GBufferPass::reloadShaders(vulkan::ShaderLibrary& shaderLibrary) {
             .size = vulkan::MAX_PUSH_CONSTANT_SIZE},
        }});
 
-  mPipeline = makeUnique<vulkan::RasterPipeline>({
+  auto pipeline = makeUnique<vulkan::RasterPipeline>({
       .device = mDevice,
-      .layout = *mPipelineLayout,
+      .layout = *pipelineLayout,
       .renderPass = *mRenderPass,
       .state =
           {
@@ -111,6 +129,11 @@ void GBufferPass::reloadShaders(vulkan::ShaderLibrary& shaderLibrary) {
       .shaders = {shaderLibrary.loadShader(kGBufferVertexShader),
                   shaderLibrary.loadShader(kGBufferFragmentShader)},
   });
+
+  PipelineUpdate update;
+  update.set(mPipelineLayout, std::move(pipelineLayout));
+  update.set(mPipeline, std::move(pipeline));
+  return update;
 }
 
 void GBufferPass::execute(const vulkan::CommandBuffer& commandBuffer,
@@ -21,9 +21,12 @@ class GBufferPass : public Pass {
   explicit GBufferPass(const vulkan::Device& device,
                        const scene::GPUScene& scene);
 
-  void resize(uint32_t width, uint32_t height) override;
+  [[nodiscard]] PipelineUpdate resize(uint32_t width, uint32_t height) override;
 
-  void reloadShaders(vulkan::ShaderLibrary& shaderLibrary) override;
+  void registerShaders(vulkan::ShaderLibrary& shaderLibrary) override;
+
+  [[nodiscard]] PipelineUpdate createPipelines(
+      vulkan::ShaderLibrary& shaderLibrary) override;
 
   void execute(const vulkan::CommandBuffer& commandBuffer,
                vulkan::RenderFrame& currentFrame) override;
@@ -5,6 +5,10 @@
 
 #include <recore/vulkan/debug.h>
 
+#include <algorithm>
+#include <array>
+#include <format>
+
 namespace recore::passes {
 
 GUIPass::GUIPass(const vulkan::Device& device,
@@ -35,10 +39,14 @@ GUIPass::~GUIPass() {
   ImGui::DestroyContext();
 }
 
-void GUIPass::setFramebuffer(const vulkan::Image& image) {
+void GUIPass::setFramebuffer(const vulkan::Image& image,
+                             vulkan::RenderFrame* frame) {
   uint32_t width = image.getWidth();
   uint32_t height = image.getHeight();
 
+  if (frame != nullptr) {
+    frame->deferDestroy(std::move(mFramebuffer));
+  }
   mFramebuffer = makeUnique<vulkan::Framebuffer>({
       .device = mRenderPass->getDevice(),
       .renderPass = *mRenderPass,
@@ -75,6 +83,7 @@ void GUIPass::initImGui(const vulkan::Device& device,
   initInfo.PhysicalDevice = device.getPhysicalDevice().vkHandle();
   initInfo.Device = device.vkHandle();
   initInfo.Queue = device.getGraphicsQueue().vkHandle();
+  initInfo.PipelineCache = device.getPipelineCache().vkHandle();
   initInfo.DescriptorPool = mDescriptorPool->vkHandle();
   initInfo.MinImageCount = numFramesInFlight;
   initInfo.ImageCount = numFramesInFlight;
@@ -110,4 +119,213 @@ void GUIPass::draw(const vulkan::CommandBuffer& commandBuffer) {
   commandBuffer.endRenderPass();
 }
 
+void drawPipelineStatistics(const vulkan::Device& device) {
+  if (!device.isExtensionEnabled(
+          VK_KHR_PIPELINE_EXECUTABLE_PROPERTIES_EXTENSION_NAME)) {
+    ImGui::TextDisabled("VK_KHR_pipeline_executable_properties not enabled");
+    return;
+  }
+
+  bool capture = device.isCapturingStatistics();
+  if (ImGui::Checkbox("Capture statistics", &capture)) {
+    device.setCaptureStatistics(capture);
+  }
+  ImGui::SameLine();
+  ImGui::TextDisabled("(pipelines created afterwards)");
+
+  auto pipelines = device.getPipelines();
+  std::ranges::sort(pipelines, {}, &vulkan::Pipeline::getName);
+
+  for (const auto* pipeline : pipelines) {
+    ImGui::PushID(pipeline);
+    if (ImGui::TreeNode(pipeline->getName().c_str())) {
+      for (const auto& executable : pipeline->getExecutableStatistics()) {
+        ImGui::TextUnformatted(executable.name.c_str());
+        if (ImGui::IsItemHovered()) {
+          ImGui::SetTooltip("%s", executable.description.c_str());
+        }
+
+        constexpr auto kTableFlags = ImGuiTableFlags_Borders |
+                                     ImGuiTableFlags_RowBg |
+                                     ImGuiTableFlags_SizingStretchProp;
+        if (ImGui::BeginTable(executable.name.c_str(), 2, kTableFlags)) {
+          ImGui::TableNextRow();
+          ImGui::TableNextColumn();
+          ImGui::TextUnformatted("Subgroup size");
+          ImGui::TableNextColumn();
+          ImGui::Text("%u", executable.subgroupSize);
+
+          for (const auto& statistic : executable.statistics) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(statistic.name.c_str());
+            if (ImGui::IsItemHovered()) {
+              ImGui::SetTooltip("%s", statistic.description.c_str());
+            }
+            ImGui::TableNextColumn();
+            auto value = std::visit(
+                [](auto v) { return std::format("{}", v); }, statistic.value);
+            ImGui::TextUnformatted(value.c_str());
+          }
+          ImGui::EndTable();
+        }
+      }
+      ImGui::TreePop();
+    }
+    ImGui::PopID();
+  }
+}
+
+static const char* getPresentModeName(VkPresentModeKHR presentMode) {
+  switch (presentMode) {
+    case VK_PRESENT_MODE_FIFO_KHR:
+      return "FIFO";
+    case VK_PRESENT_MODE_FIFO_RELAXED_KHR:
+      return "FIFO relaxed";
+    case VK_PRESENT_MODE_MAILBOX_KHR:
+      return "Mailbox";
+    case VK_PRESENT_MODE_IMMEDIATE_KHR:
+      return "Immediate";
+    default:
+      return "Unknown";
+  }
+}
+
+void drawFramePacing(vulkan::RenderContext& renderContext) {
+  int framesInFlight = static_cast<int>(renderContext.getNumFramesInFlight());
+  if (ImGui::SliderInt("Frames in flight",
+                       &framesInFlight,
+                       1,
+                       vulkan::RenderContext::kMaxFramesInFlight)) {
+    renderContext.setNumFramesInFlight(static_cast<uint32_t>(framesInFlight));
+  }
+
+  constexpr std::array kPresentModes = {
+      VK_PRESENT_MODE_FIFO_KHR,
+      VK_PRESENT_MODE_FIFO_RELAXED_KHR,
+      VK_PRESENT_MODE_MAILBOX_KHR,
+      VK_PRESENT_MODE_IMMEDIATE_KHR,
+  };
+
+  auto current = renderContext.getPresentMode();
+  if (ImGui::BeginCombo("Present mode", getPresentModeName(current))) {
+    const auto& supported = renderContext.getSupportedPresentModes();
+    for (auto presentMode : kPresentModes) {
+      if (!std::ranges::contains(supported, presentMode)) {
+        continue;
+      }
+      if (ImGui::Selectable(getPresentModeName(presentMode),
+                            presentMode == current)) {
+        renderContext.setPresentMode(presentMode);
+      }
+    }
+    ImGui::EndCombo();
+  }
+
+  const auto& latency = renderContext.getLatency();
+  ImGui::Text("Input to submit: %.2f ms", latency.inputToSubmit);
+  ImGui::Text("GPU frame: %.2f ms", latency.gpuTime);
+  if (latency.inputToGPU.has_value()) {
+    ImGui::Text("Input to GPU done: %.2f ms", *latency.inputToGPU);
+  } else {
+    ImGui::TextDisabled("Input to GPU done: no calibrated timestamps");
+  }
+  if (latency.inputToPresent.has_value()) {
+    ImGui::Text("Input to present: %.2f ms", *latency.inputToPresent);
+  } else {
+    ImGui::TextDisabled("Input to present: no display timing");
+  }
+}
+
+void drawGPUProfiler(const vulkan::GPUProfiler& profiler) {
+  if (ImGui::Button("Export trace")) {
+    profiler.exportTrace("gpu_trace.json");
+  }
+  ImGui::SameLine();
+  if (ImGui::Button("Export CSV")) {
+    profiler.exportCSV("gpu_profile.csv");
+  }
+
+  constexpr auto kTableFlags = ImGuiTableFlags_Borders |
+                               ImGuiTableFlags_RowBg |
+                               ImGuiTableFlags_SizingStretchProp;
+  if (!ImGui::BeginTable("GPUProfiler", 6, kTableFlags)) {
+    return;
+  }
+  for (const char* column : {"Scope", "Last", "Avg", "Min", "P95", "P99"}) {
+    ImGui::TableSetupColumn(column);
+  }
+  ImGui::TableHeadersRow();
+
+  auto drawScope = [&](const auto& self, uint32_t id) -> void {
+    const auto& scope = profiler.getScope(id);
+    auto statistics = profiler.getStatistics(id);
+
+    ImGuiTreeNodeFlags flags = ImGuiTreeNodeFlags_DefaultOpen |
+                               ImGuiTreeNodeFlags_SpanFullWidth;
+    if (scope.children.empty()) {
+      flags |= ImGuiTreeNodeFlags_Leaf | ImGuiTreeNodeFlags_NoTreePushOnOpen;
+    }
+
+    ImGui::TableNextRow();
+    ImGui::TableNextColumn();
+    bool open = ImGui::TreeNodeEx(
+        reinterpret_cast<void*>(static_cast<uintptr_t>(id)),
+        flags,
+        "%s",
+        scope.name.c_str());
+
+    for (float time : {statistics.last,
+                       statistics.avg,
+                       statistics.min,
+                       statistics.p95,
+                       statistics.p99}) {
+      ImGui::TableNextColumn();
+      ImGui::Text("%.3f ms", time);
+    }
+
+    if (open && !scope.children.empty()) {
+      for (uint32_t child : scope.children) {
+        self(self, child);
+      }
+      ImGui::TreePop();
+    }
+  };
+  drawScope(drawScope, vulkan::GPUProfiler::kRootScope);
+
+  ImGui::EndTable();
+}
+
+void drawWorkgroupSizes(PassGroup& passGroup) {
+  const auto* tuner = passGroup.getWorkgroupSizeTuner();
+  ImGui::BeginDisabled(tuner != nullptr && !tuner->isDone());
+  if (ImGui::Button("Tune")) {
+    passGroup.tuneWorkgroupSizes();
+  }
+  ImGui::EndDisabled();
+  if (tuner != nullptr) {
+    ImGui::TextUnformatted(tuner->getStatus().c_str());
+  }
+}
+
+void drawRendererSections(const vulkan::Device& device,
+                          vulkan::RenderContext& renderContext,
+                          PassGroup& passGroup) {
+  if (ImGui::CollapsingHeader("Frame Pacing")) {
+    drawFramePacing(renderContext);
+  }
+
+  if (ImGui::CollapsingHeader("GPU Profiler")) {
+    drawGPUProfiler(renderContext.getGPUProfiler());
+  }
+
+  if (ImGui::CollapsingHeader("Workgroup Sizes")) {
+    drawWorkgroupSizes(passGroup);
+  }
+
+  if (ImGui::CollapsingHeader("Pipeline Statistics")) {
+    drawPipelineStatistics(device);
+  }
+}
+
 }  // namespace recore::passes
@@ -2,6 +2,8 @@
 
 #include <imgui.h>
 
+#include <recore/passes/pass_group.h>
+
 #include <recore/vulkan/api/descriptor.h>
 #include <recore/vulkan/context.h>
 
@@ -19,7 +21,9 @@ class GUIPass : public NoCopyMove {
 
   ~GUIPass();
 
-  void setFramebuffer(const vulkan::Image& image);
+  // The previous framebuffer is retired into the frame, without one the
+  // device has to be idle
+  void setFramebuffer(const vulkan::Image& image, vulkan::RenderFrame* frame);
 
   void newFrame();
   void draw(const vulkan::CommandBuffer& commandBuffer);
@@ -35,4 +39,26 @@ class GUIPass : public NoCopyMove {
   uPtr<vulkan::Framebuffer> mFramebuffer;
 };
 
+// Table of the driver statistics of all live pipelines, to be called between
+// ImGui::Begin and ImGui::End
+void drawPipelineStatistics(const vulkan::Device& device);
+
+// Frames in flight and present mode of the context with its latency, to be
+// called between ImGui::Begin and ImGui::End
+void drawFramePacing(vulkan::RenderContext& renderContext);
+
+// Scope tree of the profiler with its statistics and buttons to export them
+// to the working directory, to be called between ImGui::Begin and ImGui::End
+void drawGPUProfiler(const vulkan::GPUProfiler& profiler);
+
+// Button to tune the workgroup sizes of the passes and the tuner progress, to
+// be called between ImGui::Begin and ImGui::End
+void drawWorkgroupSizes(PassGroup& passGroup);
+
+// Collapsing headers of the sections above that all renderers share, to be
+// called between ImGui::Begin and ImGui::End
+void drawRendererSections(const vulkan::Device& device,
+                          vulkan::RenderContext& renderContext,
+                          PassGroup& passGroup);
+
 }  // namespace recore::passes
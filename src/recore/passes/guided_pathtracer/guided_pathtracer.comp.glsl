@@ -25,7 +25,11 @@
 
 
 
-layout(local_size_x = 32, local_size_y = 32, local_size_z = 1) in;
+#include <recore/shaders/workgroup_size.glslh>
+
+layout(local_size_x = 32, local_size_y = 32, local_size_z = 1,
+       local_size_x_id = WORKGROUP_SIZE_X_ID,
+       local_size_y_id = WORKGROUP_SIZE_Y_ID) in;
 
 layout(set = 1, binding = 0, rgba32f) uniform image2D gOutputImage;
 
@@ -47,7 +51,7 @@ vec3 evalNEE(ShadingData sd, vec3 wi) {
   vec3 wo = light.position - sd.P;
   vec3 lambert = Lambert_eval(sd, normalize(wo));
   vec3 lightWeight = PointLight_eval(light, sd.P);
-  float shadow = float(!traceShadowRay(Ray(sd.P, wo)));
+  float shadow = float(!traceShadowRay(p.scene, Ray(sd.P, wo)));
 
   #else
 
@@ -57,7 +61,7 @@ vec3 evalNEE(ShadingData sd, vec3 wi) {
   vec3 wo = -sunLight.direction;
   vec3 lambert = Lambert_eval(sd, normalize(wo));
   vec3 lightWeight = DirectionalLight_eval(sunLight);
-  float shadow = float(!traceShadowRay(Ray(sd.P, 1000 * wo)));
+  float shadow = float(!traceShadowRay(p.scene, Ray(sd.P, 1000 * wo)));
 
   #endif
 
@@ -185,7 +189,7 @@ vec3 tracePathTrainGuide(inout RandomSampler rng, ivec2 pixel, ShadingData sd, v
     // Trace next path segment
     Ray ray = Ray(sd.P + M_EPSILON * sd.N, brdfSample.wo);
     Hit hit;
-    if(!traceRay(ray, hit)) {
+    if(!traceRay(p.scene, ray, hit)) {
       break;
     }
 
@@ -5,6 +5,8 @@
 #include "guided_pathtracer.glslh"
 #include "guiding.glslh"
 
+#include <algorithm>
+
 namespace recore::passes {
 
 constexpr auto kPathTracerShader =
@@ -27,6 +29,8 @@ GuidedPathTracerPass::GuidedPathTracerPass(const vulkan::Device& device,
               {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1},
               {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4},
           },
+      .maxSets = FrameDescriptorSet::kSetCount,
+      .perSet = true,
   });
 
   mDescriptors.layout = makeUnique<vulkan::DescriptorSetLayout>({
@@ -67,12 +71,18 @@ GuidedPathTracerPass::GuidedPathTracerPass(const vulkan::Device& device,
   });
 
   // Initialize buffers
-  mDescriptors.set = makeUnique<vulkan::DescriptorSet>({
+  mDescriptors.set = makeUnique<FrameDescriptorSet>({
       .device = mDevice,
       .pool = *mDescriptors.pool,
       .layout = *mDescriptors.layout,
   });
 
+  mDescriptors.updateTemplate = makeUnique<vulkan::DescriptorUpdateTemplate>({
+      .device = mDevice,
+      .layout = *mDescriptors.layout,
+      .entries = vulkan::DescriptorUpdateTemplate::getEntries<Descriptors>(),
+  });
+
   mBuffers.hashGrid = makeUnique<vulkan::Buffer>({
       .device = mDevice,
       .size = mHashGrid.size * sizeof(HashGridCell),
@@ -132,9 +142,19 @@ GuidedPathTracerPass::GuidedPathTracerPass(const vulkan::Device& device,
   mPrefixSumPass = makeUnique<PrefixSumPass>(mDevice, *mBuffers.cellPrefixSums);
 }
 
-void GuidedPathTracerPass::reloadShaders(vulkan::ShaderLibrary& shaderLibrary) {
+void GuidedPathTracerPass::registerShaders(
+    vulkan::ShaderLibrary& shaderLibrary) {
+  requestShader(shaderLibrary, kPathTracerShader);
+  requestShader(shaderLibrary, kGuidingIndicesShader);
+  requestShader(shaderLibrary, kGuidingEMShader);
+}
+
+PipelineUpdate GuidedPathTracerPass::createPipelines(
+    vulkan::ShaderLibrary& shaderLibrary) {
+  PipelineUpdate update;
+
   {
-    mPipelineLayout = makeUnique<vulkan::PipelineLayout>({
+    auto pipelineLayout = makeUnique<vulkan::PipelineLayout>({
         .device = mDevice,
         .descriptorSetLayouts = {&mScene.getDescriptorSetLayout(),
                                  &*mDescriptors.layout},
@@ -145,18 +165,21 @@ void GuidedPathTracerPass::reloadShaders(vulkan::ShaderLibrary& shaderLibrary) {
     });
 
     const auto& shaderData = shaderLibrary.loadShader(kPathTracerShader);
-    mPipeline = makeUnique<vulkan::ComputePipeline>({
+    auto pipeline = makeUnique<vulkan::ComputePipeline>({
         .device = mDevice,
-        .layout = *mPipelineLayout,
+        .layout = *pipelineLayout,
         .shader = *shaderData.shader,
     });
-    mWorkgroupSize = shaderData.reflection.workgroupSize.value();
+
+    update.set(mPipelineLayout, std::move(pipelineLayout));
+    update.set(mPipeline, std::move(pipeline));
+    update.set(mWorkgroupSize, shaderData.reflection.workgroupSize.value());
   }
 
-  mPrefixSumPass->reloadShaders(shaderLibrary);
+  update.append(mPrefixSumPass->createPipelines(shaderLibrary));
 
   {
-    mGuidingIndicesPass.pipelineLayout = makeUnique<vulkan::PipelineLayout>({
+    auto pipelineLayout = makeUnique<vulkan::PipelineLayout>({
         .device = mDevice,
         .descriptorSetLayouts = {},
         .pushConstants = {{
@@ -166,18 +189,21 @@ void GuidedPathTracerPass::reloadShaders(vulkan::ShaderLibrary& shaderLibrary) {
     });
 
     const auto& shaderData = shaderLibrary.loadShader(kGuidingIndicesShader);
-    mGuidingIndicesPass.workgroupSize =
-        shaderData.reflection.workgroupSize.value();
 
-    mGuidingIndicesPass.pipeline = makeUnique<vulkan::ComputePipeline>({
+    auto pipeline = makeUnique<vulkan::ComputePipeline>({
         .device = mDevice,
-        .layout = *mGuidingIndicesPass.pipelineLayout,
+        .layout = *pipelineLayout,
         .shader = *shaderData.shader,
     });
+
+    update.set(mGuidingIndicesPass.pipelineLayout, std::move(pipelineLayout));
+    update.set(mGuidingIndicesPass.pipeline, std::move(pipeline));
+    update.set(mGuidingIndicesPass.workgroupSize,
+               shaderData.reflection.workgroupSize.value());
   }
 
   {
-    mGuidingEMPass.pipelineLayout = makeUnique<vulkan::PipelineLayout>({
+    auto pipelineLayout = makeUnique<vulkan::PipelineLayout>({
         .device = mDevice,
         .descriptorSetLayouts = {},
         .pushConstants = {{
@@ -187,51 +213,37 @@ void GuidedPathTracerPass::reloadShaders(vulkan::ShaderLibrary& shaderLibrary) {
     });
 
     const auto& shaderData = shaderLibrary.loadShader(kGuidingEMShader);
-    mGuidingEMPass.workgroupSize = shaderData.reflection.workgroupSize.value();
 
-    mGuidingEMPass.pipeline = makeUnique<vulkan::ComputePipeline>({
+    auto pipeline = makeUnique<vulkan::ComputePipeline>({
         .device = mDevice,
-        .layout = *mGuidingEMPass.pipelineLayout,
+        .layout = *pipelineLayout,
         .shader = *shaderData.shader,
     });
+
+    update.set(mGuidingEMPass.pipelineLayout, std::move(pipelineLayout));
+    update.set(mGuidingEMPass.pipeline, std::move(pipeline));
+    update.set(mGuidingEMPass.workgroupSize,
+               shaderData.reflection.workgroupSize.value());
   }
+
+  return update;
 }
 
 void GuidedPathTracerPass::setInput(const Input& input) {
-  vulkan::DescriptorSet::Resources resources;
-
-  resources.images[0][0] = {
-      .sampler = VK_NULL_HANDLE,
-      .imageView = mOutputImage->getView().vkHandle(),
-      .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
-  };
-
-  resources.images[1][0] = {
-      .sampler = mSampler->vkHandle(),
-      .imageView = input.gPosition.getView().vkHandle(),
-      .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+  const Descriptors descriptors{
+      .outputImage = vulkan::getStorageImageInfo(*mOutputImage),
+      .gPosition = vulkan::getSampledImageInfo(input.gPosition, *mSampler),
+      .gNormal = vulkan::getSampledImageInfo(input.gNormal, *mSampler),
+      .gAlbedo = vulkan::getSampledImageInfo(input.gAlbedo, *mSampler),
+      .gEmissive = vulkan::getSampledImageInfo(input.gEmissive, *mSampler),
   };
-  resources.images[2][0] = {
-      .sampler = mSampler->vkHandle(),
-      .imageView = input.gNormal.getView().vkHandle(),
-      .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-  };
-  resources.images[3][0] = {
-      .sampler = mSampler->vkHandle(),
-      .imageView = input.gAlbedo.getView().vkHandle(),
-      .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-  };
-  resources.images[4][0] = {
-      .sampler = mSampler->vkHandle(),
-      .imageView = input.gEmissive.getView().vkHandle(),
-      .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-  };
-
-  mDescriptors.set->update(resources);
+  mDescriptors.set->write([this, descriptors](const auto& set) {
+    mDescriptors.updateTemplate->update(set, &descriptors);
+  });
 }
 
-void GuidedPathTracerPass::resize(uint32_t width, uint32_t height) {
-  mOutputImage = makeUnique<vulkan::Image>({
+PipelineUpdate GuidedPathTracerPass::resize(uint32_t width, uint32_t height) {
+  auto outputImage = makeUnique<vulkan::Image>({
       .device = mDevice,
       .format = VK_FORMAT_R32G32B32A32_SFLOAT,
       .extent = {width, height, 1},
@@ -240,111 +252,208 @@ void GuidedPathTracerPass::resize(uint32_t width, uint32_t height) {
       .memoryUsage = VMA_MEMORY_USAGE_GPU_ONLY,
   });
 
-  mDevice.submitAndWait([&](const auto& commandBuffer) {
-    commandBuffer.transitionImageLayout(*mOutputImage,
-                                        VK_IMAGE_LAYOUT_UNDEFINED,
-                                        VK_IMAGE_LAYOUT_GENERAL,
-                                        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-                                        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+  mDevice.getImmediateContext().record([&](const auto& commandBuffer) {
+    vulkan::BarrierBatch{commandBuffer}.image(
+        *outputImage, vulkan::access::kNone, vulkan::access::kComputeWrite);
   });
 
   // Buffers that depend on the resolution
 
-  mNumGuidingSamples = width * height * PATH_TRACER_MAX_BOUNCES;
+  uint32_t numGuidingSamples = width * height * PATH_TRACER_MAX_BOUNCES;
 
-  mBuffers.guidingSamples = makeUnique<vulkan::Buffer>({
+  auto guidingSamples = makeUnique<vulkan::Buffer>({
       .device = mDevice,
-      .size = mNumGuidingSamples * sizeof(GuidingSample),
+      .size = numGuidingSamples * sizeof(GuidingSample),
       .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
                VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT |
                VK_BUFFER_USAGE_TRANSFER_DST_BIT,
       .memoryUsage = VMA_MEMORY_USAGE_GPU_ONLY,
   });
 
-  mBuffers.cellIndices = makeUnique<vulkan::Buffer>({
+  auto cellIndices = makeUnique<vulkan::Buffer>({
       .device = mDevice,
-      .size = mNumGuidingSamples * sizeof(uint32_t),
+      .size = numGuidingSamples * sizeof(uint32_t),
       .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
                VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT |
                VK_BUFFER_USAGE_TRANSFER_DST_BIT,
       .memoryUsage = VMA_MEMORY_USAGE_GPU_ONLY,
   });
+
+  PipelineUpdate update;
+  update.set(mOutputImage, std::move(outputImage));
+  update.set(mNumGuidingSamples, numGuidingSamples);
+  update.set(mBuffers.guidingSamples, std::move(guidingSamples));
+  update.set(mBuffers.cellIndices, std::move(cellIndices));
+  return update;
 }
 
 void GuidedPathTracerPass::execute(const vulkan::CommandBuffer& commandBuffer,
                                    vulkan::RenderFrame& currentFrame) {
   RECORE_GPU_PROFILE_SCOPE(
       currentFrame, commandBuffer, "GuidedPathTracer::execute");
+  acquireBuffers(commandBuffer);
+
   // Perpare buffers, zero initialize per frame
   prepareBuffers(commandBuffer, currentFrame);
 
-  commandBuffer.memoryBarrier(
-      VK_ACCESS_MEMORY_WRITE_BIT | VK_ACCESS_MEMORY_READ_BIT,
-      VK_ACCESS_MEMORY_WRITE_BIT | VK_ACCESS_MEMORY_READ_BIT,
-      VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-      VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
-
-  commandBuffer.transitionImageLayout(*mOutputImage,
-                                      VK_IMAGE_LAYOUT_UNDEFINED,
-                                      VK_IMAGE_LAYOUT_GENERAL,
-                                      VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-                                      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+  // The guiding mixture of the last training is read by the path tracer
+  vulkan::BarrierBatch{commandBuffer}.memory(
+      vulkan::access::kComputeWrite, vulkan::access::kComputeReadWrite);
 
   // Run path tracer
   executePathTracer(commandBuffer, currentFrame);
 
-  if (mSettings.train) {
-    RECORE_GPU_PROFILE_SCOPE(
-        currentFrame, commandBuffer, "GuidedPathTracer::Guiding");
-    commandBuffer.memoryBarrier(
-        VK_ACCESS_MEMORY_WRITE_BIT | VK_ACCESS_MEMORY_READ_BIT,
-        VK_ACCESS_MEMORY_WRITE_BIT | VK_ACCESS_MEMORY_READ_BIT,
-        VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-        VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
-
-    computeCellCounterPrefixSum(commandBuffer, currentFrame);
-    prepareGuidingIndices(commandBuffer, currentFrame);
-
-    commandBuffer.memoryBarrier(
-        VK_ACCESS_MEMORY_WRITE_BIT | VK_ACCESS_MEMORY_READ_BIT,
-        VK_ACCESS_MEMORY_WRITE_BIT | VK_ACCESS_MEMORY_READ_BIT,
-        VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-        VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
-
-    updateGuidingMixture(commandBuffer, currentFrame);
+  if (!mSettings.train) {
+    return;
+  }
+
+  if (mTrainingQueue != nullptr) {
+    mReleasedBuffers = getGuidingBuffers();
+    transferBuffers(commandBuffer,
+                    mReleasedBuffers,
+                    mDevice.getGraphicsQueue().getFamilyIndex(),
+                    mTrainingQueueFamilyIndex);
+    mBufferOwnership = BufferOwnership::ReleasedToTraining;
+  } else {
+    train(commandBuffer, currentFrame);
   }
 }
 
-void GuidedPathTracerPass::resetGrid() {
-  mDevice.submitAndWait([&](const auto& commandBuffer) {
-    commandBuffer.fillBuffer(*mBuffers.hashGrid);
-    commandBuffer.fillBuffer(*mBuffers.vmms);
-  });
+void GuidedPathTracerPass::executeTraining(
+    const vulkan::CommandBuffer& commandBuffer,
+    vulkan::RenderFrame& currentFrame) {
+  if (mBufferOwnership != BufferOwnership::ReleasedToTraining) {
+    return;
+  }
+
+  const auto graphicsQueueFamilyIndex =
+      mDevice.getGraphicsQueue().getFamilyIndex();
+  transferBuffers(commandBuffer,
+                  getReleasedBuffers(),
+                  graphicsQueueFamilyIndex,
+                  mTrainingQueueFamilyIndex);
+
+  train(commandBuffer, currentFrame);
+
+  mReleasedBuffers = getGuidingBuffers();
+  transferBuffers(commandBuffer,
+                  mReleasedBuffers,
+                  mTrainingQueueFamilyIndex,
+                  graphicsQueueFamilyIndex);
+  mBufferOwnership = BufferOwnership::ReleasedToGraphics;
+  mReleasedQueueFamilyIndex = mTrainingQueueFamilyIndex;
+}
+
+void GuidedPathTracerPass::setTrainingQueue(const vulkan::Queue* queue) {
+  // Only execute() acquires, its frame waits for the release on the training
+  // queue. Buffers released but never acquired by the training queue are
+  // still usable on graphics.
+  if (mBufferOwnership == BufferOwnership::ReleasedToTraining) {
+    mBufferOwnership = BufferOwnership::Graphics;
+    mReleasedBuffers.clear();
+  }
+
+  mTrainingQueue = queue;
+  if (queue != nullptr) {
+    mTrainingQueueFamilyIndex = queue->getFamilyIndex();
+  }
+}
+
+void GuidedPathTracerPass::train(const vulkan::CommandBuffer& commandBuffer,
+                                 vulkan::RenderFrame& currentFrame) {
+  RECORE_GPU_PROFILE_SCOPE(
+      currentFrame, commandBuffer, "GuidedPathTracer::Guiding");
+  // Cell counters of the path tracer are copied first, the following
+  // dispatches are ordered by the barriers of the training steps
+  vulkan::BarrierBatch{commandBuffer}.buffer(*mBuffers.cellCounters,
+                                             vulkan::access::kComputeWrite,
+                                             vulkan::access::kTransferRead);
+
+  computeCellCounterPrefixSum(commandBuffer, currentFrame);
+  prepareGuidingIndices(commandBuffer, currentFrame);
+  updateGuidingMixture(commandBuffer, currentFrame);
+}
+
+std::vector<const vulkan::Buffer*> GuidedPathTracerPass::getGuidingBuffers()
+    const {
+  return {&*mBuffers.hashGrid,
+          &*mBuffers.vmms,
+          &*mBuffers.guidingSamples,
+          &*mBuffers.cellCounters,
+          &*mBuffers.cellCountersPrefix,
+          &*mBuffers.cellPrefixSums,
+          &*mBuffers.cellIndices};
+}
+
+std::vector<const vulkan::Buffer*> GuidedPathTracerPass::getReleasedBuffers()
+    const {
+  // Replaced buffers are destroyed with a later frame, so a new buffer never
+  // has the address of a released one still listed here
+  std::vector<const vulkan::Buffer*> buffers;
+  for (const auto* buffer : getGuidingBuffers()) {
+    if (std::ranges::contains(mReleasedBuffers, buffer)) {
+      buffers.push_back(buffer);
+    }
+  }
+  return buffers;
+}
+
+void GuidedPathTracerPass::transferBuffers(
+    const vulkan::CommandBuffer& commandBuffer,
+    const std::vector<const vulkan::Buffer*>& buffers,
+    uint32_t srcQueueFamilyIndex,
+    uint32_t dstQueueFamilyIndex) const {
+  constexpr vulkan::Access kGuidingAccess{
+      VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+      vulkan::access::kComputeReadWrite.access |
+          VK_ACCESS_2_TRANSFER_READ_BIT | VK_ACCESS_2_TRANSFER_WRITE_BIT,
+  };
+
+  vulkan::BarrierBatch barriers{commandBuffer};
+  for (const auto* buffer : buffers) {
+    barriers.transferOwnership(*buffer,
+                               srcQueueFamilyIndex,
+                               dstQueueFamilyIndex,
+                               kGuidingAccess,
+                               kGuidingAccess);
+  }
+}
+
+void GuidedPathTracerPass::acquireBuffers(
+    const vulkan::CommandBuffer& commandBuffer) {
+  if (mBufferOwnership != BufferOwnership::ReleasedToGraphics) {
+    return;
+  }
+  transferBuffers(commandBuffer,
+                  getReleasedBuffers(),
+                  mReleasedQueueFamilyIndex,
+                  mDevice.getGraphicsQueue().getFamilyIndex());
+  mBufferOwnership = BufferOwnership::Graphics;
+  mReleasedBuffers.clear();
 }
 
 void GuidedPathTracerPass::prepareBuffers(
     const vulkan::CommandBuffer& commandBuffer,
-    vulkan::RenderFrame& currentFrame) const {
+    vulkan::RenderFrame& currentFrame) {
   RECORE_GPU_PROFILE_SCOPE(
       currentFrame, commandBuffer, "GuidedPathTracerPass::prepareBuffers");
 
-  commandBuffer.memoryBarrier(
-      VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT,
-      VK_ACCESS_TRANSFER_WRITE_BIT,
-      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-      VK_PIPELINE_STAGE_TRANSFER_BIT);
+  vulkan::BarrierBatch{commandBuffer}.memory(vulkan::access::kComputeWrite,
+                                             vulkan::access::kTransferWrite);
 
   commandBuffer.fillBuffer(*mBuffers.guidingSamples);
   commandBuffer.fillBuffer(*mBuffers.cellCounters);
   commandBuffer.fillBuffer(*mBuffers.cellCountersPrefix);
   commandBuffer.fillBuffer(*mBuffers.cellPrefixSums);
   commandBuffer.fillBuffer(*mBuffers.cellIndices);
+  if (mResetGrid) {
+    commandBuffer.fillBuffer(*mBuffers.hashGrid);
+    commandBuffer.fillBuffer(*mBuffers.vmms);
+    mResetGrid = false;
+  }
 
-  commandBuffer.memoryBarrier(
-      VK_ACCESS_TRANSFER_WRITE_BIT,
-      VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT,
-      VK_PIPELINE_STAGE_TRANSFER_BIT,
-      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+  vulkan::BarrierBatch{commandBuffer}.memory(
+      vulkan::access::kTransferWrite, vulkan::access::kComputeReadWrite);
 }
 
 void GuidedPathTracerPass::executePathTracer(
@@ -371,7 +480,7 @@ void GuidedPathTracerPass::executePathTracer(
 
   commandBuffer.bindPipeline(*mPipeline);
   commandBuffer.bindDescriptorSet(*mPipeline, mScene.getDescriptorSet(), 0);
-  commandBuffer.bindDescriptorSet(*mPipeline, *mDescriptors.set, 1);
+  commandBuffer.bindDescriptorSet(*mPipeline, mDescriptors.set->get(), 1);
 
   commandBuffer.pushConstants(*mPipelineLayout, p);
 
@@ -393,23 +502,16 @@ void GuidedPathTracerPass::computeCellCounterPrefixSum(
   commandBuffer.copyBufferToBuffer(*mBuffers.cellCounters,
                                    *mBuffers.cellPrefixSums);
 
-  commandBuffer.memoryBarrier(
-      VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_TRANSFER_READ_BIT,
-      VK_ACCESS_SHADER_READ_BIT,
-      VK_PIPELINE_STAGE_TRANSFER_BIT,
-      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
-
-  commandBuffer.memoryBarrier(VK_ACCESS_SHADER_WRITE_BIT,
-                              VK_ACCESS_SHADER_READ_BIT,
-                              VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-                              VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+  // The prefix sum runs in place on the copy
+  vulkan::BarrierBatch{commandBuffer}.buffer(
+      *mBuffers.cellPrefixSums,
+      vulkan::access::kTransferWrite,
+      vulkan::access::kComputeReadWrite);
 
   mPrefixSumPass->execute(commandBuffer, currentFrame);
 
-  commandBuffer.memoryBarrier(VK_ACCESS_SHADER_WRITE_BIT,
-                              VK_ACCESS_SHADER_READ_BIT,
-                              VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-                              VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+  vulkan::BarrierBatch{commandBuffer}.memory(vulkan::access::kComputeWrite,
+                                             vulkan::access::kComputeRead);
 }
 
 void GuidedPathTracerPass::prepareGuidingIndices(
@@ -446,10 +548,8 @@ void GuidedPathTracerPass::updateGuidingMixture(
                            commandBuffer,
                            "GuidedPathTracerPass::updateGuidingMixture");
 
-  commandBuffer.memoryBarrier(VK_ACCESS_SHADER_WRITE_BIT,
-                              VK_ACCESS_SHADER_READ_BIT,
-                              VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-                              VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+  vulkan::BarrierBatch{commandBuffer}.memory(vulkan::access::kComputeWrite,
+                                             vulkan::access::kComputeRead);
 
   GuidingEMPush p{
       .hashGrid = mHashGrid,
@@ -9,6 +9,8 @@
 
 #include <recore/shaders/hashgrid.glslh>
 
+#include <vector>
+
 namespace recore::passes {
 
 struct GuidingPathTracerSettings {
@@ -22,9 +24,12 @@ class GuidedPathTracerPass : public Pass {
   explicit GuidedPathTracerPass(const vulkan::Device& device,
                                 const scene::GPUScene& scene);
 
-  void reloadShaders(vulkan::ShaderLibrary& shaderLibrary) override;
+  void registerShaders(vulkan::ShaderLibrary& shaderLibrary) override;
+
+  [[nodiscard]] PipelineUpdate createPipelines(
+      vulkan::ShaderLibrary& shaderLibrary) override;
 
-  void resize(uint32_t width, uint32_t height) override;
+  [[nodiscard]] PipelineUpdate resize(uint32_t width, uint32_t height) override;
 
   void execute(const vulkan::CommandBuffer& commandBuffer,
                vulkan::RenderFrame& currentFrame) override;
@@ -44,11 +49,28 @@ class GuidedPathTracerPass : public Pass {
 
   [[nodiscard]] GuidingPathTracerSettings& settings() { return mSettings; }
 
-  void resetGrid();
+  // Clears the guiding mixtures in the next execute(), after the training of
+  // the last frame on whichever queue it ran
+  void resetGrid() { mResetGrid = true; }
+
+  // Trains with executeTraining() on the given queue, e.g. the async compute
+  // queue, instead of at the end of execute(). Null trains inline again.
+  // Buffers released by the previous queue are acquired in the next
+  // execute().
+  void setTrainingQueue(const vulkan::Queue* queue);
+
+  [[nodiscard]] bool hasTrainingQueue() const {
+    return mTrainingQueue != nullptr;
+  }
+
+  // Guiding update from the samples of the last execute(), recorded for the
+  // training queue. The buffers are moved between the queue families.
+  void executeTraining(const vulkan::CommandBuffer& commandBuffer,
+                       vulkan::RenderFrame& currentFrame);
 
  private:
   void prepareBuffers(const vulkan::CommandBuffer& commandBuffer,
-                      vulkan::RenderFrame& currentFrame) const;
+                      vulkan::RenderFrame& currentFrame);
 
   void executePathTracer(const vulkan::CommandBuffer& commandBuffer,
                          vulkan::RenderFrame& currentFrame);
@@ -62,12 +84,40 @@ class GuidedPathTracerPass : public Pass {
   void updateGuidingMixture(const vulkan::CommandBuffer& commandBuffer,
                             vulkan::RenderFrame& currentFrame) const;
 
+  void train(const vulkan::CommandBuffer& commandBuffer,
+             vulkan::RenderFrame& currentFrame);
+
+  // Everything the path tracer and the training read and write
+  [[nodiscard]] std::vector<const vulkan::Buffer*> getGuidingBuffers() const;
+
+  // Of the buffers released to another queue the ones still in use. Buffers
+  // replaced since, e.g. on resize, were never released.
+  [[nodiscard]] std::vector<const vulkan::Buffer*> getReleasedBuffers() const;
+
+  void transferBuffers(const vulkan::CommandBuffer& commandBuffer,
+                       const std::vector<const vulkan::Buffer*>& buffers,
+                       uint32_t srcQueueFamilyIndex,
+                       uint32_t dstQueueFamilyIndex) const;
+
+  // Acquires the buffers the training queue released, if it did
+  void acquireBuffers(const vulkan::CommandBuffer& commandBuffer);
+
   const scene::GPUScene& mScene;
 
+  // Set 1 in binding order, written with the update template
+  struct Descriptors {
+    VkDescriptorImageInfo outputImage;
+    VkDescriptorImageInfo gPosition;
+    VkDescriptorImageInfo gNormal;
+    VkDescriptorImageInfo gAlbedo;
+    VkDescriptorImageInfo gEmissive;
+  };
+
   struct {
     uPtr<vulkan::DescriptorPool> pool;
     uPtr<vulkan::DescriptorSetLayout> layout;
-    uPtr<vulkan::DescriptorSet> set;
+    uPtr<FrameDescriptorSet> set;
+    uPtr<vulkan::DescriptorUpdateTemplate> updateTemplate;
   } mDescriptors;
 
   HashGrid mHashGrid = {
@@ -110,6 +160,21 @@ class GuidedPathTracerPass : public Pass {
   } mGuidingEMPass;
 
   GuidingPathTracerSettings mSettings;
+
+  const vulkan::Queue* mTrainingQueue{nullptr};
+  uint32_t mTrainingQueueFamilyIndex{0};
+  // Of the queue that released the buffers to graphics, the training queue
+  // may have changed since
+  uint32_t mReleasedQueueFamilyIndex{0};
+  bool mResetGrid{false};
+
+  // Buffer ownership between releasing them to a queue and acquiring there
+  enum class BufferOwnership {
+    Graphics,
+    ReleasedToTraining,
+    ReleasedToGraphics,
+  } mBufferOwnership{BufferOwnership::Graphics};
+  std::vector<const vulkan::Buffer*> mReleasedBuffers;
 };
 
 }  // namespace recore::passes
@@ -7,7 +7,10 @@
 #include <recore/shaders/hashgrid.glsl>
 #include <recore/shaders/vmm.glsl>
 
-layout(local_size_x = 64, local_size_y = 1, local_size_z = 1) in;
+#include <recore/shaders/workgroup_size.glslh>
+
+layout(local_size_x = 64, local_size_y = 1, local_size_z = 1,
+       local_size_x_id = WORKGROUP_SIZE_X_ID) in;
 
 PUSH_CONSTANT(GuidingEMPush);
 
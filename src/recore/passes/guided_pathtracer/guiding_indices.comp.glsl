@@ -4,7 +4,10 @@
 
 #include "guiding.glslh"
 
-layout(local_size_x = 32, local_size_y = 1, local_size_z = 1) in;
+#include <recore/shaders/workgroup_size.glslh>
+
+layout(local_size_x = 32, local_size_y = 1, local_size_z = 1,
+       local_size_x_id = WORKGROUP_SIZE_X_ID) in;
 
 PUSH_CONSTANT(GuidingIndicesPush);
 
@@ -138,10 +138,19 @@ LightPropagationVolumePass::LightPropagationVolumePass(
   }
 }
 
-void LightPropagationVolumePass::reloadShaders(
+void LightPropagationVolumePass::registerShaders(
     vulkan::ShaderLibrary& shaderLibrary) {
+  requestShader(shaderLibrary, kInjectLightShader);
+  requestShader(shaderLibrary, kInjectGeometryShader);
+  requestShader(shaderLibrary, kPropagationShader);
+}
+
+PipelineUpdate LightPropagationVolumePass::createPipelines(
+    vulkan::ShaderLibrary& shaderLibrary) {
+  PipelineUpdate update;
+
   {  // Inject light pass
-    mInjectLightPass.pipelineLayout = makeUnique<vulkan::PipelineLayout>({
+    auto pipelineLayout = makeUnique<vulkan::PipelineLayout>({
         .device = mDevice,
         .descriptorSetLayouts = {&*mLightDescriptors.layout},
         .pushConstants = {{.stageFlags = VK_SHADER_STAGE_ALL,
@@ -149,17 +158,20 @@ void LightPropagationVolumePass::reloadShaders(
     });
 
     const auto& shaderData = shaderLibrary.loadShader(kInjectLightShader);
-    mInjectLightPass.pipeline = makeUnique<vulkan::ComputePipeline>({
+    auto pipeline = makeUnique<vulkan::ComputePipeline>({
         .device = mDevice,
-        .layout = *mInjectLightPass.pipelineLayout,
+        .layout = *pipelineLayout,
         .shader = *shaderData.shader,
     });
-    mInjectLightPass.workgroupSize =
-        shaderData.reflection.workgroupSize.value();
+
+    update.set(mInjectLightPass.pipelineLayout, std::move(pipelineLayout));
+    update.set(mInjectLightPass.pipeline, std::move(pipeline));
+    update.set(mInjectLightPass.workgroupSize,
+               shaderData.reflection.workgroupSize.value());
   }
 
   {  // Inject geometry pass
-    mInjectGeometryPass.pipelineLayout = makeUnique<vulkan::PipelineLayout>({
+    auto pipelineLayout = makeUnique<vulkan::PipelineLayout>({
         .device = mDevice,
         .descriptorSetLayouts = {&*mOccluderDescriptors.layout},
         .pushConstants = {{.stageFlags = VK_SHADER_STAGE_ALL,
@@ -167,17 +179,20 @@ void LightPropagationVolumePass::reloadShaders(
     });
 
     const auto& shaderData = shaderLibrary.loadShader(kInjectGeometryShader);
-    mInjectGeometryPass.pipeline = makeUnique<vulkan::ComputePipeline>({
+    auto pipeline = makeUnique<vulkan::ComputePipeline>({
         .device = mDevice,
-        .layout = *mInjectGeometryPass.pipelineLayout,
+        .layout = *pipelineLayout,
         .shader = *shaderData.shader,
     });
-    mInjectGeometryPass.workgroupSize =
-        shaderData.reflection.workgroupSize.value();
+
+    update.set(mInjectGeometryPass.pipelineLayout, std::move(pipelineLayout));
+    update.set(mInjectGeometryPass.pipeline, std::move(pipeline));
+    update.set(mInjectGeometryPass.workgroupSize,
+               shaderData.reflection.workgroupSize.value());
   }
 
   {  // Propagation pass
-    mPropagationPass.pipelineLayout = makeUnique<vulkan::PipelineLayout>({
+    auto pipelineLayout = makeUnique<vulkan::PipelineLayout>({
         .device = mDevice,
         .descriptorSetLayouts = {},
         .pushConstants = {{.stageFlags = VK_SHADER_STAGE_ALL,
@@ -185,14 +200,19 @@ void LightPropagationVolumePass::reloadShaders(
     });
 
     const auto& shaderData = shaderLibrary.loadShader(kPropagationShader);
-    mPropagationPass.pipeline = makeUnique<vulkan::ComputePipeline>({
+    auto pipeline = makeUnique<vulkan::ComputePipeline>({
         .device = mDevice,
-        .layout = *mPropagationPass.pipelineLayout,
+        .layout = *pipelineLayout,
         .shader = *shaderData.shader,
     });
-    mPropagationPass.workgroupSize =
-        shaderData.reflection.workgroupSize.value();
+
+    update.set(mPropagationPass.pipelineLayout, std::move(pipelineLayout));
+    update.set(mPropagationPass.pipeline, std::move(pipeline));
+    update.set(mPropagationPass.workgroupSize,
+               shaderData.reflection.workgroupSize.value());
   }
+
+  return update;
 }
 
 void LightPropagationVolumePass::setRSM(const RSM& rsm) {
@@ -257,20 +277,15 @@ void LightPropagationVolumePass::execute(
     return;
   }
 
-  commandBuffer.memoryBarrier(
-      VK_ACCESS_MEMORY_WRITE_BIT | VK_ACCESS_MEMORY_READ_BIT,
-      VK_ACCESS_MEMORY_WRITE_BIT | VK_ACCESS_MEMORY_READ_BIT,
-      VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-      VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+  // Injection accumulates into the cleared volumes
+  vulkan::BarrierBatch{commandBuffer}.memory(
+      vulkan::access::kTransferWrite, vulkan::access::kComputeReadWrite);
 
   injectLight(commandBuffer, currentFrame);
   injectGeometry(commandBuffer, currentFrame);
 
-  commandBuffer.memoryBarrier(
-      VK_ACCESS_MEMORY_WRITE_BIT | VK_ACCESS_MEMORY_READ_BIT,
-      VK_ACCESS_MEMORY_WRITE_BIT | VK_ACCESS_MEMORY_READ_BIT,
-      VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-      VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+  vulkan::BarrierBatch{commandBuffer}.memory(
+      vulkan::access::kComputeWrite, vulkan::access::kComputeReadWrite);
 
   propagate(commandBuffer, currentFrame);
 }
@@ -338,11 +353,8 @@ void LightPropagationVolumePass::propagate(
   for (uint32_t i = 0; i < mSettings.numIterations; i++) {
     p.iteration = i;
 
-    commandBuffer.memoryBarrier(
-        VK_ACCESS_MEMORY_WRITE_BIT | VK_ACCESS_MEMORY_READ_BIT,
-        VK_ACCESS_MEMORY_WRITE_BIT | VK_ACCESS_MEMORY_READ_BIT,
-        VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-        VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+    vulkan::BarrierBatch{commandBuffer}.memory(
+        vulkan::access::kComputeWrite, vulkan::access::kComputeReadWrite);
 
     commandBuffer.pushConstants(*mPropagationPass.pipelineLayout, p);
 
@@ -358,11 +370,15 @@ void LightPropagationVolumePass::propagate(
     std::swap(p.lpvGrid.volume, p.lpvGrid.volumeSwap);
   }
 
-  commandBuffer.memoryBarrier(
-      VK_ACCESS_MEMORY_WRITE_BIT | VK_ACCESS_MEMORY_READ_BIT,
-      VK_ACCESS_MEMORY_WRITE_BIT | VK_ACCESS_MEMORY_READ_BIT,
-      VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-      VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+  // Volumes are sampled by the shading of any kind of pass
+  constexpr vulkan::Access kVolumeRead{
+      VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT |
+          VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT |
+          VK_PIPELINE_STAGE_2_RAY_TRACING_SHADER_BIT_KHR,
+      VK_ACCESS_2_SHADER_STORAGE_READ_BIT,
+  };
+  vulkan::BarrierBatch{commandBuffer}.memory(vulkan::access::kComputeWrite,
+                                             kVolumeRead);
 }
 
 }  // namespace recore::passes
@@ -18,7 +18,10 @@ class LightPropagationVolumePass : public Pass {
   explicit LightPropagationVolumePass(const vulkan::Device& device,
                                       const scene::Scene& scene);
 
-  void reloadShaders(vulkan::ShaderLibrary& shaderLibrary) override;
+  void registerShaders(vulkan::ShaderLibrary& shaderLibrary) override;
+
+  [[nodiscard]] PipelineUpdate createPipelines(
+      vulkan::ShaderLibrary& shaderLibrary) override;
 
   void execute(const vulkan::CommandBuffer& commandBuffer,
                vulkan::RenderFrame& currentFrame) override;
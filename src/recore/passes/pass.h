@@ -2,8 +2,11 @@
 
 #include <recore/core/base.h>
 
+#include <recore/vulkan/api/barrier.h>
+#include <recore/vulkan/api/bindless.h>
 #include <recore/vulkan/api/buffer.h>
 #include <recore/vulkan/api/command.h>
+#include <recore/vulkan/api/descriptor.h>
 #include <recore/vulkan/api/device.h>
 #include <recore/vulkan/api/image.h>
 #include <recore/vulkan/api/pipeline.h>
@@ -14,23 +17,164 @@
 
 #include <recore/vulkan/context.h>
 
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <unordered_set>
+
 namespace recore::passes {
 
+// Objects of a pass that are replaced while frames are in flight, e.g.
+// pipelines created off the render thread during hot reload or images created
+// on resize. commit() swaps them into the pass between two frames.
+class PipelineUpdate {
+ public:
+  template <typename T, typename U>
+  void set(uPtr<T>& target, uPtr<U>&& value) {
+    auto staged = makeShared<uPtr<T>>(std::move(value));
+    mCommits.emplace_back([&target, staged](vulkan::RenderFrame* frame) {
+      std::swap(target, *staged);
+      if (frame != nullptr && *staged != nullptr) {
+        frame->deferDestroy(std::move(*staged));
+      }
+    });
+  }
+
+  template <typename T>
+  void set(T& target, const T& value) {
+    mCommits.emplace_back(
+        [&target, value](vulkan::RenderFrame*) { target = value; });
+  }
+
+  void append(PipelineUpdate&& other) {
+    std::ranges::move(other.mCommits, std::back_inserter(mCommits));
+    other.mCommits.clear();
+  }
+
+  // Replaced objects are retired into the frame, which destroys them once the
+  // GPU finished it. Without a frame they are destroyed right away, so the
+  // device has to be idle.
+  void commit(vulkan::RenderFrame* frame = nullptr) {
+    for (auto& commit : mCommits) {
+      commit(frame);
+    }
+    mCommits.clear();
+  }
+
+ private:
+  std::vector<std::function<void(vulkan::RenderFrame*)>> mCommits;
+};
+
+// Descriptor set of a pass whose resources are replaced while frames are in
+// flight, e.g. on resize. A write is staged and applied to the next of
+// several sets when a frame records the pass, so a set is only rewritten
+// once the frames reading it retired.
+class FrameDescriptorSet : public NoCopyMove {
+ public:
+  // One more than frames can be in flight
+  static constexpr uint32_t kSetCount =
+      vulkan::RenderContext::kMaxFramesInFlight + 1;
+
+  struct Desc {
+    const vulkan::Device& device;
+    // With room for kSetCount sets
+    const vulkan::DescriptorPool& pool;
+    const vulkan::DescriptorSetLayout& layout;
+  };
+
+  using Writer = std::function<void(const vulkan::DescriptorSet& set)>;
+
+  explicit FrameDescriptorSet(const Desc& desc) {
+    for (auto& set : mSets) {
+      set = makeUnique<vulkan::DescriptorSet>({
+          .device = desc.device,
+          .pool = desc.pool,
+          .layout = desc.layout,
+      });
+    }
+  }
+
+  // Replaces a write that was not applied yet
+  void write(Writer&& writer) { mPendingWrite = std::move(writer); }
+
+  // Set to bind in the frame being recorded. Writes must not be staged
+  // between two calls in the same frame.
+  [[nodiscard]] const vulkan::DescriptorSet& get() {
+    if (mPendingWrite) {
+      mCurrent = (mCurrent + 1) % kSetCount;
+      mPendingWrite(*mSets[mCurrent]);
+      mPendingWrite = nullptr;
+    }
+    return *mSets[mCurrent];
+  }
+
+ private:
+  std::array<uPtr<vulkan::DescriptorSet>, kSetCount> mSets;
+  uint32_t mCurrent{0};
+  Writer mPendingWrite;
+};
+
 class Pass : public NoCopyMove {
  public:
   explicit Pass(const vulkan::Device& device) : mDevice{device} {}
 
   virtual ~Pass() = default;
 
-  virtual void resize(uint32_t width, uint32_t height) {}
+  // Creates the resolution dependent resources, their initial layout
+  // transitions are recorded into the device's immediate context
+  [[nodiscard]] virtual PipelineUpdate resize(uint32_t width,
+                                              uint32_t height) {
+    return {};
+  }
+
+  // Requests all shaders of the pass, so they compile in the background
+  // before reloadShaders() loads them
+  virtual void registerShaders(vulkan::ShaderLibrary& shaderLibrary) {}
 
-  virtual void reloadShaders(vulkan::ShaderLibrary& shaderLibrary) {}
+  // Creates the pipelines of the pass from the requested shaders. Must not
+  // modify anything execute() uses, hot reload calls it on a background thread
+  // while the pass keeps rendering with its current pipelines.
+  [[nodiscard]] virtual PipelineUpdate createPipelines(
+      vulkan::ShaderLibrary& shaderLibrary) {
+    return {};
+  }
+
+  // Synchronous createPipelines(). Replaced pipelines are retired into the
+  // frame, without one the device has to be idle.
+  void reloadShaders(vulkan::ShaderLibrary& shaderLibrary,
+                     vulkan::RenderFrame* frame = nullptr) {
+    createPipelines(shaderLibrary).commit(frame);
+  }
 
   virtual void execute(const vulkan::CommandBuffer& commandBuffer,
                        vulkan::RenderFrame& frame) = 0;
 
+  // True if one of the shaders requested in registerShaders() is in names.
+  // Used to only rebuild the pipelines of passes affected by a hot reload.
+  [[nodiscard]] bool usesShaders(
+      const std::unordered_set<std::string>& names) const {
+    return std::ranges::any_of(mShaderNames, [&](const auto& name) {
+      return names.contains(name);
+    });
+  }
+
  protected:
+  void requestShader(vulkan::ShaderLibrary& shaderLibrary,
+                     const std::filesystem::path& path) {
+    requestShader(shaderLibrary, {.path = path});
+  }
+
+  // Requests a permutation, load it with the same LoadData
+  void requestShader(vulkan::ShaderLibrary& shaderLibrary,
+                     const vulkan::ShaderLibrary::LoadData& loadData) {
+    mShaderNames.insert(loadData.getName());
+    shaderLibrary.requestShaderSource(loadData);
+  }
+
   const vulkan::Device& mDevice;
+
+ private:
+  std::unordered_set<std::string> mShaderNames;
 };
 
 }  // namespace recore::passes
@@ -0,0 +1,119 @@
+#include "pass_group.h"
+
+#include <chrono>
+#include <format>
+#include <iostream>
+
+namespace recore::passes {
+
+PassGroup::PassGroup(const Desc& desc)
+    : mDevice{desc.device},
+      mShaderLibrary{desc.shaderLibrary},
+      mResolution{desc.resolution} {}
+
+void PassGroup::build(const std::function<void()>& addPasses) {
+  finishReload();
+
+  auto startTime = std::chrono::high_resolution_clock::now();
+  auto pipelineStatistics = mDevice.getPipelineCache().getStatistics();
+
+  mPasses.clear();
+  addPasses();
+
+  // All shaders compile in parallel, loading them waits for the results
+  for (auto& pass : mPasses) {
+    pass->reloadShaders(mShaderLibrary);
+  }
+
+  // Startup profile, shader compilation is part of the pass build time
+  std::chrono::duration<double, std::milli> buildTime =
+      std::chrono::high_resolution_clock::now() - startTime;
+  auto pipelines =
+      mDevice.getPipelineCache().getStatistics() - pipelineStatistics;
+  std::cout << std::format(
+                   "Built passes in {:.1f} ms, {} pipelines in {:.1f} ms "
+                   "({} pipeline cache)",
+                   buildTime.count(),
+                   pipelines.pipelineCount,
+                   std::chrono::duration<double, std::milli>(
+                       pipelines.creationTime)
+                       .count(),
+                   mDevice.getPipelineCache().isWarm() ? "warm" : "cold")
+            << std::endl;
+}
+
+void PassGroup::update(vulkan::RenderFrame& frame) {
+  if (mPendingReload.valid() &&
+      mPendingReload.wait_for(std::chrono::seconds{0}) ==
+          std::future_status::ready) {
+    mPendingReload.get().commit(&frame);
+  }
+
+  // Workgroup size candidates are swapped in like reloaded shaders
+  if (mWorkgroupSizeTuner != nullptr && !mPendingReload.valid()) {
+    auto retuned = mWorkgroupSizeTuner->update(frame);
+    PipelineUpdate update;
+    for (auto& pass : mPasses) {
+      if (pass->usesShaders(retuned)) {
+        update.append(pass->createPipelines(mShaderLibrary));
+      }
+    }
+    update.commit(&frame);
+  }
+}
+
+void PassGroup::resize(uint32_t width,
+                       uint32_t height,
+                       vulkan::RenderFrame& frame) {
+  finishReload(&frame);
+  mResolution = {width, height};
+
+  // Create all new resources first, their layout transitions are submitted
+  // in one batch with this frame
+  PipelineUpdate update;
+  for (auto& pass : mPasses) {
+    update.append(pass->resize(width, height));
+  }
+
+  // Replaced resources are destroyed after this frame. Frames in flight keep
+  // their descriptor sets, the new inputs go to a FrameDescriptorSet.
+  update.commit(&frame);
+}
+
+void PassGroup::reload() {
+  if (mPendingReload.valid()) {
+    return;  // Still busy with the previous reload
+  }
+
+  mPendingReload = std::async(std::launch::async, [this]() {
+    // Only shaders with changed sources or includes are recompiled, and only
+    // the passes using them rebuild their pipelines
+    PipelineUpdate update;
+    try {
+      auto reloaded = mShaderLibrary.reload();
+      for (auto& pass : mPasses) {
+        if (pass->usesShaders(reloaded)) {
+          update.append(pass->createPipelines(mShaderLibrary));
+        }
+      }
+    } catch (const std::exception& e) {
+      // Keep rendering with the current pipelines
+      std::cerr << e.what() << std::endl;
+      return PipelineUpdate{};
+    }
+    return update;
+  });
+}
+
+void PassGroup::finishReload(vulkan::RenderFrame* frame) {
+  if (mPendingReload.valid()) {
+    mPendingReload.get().commit(frame);
+  }
+}
+
+void PassGroup::tuneWorkgroupSizes() {
+  mWorkgroupSizeTuner = makeUnique<vulkan::WorkgroupSizeTuner>(
+      {.device = mDevice, .shaderLibrary = mShaderLibrary});
+}
+
+}  // namespace recore::passes
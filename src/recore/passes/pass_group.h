@@ -0,0 +1,83 @@
+#pragma once
+
+#include <recore/core/utils.h>
+
+#include <recore/passes/pass.h>
+
+#include <recore/vulkan/workgroup_size_tuner.h>
+
+#include <functional>
+#include <future>
+
+namespace recore::passes {
+
+// Owns the passes of a renderer and swaps their pipelines between frames,
+// after a hot reload, while tuning workgroup sizes and on resize
+class PassGroup : public NoCopyMove {
+ public:
+  struct Desc {
+    const vulkan::Device& device;
+    vulkan::ShaderLibrary& shaderLibrary;
+    core::Resolution resolution;
+  };
+
+  explicit PassGroup(const Desc& desc);
+
+  // Replaces all passes with the ones created by addPasses and loads their
+  // shaders, which compile in parallel. The device has to be idle.
+  void build(const std::function<void()>& addPasses);
+
+  // To be called from addPasses in build(). The pass is owned by the group.
+  template <typename T, typename... Args>
+    requires std::is_base_of_v<Pass, T>
+  [[nodiscard]] T* addPass(Args&&... args) {
+    auto pass = makeUnique<T>(std::forward<Args>(args)...);
+    pass->resize(mResolution.width, mResolution.height).commit();
+    pass->registerShaders(mShaderLibrary);
+    auto* result = &*pass;
+    mPasses.push_back(std::move(pass));
+    return result;
+  }
+
+  // Frame boundary: swaps in the pipelines of a finished reload or a new
+  // workgroup size candidate. The replaced ones are destroyed once this frame
+  // retired.
+  void update(vulkan::RenderFrame& frame);
+
+  // Creates the resources of all passes for the new resolution, replaced ones
+  // are destroyed after the frame
+  void resize(uint32_t width, uint32_t height, vulkan::RenderFrame& frame);
+
+  // Recompiles shaders and rebuilds pipelines on a background thread. The
+  // passes keep rendering with their current pipelines until update() swaps
+  // in the new ones.
+  void reload();
+
+  // Blocks until a running reload is done and installs its pipelines right
+  // away. Replaced ones are retired into the frame, without one the device
+  // has to be idle.
+  void finishReload(vulkan::RenderFrame* frame = nullptr);
+
+  // Tries workgroup sizes for all tunable compute shaders over the next
+  // frames and keeps the fastest ones. Tuning starts once update() swapped in
+  // a running reload.
+  void tuneWorkgroupSizes();
+
+  [[nodiscard]] const vulkan::WorkgroupSizeTuner* getWorkgroupSizeTuner()
+      const {
+    return mWorkgroupSizeTuner.get();
+  }
+
+ private:
+  const vulkan::Device& mDevice;
+  vulkan::ShaderLibrary& mShaderLibrary;
+  core::Resolution mResolution;
+
+  std::vector<uPtr<Pass>> mPasses;
+  uPtr<vulkan::WorkgroupSizeTuner> mWorkgroupSizeTuner;
+
+  // Declared last, so a running reload finishes before the passes go away
+  std::future<PipelineUpdate> mPendingReload;
+};
+
+}  // namespace recore::passes
@@ -22,7 +22,10 @@
 #include "photontracer.glslh"
 
 
-layout(local_size_x = 32, local_size_y = 1, local_size_z = 1) in;
+#include <recore/shaders/workgroup_size.glslh>
+
+layout(local_size_x = 32, local_size_y = 1, local_size_z = 1,
+       local_size_x_id = WORKGROUP_SIZE_X_ID) in;
 
 PUSH_CONSTANT(PhotonTracerPush);
 
@@ -75,7 +78,7 @@ void main() {
 
     Ray ray = Ray(sd.P + sign(dot(wo, sd.N)) * M_EPSILON * sd.N, wo);
     Hit hit;
-    if (!traceRay(ray, hit)) {
+    if (!traceRay(p.scene, ray, hit)) {
       break;
     }
 
@@ -30,8 +30,13 @@ PhotonTracerPass::PhotonTracerPass(const vulkan::Device& device,
   vulkan::debug::setName(*mBuffers.photons, "Photons");
 }
 
-void PhotonTracerPass::reloadShaders(vulkan::ShaderLibrary& shaderLibrary) {
-  mPipelineLayout = makeUnique<vulkan::PipelineLayout>({
+void PhotonTracerPass::registerShaders(vulkan::ShaderLibrary& shaderLibrary) {
+  requestShader(shaderLibrary, kPhotonTracerShader);
+}
+
+PipelineUpdate PhotonTracerPass::createPipelines(
+    vulkan::ShaderLibrary& shaderLibrary) {
+  auto pipelineLayout = makeUnique<vulkan::PipelineLayout>({
       .device = mDevice,
       .descriptorSetLayouts = {&mScene.getDescriptorSetLayout()},
       .pushConstants = {{
@@ -41,12 +46,17 @@ void PhotonTracerPass::reloadShaders(vulkan::ShaderLibrary& shaderLibrary) {
   });
 
   const auto& shaderData = shaderLibrary.loadShader(kPhotonTracerShader);
-  mPipeline = makeUnique<vulkan::ComputePipeline>({
+  auto pipeline = makeUnique<vulkan::ComputePipeline>({
       .device = mDevice,
-      .layout = *mPipelineLayout,
+      .layout = *pipelineLayout,
       .shader = *shaderData.shader,
   });
-  mWorkgroupSize = shaderData.reflection.workgroupSize.value();
+
+  PipelineUpdate update;
+  update.set(mPipelineLayout, std::move(pipelineLayout));
+  update.set(mPipeline, std::move(pipeline));
+  update.set(mWorkgroupSize, shaderData.reflection.workgroupSize.value());
+  return update;
 }
 
 void PhotonTracerPass::execute(const vulkan::CommandBuffer& commandBuffer,
@@ -13,7 +13,10 @@ class PhotonTracerPass : public Pass {
   explicit PhotonTracerPass(const vulkan::Device& device,
                             const scene::GPUScene& scene);
 
-  void reloadShaders(vulkan::ShaderLibrary& shaderLibrary) override;
+  void registerShaders(vulkan::ShaderLibrary& shaderLibrary) override;
+
+  [[nodiscard]] PipelineUpdate createPipelines(
+      vulkan::ShaderLibrary& shaderLibrary) override;
 
   void execute(const vulkan::CommandBuffer& commandBuffer,
                vulkan::RenderFrame& currentFrame) override;
@@ -24,6 +27,14 @@ class PhotonTracerPass : public Pass {
     return mBuffers.photons->getDeviceAddress();
   }
 
+  [[nodiscard]] const vulkan::Buffer& getHashGridBuffer() const {
+    return *mBuffers.hashGrid;
+  }
+
+  [[nodiscard]] const vulkan::Buffer& getPhotonBuffer() const {
+    return *mBuffers.photons;
+  }
+
  private:
   const scene::GPUScene& mScene;
 
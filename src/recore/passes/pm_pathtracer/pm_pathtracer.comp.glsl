@@ -17,7 +17,11 @@
 
 #include "pm_pathtracer.glslh"
 
-layout(local_size_x = 32, local_size_y = 32, local_size_z = 1) in;
+#include <recore/shaders/workgroup_size.glslh>
+
+layout(local_size_x = 32, local_size_y = 32, local_size_z = 1,
+       local_size_x_id = WORKGROUP_SIZE_X_ID,
+       local_size_y_id = WORKGROUP_SIZE_Y_ID) in;
 
 layout(set = 1, binding = 0, rgba32f) uniform image2D gOutputImage;
 
@@ -98,7 +102,7 @@ vec3 evalNEE(inout RandomSampler rng, ShadingData sd, vec3 wi) {
   vec3 wo = -sunLight.direction;
   vec3 lambert = evalBRDF(sd, normalize(wo), normalize(wi));
   vec3 lightWeight = DirectionalLight_eval(sunLight);
-  float shadow = float(!traceShadowRay(Ray(sd.P, 1000 * wo)));
+  float shadow = float(!traceShadowRay(p.scene, Ray(sd.P, 1000 * wo)));
 
   return 10.f* lambert * lightWeight * shadow;
 #else
@@ -107,7 +111,7 @@ vec3 evalNEE(inout RandomSampler rng, ShadingData sd, vec3 wi) {
 
   vec3 P = SPHERE_LIGHT + SPHERE_LIGHT_RADIUS * sampleSphere(rng);
   vec3 wo = P - sd.P;
-  float shadow2 = float(!traceShadowRay(Ray(sd.P, wo)));
+  float shadow2 = float(!traceShadowRay(p.scene, Ray(sd.P, wo)));
 
   float falloff = 1.f / dot(wo, wo);
   return 5.f* evalBRDF(sd, normalize(wi), normalize(wo)) * shadow2 * falloff / pdfSampleSphere();
@@ -141,7 +145,7 @@ vec3 tracePath(inout RandomSampler rng, ivec2 pixel, ShadingData sd, vec3 wi) {
     // Trace path
     Ray ray = Ray(sd.P + sign(dot(brdfSample.wo, sd.N)) * M_EPSILON * sd.N, brdfSample.wo);
     Hit hit;
-    if(!traceRay(ray, hit)) {
+    if(!traceRay(p.scene, ray, hit)) {
       break;
     }
 
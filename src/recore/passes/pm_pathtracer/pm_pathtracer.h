@@ -13,9 +13,12 @@ class PhotonMappingPathTracerPass : public Pass {
   explicit PhotonMappingPathTracerPass(const vulkan::Device& device,
                                        const scene::GPUScene& scene);
 
-  void reloadShaders(vulkan::ShaderLibrary& shaderLibrary) override;
+  void registerShaders(vulkan::ShaderLibrary& shaderLibrary) override;
 
-  void resize(uint32_t width, uint32_t height) override;
+  [[nodiscard]] PipelineUpdate createPipelines(
+      vulkan::ShaderLibrary& shaderLibrary) override;
+
+  [[nodiscard]] PipelineUpdate resize(uint32_t width, uint32_t height) override;
 
   void execute(const vulkan::CommandBuffer& commandBuffer,
                vulkan::RenderFrame& currentFrame) override;
@@ -42,10 +45,21 @@ class PhotonMappingPathTracerPass : public Pass {
  private:
   const scene::GPUScene& mScene;
 
+  // Set 1 in binding order, written with the update template
+  struct Descriptors {
+    VkDescriptorImageInfo outputImage;
+    VkDescriptorImageInfo gPosition;
+    VkDescriptorImageInfo gNormal;
+    VkDescriptorImageInfo gAlbedo;
+    VkDescriptorImageInfo gEmissive;
+    VkDescriptorImageInfo gMaterial;
+  };
+
   struct {
     uPtr<vulkan::DescriptorPool> pool;
     uPtr<vulkan::DescriptorSetLayout> layout;
-    uPtr<vulkan::DescriptorSet> set;
+    uPtr<FrameDescriptorSet> set;
+    uPtr<vulkan::DescriptorUpdateTemplate> updateTemplate;
   } mDescriptors;
 
   uPtr<vulkan::PipelineLayout> mPipelineLayout;
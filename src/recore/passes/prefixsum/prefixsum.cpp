@@ -46,9 +46,17 @@ PrefixSumPass::PrefixSumPass(const vulkan::Device& device,
   });
 }
 
-void PrefixSumPass::reloadShaders(vulkan::ShaderLibrary& shaderLibrary) {
+void PrefixSumPass::registerShaders(vulkan::ShaderLibrary& shaderLibrary) {
+  requestShader(shaderLibrary, kPrefixSumShader);
+  requestShader(shaderLibrary, kPrefixSumAddShader);
+}
+
+PipelineUpdate PrefixSumPass::createPipelines(
+    vulkan::ShaderLibrary& shaderLibrary) {
+  PipelineUpdate update;
+
   {
-    mPipelineLayout = makeUnique<vulkan::PipelineLayout>({
+    auto pipelineLayout = makeUnique<vulkan::PipelineLayout>({
         .device = mDevice,
         .descriptorSetLayouts = {},
         .pushConstants = {{.stageFlags = VK_SHADER_STAGE_ALL,
@@ -56,16 +64,19 @@ void PrefixSumPass::reloadShaders(vulkan::ShaderLibrary& shaderLibrary) {
     });
 
     const auto& shaderData = shaderLibrary.loadShader(kPrefixSumShader);
-    mPipeline = makeUnique<vulkan::ComputePipeline>({
+    auto pipeline = makeUnique<vulkan::ComputePipeline>({
         .device = mDevice,
-        .layout = *mPipelineLayout,
+        .layout = *pipelineLayout,
         .shader = *shaderData.shader,
     });
-    mWorkgroupSize = shaderData.reflection.workgroupSize.value();
+
+    update.set(mPipelineLayout, std::move(pipelineLayout));
+    update.set(mPipeline, std::move(pipeline));
+    update.set(mWorkgroupSize, shaderData.reflection.workgroupSize.value());
   }
 
   {
-    mAddPass.pipelineLayout = makeUnique<vulkan::PipelineLayout>({
+    auto pipelineLayout = makeUnique<vulkan::PipelineLayout>({
         .device = mDevice,
         .descriptorSetLayouts = {},
         .pushConstants = {{.stageFlags = VK_SHADER_STAGE_ALL,
@@ -73,13 +84,19 @@ void PrefixSumPass::reloadShaders(vulkan::ShaderLibrary& shaderLibrary) {
     });
 
     const auto& shaderData = shaderLibrary.loadShader(kPrefixSumAddShader);
-    mAddPass.pipeline = makeUnique<vulkan::ComputePipeline>({
+    auto pipeline = makeUnique<vulkan::ComputePipeline>({
         .device = mDevice,
-        .layout = *mAddPass.pipelineLayout,
+        .layout = *pipelineLayout,
         .shader = *shaderData.shader,
     });
-    mAddPass.workgroupSize = shaderData.reflection.workgroupSize.value();
+
+    update.set(mAddPass.pipelineLayout, std::move(pipelineLayout));
+    update.set(mAddPass.pipeline, std::move(pipeline));
+    update.set(mAddPass.workgroupSize,
+               shaderData.reflection.workgroupSize.value());
   }
+
+  return update;
 }
 
 void PrefixSumPass::execute(const vulkan::CommandBuffer& commandBuffer,
@@ -104,6 +121,16 @@ void PrefixSumPass::execute(const vulkan::CommandBuffer& commandBuffer,
                                                 numElements);
 
   commandBuffer.fillBuffer(*mTotalSumBuffer);
+  vulkan::BarrierBatch{commandBuffer}.buffer(*mTotalSumBuffer,
+                                             vulkan::access::kTransferWrite,
+                                             vulkan::access::kTransferRead);
+
+  // Shader writes of an iteration are read by the copy of the next one
+  constexpr vulkan::Access kIterationEnd{
+      VK_PIPELINE_STAGE_2_TRANSFER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+      VK_ACCESS_2_TRANSFER_READ_BIT | VK_ACCESS_2_TRANSFER_WRITE_BIT |
+          vulkan::access::kComputeReadWrite.access,
+  };
 
   for (uint32_t i = 0; i < numIterations; i++) {
     RECORE_DEBUG_SCOPE(commandBuffer, std::format("PrefixSumPass: i = {}", i));
@@ -115,20 +142,11 @@ void PrefixSumPass::execute(const vulkan::CommandBuffer& commandBuffer,
             std::min(maxNumElementsPerIteration, numElements)));
     p.iteration = i,
 
-    commandBuffer.memoryBarrier(
-        VK_ACCESS_TRANSFER_WRITE_BIT,
-        VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT,
-        VK_PIPELINE_STAGE_TRANSFER_BIT,
-        VK_PIPELINE_STAGE_TRANSFER_BIT);
-
     commandBuffer.copyBufferToBuffer(*mTotalSumBuffer, *mPrevTotalSumBuffer);
     commandBuffer.fillBuffer(*mWorkgroupPrefixSumsBuffer);
 
-    commandBuffer.memoryBarrier(
-        VK_ACCESS_TRANSFER_WRITE_BIT,
-        VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT,
-        VK_PIPELINE_STAGE_TRANSFER_BIT,
-        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+    vulkan::BarrierBatch{commandBuffer}.memory(
+        vulkan::access::kTransferWrite, vulkan::access::kComputeReadWrite);
 
     {
       RECORE_DEBUG_SCOPE(commandBuffer, "PrefixSumPass::LocalPrefixSum");
@@ -137,10 +155,8 @@ void PrefixSumPass::execute(const vulkan::CommandBuffer& commandBuffer,
       commandBuffer.dispatch({xSize, 1, 1});
     }
 
-    commandBuffer.memoryBarrier(VK_ACCESS_SHADER_WRITE_BIT,
-                                VK_ACCESS_SHADER_READ_BIT,
-                                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-                                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+    vulkan::BarrierBatch{commandBuffer}.memory(
+        vulkan::access::kComputeWrite, vulkan::access::kComputeReadWrite);
 
     if (xSize > 1) {
       RECORE_DEBUG_SCOPE(commandBuffer, "PrefixSumPass::Add");
@@ -149,10 +165,8 @@ void PrefixSumPass::execute(const vulkan::CommandBuffer& commandBuffer,
       commandBuffer.dispatch({(xSize - 1) * 2, 1, 1});
     }
 
-    commandBuffer.memoryBarrier(VK_ACCESS_SHADER_WRITE_BIT,
-                                VK_ACCESS_SHADER_READ_BIT,
-                                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-                                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+    vulkan::BarrierBatch{commandBuffer}.memory(vulkan::access::kComputeWrite,
+                                               kIterationEnd);
 
     numElements -= maxNumElementsPerIteration;
   }
@@ -9,7 +9,10 @@ class PrefixSumPass : public Pass {
   explicit PrefixSumPass(const vulkan::Device& device,
                          const vulkan::Buffer& dataBuffer);
 
-  void reloadShaders(vulkan::ShaderLibrary& shaderLibrary) override;
+  void registerShaders(vulkan::ShaderLibrary& shaderLibrary) override;
+
+  [[nodiscard]] PipelineUpdate createPipelines(
+      vulkan::ShaderLibrary& shaderLibrary) override;
 
   void execute(const vulkan::CommandBuffer& commandBuffer,
                vulkan::RenderFrame& currentFrame) override;
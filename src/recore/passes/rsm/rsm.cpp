@@ -62,17 +62,22 @@ RSMPass::RSMPass(const vulkan::Device& device,
        .height = height});
 }
 
-void RSMPass::reloadShaders(vulkan::ShaderLibrary& shaderLibrary) {
-  mPipelineLayout = makeUnique<vulkan::PipelineLayout>(
+void RSMPass::registerShaders(vulkan::ShaderLibrary& shaderLibrary) {
+  requestShader(shaderLibrary, kRSMVertexShader);
+  requestShader(shaderLibrary, kRSMFragmentShader);
+}
+
+PipelineUpdate RSMPass::createPipelines(vulkan::ShaderLibrary& shaderLibrary) {
+  auto pipelineLayout = makeUnique<vulkan::PipelineLayout>(
       {.device = mDevice,
        .descriptorSetLayouts = {&mScene.getDescriptorSetLayout()},
        .pushConstants = {
            {.stageFlags = VK_SHADER_STAGE_ALL, .size = sizeof(RSMPush)},
        }});
 
-  mPipeline = makeUnique<vulkan::RasterPipeline>({
+  auto pipeline = makeUnique<vulkan::RasterPipeline>({
       .device = mDevice,
-      .layout = *mPipelineLayout,
+      .layout = *pipelineLayout,
       .renderPass = *mRenderPass,
       .state =
           {
@@ -101,6 +106,11 @@ void RSMPass::reloadShaders(vulkan::ShaderLibrary& shaderLibrary) {
       .shaders = {shaderLibrary.loadShader(kRSMVertexShader),
                   shaderLibrary.loadShader(kRSMFragmentShader)},
   });
+
+  PipelineUpdate update;
+  update.set(mPipelineLayout, std::move(pipelineLayout));
+  update.set(mPipeline, std::move(pipeline));
+  return update;
 }
 
 void RSMPass::execute(const vulkan::CommandBuffer& commandBuffer,
@@ -1,19 +1,23 @@
 #version 460
 
-#include "atrous.glslh"
+#include "svgf.glslh"
 
+#include <recore/shaders/bindless.glsl>
+#include <recore/shaders/workgroup_size.glslh>
 
-layout(local_size_x = 32, local_size_y = 32, local_size_z = 1) in;
+layout(local_size_x = 32, local_size_y = 32, local_size_z = 1,
+       local_size_x_id = WORKGROUP_SIZE_X_ID,
+       local_size_y_id = WORKGROUP_SIZE_Y_ID) in;
+
+PUSH_CONSTANT(ATrousPush);
 
 // Output
-layout(set = 0, binding = 0, rgba32f) uniform writeonly image2D gFilteredImage;
+#define gFilteredImage bindlessImage2D(p.filteredImage)
 
 // Input
-layout(set = 0, binding = 1) uniform sampler2D gPosition;
-layout(set = 0, binding = 2) uniform sampler2D gNormal;
-layout(set = 0, binding = 3) uniform sampler2D gColor;
-
-PUSH_CONSTANT(ATrousPush);
+#define gPosition bindlessSampler2D(p.gPosition, p.sampler)
+#define gNormal bindlessSampler2D(p.gNormal, p.sampler)
+#define gColor bindlessSampler2D(p.color, p.sampler)
 
 #define FILTER_SIZE 5
 
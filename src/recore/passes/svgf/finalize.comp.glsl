@@ -1,9 +1,20 @@
 #version 460
 
-layout(set = 0, binding = 0) uniform sampler2D gAlbedo;
-layout(set = 0, binding = 1) uniform sampler2D gIllumination;
+#include "svgf.glslh"
 
-layout(set = 0, binding = 2, rgba32f) uniform writeonly image2D gOutputImage;
+#include <recore/shaders/bindless.glsl>
+#include <recore/shaders/workgroup_size.glslh>
+
+layout(local_size_x = 32, local_size_y = 32, local_size_z = 1,
+       local_size_x_id = WORKGROUP_SIZE_X_ID,
+       local_size_y_id = WORKGROUP_SIZE_Y_ID) in;
+
+PUSH_CONSTANT(FinalizePush);
+
+#define gAlbedo bindlessSampler2D(p.gAlbedo, p.sampler)
+#define gIllumination bindlessSampler2D(p.illumination, p.sampler)
+
+#define gOutputImage bindlessImage2D(p.outputImage)
 
 void main() {
   ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
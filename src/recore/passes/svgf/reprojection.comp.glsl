@@ -1,21 +1,32 @@
 #version 460
 
+#include "svgf.glslh"
+
+#include <recore/shaders/bindless.glsl>
+#include <recore/shaders/workgroup_size.glslh>
+
+layout(local_size_x = 32, local_size_y = 32, local_size_z = 1,
+       local_size_x_id = WORKGROUP_SIZE_X_ID,
+       local_size_y_id = WORKGROUP_SIZE_Y_ID) in;
+
+PUSH_CONSTANT(ReprojectionPush);
+
 // Input
-layout(set = 0, binding = 0) uniform sampler2D gGPosition;
-layout(set = 0, binding = 1) uniform sampler2D gGNormal;
-layout(set = 0, binding = 2) uniform sampler2D gGAlbedo;
-layout(set = 0, binding = 3) uniform sampler2D gGMotion;
-layout(set = 0, binding = 4) uniform sampler2D gIllumination;
-
-layout(set = 0, binding = 10) uniform sampler2D gPrevGPosition;
-layout(set = 0, binding = 11) uniform sampler2D gPrevGNormal;
-layout(set = 0, binding = 12) uniform sampler2D gPrevGAlbedo;
-layout(set = 0, binding = 13) uniform sampler2D gPrevIllumination;
-layout(set = 0, binding = 14) uniform sampler2D gPrevHistoryLength;
+#define gGPosition bindlessSampler2D(p.gPosition, p.sampler)
+#define gGNormal bindlessSampler2D(p.gNormal, p.sampler)
+#define gGAlbedo bindlessSampler2D(p.gAlbedo, p.sampler)
+#define gGMotion bindlessSampler2D(p.gMotion, p.sampler)
+#define gIllumination bindlessSampler2D(p.illumination, p.sampler)
+
+#define gPrevGPosition bindlessSampler2D(p.prevPosition, p.sampler)
+#define gPrevGNormal bindlessSampler2D(p.prevNormal, p.sampler)
+#define gPrevGAlbedo bindlessSampler2D(p.prevAlbedo, p.sampler)
+#define gPrevIllumination bindlessSampler2D(p.prevIllumination, p.sampler)
+#define gPrevHistoryLength bindlessSampler2D(p.prevHistoryLength, p.sampler)
 
 // Output
-layout(set = 0, binding = 20, rgba32f) uniform writeonly image2D gOutputIllumination;
-layout(set = 0, binding = 21, r32f) uniform writeonly image2D gOutputHistoryLength;
+#define gOutputIllumination bindlessImage2D(p.outputIllumination)
+#define gOutputHistoryLength bindlessImage2DR32f(p.outputHistoryLength)
 
 
 #define MAX_POSITION_DIFFERENCE 0.25
@@ -1,6 +1,6 @@
 #include "svgf.h"
 
-#include "atrous.glslh"
+#include "svgf.glslh"
 
 #include <recore/vulkan/debug.h>
 
@@ -12,272 +12,62 @@ constexpr auto kATrousShader = "recore/passes/svgf/atrous.comp.glsl";
 constexpr auto kFinalizeShader = "recore/passes/svgf/finalize.comp.glsl";
 
 SVGFPass::SVGFPass(const vulkan::Device& device) : Pass{device} {
-  {  // Initialize reprojection descriptors
-    mReprojectionDescriptors.pool = makeUnique<vulkan::DescriptorPool>({
-        .device = mDevice,
-        .poolSizes =
-            {
-                {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 2},
-                {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 10},
-            },
-    });
-
-    mReprojectionDescriptors.layout = makeUnique<vulkan::DescriptorSetLayout>({
-        .device = mDevice,
-        .bindings =
-            {
-                {
-                    {.binding = 0,
-                     .descriptorType =
-                         VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                     .descriptorCount = 1,
-                     .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT},
-                },
-                {
-                    {.binding = 1,
-                     .descriptorType =
-                         VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                     .descriptorCount = 1,
-                     .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT},
-                },
-                {
-                    {.binding = 2,
-                     .descriptorType =
-                         VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                     .descriptorCount = 1,
-                     .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT},
-                },
-                {
-                    {.binding = 3,
-                     .descriptorType =
-                         VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                     .descriptorCount = 1,
-                     .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT},
-                },
-                {
-                    {.binding = 4,
-                     .descriptorType =
-                         VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                     .descriptorCount = 1,
-                     .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT},
-                },
-                {
-                    {.binding = 10,
-                     .descriptorType =
-                         VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                     .descriptorCount = 1,
-                     .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT},
-                },
-                {
-                    {.binding = 11,
-                     .descriptorType =
-                         VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                     .descriptorCount = 1,
-                     .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT},
-                },
-                {
-                    {.binding = 12,
-                     .descriptorType =
-                         VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                     .descriptorCount = 1,
-                     .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT},
-                },
-                {
-                    {.binding = 13,
-                     .descriptorType =
-                         VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                     .descriptorCount = 1,
-                     .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT},
-                },
-                {
-                    {.binding = 14,
-                     .descriptorType =
-                         VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                     .descriptorCount = 1,
-                     .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT},
-                },
-                {
-                    {.binding = 20,
-                     .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
-                     .descriptorCount = 1,
-                     .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT},
-                },
-                {
-                    {.binding = 21,
-                     .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
-                     .descriptorCount = 1,
-                     .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT},
-                },
-            },
-    });
-
-    mReprojectionDescriptors.set = makeUnique<vulkan::DescriptorSet>({
-        .device = mDevice,
-        .pool = *mReprojectionDescriptors.pool,
-        .layout = *mReprojectionDescriptors.layout,
-    });
-  }
-
-  {  // Initialize ATrous descriptors
-    const uint32_t numATrousSets = mATrousDescriptors.sets.size();
-    mATrousDescriptors.pool = makeUnique<vulkan::DescriptorPool>({
-        .device = mDevice,
-        .poolSizes =
-            {
-                {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1},
-                {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 3},
-            },
-        .maxSets = numATrousSets,
-        .multiplier = numATrousSets,
-        .perSet = true,
-    });
-
-    mATrousDescriptors.layout = makeUnique<vulkan::DescriptorSetLayout>({
-        .device = mDevice,
-        .bindings =
-            {
-                {
-                    {.binding = 0,
-                     .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
-                     .descriptorCount = 1,
-                     .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT},
-                },
-                {
-                    {.binding = 1,
-                     .descriptorType =
-                         VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                     .descriptorCount = 1,
-                     .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT},
-                },
-                {
-                    {.binding = 2,
-                     .descriptorType =
-                         VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                     .descriptorCount = 1,
-                     .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT},
-                },
-                {
-                    {.binding = 3,
-                     .descriptorType =
-                         VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                     .descriptorCount = 1,
-                     .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT},
-                },
-            },
-    });
-
-    for (auto& set : mATrousDescriptors.sets) {
-      set = makeUnique<vulkan::DescriptorSet>({
-          .device = mDevice,
-          .pool = *mATrousDescriptors.pool,
-          .layout = *mATrousDescriptors.layout,
-      });
-    }
-  }
-
-  {  // Initialize finalize descriptors
-    mFinalizeDescriptors.pool = makeUnique<vulkan::DescriptorPool>({
-        .device = mDevice,
-        .poolSizes =
-            {
-                {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1},
-                {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2},
-            },
-    });
-
-    mFinalizeDescriptors.layout = makeUnique<vulkan::DescriptorSetLayout>({
-        .device = mDevice,
-        .bindings =
-            {
-                {
-                    {.binding = 0,
-                     .descriptorType =
-                         VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                     .descriptorCount = 1,
-                     .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT},
-                },
-                {
-                    {.binding = 1,
-                     .descriptorType =
-                         VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                     .descriptorCount = 1,
-                     .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT},
-                },
-                {
-                    {.binding = 2,
-                     .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
-                     .descriptorCount = 1,
-                     .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT},
-                },
-            },
-    });
-
-    mFinalizeDescriptors.set = makeUnique<vulkan::DescriptorSet>({
-        .device = mDevice,
-        .pool = *mFinalizeDescriptors.pool,
-        .layout = *mFinalizeDescriptors.layout,
-    });
-  }
-
   mSampler = makeUnique<vulkan::Sampler>({.device = mDevice});
 }
 
-void SVGFPass::reloadShaders(vulkan::ShaderLibrary& shaderLibrary) {
-  {  // Reprojection pipeline
-    mReprojectionPipeline.layout = makeUnique<vulkan::PipelineLayout>({
-        .device = mDevice,
-        .descriptorSetLayouts = {&*mReprojectionDescriptors.layout},
-        .pushConstants = {},
-    });
+void SVGFPass::registerShaders(vulkan::ShaderLibrary& shaderLibrary) {
+  requestShader(shaderLibrary, kReprojectionShader);
+  requestShader(shaderLibrary, kATrousShader);
+  requestShader(shaderLibrary, kFinalizeShader);
+}
+
+PipelineUpdate SVGFPass::createPipelines(vulkan::ShaderLibrary& shaderLibrary) {
+  const auto& layout = mDevice.getBindlessHeap().getPipelineLayout();
+  PipelineUpdate update;
 
+  {  // Reprojection pipeline
     const auto& shaderData = shaderLibrary.loadShader(kReprojectionShader);
-    mReprojectionPipeline.pipeline = makeUnique<vulkan::ComputePipeline>({
+    auto pipeline = makeUnique<vulkan::ComputePipeline>({
         .device = mDevice,
-        .layout = *mReprojectionPipeline.layout,
+        .layout = layout,
         .shader = *shaderData.shader,
     });
-    mReprojectionPipeline.workgroupSize =
-        shaderData.reflection.workgroupSize.value();
+
+    update.set(mReprojectionPipeline.pipeline, std::move(pipeline));
+    update.set(mReprojectionPipeline.workgroupSize,
+               shaderData.reflection.workgroupSize.value());
   }
 
   {  // ATrous pipeline
-    mATrousPipeline.layout = makeUnique<vulkan::PipelineLayout>({
-        .device = mDevice,
-        .descriptorSetLayouts = {&*mATrousDescriptors.layout},
-        .pushConstants = {{
-            .stageFlags = VK_SHADER_STAGE_ALL,
-            .size = sizeof(ATrousPush),
-        }},
-    });
-
     const auto& shaderData = shaderLibrary.loadShader(kATrousShader);
-    mATrousPipeline.pipeline = makeUnique<vulkan::ComputePipeline>({
+    auto pipeline = makeUnique<vulkan::ComputePipeline>({
         .device = mDevice,
-        .layout = *mATrousPipeline.layout,
+        .layout = layout,
         .shader = *shaderData.shader,
     });
-    mATrousPipeline.workgroupSize = shaderData.reflection.workgroupSize.value();
+
+    update.set(mATrousPipeline.pipeline, std::move(pipeline));
+    update.set(mATrousPipeline.workgroupSize,
+               shaderData.reflection.workgroupSize.value());
   }
 
   {  // Finalize pipeline
-    mFinalizePipeline.layout = makeUnique<vulkan::PipelineLayout>({
-        .device = mDevice,
-        .descriptorSetLayouts = {&*mFinalizeDescriptors.layout},
-        .pushConstants = {},
-    });
-
     const auto& shaderData = shaderLibrary.loadShader(kFinalizeShader);
-    mFinalizePipeline.pipeline = makeUnique<vulkan::ComputePipeline>({
+    auto pipeline = makeUnique<vulkan::ComputePipeline>({
         .device = mDevice,
-        .layout = *mFinalizePipeline.layout,
+        .layout = layout,
         .shader = *shaderData.shader,
     });
-    mFinalizePipeline.workgroupSize =
-        shaderData.reflection.workgroupSize.value();
+
+    update.set(mFinalizePipeline.pipeline, std::move(pipeline));
+    update.set(mFinalizePipeline.workgroupSize,
+               shaderData.reflection.workgroupSize.value());
   }
+
+  return update;
 }
 
-void SVGFPass::resize(uint32_t width, uint32_t height) {
+PipelineUpdate SVGFPass::resize(uint32_t width, uint32_t height) {
   auto genImage = [&](VkFormat format = VK_FORMAT_R32G32B32A32_SFLOAT) {
     return makeUnique<vulkan::Image>({
         .device = mDevice,
@@ -291,57 +81,89 @@ void SVGFPass::resize(uint32_t width, uint32_t height) {
   };
 
   // Ping-pong filtered images for a trous
-  for (auto& image : mFilteredImages) {
+  std::array<uPtr<vulkan::Image>, 2> filteredImages;
+  for (auto& image : filteredImages) {
     image = genImage();
   }
 
-  mOutputImage = genImage();
-  mIllumination = genImage();
-  mHistoryLength = genImage(VK_FORMAT_R32_SFLOAT);
-  mPrevPosition = genImage();
-  mPrevNormal = genImage();
-  mPrevAlbedo = genImage();
-  mPrevIllumination = genImage();
-  mPrevHistoryLength = genImage(VK_FORMAT_R32_SFLOAT);
-
-  mDevice.submitAndWait([&](const auto& commandBuffer) {
-    commandBuffer.transitionImageLayout({&*mFilteredImages[0],
-                                         &*mFilteredImages[1],
-                                         &*mOutputImage,
-                                         &*mIllumination,
-                                         &*mHistoryLength},
-                                        VK_IMAGE_LAYOUT_UNDEFINED,
-                                        VK_IMAGE_LAYOUT_GENERAL,
-                                        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-                                        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
-
-    commandBuffer.transitionImageLayout(
-        {&*mPrevPosition,
-         &*mPrevNormal,
-         &*mPrevAlbedo,
-         &*mPrevIllumination,
-         &*mPrevHistoryLength},
-        VK_IMAGE_LAYOUT_UNDEFINED,
-        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+  auto outputImage = genImage();
+  auto illumination = genImage();
+  auto historyLength = genImage(VK_FORMAT_R32_SFLOAT);
+  auto prevPosition = genImage();
+  auto prevNormal = genImage();
+  auto prevAlbedo = genImage();
+  auto prevIllumination = genImage();
+  auto prevHistoryLength = genImage(VK_FORMAT_R32_SFLOAT);
+
+  mDevice.getImmediateContext().record([&](const auto& commandBuffer) {
+    using namespace vulkan::access;
+    vulkan::BarrierBatch barriers{commandBuffer};
+    for (const auto* image : {&*filteredImages[0],
+                              &*filteredImages[1],
+                              &*outputImage,
+                              &*illumination,
+                              &*historyLength}) {
+      barriers.image(*image, kNone, kComputeWrite);
+    }
+    for (const auto* image : {&*prevPosition,
+                              &*prevNormal,
+                              &*prevAlbedo,
+                              &*prevIllumination,
+                              &*prevHistoryLength}) {
+      barriers.image(*image, kNone, kComputeSampled);
+    }
   });
+
+  PipelineUpdate update;
+  for (size_t i = 0; i < filteredImages.size(); i++) {
+    update.set(mFilteredImages[i], std::move(filteredImages[i]));
+  }
+  update.set(mOutputImage, std::move(outputImage));
+  update.set(mIllumination, std::move(illumination));
+  update.set(mHistoryLength, std::move(historyLength));
+  update.set(mPrevPosition, std::move(prevPosition));
+  update.set(mPrevNormal, std::move(prevNormal));
+  update.set(mPrevAlbedo, std::move(prevAlbedo));
+  update.set(mPrevIllumination, std::move(prevIllumination));
+  update.set(mPrevHistoryLength, std::move(prevHistoryLength));
+  return update;
 }
 
 void SVGFPass::execute(const vulkan::CommandBuffer& commandBuffer,
                        vulkan::RenderFrame& currentFrame) {
   RECORE_GPU_PROFILE_SCOPE(currentFrame, commandBuffer, "SVGFPass::execute");
+  using namespace vulkan::access;
+
+  // Overwrites an image that earlier dispatches read
+  constexpr vulkan::Access kComputeDiscard{
+      VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT};
+
+  // Stays bound, all pipelines share the layout of the heap
+  mDevice.getBindlessHeap().bind(commandBuffer,
+                                 VK_PIPELINE_BIND_POINT_COMPUTE);
 
   {  // Reprojection
-    commandBuffer.transitionImageLayout(*mIllumination,
-                                        VK_IMAGE_LAYOUT_UNDEFINED,
-                                        VK_IMAGE_LAYOUT_GENERAL,
-                                        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-                                        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+    vulkan::BarrierBatch{commandBuffer}.image(
+        *mIllumination, kComputeDiscard, kComputeWrite);
 
     commandBuffer.bindPipeline(*mReprojectionPipeline.pipeline);
-    commandBuffer.bindDescriptorSet(
-        *mReprojectionPipeline.pipeline, *mReprojectionDescriptors.set, 0);
+
+    ReprojectionPush p{
+        .gPosition = mPosition->getSampledHandle(),
+        .gNormal = mNormal->getSampledHandle(),
+        .gAlbedo = mAlbedo->getSampledHandle(),
+        .gMotion = mMotion->getSampledHandle(),
+        .illumination = mNoisyImage->getSampledHandle(),
+        .prevPosition = mPrevPosition->getSampledHandle(),
+        .prevNormal = mPrevNormal->getSampledHandle(),
+        .prevAlbedo = mPrevAlbedo->getSampledHandle(),
+        .prevIllumination = mPrevIllumination->getSampledHandle(),
+        .prevHistoryLength = mPrevHistoryLength->getSampledHandle(),
+        .outputIllumination = mIllumination->getStorageHandle(),
+        .outputHistoryLength = mHistoryLength->getStorageHandle(),
+        .sampler = mSampler->getHandle(),
+    };
+    commandBuffer.pushConstants(mReprojectionPipeline.pipeline->getLayout(), p);
 
     vulkan::CommandBuffer::DispatchDim dispatchDim = {
         vulkan::dispatchSize(mReprojectionPipeline.workgroupSize.x,
@@ -355,24 +177,18 @@ void SVGFPass::execute(const vulkan::CommandBuffer& commandBuffer,
 
   {  // A Trous
 
-    commandBuffer.transitionImageLayout(
-        *mIllumination,
-        VK_IMAGE_LAYOUT_GENERAL,
-        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
-
-    commandBuffer.transitionImageLayout(*mFilteredImages[0],
-                                        VK_IMAGE_LAYOUT_UNDEFINED,
-                                        VK_IMAGE_LAYOUT_GENERAL,
-                                        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-                                        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+    vulkan::BarrierBatch{commandBuffer}
+        .image(*mIllumination, kComputeWrite, kComputeSampled)
+        .image(*mFilteredImages[0], kComputeDiscard, kComputeWrite);
 
     ATrousPush p{
         .phiColor = 512.f,
         .phiNormal = 0.05f,
         .phiPosition = 0.05f,
         .stepWidth = 1.f,
+        .gPosition = mPosition->getSampledHandle(),
+        .gNormal = mNormal->getSampledHandle(),
+        .sampler = mSampler->getHandle(),
     };
 
     const float phiAttenuation = 0.5f;
@@ -394,17 +210,13 @@ void SVGFPass::execute(const vulkan::CommandBuffer& commandBuffer,
 
     const uint32_t outID = ((numATrousIterations % 2) != 0) ? 0 : 1;
     for (uint32_t i = 0; i < numATrousIterations; ++i) {
-      if (i == 0) {
-        commandBuffer.bindDescriptorSet(
-            *mATrousPipeline.pipeline, *mATrousDescriptors.sets.at(0), 0);
-      } else {
-        commandBuffer.bindDescriptorSet(
-            *mATrousPipeline.pipeline,
-            *mATrousDescriptors.sets.at(((i + 1) % 2) + 1),
-            0);
-      }
+      // Reprojection -> [0], then ping-pong between the filtered images
+      const auto& color =
+          i == 0 ? *mIllumination : *mFilteredImages.at((i + 1) % 2);
+      p.color = color.getSampledHandle();
+      p.filteredImage = mFilteredImages.at(i % 2)->getStorageHandle();
 
-      commandBuffer.pushConstants(*mATrousPipeline.layout, p);
+      commandBuffer.pushConstants(mATrousPipeline.pipeline->getLayout(), p);
 
       commandBuffer.dispatch(dispatchDim);
 
@@ -413,64 +225,37 @@ void SVGFPass::execute(const vulkan::CommandBuffer& commandBuffer,
       p.phiPosition *= phiAttenuation;
       p.stepWidth *= 2.f;
 
-      commandBuffer.transitionImageLayout(
-          *mFilteredImages.at(i % 2),
-          VK_IMAGE_LAYOUT_GENERAL,
-          VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-          VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-          VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
-
-      commandBuffer.transitionImageLayout(*mFilteredImages.at((i + 1) % 2),
-                                          VK_IMAGE_LAYOUT_UNDEFINED,
-                                          VK_IMAGE_LAYOUT_GENERAL,
-                                          VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-                                          VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+      vulkan::BarrierBatch barriers{commandBuffer};
+      barriers.image(
+          *mFilteredImages.at((i + 1) % 2), kComputeDiscard, kComputeWrite);
 
       if (i == 0) {
         // Use first filtered image as color history for next frame
-        commandBuffer.transitionImageLayout(
-            *mFilteredImages[0],
-            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-            VK_PIPELINE_STAGE_TRANSFER_BIT);
-
-        commandBuffer.transitionImageLayout(
-            *mPrevIllumination,
-            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-            VK_PIPELINE_STAGE_TRANSFER_BIT);
+        barriers.image(*mFilteredImages[0], kComputeWrite, kTransferRead)
+            .image(*mPrevIllumination, kComputeSampled, kTransferWrite)
+            .flush();
 
         commandBuffer.blitImage(*mFilteredImages[0], *mPrevIllumination);
 
-        commandBuffer.transitionImageLayout(
-            *mFilteredImages[0],
-            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-            VK_PIPELINE_STAGE_TRANSFER_BIT,
-            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
-
-        commandBuffer.transitionImageLayout(
-            *mPrevIllumination,
-            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-            VK_PIPELINE_STAGE_TRANSFER_BIT,
-            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+        barriers.image(*mFilteredImages[0], kTransferRead, kComputeSampled)
+            .image(*mPrevIllumination, kTransferWrite, kComputeSampled);
+      } else {
+        barriers.image(
+            *mFilteredImages.at(i % 2), kComputeWrite, kComputeSampled);
       }
     }
   }
 
   {  // Finalize
-    commandBuffer.transitionImageLayout(*mOutputImage,
-                                        VK_IMAGE_LAYOUT_UNDEFINED,
-                                        VK_IMAGE_LAYOUT_GENERAL,
-                                        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-                                        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
-
     commandBuffer.bindPipeline(*mFinalizePipeline.pipeline);
-    commandBuffer.bindDescriptorSet(
-        *mFinalizePipeline.pipeline, *mFinalizeDescriptors.set, 0);
+
+    FinalizePush p{
+        .gAlbedo = mAlbedo->getSampledHandle(),
+        .illumination = mFilteredImages[0]->getSampledHandle(),
+        .outputImage = mOutputImage->getStorageHandle(),
+        .sampler = mSampler->getHandle(),
+    };
+    commandBuffer.pushConstants(mFinalizePipeline.pipeline->getLayout(), p);
 
     vulkan::CommandBuffer::DispatchDim dispatchDim = {
         vulkan::dispatchSize(mFinalizePipeline.workgroupSize.x,
@@ -484,199 +269,42 @@ void SVGFPass::execute(const vulkan::CommandBuffer& commandBuffer,
 
   {  // Blit to store current frame for next frame reprojection
 
-    commandBuffer.transitionImageLayout(*mHistoryLength,
-                                        VK_IMAGE_LAYOUT_GENERAL,
-                                        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-                                        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-                                        VK_PIPELINE_STAGE_TRANSFER_BIT);
-
-    commandBuffer.transitionImageLayout(
-        {mPosition, mNormal, mAlbedo},
-        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-        VK_PIPELINE_STAGE_TRANSFER_BIT);
-
-    commandBuffer.transitionImageLayout(
-        {&*mPrevHistoryLength, &*mPrevPosition, &*mPrevNormal, &*mPrevAlbedo},
-        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-        VK_PIPELINE_STAGE_TRANSFER_BIT);
+    const std::array<const vulkan::Image*, 3> gBuffer{
+        mPosition, mNormal, mAlbedo};
+    const std::array<const vulkan::Image*, 4> history{
+        &*mPrevHistoryLength, &*mPrevPosition, &*mPrevNormal, &*mPrevAlbedo};
+
+    vulkan::BarrierBatch barriers{commandBuffer};
+    barriers.image(*mHistoryLength, kComputeWrite, kTransferRead);
+    for (const auto* image : gBuffer) {
+      barriers.image(*image, kComputeSampled, kTransferRead);
+    }
+    for (const auto* image : history) {
+      barriers.image(*image, kComputeSampled, kTransferWrite);
+    }
+    barriers.flush();
 
     commandBuffer.blitImage(*mHistoryLength, *mPrevHistoryLength);
     commandBuffer.blitImage(*mPosition, *mPrevPosition);
     commandBuffer.blitImage(*mNormal, *mPrevNormal);
     commandBuffer.blitImage(*mAlbedo, *mPrevAlbedo);
 
-    commandBuffer.transitionImageLayout(*mHistoryLength,
-                                        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-                                        VK_IMAGE_LAYOUT_GENERAL,
-                                        VK_PIPELINE_STAGE_TRANSFER_BIT,
-                                        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
-
-    commandBuffer.transitionImageLayout(
-        {mPosition, mNormal, mAlbedo},
-        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-        VK_PIPELINE_STAGE_TRANSFER_BIT,
-        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
-
-    commandBuffer.transitionImageLayout(
-        {&*mPrevHistoryLength, &*mPrevPosition, &*mPrevNormal, &*mPrevAlbedo},
-        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-        VK_PIPELINE_STAGE_TRANSFER_BIT,
-        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+    barriers.image(*mHistoryLength, kTransferRead, kComputeReadWrite);
+    for (const auto* image : gBuffer) {
+      barriers.image(*image, kTransferRead, kComputeSampled);
+    }
+    for (const auto* image : history) {
+      barriers.image(*image, kTransferWrite, kComputeSampled);
+    }
   }
 }
 
 void SVGFPass::setInput(const Input& input) {
-  {  // Reprojection
-    vulkan::DescriptorSet::Resources resources;
-
-    resources.images[0][0] = {
-        .sampler = mSampler->vkHandle(),
-        .imageView = input.gPosition.getView().vkHandle(),
-        .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-    };
-    resources.images[1][0] = {
-        .sampler = mSampler->vkHandle(),
-        .imageView = input.gNormal.getView().vkHandle(),
-        .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-    };
-    resources.images[2][0] = {
-        .sampler = mSampler->vkHandle(),
-        .imageView = input.gAlbedo.getView().vkHandle(),
-        .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-    };
-    resources.images[3][0] = {
-        .sampler = mSampler->vkHandle(),
-        .imageView = input.gMotion.getView().vkHandle(),
-        .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-    };
-    resources.images[4][0] = {
-        .sampler = mSampler->vkHandle(),
-        .imageView = input.noisyImage.getView().vkHandle(),
-        .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-    };
-
-    resources.images[10][0] = {
-        .sampler = mSampler->vkHandle(),
-        .imageView = mPrevPosition->getView().vkHandle(),
-        .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-    };
-    resources.images[11][0] = {
-        .sampler = mSampler->vkHandle(),
-        .imageView = mPrevNormal->getView().vkHandle(),
-        .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-    };
-    resources.images[12][0] = {
-        .sampler = mSampler->vkHandle(),
-        .imageView = mPrevAlbedo->getView().vkHandle(),
-        .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-    };
-    resources.images[13][0] = {
-        .sampler = mSampler->vkHandle(),
-        .imageView = mPrevIllumination->getView().vkHandle(),
-        .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-    };
-    resources.images[14][0] = {
-        .sampler = mSampler->vkHandle(),
-        .imageView = mPrevHistoryLength->getView().vkHandle(),
-        .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-    };
-
-    resources.images[20][0] = {
-        .sampler = VK_NULL_HANDLE,
-        .imageView = mIllumination->getView().vkHandle(),
-        .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
-    };
-    resources.images[21][0] = {
-        .sampler = VK_NULL_HANDLE,
-        .imageView = mHistoryLength->getView().vkHandle(),
-        .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
-    };
-
-    mReprojectionDescriptors.set->update(resources);
-  }
-  {  // A Trous
-    vulkan::DescriptorSet::Resources resources;
-    resources.images[0][0] = {
-        .sampler = VK_NULL_HANDLE,
-        .imageView = mFilteredImages[0]->getView().vkHandle(),
-        .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
-    };
-    resources.images[1][0] = {
-        .sampler = mSampler->vkHandle(),
-        .imageView = input.gPosition.getView().vkHandle(),
-        .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-    };
-    resources.images[2][0] = {
-        .sampler = mSampler->vkHandle(),
-        .imageView = input.gNormal.getView().vkHandle(),
-        .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-    };
-    resources.images[3][0] = {
-        .sampler = mSampler->vkHandle(),
-        .imageView = mIllumination->getView().vkHandle(),
-        .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-    };
-
-    // Set for first round: gbuffer / reprojection -> filtered image [0]
-    mATrousDescriptors.sets[0]->update(resources);
-
-    resources.images[0][0] = {
-        .sampler = VK_NULL_HANDLE,
-        .imageView = mFilteredImages[1]->getView().vkHandle(),
-        .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
-    };
-    resources.images[3][0] = {
-        .sampler = mSampler->vkHandle(),
-        .imageView = mFilteredImages[0]->getView().vkHandle(),
-        .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-    };
-
-    // Set for the second round: filtered image [0] -> filtered image [1]
-    mATrousDescriptors.sets[1]->update(resources);
-
-    resources.images[0][0] = {
-        .sampler = VK_NULL_HANDLE,
-        .imageView = mFilteredImages[0]->getView().vkHandle(),
-        .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
-    };
-    resources.images[3][0] = {
-        .sampler = mSampler->vkHandle(),
-        .imageView = mFilteredImages[1]->getView().vkHandle(),
-        .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-    };
-
-    // Set for the third round: filtered image [1] -> filtered image [0]
-    mATrousDescriptors.sets[2]->update(resources);
-  }
-  {  // Finalize
-    vulkan::DescriptorSet::Resources resources;
-    resources.images[0][0] = {
-        .sampler = mSampler->vkHandle(),
-        .imageView = input.gAlbedo.getView().vkHandle(),
-        .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-    };
-    resources.images[1][0] = {
-        .sampler = mSampler->vkHandle(),
-        .imageView = mFilteredImages[0]->getView().vkHandle(),
-        .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-    };
-    resources.images[2][0] = {
-        .sampler = VK_NULL_HANDLE,
-        .imageView = mOutputImage->getView().vkHandle(),
-        .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
-    };
-
-    mFinalizeDescriptors.set->update(resources);
-  }
-
   mPosition = &input.gPosition;
   mNormal = &input.gNormal;
   mAlbedo = &input.gAlbedo;
+  mMotion = &input.gMotion;
+  mNoisyImage = &input.noisyImage;
 }
+
 }  // namespace recore::passes
@@ -10,9 +10,12 @@ class SVGFPass : public Pass {
  public:
   explicit SVGFPass(const vulkan::Device& device);
 
-  void reloadShaders(vulkan::ShaderLibrary& shaderLibrary) override;
+  void registerShaders(vulkan::ShaderLibrary& shaderLibrary) override;
 
-  void resize(uint32_t width, uint32_t height) override;
+  [[nodiscard]] PipelineUpdate createPipelines(
+      vulkan::ShaderLibrary& shaderLibrary) override;
+
+  [[nodiscard]] PipelineUpdate resize(uint32_t width, uint32_t height) override;
 
   void execute(const vulkan::CommandBuffer& commandBuffer,
                vulkan::RenderFrame& currentFrame) override;
@@ -32,50 +35,29 @@ class SVGFPass : public Pass {
   }
 
  private:
-  // Reprojection
-  struct {
-    uPtr<vulkan::DescriptorPool> pool;
-    uPtr<vulkan::DescriptorSetLayout> layout;
-    uPtr<vulkan::DescriptorSet> set;
-  } mReprojectionDescriptors;
-
+  // All pipelines use the layout of the bindless heap
   struct {
-    uPtr<vulkan::PipelineLayout> layout;
     uPtr<vulkan::ComputePipeline> pipeline;
     vulkan::ShaderReflectionData::WorkgroupSize workgroupSize{};
   } mReprojectionPipeline;
 
-  // A Trous
   struct {
-    uPtr<vulkan::DescriptorPool> pool;
-    uPtr<vulkan::DescriptorSetLayout> layout;
-    std::array<uPtr<vulkan::DescriptorSet>, 3> sets;
-  } mATrousDescriptors;
-
-  struct {
-    uPtr<vulkan::PipelineLayout> layout;
     uPtr<vulkan::ComputePipeline> pipeline;
     vulkan::ShaderReflectionData::WorkgroupSize workgroupSize{};
   } mATrousPipeline;
 
-  // Finalize
-  struct {
-    uPtr<vulkan::DescriptorPool> pool;
-    uPtr<vulkan::DescriptorSetLayout> layout;
-    uPtr<vulkan::DescriptorSet> set;
-  } mFinalizeDescriptors;
-
   struct {
-    uPtr<vulkan::PipelineLayout> layout;
     uPtr<vulkan::ComputePipeline> pipeline;
     vulkan::ShaderReflectionData::WorkgroupSize workgroupSize{};
   } mFinalizePipeline;
 
   std::array<uPtr<vulkan::Image>, 2> mFilteredImages;
 
-  const vulkan::Image* mPosition;
-  const vulkan::Image* mNormal;
-  const vulkan::Image* mAlbedo;
+  const vulkan::Image* mPosition{nullptr};
+  const vulkan::Image* mNormal{nullptr};
+  const vulkan::Image* mAlbedo{nullptr};
+  const vulkan::Image* mMotion{nullptr};
+  const vulkan::Image* mNoisyImage{nullptr};
 
   uPtr<vulkan::Image> mOutputImage, mIllumination, mHistoryLength;
   uPtr<vulkan::Image> mPrevPosition, mPrevNormal, mPrevAlbedo,
@@ -1,12 +1,21 @@
 #version 460
 
-layout(local_size_x = 32, local_size_y = 32, local_size_z = 1) in;
+#include "taa.glslh"
 
-layout(set = 0, binding = 0, rgba32f) uniform writeonly image2D gOutputImage;
+#include <recore/shaders/bindless.glsl>
+#include <recore/shaders/workgroup_size.glslh>
 
-layout(set = 0, binding = 1) uniform sampler2D gMotion;
-layout(set = 0, binding = 2) uniform sampler2D gPrevFrame;
-layout(set = 0, binding = 3) uniform sampler2D gCurrentFrame;
+layout(local_size_x = 32, local_size_y = 32, local_size_z = 1,
+       local_size_x_id = WORKGROUP_SIZE_X_ID,
+       local_size_y_id = WORKGROUP_SIZE_Y_ID) in;
+
+PUSH_CONSTANT(TAAPush);
+
+#define gOutputImage bindlessImage2D(p.outputImage)
+
+#define gMotion bindlessSampler2D(p.motion, p.sampler)
+#define gPrevFrame bindlessSampler2D(p.prevFrame, p.sampler)
+#define gCurrentFrame bindlessSampler2D(p.currentFrame, p.sampler)
 
 #define SAMPLE_MOTION_RADIUS 1
 #define ESTIMATE_BOUNDS_RADIUS 1
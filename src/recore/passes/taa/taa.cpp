@@ -1,82 +1,35 @@
 #include "taa.h"
 
+#include "taa.glslh"
+
 namespace recore::passes {
 
 constexpr auto kTAAShader = "recore/passes/taa/taa.comp.glsl";
 
 TAAPass::TAAPass(const vulkan::Device& device) : Pass{device} {
-  {  // Initialize descriptor set layout
-    mDescriptors.pool = makeUnique<vulkan::DescriptorPool>({
-        .device = mDevice,
-        .poolSizes =
-            {
-                {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1},
-                {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 3},
-            },
-    });
-
-    mDescriptors.layout = makeUnique<vulkan::DescriptorSetLayout>({
-        .device = mDevice,
-        .bindings =
-            {
-                {
-                    {.binding = 0,
-                     .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
-                     .descriptorCount = 1,
-                     .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT},
-                },
-                {
-                    {.binding = 1,
-                     .descriptorType =
-                         VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                     .descriptorCount = 1,
-                     .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT},
-                },
-                {
-                    {.binding = 2,
-                     .descriptorType =
-                         VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                     .descriptorCount = 1,
-                     .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT},
-                },
-                {
-                    {.binding = 3,
-                     .descriptorType =
-                         VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                     .descriptorCount = 1,
-                     .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT},
-                },
-            },
-    });
-
-    mDescriptors.set = makeUnique<vulkan::DescriptorSet>({
-        .device = mDevice,
-        .pool = *mDescriptors.pool,
-        .layout = *mDescriptors.layout,
-    });
-  }
-
   mSampler = makeUnique<vulkan::Sampler>({.device = mDevice});
 }
 
-void TAAPass::reloadShaders(vulkan::ShaderLibrary& shaderLibrary) {
-  mPipelineLayout = makeUnique<vulkan::PipelineLayout>({
-      .device = mDevice,
-      .descriptorSetLayouts = {&*mDescriptors.layout},
-      .pushConstants = {},
-  });
+void TAAPass::registerShaders(vulkan::ShaderLibrary& shaderLibrary) {
+  requestShader(shaderLibrary, kTAAShader);
+}
 
+PipelineUpdate TAAPass::createPipelines(vulkan::ShaderLibrary& shaderLibrary) {
   const auto& shaderData = shaderLibrary.loadShader(kTAAShader);
-  mPipeline = makeUnique<vulkan::ComputePipeline>({
+  auto pipeline = makeUnique<vulkan::ComputePipeline>({
       .device = mDevice,
-      .layout = *mPipelineLayout,
+      .layout = mDevice.getBindlessHeap().getPipelineLayout(),
       .shader = *shaderData.shader,
   });
-  mWorkgroupSize = shaderData.reflection.workgroupSize.value();
+
+  PipelineUpdate update;
+  update.set(mPipeline, std::move(pipeline));
+  update.set(mWorkgroupSize, shaderData.reflection.workgroupSize.value());
+  return update;
 }
 
-void TAAPass::resize(uint32_t width, uint32_t height) {
-  mOutputImage = makeUnique<vulkan::Image>({
+PipelineUpdate TAAPass::resize(uint32_t width, uint32_t height) {
+  auto outputImage = makeUnique<vulkan::Image>({
       .device = mDevice,
       .format = VK_FORMAT_R32G32B32A32_SFLOAT,
       .extent = {width, height, 1},
@@ -85,7 +38,7 @@ void TAAPass::resize(uint32_t width, uint32_t height) {
       .memoryUsage = VMA_MEMORY_USAGE_GPU_ONLY,
   });
 
-  mPrevFrame = makeUnique<vulkan::Image>({
+  auto prevFrame = makeUnique<vulkan::Image>({
       .device = mDevice,
       .format = VK_FORMAT_R32G32B32A32_SFLOAT,
       .extent = {width, height, 1},
@@ -94,28 +47,35 @@ void TAAPass::resize(uint32_t width, uint32_t height) {
       .memoryUsage = VMA_MEMORY_USAGE_GPU_ONLY,
   });
 
-  mDevice.submitAndWait([&](const auto& commandBuffer) {
-    commandBuffer.transitionImageLayout(*mOutputImage,
-                                        VK_IMAGE_LAYOUT_UNDEFINED,
-                                        VK_IMAGE_LAYOUT_GENERAL,
-                                        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-                                        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
-
-    commandBuffer.transitionImageLayout(
-        *mPrevFrame,
-        VK_IMAGE_LAYOUT_UNDEFINED,
-        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+  mDevice.getImmediateContext().record([&](const auto& commandBuffer) {
+    using namespace vulkan::access;
+    vulkan::BarrierBatch{commandBuffer}
+        .image(*outputImage, kNone, kComputeWrite)
+        .image(*prevFrame, kNone, kComputeSampled);
   });
+
+  PipelineUpdate update;
+  update.set(mOutputImage, std::move(outputImage));
+  update.set(mPrevFrame, std::move(prevFrame));
+  return update;
 }
 
 void TAAPass::execute(const vulkan::CommandBuffer& commandBuffer,
                       vulkan::RenderFrame& currentFrame) {
   RECORE_GPU_PROFILE_SCOPE(currentFrame, commandBuffer, "TAA::execute");
 
+  mDevice.getBindlessHeap().bind(commandBuffer,
+                                 VK_PIPELINE_BIND_POINT_COMPUTE);
   commandBuffer.bindPipeline(*mPipeline);
-  commandBuffer.bindDescriptorSet(*mPipeline, *mDescriptors.set, 0);
+
+  TAAPush p{
+      .outputImage = mOutputImage->getStorageHandle(),
+      .motion = mMotion->getSampledHandle(),
+      .prevFrame = mPrevFrame->getSampledHandle(),
+      .currentFrame = mInputImage->getSampledHandle(),
+      .sampler = mSampler->getHandle(),
+  };
+  commandBuffer.pushConstants(mPipeline->getLayout(), p);
 
   vulkan::CommandBuffer::DispatchDim dispatchDim = {
       vulkan::dispatchSize(mWorkgroupSize.x, mOutputImage->getWidth()),
@@ -125,62 +85,22 @@ void TAAPass::execute(const vulkan::CommandBuffer& commandBuffer,
   commandBuffer.dispatch(dispatchDim);
 
   {  // Blit to save previous frame
-    commandBuffer.transitionImageLayout(*mOutputImage,
-                                        VK_IMAGE_LAYOUT_GENERAL,
-                                        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-                                        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-                                        VK_PIPELINE_STAGE_TRANSFER_BIT);
-
-    commandBuffer.transitionImageLayout(
-        *mPrevFrame,
-        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-        VK_PIPELINE_STAGE_TRANSFER_BIT);
+    using namespace vulkan::access;
+    vulkan::BarrierBatch{commandBuffer}
+        .image(*mOutputImage, kComputeWrite, kTransferRead)
+        .image(*mPrevFrame, kComputeSampled, kTransferWrite);
 
     commandBuffer.blitImage(*mOutputImage, *mPrevFrame);
 
-    commandBuffer.transitionImageLayout(*mOutputImage,
-                                        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-                                        VK_IMAGE_LAYOUT_GENERAL,
-                                        VK_PIPELINE_STAGE_TRANSFER_BIT,
-                                        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
-
-    commandBuffer.transitionImageLayout(
-        *mPrevFrame,
-        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-        VK_PIPELINE_STAGE_TRANSFER_BIT,
-        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+    vulkan::BarrierBatch{commandBuffer}
+        .image(*mOutputImage, kTransferRead, kComputeRead)
+        .image(*mPrevFrame, kTransferWrite, kComputeSampled);
   }
 }
 
 void TAAPass::setInput(const Input& input) {
-  vulkan::DescriptorSet::Resources resources;
-
-  resources.images[0][0] = {
-      .sampler = VK_NULL_HANDLE,
-      .imageView = mOutputImage->getView().vkHandle(),
-      .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
-  };
-
-  resources.images[1][0] = {
-      .sampler = mSampler->vkHandle(),
-      .imageView = input.gMotion.getView().vkHandle(),
-      .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-  };
-  resources.images[2][0] = {
-      .sampler = mSampler->vkHandle(),
-      .imageView = mPrevFrame->getView().vkHandle(),
-      .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-  };
-  resources.images[3][0] = {
-      .sampler = mSampler->vkHandle(),
-      .imageView = input.image.getView().vkHandle(),
-      .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-  };
-
-  mDescriptors.set->update(resources);
+  mMotion = &input.gMotion;
+  mInputImage = &input.image;
 }
 
 }  // namespace recore::passes
@@ -8,9 +8,12 @@ class TAAPass : public Pass {
  public:
   explicit TAAPass(const vulkan::Device& device);
 
-  void reloadShaders(vulkan::ShaderLibrary& shaderLibrary) override;
+  void registerShaders(vulkan::ShaderLibrary& shaderLibrary) override;
 
-  void resize(uint32_t width, uint32_t height) override;
+  [[nodiscard]] PipelineUpdate createPipelines(
+      vulkan::ShaderLibrary& shaderLibrary) override;
+
+  [[nodiscard]] PipelineUpdate resize(uint32_t width, uint32_t height) override;
 
   void execute(const vulkan::CommandBuffer& commandBuffer,
                vulkan::RenderFrame& currentFrame) override;
@@ -27,18 +30,15 @@ class TAAPass : public Pass {
   }
 
  private:
-  struct {
-    uPtr<vulkan::DescriptorPool> pool;
-    uPtr<vulkan::DescriptorSetLayout> layout;
-    uPtr<vulkan::DescriptorSet> set;
-  } mDescriptors;
-
-  uPtr<vulkan::PipelineLayout> mPipelineLayout;
+  // Uses the layout of the bindless heap
   uPtr<vulkan::ComputePipeline> mPipeline;
   vulkan::ShaderReflectionData::WorkgroupSize mWorkgroupSize{};
 
   uPtr<vulkan::Sampler> mSampler;
 
+  const vulkan::Image* mMotion{nullptr};
+  const vulkan::Image* mInputImage{nullptr};
+
   uPtr<vulkan::Image> mPrevFrame;
   uPtr<vulkan::Image> mOutputImage;
 };
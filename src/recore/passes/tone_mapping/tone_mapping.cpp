@@ -22,6 +22,8 @@ ToneMappingPass::ToneMappingPass(const vulkan::Device& device) : Pass{device} {
           {
               {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1},
           },
+      .maxSets = FrameDescriptorSet::kSetCount,
+      .perSet = true,
   });
 
   mDescriptors.layout = makeUnique<vulkan::DescriptorSetLayout>({
@@ -37,7 +39,7 @@ ToneMappingPass::ToneMappingPass(const vulkan::Device& device) : Pass{device} {
           },
   });
 
-  mDescriptors.set = makeUnique<vulkan::DescriptorSet>({
+  mDescriptors.set = makeUnique<FrameDescriptorSet>({
       .device = mDevice,
       .pool = *mDescriptors.pool,
       .layout = *mDescriptors.layout,
@@ -46,8 +48,8 @@ ToneMappingPass::ToneMappingPass(const vulkan::Device& device) : Pass{device} {
   mSampler = makeUnique<vulkan::Sampler>({.device = mDevice});
 }
 
-void ToneMappingPass::resize(uint32_t width, uint32_t height) {
-  mOutputImage = makeUnique<vulkan::Image>({
+PipelineUpdate ToneMappingPass::resize(uint32_t width, uint32_t height) {
+  auto outputImage = makeUnique<vulkan::Image>({
       .device = mDevice,
       .format = VK_FORMAT_R8G8B8A8_UNORM,
       .extent = {width, height, 1},
@@ -56,16 +58,27 @@ void ToneMappingPass::resize(uint32_t width, uint32_t height) {
       .memoryUsage = VMA_MEMORY_USAGE_GPU_ONLY,
   });
 
-  mFramebuffer = makeUnique<vulkan::Framebuffer>(
+  auto framebuffer = makeUnique<vulkan::Framebuffer>(
       {.device = mDevice,
        .renderPass = *mRenderPass,
-       .attachments = {&mOutputImage->getView()},
+       .attachments = {&outputImage->getView()},
        .width = width,
        .height = height});
+
+  PipelineUpdate update;
+  update.set(mOutputImage, std::move(outputImage));
+  update.set(mFramebuffer, std::move(framebuffer));
+  return update;
+}
+
+void ToneMappingPass::registerShaders(vulkan::ShaderLibrary& shaderLibrary) {
+  requestShader(shaderLibrary, kFullscreenShader);
+  requestShader(shaderLibrary, kToneMappingShader);
 }
 
-void ToneMappingPass::reloadShaders(vulkan::ShaderLibrary& shaderLibrary) {
-  mPipelineLayout = makeUnique<vulkan::PipelineLayout>(
+PipelineUpdate ToneMappingPass::createPipelines(
+    vulkan::ShaderLibrary& shaderLibrary) {
+  auto pipelineLayout = makeUnique<vulkan::PipelineLayout>(
       {.device = mDevice,
        .descriptorSetLayouts = {&*mDescriptors.layout},
        .pushConstants = {
@@ -75,13 +88,18 @@ void ToneMappingPass::reloadShaders(vulkan::ShaderLibrary& shaderLibrary) {
   const auto& vertexShader = shaderLibrary.loadShader(kFullscreenShader);
   const auto& fragmentShader = shaderLibrary.loadShader(kToneMappingShader);
 
-  mPipeline = makeUnique<vulkan::RasterPipeline>({
+  auto pipeline = makeUnique<vulkan::RasterPipeline>({
       .device = mDevice,
-      .layout = *mPipelineLayout,
+      .layout = *pipelineLayout,
       .renderPass = *mRenderPass,
       .state = {},
       .shaders = {vertexShader, fragmentShader},
   });
+
+  PipelineUpdate update;
+  update.set(mPipelineLayout, std::move(pipelineLayout));
+  update.set(mPipeline, std::move(pipeline));
+  return update;
 }
 
 void ToneMappingPass::execute(const vulkan::CommandBuffer& commandBuffer,
@@ -96,7 +114,7 @@ void ToneMappingPass::execute(const vulkan::CommandBuffer& commandBuffer,
                                 });
 
   commandBuffer.bindPipeline(*mPipeline);
-  commandBuffer.bindDescriptorSet(*mPipeline, *mDescriptors.set, 0);
+  commandBuffer.bindDescriptorSet(*mPipeline, mDescriptors.set->get(), 0);
 
   ToneMappingPush p{
       .gamma = mSettings.gamma,
@@ -118,7 +136,8 @@ void ToneMappingPass::setInput(const vulkan::Image& inputImage) {
       .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
   };
 
-  mDescriptors.set->update(resources);
+  mDescriptors.set->write(
+      [resources](const auto& set) { set.update(resources); });
 }
 
 }  // namespace recore::passes
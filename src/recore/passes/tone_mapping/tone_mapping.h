@@ -13,9 +13,12 @@ class ToneMappingPass : public Pass {
  public:
   explicit ToneMappingPass(const vulkan::Device& device);
 
-  void resize(uint32_t width, uint32_t height) override;
+  [[nodiscard]] PipelineUpdate resize(uint32_t width, uint32_t height) override;
 
-  void reloadShaders(vulkan::ShaderLibrary& shaderLibrary) override;
+  void registerShaders(vulkan::ShaderLibrary& shaderLibrary) override;
+
+  [[nodiscard]] PipelineUpdate createPipelines(
+      vulkan::ShaderLibrary& shaderLibrary) override;
 
   void execute(const vulkan::CommandBuffer& commandBuffer,
                vulkan::RenderFrame& currentFrame) override;
@@ -34,7 +37,7 @@ class ToneMappingPass : public Pass {
   struct {
     uPtr<vulkan::DescriptorPool> pool;
     uPtr<vulkan::DescriptorSetLayout> layout;
-    uPtr<vulkan::DescriptorSet> set;
+    uPtr<FrameDescriptorSet> set;
   } mDescriptors;
 
   uPtr<vulkan::Sampler> mSampler;
@@ -10,7 +10,11 @@
 
 #include "volume_pathtracer.glslh"
 
-layout(local_size_x = 32, local_size_y = 32, local_size_z = 1) in;
+#include <recore/shaders/workgroup_size.glslh>
+
+layout(local_size_x = 32, local_size_y = 32, local_size_z = 1,
+       local_size_x_id = WORKGROUP_SIZE_X_ID,
+       local_size_y_id = WORKGROUP_SIZE_Y_ID) in;
 
 layout(set = 1, binding = 0, rgba32f) uniform image2D gOutputImage;
 
@@ -148,7 +152,7 @@ vec3 evalNEE(ShadingData sd, vec3 wi) {
   vec3 wo = -sunLight.direction;
   vec3 lambert = Lambert_eval(sd, normalize(wo));
   vec3 lightWeight = DirectionalLight_eval(sunLight);
-  float shadow = float(!traceShadowRay(Ray(sd.P, 1000 * wo)));
+  float shadow = float(!traceShadowRay(p.scene, Ray(sd.P, 1000 * wo)));
 
   float t = abs(dot(sd.P - light.position, normalize(sunLight.direction))) / length(sunLight.direction);
   float T = evalTransmittance(t, MediumSample_mu_t(sampleMedium(sd.P)));
@@ -163,7 +167,7 @@ vec3 evalNEEVolume(vec3 P, vec3 wi) {
   vec3 wo = -normalize(sunLight.direction);
   float phase = HGPhase_eval(HG_FORWARDNESS, dot(wo, wi));
   vec3 lightWeight = DirectionalLight_eval(sunLight);
-  float shadow = float(!traceShadowRay(Ray(P, 1000 * wo)));
+  float shadow = float(!traceShadowRay(p.scene, Ray(P, 1000 * wo)));
 
   return phase * lightWeight * shadow;
 }
@@ -228,7 +232,7 @@ vec3 tracePathVolume(inout RandomSampler rng, ivec2 pixel, ShadingData sd, vec3
           // Update ray
           ray = Ray(mediumPosition, brdfSample.wo);
           Hit hit;
-          if(!traceRay(ray, hit)) {
+          if(!traceRay(p.scene, ray, hit)) {
             terminate = true;
             break;
           }
@@ -277,7 +281,7 @@ vec3 tracePathVolume(inout RandomSampler rng, ivec2 pixel, ShadingData sd, vec3
     // Trace path
     ray = Ray(sd.P + M_EPSILON * sd.N, brdfSample.wo);
     Hit hit;
-    if(!traceRay(ray, hit)) {
+    if(!traceRay(p.scene, ray, hit)) {
       break;
     }
 
@@ -19,6 +19,8 @@ VolumePathTracerPass::VolumePathTracerPass(const vulkan::Device& device,
                 {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1},
                 {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4},
             },
+        .maxSets = FrameDescriptorSet::kSetCount,
+        .perSet = true,
     });
 
     mDescriptors.layout = makeUnique<vulkan::DescriptorSetLayout>({
@@ -62,18 +64,30 @@ VolumePathTracerPass::VolumePathTracerPass(const vulkan::Device& device,
             },
     });
 
-    mDescriptors.set = makeUnique<vulkan::DescriptorSet>({
+    mDescriptors.set = makeUnique<FrameDescriptorSet>({
         .device = mDevice,
         .pool = *mDescriptors.pool,
         .layout = *mDescriptors.layout,
     });
+
+    mDescriptors.updateTemplate = makeUnique<vulkan::DescriptorUpdateTemplate>({
+        .device = mDevice,
+        .layout = *mDescriptors.layout,
+        .entries = vulkan::DescriptorUpdateTemplate::getEntries<Descriptors>(),
+    });
   }
 
   mSampler = makeUnique<vulkan::Sampler>({.device = mDevice});
 }
 
-void VolumePathTracerPass::reloadShaders(vulkan::ShaderLibrary& shaderLibrary) {
-  mPipelineLayout = makeUnique<vulkan::PipelineLayout>({
+void VolumePathTracerPass::registerShaders(
+    vulkan::ShaderLibrary& shaderLibrary) {
+  requestShader(shaderLibrary, kPathTracerShader);
+}
+
+PipelineUpdate VolumePathTracerPass::createPipelines(
+    vulkan::ShaderLibrary& shaderLibrary) {
+  auto pipelineLayout = makeUnique<vulkan::PipelineLayout>({
       .device = mDevice,
       .descriptorSetLayouts = {&mScene.getDescriptorSetLayout(),
                                &*mDescriptors.layout},
@@ -84,16 +98,21 @@ void VolumePathTracerPass::reloadShaders(vulkan::ShaderLibrary& shaderLibrary) {
   });
 
   const auto& shaderData = shaderLibrary.loadShader(kPathTracerShader);
-  mPipeline = makeUnique<vulkan::ComputePipeline>({
+  auto pipeline = makeUnique<vulkan::ComputePipeline>({
       .device = mDevice,
-      .layout = *mPipelineLayout,
+      .layout = *pipelineLayout,
       .shader = *shaderData.shader,
   });
-  mWorkgroupSize = shaderData.reflection.workgroupSize.value();
+
+  PipelineUpdate update;
+  update.set(mPipelineLayout, std::move(pipelineLayout));
+  update.set(mPipeline, std::move(pipeline));
+  update.set(mWorkgroupSize, shaderData.reflection.workgroupSize.value());
+  return update;
 }
 
-void VolumePathTracerPass::resize(uint32_t width, uint32_t height) {
-  mOutputImage = makeUnique<vulkan::Image>({
+PipelineUpdate VolumePathTracerPass::resize(uint32_t width, uint32_t height) {
+  auto outputImage = makeUnique<vulkan::Image>({
       .device = mDevice,
       .format = VK_FORMAT_R32G32B32A32_SFLOAT,
       .extent = {width, height, 1},
@@ -102,13 +121,14 @@ void VolumePathTracerPass::resize(uint32_t width, uint32_t height) {
       .memoryUsage = VMA_MEMORY_USAGE_GPU_ONLY,
   });
 
-  mDevice.submitAndWait([&](const auto& commandBuffer) {
-    commandBuffer.transitionImageLayout(*mOutputImage,
-                                        VK_IMAGE_LAYOUT_UNDEFINED,
-                                        VK_IMAGE_LAYOUT_GENERAL,
-                                        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-                                        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+  mDevice.getImmediateContext().record([&](const auto& commandBuffer) {
+    vulkan::BarrierBatch{commandBuffer}.image(
+        *outputImage, vulkan::access::kNone, vulkan::access::kComputeWrite);
   });
+
+  PipelineUpdate update;
+  update.set(mOutputImage, std::move(outputImage));
+  return update;
 }
 
 void VolumePathTracerPass::execute(const vulkan::CommandBuffer& commandBuffer,
@@ -116,12 +136,6 @@ void VolumePathTracerPass::execute(const vulkan::CommandBuffer& commandBuffer,
   RECORE_GPU_PROFILE_SCOPE(
       currentFrame, commandBuffer, "VolumePathTracer::execute");
 
-  commandBuffer.transitionImageLayout(*mOutputImage,
-                                      VK_IMAGE_LAYOUT_UNDEFINED,
-                                      VK_IMAGE_LAYOUT_GENERAL,
-                                      VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-                                      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
-
   uint32_t rngSeed = static_cast<uint32_t>(
       std::chrono::system_clock::now().time_since_epoch().count());
 
@@ -132,7 +146,7 @@ void VolumePathTracerPass::execute(const vulkan::CommandBuffer& commandBuffer,
 
   commandBuffer.bindPipeline(*mPipeline);
   commandBuffer.bindDescriptorSet(*mPipeline, mScene.getDescriptorSet(), 0);
-  commandBuffer.bindDescriptorSet(*mPipeline, *mDescriptors.set, 1);
+  commandBuffer.bindDescriptorSet(*mPipeline, mDescriptors.set->get(), 1);
 
   commandBuffer.pushConstants(*mPipelineLayout, p);
 
@@ -145,36 +159,16 @@ void VolumePathTracerPass::execute(const vulkan::CommandBuffer& commandBuffer,
 }
 
 void VolumePathTracerPass::setInput(const Input& input) {
-  vulkan::DescriptorSet::Resources resources;
-
-  resources.images[0][0] = {
-      .sampler = VK_NULL_HANDLE,
-      .imageView = mOutputImage->getView().vkHandle(),
-      .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
-  };
-
-  resources.images[1][0] = {
-      .sampler = mSampler->vkHandle(),
-      .imageView = input.gPosition.getView().vkHandle(),
-      .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-  };
-  resources.images[2][0] = {
-      .sampler = mSampler->vkHandle(),
-      .imageView = input.gNormal.getView().vkHandle(),
-      .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+  const Descriptors descriptors{
+      .outputImage = vulkan::getStorageImageInfo(*mOutputImage),
+      .gPosition = vulkan::getSampledImageInfo(input.gPosition, *mSampler),
+      .gNormal = vulkan::getSampledImageInfo(input.gNormal, *mSampler),
+      .gAlbedo = vulkan::getSampledImageInfo(input.gAlbedo, *mSampler),
+      .gEmissive = vulkan::getSampledImageInfo(input.gEmissive, *mSampler),
   };
-  resources.images[3][0] = {
-      .sampler = mSampler->vkHandle(),
-      .imageView = input.gAlbedo.getView().vkHandle(),
-      .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-  };
-  resources.images[4][0] = {
-      .sampler = mSampler->vkHandle(),
-      .imageView = input.gEmissive.getView().vkHandle(),
-      .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-  };
-
-  mDescriptors.set->update(resources);
+  mDescriptors.set->write([this, descriptors](const auto& set) {
+    mDescriptors.updateTemplate->update(set, &descriptors);
+  });
 }
 
 }  // namespace recore::passes
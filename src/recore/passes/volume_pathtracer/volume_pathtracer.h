@@ -11,9 +11,12 @@ class VolumePathTracerPass : public Pass {
   explicit VolumePathTracerPass(const vulkan::Device& device,
                                  const scene::GPUScene& scene);
 
-  void reloadShaders(vulkan::ShaderLibrary& shaderLibrary) override;
+  void registerShaders(vulkan::ShaderLibrary& shaderLibrary) override;
 
-  void resize(uint32_t width, uint32_t height) override;
+  [[nodiscard]] PipelineUpdate createPipelines(
+      vulkan::ShaderLibrary& shaderLibrary) override;
+
+  [[nodiscard]] PipelineUpdate resize(uint32_t width, uint32_t height) override;
 
   void execute(const vulkan::CommandBuffer& commandBuffer,
                vulkan::RenderFrame& currentFrame) override;
@@ -34,10 +37,20 @@ class VolumePathTracerPass : public Pass {
  private:
   const scene::GPUScene& mScene;
 
+  // Set 1 in binding order, written with the update template
+  struct Descriptors {
+    VkDescriptorImageInfo outputImage;
+    VkDescriptorImageInfo gPosition;
+    VkDescriptorImageInfo gNormal;
+    VkDescriptorImageInfo gAlbedo;
+    VkDescriptorImageInfo gEmissive;
+  };
+
   struct {
     uPtr<vulkan::DescriptorPool> pool;
     uPtr<vulkan::DescriptorSetLayout> layout;
-    uPtr<vulkan::DescriptorSet> set;
+    uPtr<FrameDescriptorSet> set;
+    uPtr<vulkan::DescriptorUpdateTemplate> updateTemplate;
   } mDescriptors;
 
   uPtr<vulkan::PipelineLayout> mPipelineLayout;
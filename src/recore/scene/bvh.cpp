@@ -0,0 +1,332 @@
+#include "bvh.h"
+
+#include <cassert>
+#include <future>
+#include <numeric>
+
+namespace recore::scene {
+
+namespace {
+
+constexpr uint32_t kBinCount = 16;
+constexpr uint32_t kMaxLeafSize = 4;
+// Subtrees below this size are built serially by one worker
+constexpr uint32_t kParallelBuildThreshold = 8 * 1024;
+
+struct BuildNode {
+  Bounds bounds;
+  uint32_t left = 0;
+  uint32_t right = 0;
+  uint32_t first = 0;
+  uint32_t count = 0;  // > 0 for leaves
+};
+
+class BinaryBuilder {
+ public:
+  BinaryBuilder(const std::vector<Bounds>& primitiveBounds,
+                const std::vector<glm::vec3>& centroids,
+                std::vector<uint32_t>& indices)
+      : mPrimitiveBounds{primitiveBounds},
+        mCentroids{centroids},
+        mIndices{indices} {}
+
+  // Partitions [begin, end) and returns the split position, or end if the
+  // range should become a leaf
+  uint32_t split(uint32_t begin,
+                 uint32_t end,
+                 uint32_t depth,
+                 Bounds& bounds) const {
+    Bounds centroidBounds;
+    for (uint32_t i = begin; i < end; i++) {
+      bounds.grow(mPrimitiveBounds[mIndices[i]]);
+      centroidBounds.grow(mCentroids[mIndices[i]]);
+    }
+
+    uint32_t count = end - begin;
+    if (count <= kMaxLeafSize) {
+      return end;
+    }
+    assert(depth < BVH::kMaxBuildDepth);
+
+    auto extent = centroidBounds.max - centroidBounds.min;
+    uint32_t axis = 0;
+    if (extent.y > extent[axis]) {
+      axis = 1;
+    }
+    if (extent.z > extent[axis]) {
+      axis = 2;
+    }
+
+    if (extent[axis] <= 0.f || depth >= BVH::kMaxSAHDepth) {
+      return medianSplit(begin, end, axis);
+    }
+
+    struct Bin {
+      Bounds bounds;
+      uint32_t count = 0;
+    };
+    std::array<Bin, kBinCount> bins{};
+
+    float scale = kBinCount / extent[axis];
+    auto binIndex = [&](uint32_t primitive) {
+      auto bin = static_cast<uint32_t>(
+          (mCentroids[primitive][axis] - centroidBounds.min[axis]) * scale);
+      return std::min(bin, kBinCount - 1);
+    };
+
+    for (uint32_t i = begin; i < end; i++) {
+      auto& bin = bins[binIndex(mIndices[i])];
+      bin.bounds.grow(mPrimitiveBounds[mIndices[i]]);
+      bin.count++;
+    }
+
+    // Sweep from the right to get the cost of all right partitions
+    std::array<float, kBinCount> rightCosts{};
+    Bounds rightBounds;
+    uint32_t rightCount = 0;
+    for (uint32_t i = kBinCount - 1; i > 0; i--) {
+      rightBounds.grow(bins[i].bounds);
+      rightCount += bins[i].count;
+      rightCosts[i] = rightBounds.getSurfaceArea() * rightCount;
+    }
+
+    float bestCost = std::numeric_limits<float>::max();
+    uint32_t bestSplit = 0;
+    Bounds leftBounds;
+    uint32_t leftCount = 0;
+    for (uint32_t i = 0; i < kBinCount - 1; i++) {
+      leftBounds.grow(bins[i].bounds);
+      leftCount += bins[i].count;
+      float cost = leftBounds.getSurfaceArea() * leftCount + rightCosts[i + 1];
+      if (cost < bestCost) {
+        bestCost = cost;
+        bestSplit = i;
+      }
+    }
+
+    auto* middle = std::partition(
+        mIndices.data() + begin,
+        mIndices.data() + end,
+        [&](uint32_t primitive) { return binIndex(primitive) <= bestSplit; });
+    auto mid = static_cast<uint32_t>(middle - mIndices.data());
+
+    if (mid == begin || mid == end) {
+      return medianSplit(begin, end, axis);
+    }
+    return mid;
+  }
+
+  uint32_t build(std::vector<BuildNode>& nodes,
+                 uint32_t begin,
+                 uint32_t end,
+                 uint32_t depth) const {
+    auto index = static_cast<uint32_t>(nodes.size());
+    nodes.emplace_back();
+
+    Bounds bounds;
+    auto mid = split(begin, end, depth, bounds);
+    nodes[index].bounds = bounds;
+
+    if (mid == end) {
+      nodes[index].first = begin;
+      nodes[index].count = end - begin;
+      return index;
+    }
+
+    auto left = build(nodes, begin, mid, depth + 1);
+    auto right = build(nodes, mid, end, depth + 1);
+    nodes[index].left = left;
+    nodes[index].right = right;
+    return index;
+  }
+
+ private:
+  uint32_t medianSplit(uint32_t begin, uint32_t end, uint32_t axis) const {
+    uint32_t mid = begin + (end - begin) / 2;
+    std::nth_element(mIndices.data() + begin,
+                     mIndices.data() + mid,
+                     mIndices.data() + end,
+                     [&](uint32_t a, uint32_t b) {
+                       return mCentroids[a][axis] < mCentroids[b][axis];
+                     });
+    return mid;
+  }
+
+  const std::vector<Bounds>& mPrimitiveBounds;
+  const std::vector<glm::vec3>& mCentroids;
+  std::vector<uint32_t>& mIndices;
+};
+
+struct SubtreeTask {
+  uint32_t node;
+  uint32_t begin;
+  uint32_t end;
+  uint32_t depth;
+};
+
+// Splits the top of the tree on the calling thread and collects the subtrees
+// that are handed to the workers
+uint32_t buildTop(const BinaryBuilder& builder,
+                  std::vector<BuildNode>& nodes,
+                  std::vector<SubtreeTask>& tasks,
+                  uint32_t begin,
+                  uint32_t end,
+                  uint32_t depth) {
+  auto index = static_cast<uint32_t>(nodes.size());
+  nodes.emplace_back();
+
+  if (end - begin <= kParallelBuildThreshold) {
+    tasks.push_back({index, begin, end, depth});
+    return index;
+  }
+
+  Bounds bounds;
+  auto mid = builder.split(begin, end, depth, bounds);
+  nodes[index].bounds = bounds;
+
+  if (mid == end) {
+    nodes[index].first = begin;
+    nodes[index].count = end - begin;
+    return index;
+  }
+
+  auto left = buildTop(builder, nodes, tasks, begin, mid, depth + 1);
+  auto right = buildTop(builder, nodes, tasks, mid, end, depth + 1);
+  nodes[index].left = left;
+  nodes[index].right = right;
+  return index;
+}
+
+}  // namespace
+
+void BVH::build(const std::vector<Bounds>& primitiveBounds,
+                core::ThreadPool* threadPool) {
+  mNodes.clear();
+  mPrimitiveIndices.resize(primitiveBounds.size());
+  std::iota(mPrimitiveIndices.begin(), mPrimitiveIndices.end(), 0);
+  mBounds = {};
+
+  if (primitiveBounds.empty()) {
+    return;
+  }
+
+  std::vector<glm::vec3> centroids;
+  centroids.reserve(primitiveBounds.size());
+  for (const auto& bounds : primitiveBounds) {
+    centroids.push_back(bounds.getCenter());
+  }
+
+  BinaryBuilder builder{primitiveBounds, centroids, mPrimitiveIndices};
+  auto primitiveCount = static_cast<uint32_t>(primitiveBounds.size());
+
+  std::vector<BuildNode> nodes;
+  nodes.reserve(2 * primitiveCount / kMaxLeafSize + 1);
+
+  if (threadPool != nullptr && primitiveCount > kParallelBuildThreshold) {
+    std::vector<SubtreeTask> tasks;
+    buildTop(builder, nodes, tasks, 0, primitiveCount, 0);
+
+    std::vector<std::vector<BuildNode>> subtrees(tasks.size());
+    std::vector<std::future<void>> futures;
+    futures.reserve(tasks.size());
+    for (size_t i = 0; i < tasks.size(); i++) {
+      futures.push_back(threadPool->submit([&, i]() {
+        const auto& task = tasks[i];
+        builder.build(subtrees[i], task.begin, task.end, task.depth);
+      }));
+    }
+    for (auto& future : futures) {
+      future.get();
+    }
+
+    // Stitch the subtrees into the top of the tree. The subtree root replaces
+    // the placeholder node, everything else is appended.
+    for (size_t i = 0; i < tasks.size(); i++) {
+      auto& subtree = subtrees[i];
+      auto offset = static_cast<uint32_t>(nodes.size()) - 1;
+      for (auto& node : subtree) {
+        if (node.count == 0) {
+          node.left += offset;
+          node.right += offset;
+        }
+      }
+      nodes[tasks[i].node] = subtree[0];
+      nodes.insert(nodes.end(), subtree.begin() + 1, subtree.end());
+    }
+  } else {
+    builder.build(nodes, 0, primitiveCount, 0);
+  }
+
+  mBounds = nodes[0].bounds;
+
+  // Collapse into 4-wide nodes by repeatedly opening the inner child with the
+  // largest surface area
+  mNodes.reserve(nodes.size() / 2 + 1);
+
+  auto collapse = [&](auto&& self, uint32_t binaryNode) -> uint32_t {
+    std::array<uint32_t, kWidth> children{};
+    uint32_t childCount = 0;
+
+    const auto& root = nodes[binaryNode];
+    if (root.count > 0) {
+      children[childCount++] = binaryNode;
+    } else {
+      children[childCount++] = root.left;
+      children[childCount++] = root.right;
+    }
+
+    while (childCount < kWidth) {
+      int32_t largest = -1;
+      float largestArea = -1.f;
+      for (uint32_t i = 0; i < childCount; i++) {
+        const auto& child = nodes[children[i]];
+        if (child.count == 0 && child.bounds.getSurfaceArea() > largestArea) {
+          largest = static_cast<int32_t>(i);
+          largestArea = child.bounds.getSurfaceArea();
+        }
+      }
+      if (largest < 0) {
+        break;
+      }
+
+      const auto& opened = nodes[children[largest]];
+      children[largest] = opened.left;
+      children[childCount++] = opened.right;
+    }
+
+    auto index = static_cast<uint32_t>(mNodes.size());
+    mNodes.emplace_back();
+
+    Node node{};
+    node.childCount = childCount;
+    for (uint32_t i = 0; i < kWidth; i++) {
+      if (i >= childCount) {
+        node.minX[i] = node.minY[i] = node.minZ[i] = 0.f;
+        node.maxX[i] = node.maxY[i] = node.maxZ[i] = 0.f;
+        continue;
+      }
+
+      const auto& child = nodes[children[i]];
+      node.minX[i] = child.bounds.min.x;
+      node.minY[i] = child.bounds.min.y;
+      node.minZ[i] = child.bounds.min.z;
+      node.maxX[i] = child.bounds.max.x;
+      node.maxY[i] = child.bounds.max.y;
+      node.maxZ[i] = child.bounds.max.z;
+
+      if (child.count > 0) {
+        node.children[i] = child.first;
+        node.counts[i] = child.count;
+      } else {
+        node.children[i] = self(self, children[i]);
+        node.counts[i] = 0;
+      }
+    }
+
+    mNodes[index] = node;
+    return index;
+  };
+  collapse(collapse, 0);
+}
+
+}  // namespace recore::scene
@@ -0,0 +1,240 @@
+#pragma once
+
+#include <recore/core/thread_pool.h>
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#if defined(__SSE__) || defined(_M_X64) || defined(_M_AMD64)
+#define RECORE_BVH_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace recore::scene {
+
+struct Bounds {
+  glm::vec3 min{std::numeric_limits<float>::max()};
+  glm::vec3 max{std::numeric_limits<float>::lowest()};
+
+  void grow(const glm::vec3& point) {
+    min = glm::min(min, point);
+    max = glm::max(max, point);
+  }
+
+  void grow(const Bounds& bounds) {
+    min = glm::min(min, bounds.min);
+    max = glm::max(max, bounds.max);
+  }
+
+  [[nodiscard]] bool isEmpty() const {
+    return min.x > max.x || min.y > max.y || min.z > max.z;
+  }
+
+  [[nodiscard]] glm::vec3 getCenter() const { return 0.5f * (min + max); }
+
+  [[nodiscard]] float getSurfaceArea() const {
+    if (isEmpty()) {
+      return 0.f;
+    }
+    auto extent = max - min;
+    return 2.f * (extent.x * extent.y + extent.y * extent.z +
+                  extent.z * extent.x);
+  }
+};
+
+// Bounding volume hierarchy with 4-wide nodes over primitive bounds. Built as a
+// binned SAH binary tree and collapsed afterwards. The BVH only knows about
+// bounds, intersecting the primitives is up to the caller of traverse().
+class BVH {
+ public:
+  static constexpr uint32_t kWidth = 4;
+
+  // Of the binary build tree. Beyond kMaxSAHDepth only median splits follow,
+  // which halve the at most 2^32 primitives.
+  static constexpr uint32_t kMaxSAHDepth = 48;
+  static constexpr uint32_t kMaxBuildDepth = kMaxSAHDepth + 32;
+
+  struct alignas(16) Node {
+    float minX[kWidth];
+    float minY[kWidth];
+    float minZ[kWidth];
+    float maxX[kWidth];
+    float maxY[kWidth];
+    float maxZ[kWidth];
+    // Inner node index, or first leaf primitive if count > 0
+    uint32_t children[kWidth];
+    uint32_t counts[kWidth];
+    uint32_t childCount;
+  };
+
+  // Builds in parallel when a thread pool is given. Must not be called from a
+  // worker of that thread pool.
+  void build(const std::vector<Bounds>& primitiveBounds,
+             core::ThreadPool* threadPool = nullptr);
+
+  [[nodiscard]] const Bounds& getBounds() const { return mBounds; }
+
+  [[nodiscard]] const std::vector<Node>& getNodes() const { return mNodes; }
+
+  // Maps the leaf order used by traverse() to the original primitive index
+  [[nodiscard]] const std::vector<uint32_t>& getPrimitiveIndices() const {
+    return mPrimitiveIndices;
+  }
+
+  // Calls intersect(leafIndex, tMax) for all primitives in hit leaves, roughly
+  // front to back. The intersector shortens tMax on hits and returns true to stop the
+  // traversal early (any-hit queries).
+  template <typename Intersector>
+  void traverse(const glm::vec3& origin,
+                const glm::vec3& direction,
+                float tMin,
+                float& tMax,
+                Intersector&& intersect) const;
+
+ private:
+  // A wide node spans at least one binary level, and each level of the
+  // traversal leaves at most kWidth - 1 siblings on the stack
+  static constexpr uint32_t kStackSize = 256;
+  static_assert(kStackSize >= (kWidth - 1) * kMaxBuildDepth + 1);
+
+  static uint32_t intersectNode(const Node& node,
+                                const glm::vec3& origin,
+                                const glm::vec3& invDirection,
+                                float tMin,
+                                float tMax,
+                                float* distances);
+
+  std::vector<Node> mNodes;
+  std::vector<uint32_t> mPrimitiveIndices;
+  Bounds mBounds;
+};
+
+inline uint32_t BVH::intersectNode(const Node& node,
+                                   const glm::vec3& origin,
+                                   const glm::vec3& invDirection,
+                                   float tMin,
+                                   float tMax,
+                                   float* distances) {
+  uint32_t validMask = (1u << node.childCount) - 1;
+
+#ifdef RECORE_BVH_SSE
+  const __m128 ox = _mm_set1_ps(origin.x);
+  const __m128 oy = _mm_set1_ps(origin.y);
+  const __m128 oz = _mm_set1_ps(origin.z);
+  const __m128 idx = _mm_set1_ps(invDirection.x);
+  const __m128 idy = _mm_set1_ps(invDirection.y);
+  const __m128 idz = _mm_set1_ps(invDirection.z);
+
+  __m128 t0x = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.minX), ox), idx);
+  __m128 t1x = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.maxX), ox), idx);
+  __m128 t0y = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.minY), oy), idy);
+  __m128 t1y = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.maxY), oy), idy);
+  __m128 t0z = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.minZ), oz), idz);
+  __m128 t1z = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.maxZ), oz), idz);
+
+  __m128 tNear = _mm_max_ps(
+      _mm_max_ps(_mm_min_ps(t0x, t1x), _mm_min_ps(t0y, t1y)),
+      _mm_max_ps(_mm_min_ps(t0z, t1z), _mm_set1_ps(tMin)));
+  __m128 tFar = _mm_min_ps(
+      _mm_min_ps(_mm_max_ps(t0x, t1x), _mm_max_ps(t0y, t1y)),
+      _mm_min_ps(_mm_max_ps(t0z, t1z), _mm_set1_ps(tMax)));
+
+  _mm_storeu_ps(distances, tNear);
+  return static_cast<uint32_t>(_mm_movemask_ps(_mm_cmple_ps(tNear, tFar))) &
+         validMask;
+#else
+  uint32_t mask = 0;
+  for (uint32_t i = 0; i < node.childCount; i++) {
+    float t0x = (node.minX[i] - origin.x) * invDirection.x;
+    float t1x = (node.maxX[i] - origin.x) * invDirection.x;
+    float t0y = (node.minY[i] - origin.y) * invDirection.y;
+    float t1y = (node.maxY[i] - origin.y) * invDirection.y;
+    float t0z = (node.minZ[i] - origin.z) * invDirection.z;
+    float t1z = (node.maxZ[i] - origin.z) * invDirection.z;
+
+    float tNear = std::max(std::max(std::min(t0x, t1x), std::min(t0y, t1y)),
+                           std::max(std::min(t0z, t1z), tMin));
+    float tFar = std::min(std::min(std::max(t0x, t1x), std::max(t0y, t1y)),
+                          std::min(std::max(t0z, t1z), tMax));
+
+    distances[i] = tNear;
+    mask |= static_cast<uint32_t>(tNear <= tFar) << i;
+  }
+  return mask & validMask;
+#endif
+}
+
+template <typename Intersector>
+void BVH::traverse(const glm::vec3& origin,
+                   const glm::vec3& direction,
+                   float tMin,
+                   float& tMax,
+                   Intersector&& intersect) const {
+  if (mNodes.empty()) {
+    return;
+  }
+
+  const glm::vec3 invDirection = 1.f / direction;
+
+  std::array<uint32_t, kStackSize> stack;
+  std::array<float, kStackSize> stackDistances;
+  uint32_t stackSize = 0;
+
+  stack[stackSize] = 0;
+  stackDistances[stackSize] = tMin;
+  stackSize++;
+
+  alignas(16) float distances[kWidth];
+
+  while (stackSize > 0) {
+    stackSize--;
+    if (stackDistances[stackSize] > tMax) {
+      continue;  // Found a closer hit after this node was pushed
+    }
+    const auto& node = mNodes[stack[stackSize]];
+
+    uint32_t hitMask =
+        intersectNode(node, origin, invDirection, tMin, tMax, distances);
+
+    // Handle leaves right away, push inner nodes sorted far to near
+    uint32_t innerChildren[kWidth];
+    uint32_t innerCount = 0;
+    while (hitMask != 0) {
+      auto i = static_cast<uint32_t>(std::countr_zero(hitMask));
+      hitMask &= hitMask - 1;
+
+      if (node.counts[i] > 0) {
+        for (uint32_t p = 0; p < node.counts[i]; p++) {
+          if (intersect(node.children[i] + p, tMax)) {
+            return;
+          }
+        }
+      } else {
+        innerChildren[innerCount++] = i;
+      }
+    }
+
+    for (uint32_t c = 1; c < innerCount; c++) {
+      auto child = innerChildren[c];
+      uint32_t j = c;
+      for (; j > 0 && distances[innerChildren[j - 1]] < distances[child]; j--) {
+        innerChildren[j] = innerChildren[j - 1];
+      }
+      innerChildren[j] = child;
+    }
+    for (uint32_t c = 0; c < innerCount; c++) {
+      auto i = innerChildren[c];
+      stack[stackSize] = node.children[i];
+      stackDistances[stackSize] = distances[i];
+      stackSize++;
+    }
+  }
+}
+
+}  // namespace recore::scene
@@ -0,0 +1,287 @@
+#include "cpu_scene.h"
+
+#include <future>
+
+namespace recore::scene {
+
+// Meshes above this size are built with the parallel BVH builder, smaller ones
+// are built as one task each
+constexpr uint32_t kParallelMeshThreshold = 64 * 1024;
+constexpr uint32_t kTraceRaysChunkSize = 1024;
+
+static bool intersectTriangle(const glm::vec3& v0,
+                              const glm::vec3& edge1,
+                              const glm::vec3& edge2,
+                              const glm::vec3& origin,
+                              const glm::vec3& direction,
+                              float tMin,
+                              float tMax,
+                              float& t,
+                              glm::vec2& barycentrics) {
+  // Moeller-Trumbore, no backface culling like the GPU instances
+  auto p = glm::cross(direction, edge2);
+  float det = glm::dot(edge1, p);
+  if (std::abs(det) < 1e-12f) {
+    return false;
+  }
+  float invDet = 1.f / det;
+
+  auto s = origin - v0;
+  float u = glm::dot(s, p) * invDet;
+  if (u < 0.f || u > 1.f) {
+    return false;
+  }
+
+  auto q = glm::cross(s, edge1);
+  float v = glm::dot(direction, q) * invDet;
+  if (v < 0.f || u + v > 1.f) {
+    return false;
+  }
+
+  t = glm::dot(edge2, q) * invDet;
+  if (t < tMin || t >= tMax) {
+    return false;
+  }
+
+  barycentrics = {u, v};
+  return true;
+}
+
+CPUScene::CPUScene(const Scene& scene) : mScene{scene} {}
+
+void CPUScene::build(core::ThreadPool* threadPool) {
+  const auto& meshes = mScene.getMeshes();
+
+  mMeshes.clear();
+  mMeshes.resize(meshes.size());
+
+  std::vector<std::future<void>> futures;
+  for (uint32_t meshID = 0; meshID < meshes.size(); meshID++) {
+    if (threadPool == nullptr) {
+      buildMesh(meshID, nullptr);
+    } else if (meshes[meshID].indexCount / 3 > kParallelMeshThreshold) {
+      buildMesh(meshID, threadPool);
+    } else {
+      futures.push_back(
+          threadPool->submit([this, meshID]() { buildMesh(meshID, nullptr); }));
+    }
+  }
+  for (auto& future : futures) {
+    future.get();
+  }
+
+  // TLAS over all instances in world space
+  const auto& geometryInstances = mScene.getGeometryInstances();
+  const auto& modelMatrices = mScene.getModelMatrices();
+  const auto& materials = mScene.getMaterials();
+
+  std::vector<Instance> instances;
+  std::vector<Bounds> instanceBounds;
+  instances.reserve(geometryInstances.size());
+  instanceBounds.reserve(geometryInstances.size());
+  for (uint32_t i = 0; i < geometryInstances.size(); i++) {
+    const auto& geometryInstance = geometryInstances[i];
+    const auto& meshBounds = mMeshes[geometryInstance.meshID].bvh.getBounds();
+    if (meshBounds.isEmpty()) {
+      continue;
+    }
+
+    const auto& model = modelMatrices[geometryInstance.modelMatrixID];
+
+    Bounds bounds;
+    for (uint32_t corner = 0; corner < 8; corner++) {
+      glm::vec3 position{(corner & 1) ? meshBounds.max.x : meshBounds.min.x,
+                         (corner & 2) ? meshBounds.max.y : meshBounds.min.y,
+                         (corner & 4) ? meshBounds.max.z : meshBounds.min.z};
+      bounds.grow(glm::vec3(model * glm::vec4(position, 1.f)));
+    }
+
+    instances.push_back({
+        .worldToObject = glm::inverse(model),
+        .instanceID = i,
+        .meshID = geometryInstance.meshID,
+        .opaque = materials.at(geometryInstance.materialID).alphaMode ==
+                  MATERIAL_ALPHA_MODE_OPAQUE,
+    });
+    instanceBounds.push_back(bounds);
+  }
+
+  mTLAS.build(instanceBounds);
+
+  mInstances.clear();
+  mInstances.reserve(instances.size());
+  for (auto index : mTLAS.getPrimitiveIndices()) {
+    mInstances.push_back(instances[index]);
+  }
+}
+
+void CPUScene::buildMesh(uint32_t meshID, core::ThreadPool* threadPool) {
+  const auto& mesh = mScene.getMeshes()[meshID];
+  const auto& vertices = mScene.getVertices();
+  const auto& indices = mScene.getIndices();
+
+  uint32_t triangleCount = mesh.indexCount / 3;
+
+  std::vector<Bounds> triangleBounds(triangleCount);
+  for (uint32_t i = 0; i < triangleCount; i++) {
+    for (uint32_t v = 0; v < 3; v++) {
+      triangleBounds[i].grow(
+          vertices[indices[mesh.firstIndex + 3 * i + v]].position);
+    }
+  }
+
+  auto& meshBVH = mMeshes[meshID];
+  meshBVH.bvh.build(triangleBounds, threadPool);
+
+  meshBVH.triangles.clear();
+  meshBVH.triangles.reserve(triangleCount);
+  for (auto primitiveID : meshBVH.bvh.getPrimitiveIndices()) {
+    const auto& p0 = vertices[indices[mesh.firstIndex + 3 * primitiveID + 0]];
+    const auto& p1 = vertices[indices[mesh.firstIndex + 3 * primitiveID + 1]];
+    const auto& p2 = vertices[indices[mesh.firstIndex + 3 * primitiveID + 2]];
+
+    meshBVH.triangles.push_back({
+        .v0 = p0.position,
+        .edge1 = p1.position - p0.position,
+        .edge2 = p2.position - p0.position,
+        .primitiveID = primitiveID,
+    });
+  }
+}
+
+std::optional<CPUScene::Hit> CPUScene::traceRay(const Ray& ray) const {
+  Hit hit{};
+  if (!trace<false>(ray, hit)) {
+    return std::nullopt;
+  }
+  return hit;
+}
+
+bool CPUScene::traceShadowRay(const Ray& ray) const {
+  Hit hit{};
+  return trace<true>(ray, hit);
+}
+
+std::vector<std::optional<CPUScene::Hit>> CPUScene::traceRays(
+    const std::vector<Ray>& rays,
+    core::ThreadPool& threadPool) const {
+  std::vector<std::optional<Hit>> hits(rays.size());
+
+  std::vector<std::future<void>> futures;
+  for (size_t begin = 0; begin < rays.size(); begin += kTraceRaysChunkSize) {
+    auto end = std::min(begin + kTraceRaysChunkSize, rays.size());
+    futures.push_back(threadPool.submit([&, begin, end]() {
+      for (size_t i = begin; i < end; i++) {
+        hits[i] = traceRay(rays[i]);
+      }
+    }));
+  }
+  for (auto& future : futures) {
+    future.get();
+  }
+
+  return hits;
+}
+
+template <bool AnyHit>
+bool CPUScene::trace(const Ray& ray, Hit& hit) const {
+  float tMax = ray.tMax;
+  bool found = false;
+
+  mTLAS.traverse(
+      ray.origin,
+      ray.direction,
+      ray.tMin,
+      tMax,
+      [&](uint32_t instanceIndex, float& instanceTMax) {
+        const auto& instance = mInstances[instanceIndex];
+        const auto& mesh = mMeshes[instance.meshID];
+
+        // Not normalized, so t stays the same in object space
+        auto origin =
+            glm::vec3(instance.worldToObject * glm::vec4(ray.origin, 1.f));
+        auto direction = glm::mat3(instance.worldToObject) * ray.direction;
+
+        bool terminate = false;
+        mesh.bvh.traverse(
+            origin,
+            direction,
+            ray.tMin,
+            instanceTMax,
+            [&](uint32_t triangleIndex, float& triangleTMax) {
+              const auto& triangle = mesh.triangles[triangleIndex];
+
+              float t = 0.f;
+              glm::vec2 barycentrics{};
+              if (!intersectTriangle(triangle.v0,
+                                     triangle.edge1,
+                                     triangle.edge2,
+                                     origin,
+                                     direction,
+                                     ray.tMin,
+                                     triangleTMax,
+                                     t,
+                                     barycentrics)) {
+                return false;
+              }
+
+              if (!instance.opaque &&
+                  !alphaTest(instance, triangle.primitiveID, barycentrics)) {
+                return false;
+              }
+
+              triangleTMax = t;
+              hit = {
+                  .instanceID = instance.instanceID,
+                  .primitiveID = triangle.primitiveID,
+                  .barycentrics = barycentrics,
+                  .t = t,
+              };
+              found = true;
+              terminate = AnyHit;
+              return terminate;
+            });
+        return terminate;
+      });
+
+  return found;
+}
+
+bool CPUScene::alphaTest(const Instance& instance,
+                         uint32_t primitiveID,
+                         const glm::vec2& barycentrics) const {
+  const auto& geometryInstance =
+      mScene.getGeometryInstances()[instance.instanceID];
+  const auto& material = mScene.getMaterials()[geometryInstance.materialID];
+
+  float alpha = material.baseColorFactor.a;
+  if (material.baseColorID != static_cast<uint32_t>(-1)) {
+    const auto& mesh = mScene.getMeshes()[instance.meshID];
+    const auto& vertices = mScene.getVertices();
+    const auto& indices = mScene.getIndices();
+
+    const auto& t0 =
+        vertices[indices[mesh.firstIndex + 3 * primitiveID + 0]].texCoord;
+    const auto& t1 =
+        vertices[indices[mesh.firstIndex + 3 * primitiveID + 1]].texCoord;
+    const auto& t2 =
+        vertices[indices[mesh.firstIndex + 3 * primitiveID + 2]].texCoord;
+
+    auto texCoord = (1.f - barycentrics.x - barycentrics.y) * t0 +
+                    barycentrics.x * t1 + barycentrics.y * t2;
+
+    // Nearest lookup with repeat wrapping on the RGBA8 texture like the scene
+    // sampler, which selects texels with a limited subtexel precision
+    const auto& texture = mScene.getTextures()[material.baseColorID];
+    auto wrapped = texCoord - glm::floor(texCoord);
+    auto x = std::min(static_cast<uint32_t>(wrapped.x * texture.width),
+                      texture.width - 1);
+    auto y = std::min(static_cast<uint32_t>(wrapped.y * texture.height),
+                      texture.height - 1);
+    alpha *= texture.image[4 * (y * texture.width + x) + 3] / 255.f;
+  }
+
+  return alpha >= material.alphaCutoff;
+}
+
+}  // namespace recore::scene
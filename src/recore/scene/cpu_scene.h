@@ -0,0 +1,91 @@
+#pragma once
+
+#include "bvh.h"
+#include "scene.h"
+
+#include <recore/core/thread_pool.h>
+
+#include <optional>
+
+namespace recore::scene {
+
+// CPU ray tracing backend over the scene geometry. Mirrors the queries of
+// ray_tracing.glsl, so hits can be compared against GPU results. Near the
+// edges of alpha cutouts they may differ, the texture lookup of the alpha
+// test is not bit exact with the sampler of the GPU.
+class CPUScene {
+ public:
+  struct Ray {
+    glm::vec3 origin;
+    glm::vec3 direction;
+    float tMin = 0.f;
+    float tMax = std::numeric_limits<float>::max();
+  };
+
+  struct Hit {
+    uint32_t instanceID;
+    uint32_t primitiveID;
+    glm::vec2 barycentrics;
+    float t;
+  };
+
+  explicit CPUScene(const Scene& scene);
+  ~CPUScene() = default;
+
+  // Delete copy & move constructors.
+  CPUScene(const CPUScene&) = delete;
+  CPUScene& operator=(const CPUScene&) = delete;
+  CPUScene(CPUScene&&) = delete;
+  CPUScene& operator=(CPUScene&&) = delete;
+
+  // (Re)builds all BVHs from the current scene state
+  void build(core::ThreadPool* threadPool = nullptr);
+
+  [[nodiscard]] std::optional<Hit> traceRay(const Ray& ray) const;
+
+  [[nodiscard]] bool traceShadowRay(const Ray& ray) const;
+
+  [[nodiscard]] std::vector<std::optional<Hit>> traceRays(
+      const std::vector<Ray>& rays,
+      core::ThreadPool& threadPool) const;
+
+  [[nodiscard]] const Scene& getScene() const { return mScene; }
+
+ private:
+  // Precomputed for the intersection test, stored in BVH leaf order
+  struct Triangle {
+    glm::vec3 v0;
+    glm::vec3 edge1;
+    glm::vec3 edge2;
+    uint32_t primitiveID;
+  };
+
+  struct MeshBVH {
+    BVH bvh;
+    std::vector<Triangle> triangles;
+  };
+
+  struct Instance {
+    glm::mat4 worldToObject;
+    uint32_t instanceID;
+    uint32_t meshID;
+    bool opaque;
+  };
+
+  const Scene& mScene;
+
+  std::vector<MeshBVH> mMeshes;
+  std::vector<Instance> mInstances;  // TLAS leaf order
+  BVH mTLAS;
+
+  void buildMesh(uint32_t meshID, core::ThreadPool* threadPool);
+
+  template <bool AnyHit>
+  bool trace(const Ray& ray, Hit& hit) const;
+
+  [[nodiscard]] bool alphaTest(const Instance& instance,
+                               uint32_t primitiveID,
+                               const glm::vec2& barycentrics) const;
+};
+
+}  // namespace recore::scene
@@ -1,9 +1,16 @@
 #include "gpu_scene.h"
 
-#include <recore/vulkan/api/command.h>
+#include <recore/core/cpu_profiler.h>
+
+#include <recore/vulkan/api/barrier.h>
+#include <recore/vulkan/api/immediate_context.h>
 
 namespace recore::scene {
 
+constexpr VkShaderStageFlags kRayTracingStages =
+    VK_SHADER_STAGE_RAYGEN_BIT_KHR | VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR |
+    VK_SHADER_STAGE_ANY_HIT_BIT_KHR | VK_SHADER_STAGE_MISS_BIT_KHR;
+
 static VkTransformMatrixKHR glmToVulkanTransform(const glm::mat4& T) {
   VkTransformMatrixKHR transformMatrix = {T[0][0],
                                           T[1][0],
@@ -26,16 +33,10 @@ GPUScene::GPUScene(const vulkan::Device& device,
     : mDevice{device}, mScene{scene}, mEnableRayTracing{enableRayTracing} {}
 
 void GPUScene::upload() {
-  const auto& queue = mDevice.getGraphicsQueue();
-  vulkan::CommandPool commandPool{{
-      .device = mDevice,
-      .queueFamilyIndex = queue.getFamilyIndex(),
-  }};
+  RECORE_CPU_PROFILE_SCOPE("GPUScene::upload");
 
-  vulkan::CommandBuffer commandBuffer{{
-      .device = mDevice,
-      .commandPool = commandPool,
-  }};
+  auto& immediate = mDevice.getImmediateContext();
+  vulkan::ImmediateContext::Ticket ticket;
 
   std::vector<uPtr<vulkan::Buffer>> garbage;
 
@@ -59,7 +60,9 @@ void GPUScene::upload() {
     });
     staging->upload(data.data());
 
-    commandBuffer.copyBufferToBuffer(*staging, *buffer);
+    ticket = immediate.record([&](const auto& commandBuffer) {
+      commandBuffer.copyBufferToBuffer(*staging, *buffer);
+    });
 
     garbage.push_back(std::move(staging));
 
@@ -78,8 +81,6 @@ void GPUScene::upload() {
 
   // Start uploading
 
-  commandBuffer.begin();
-
   // Buffers
   mBuffers.vertices = genBuffer(
       mScene.getVertices(),
@@ -135,26 +136,22 @@ void GPUScene::upload() {
     });
     stagingBuffer->upload(texture.image.data());
 
-    commandBuffer.transitionImageLayout(*image,
-                                        VK_IMAGE_LAYOUT_UNDEFINED,
-                                        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                                        VK_PIPELINE_STAGE_TRANSFER_BIT,
-                                        VK_PIPELINE_STAGE_TRANSFER_BIT);
-    commandBuffer.copyBufferToImage(*stagingBuffer, *image);
-    commandBuffer.transitionImageLayout(
-        *image,
-        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-        VK_PIPELINE_STAGE_TRANSFER_BIT,
-        VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+    ticket = immediate.record([&](const auto& commandBuffer) {
+      vulkan::BarrierBatch{commandBuffer}.image(
+          *image, vulkan::access::kNone, vulkan::access::kTransferWrite);
+      commandBuffer.copyBufferToImage(*stagingBuffer, *image);
+      vulkan::BarrierBatch{commandBuffer}.image(
+          *image,
+          vulkan::access::kTransferWrite,
+          vulkan::access::kShaderSampled);
+    });
 
     garbage.push_back(std::move(stagingBuffer));
     mImages.push_back(std::move(image));
   }
 
-  commandBuffer.end();
-  vulkan::checkResult(queue.submit(commandBuffer));
-  vulkan::checkResult(queue.waitIdle());
+  // Staging buffers are freed at the end of the scope
+  immediate.wait(ticket);
 
   mSampler = makeUnique<vulkan::Sampler>({.device = mDevice});
 
@@ -178,7 +175,8 @@ void GPUScene::upload() {
                                  VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
                              .descriptorCount = MAX_TEXTURES,
                              .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT |
-                                           VK_SHADER_STAGE_COMPUTE_BIT},
+                                           VK_SHADER_STAGE_COMPUTE_BIT |
+                                           kRayTracingStages},
                  .flags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT,
              },
              {
@@ -187,7 +185,8 @@ void GPUScene::upload() {
                                  VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR,
                              .descriptorCount = 1,
                              .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT |
-                                           VK_SHADER_STAGE_COMPUTE_BIT},
+                                           VK_SHADER_STAGE_COMPUTE_BIT |
+                                           kRayTracingStages},
              }},
     });
   } else {
@@ -228,7 +227,10 @@ void GPUScene::upload() {
 
   // Acceleration Structure
   if (mEnableRayTracing) {
-    mDevice.submitAndWait([&](const auto& commandBuffer) {
+    createBLASes();
+    createTLAS();
+
+    immediate.submitAndWait([&](const auto& commandBuffer) {
       buildAccelerationStructure(commandBuffer);
     });
 
@@ -239,6 +241,8 @@ void GPUScene::upload() {
 
 void GPUScene::update(const vulkan::CommandBuffer& commandBuffer,
                       vulkan::RenderFrame& currentFrame) {
+  RECORE_CPU_PROFILE_SCOPE("GPUScene::update");
+
   // Update changes
 
   if (mEnableCameraJitter) {  // Handle camera jitter
@@ -308,11 +312,6 @@ void GPUScene::update(const vulkan::CommandBuffer& commandBuffer,
     });
     staging->upload(&mSceneData);
 
-    commandBuffer.memoryBarrier(VK_ACCESS_MEMORY_WRITE_BIT,
-                                VK_ACCESS_MEMORY_WRITE_BIT,
-                                VK_PIPELINE_STAGE_TRANSFER_BIT,
-                                VK_PIPELINE_STAGE_TRANSFER_BIT);
-
     commandBuffer.copyBufferToBuffer(*staging, *mBuffers.sceneData);
 
     currentFrame.deferDestroy(std::move(staging));
@@ -328,11 +327,6 @@ void GPUScene::update(const vulkan::CommandBuffer& commandBuffer,
     });
     staging->upload(mScene.getLights().data());
 
-    commandBuffer.memoryBarrier(VK_ACCESS_MEMORY_WRITE_BIT,
-                                VK_ACCESS_MEMORY_WRITE_BIT,
-                                VK_PIPELINE_STAGE_TRANSFER_BIT,
-                                VK_PIPELINE_STAGE_TRANSFER_BIT);
-
     commandBuffer.copyBufferToBuffer(*staging, *mBuffers.lights);
     currentFrame.deferDestroy(std::move(staging));
   }
@@ -347,11 +341,6 @@ void GPUScene::update(const vulkan::CommandBuffer& commandBuffer,
     });
     staging->upload(mScene.getModelMatrices().data());
 
-    commandBuffer.memoryBarrier(VK_ACCESS_MEMORY_WRITE_BIT,
-                                VK_ACCESS_MEMORY_WRITE_BIT,
-                                VK_PIPELINE_STAGE_TRANSFER_BIT,
-                                VK_PIPELINE_STAGE_TRANSFER_BIT);
-
     commandBuffer.copyBufferToBuffer(*staging, *mBuffers.modelMatrices);
     currentFrame.deferDestroy(std::move(staging));
 
@@ -368,6 +357,33 @@ void GPUScene::update(const vulkan::CommandBuffer& commandBuffer,
   }
 }
 
+void GPUScene::declareUpdate(vulkan::RenderGraph::PassBuilder& builder) const {
+  builder.write(*mBuffers.sceneData, vulkan::access::kTransferWrite);
+  builder.write(*mBuffers.lights, vulkan::access::kTransferWrite);
+  builder.write(*mBuffers.modelMatrices, vulkan::access::kTransferWrite);
+  if (mAcceleration.tlas != nullptr) {
+    builder.write(mAcceleration.tlas->getBuffer(),
+                  vulkan::access::kAccelerationBuild);
+  }
+}
+
+void GPUScene::declareReads(vulkan::RenderGraph::PassBuilder& builder,
+                            VkPipelineStageFlags2 stages) const {
+  const vulkan::Access access{stages, VK_ACCESS_2_SHADER_READ_BIT};
+  builder.read(*mBuffers.sceneData, access);
+  builder.read(*mBuffers.lights, access);
+  builder.read(*mBuffers.modelMatrices, access);
+  if (mAcceleration.tlas != nullptr) {
+    builder.read(mAcceleration.tlas->getBuffer(),
+                 {stages, VK_ACCESS_2_ACCELERATION_STRUCTURE_READ_BIT_KHR});
+  }
+}
+
+bool GPUScene::isOpaque(const GeometryInstance& geometryInstance) const {
+  const auto& material = mScene.getMaterials().at(geometryInstance.materialID);
+  return material.alphaMode == MATERIAL_ALPHA_MODE_OPAQUE;
+}
+
 void GPUScene::createBLASes() {
   VkTransformMatrixKHR transformMatrixIdentity = {
       1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f};
@@ -384,7 +400,18 @@ void GPUScene::createBLASes() {
 
   const auto& meshes = mScene.getMeshes();
   mAcceleration.blases.reserve(meshes.size());
-  for (const auto& mesh : meshes) {
+
+  // Meshes referenced with an alpha masked material become non-opaque, the
+  // instances still force opacity for opaque materials (see createTLAS)
+  std::vector<bool> opaqueMeshes(meshes.size(), true);
+  for (const auto& geometryInstance : mScene.getGeometryInstances()) {
+    if (!isOpaque(geometryInstance)) {
+      opaqueMeshes[geometryInstance.meshID] = false;
+    }
+  }
+
+  for (size_t i = 0; i < meshes.size(); i++) {
+    const auto& mesh = meshes[i];
     auto blas = makeUnique<vulkan::BLAS>({
         .device = mDevice,
         .mesh =
@@ -396,6 +423,7 @@ void GPUScene::createBLASes() {
                 .indexCount = mesh.indexCount,
                 .vertexSize = sizeof(Vertex),
                 .transformOffset = 0,
+                .opaque = opaqueMeshes[i],
             },
     });
     mAcceleration.blases.emplace_back(std::move(blas));
@@ -417,7 +445,13 @@ void GPUScene::createTLAS() {
         .blas = *blases.at(geometryInstance.meshID),
         .instanceID = 0,
         .transform = transformMatrix,
-        .flags = VK_GEOMETRY_INSTANCE_TRIANGLE_FACING_CULL_DISABLE_BIT_KHR,
+        .flags =
+            VK_GEOMETRY_INSTANCE_TRIANGLE_FACING_CULL_DISABLE_BIT_KHR |
+            (isOpaque(geometryInstance)
+                 ? VK_GEOMETRY_INSTANCE_FORCE_OPAQUE_BIT_KHR
+                 : VK_GEOMETRY_INSTANCE_FORCE_NO_OPAQUE_BIT_KHR),
+        .sbtRecordOffset = isOpaque(geometryInstance) ? kOpaqueHitGroup
+                                                      : kMaskedHitGroup,
     });
   }
 
@@ -429,18 +463,16 @@ void GPUScene::createTLAS() {
 
 void GPUScene::buildAccelerationStructure(
     const vulkan::CommandBuffer& commandBuffer) {
-  createBLASes();
-  createTLAS();
-
   for (auto& blas : mAcceleration.blases) {
     blas->build(commandBuffer);
   }
 
-  commandBuffer.memoryBarrier(
-      VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR,
-      VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR,
-      VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
-      VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR);
+  // The BLASes are read by the TLAS build
+  vulkan::BarrierBatch{commandBuffer}.memory(
+      {VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
+       VK_ACCESS_2_ACCELERATION_STRUCTURE_WRITE_BIT_KHR},
+      {VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
+       VK_ACCESS_2_ACCELERATION_STRUCTURE_READ_BIT_KHR});
 
   mAcceleration.tlas->build(commandBuffer);
 }
@@ -8,11 +8,16 @@
 #include <recore/vulkan/api/image.h>
 
 #include <recore/vulkan/context.h>
+#include <recore/vulkan/render_graph.h>
 
 namespace recore::scene {
 
 class GPUScene {
  public:
+  // Hit groups selected per instance when tracing with a ray tracing pipeline
+  static constexpr uint32_t kOpaqueHitGroup = 0;
+  static constexpr uint32_t kMaskedHitGroup = 1;
+
   explicit GPUScene(const vulkan::Device& device,
                     const Scene& scene,
                     bool enableRayTracing = false);
@@ -28,6 +33,11 @@ class GPUScene {
   void update(const vulkan::CommandBuffer& commandBuffer,
               vulkan::RenderFrame& currentFrame);
 
+  // Render graph declarations of update() and of passes using the scene
+  void declareUpdate(vulkan::RenderGraph::PassBuilder& builder) const;
+  void declareReads(vulkan::RenderGraph::PassBuilder& builder,
+                    VkPipelineStageFlags2 stages) const;
+
   [[nodiscard]] const Scene& getScene() const { return mScene; }
 
   [[nodiscard]] const vulkan::DescriptorSetLayout& getDescriptorSetLayout()
@@ -88,6 +98,8 @@ class GPUScene {
     uPtr<vulkan::Buffer> identityTransform;
   } mAcceleration;
 
+  [[nodiscard]] bool isOpaque(const GeometryInstance& geometryInstance) const;
+
   void createBLASes();
 
   void createTLAS();
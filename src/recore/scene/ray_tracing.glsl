@@ -2,6 +2,7 @@
 #define RAY_TRACING_GLSL
 
 #include <recore/scene/scene.glsl>
+#include <recore/scene/shading.glsl>
 #include <recore/shaders/constants.glsl>
 
 struct Ray {
@@ -17,20 +18,37 @@ struct Hit {
 
 
 #ifdef ENABLE_RAY_TRACING
-bool traceShadowRay(Ray ray) {
+// Only alpha masked geometry is non-opaque, so this is never called for the
+// rest of the scene
+bool alphaTest(SceneData scene, rayQueryEXT rayQuery) {
+  int instanceID = rayQueryGetIntersectionInstanceIdEXT(rayQuery, false);
+  int primitiveID = rayQueryGetIntersectionPrimitiveIndexEXT(rayQuery, false);
+  vec2 barycentrics = rayQueryGetIntersectionBarycentricsEXT(rayQuery, false);
+
+  return alphaTest(scene, instanceID, primitiveID, barycentrics);
+}
+
+bool traceShadowRay(SceneData scene, Ray ray) {
   rayQueryEXT rayQuery;
-  rayQueryInitializeEXT(rayQuery, gTLAS, gl_RayFlagsTerminateOnFirstHitEXT | gl_RayFlagsOpaqueEXT, 0xFF, ray.origin, M_EPSILON, ray.direction, 1.0 - M_EPSILON);
+  rayQueryInitializeEXT(rayQuery, gTLAS, gl_RayFlagsTerminateOnFirstHitEXT, 0xFF, ray.origin, M_EPSILON, ray.direction, 1.0 - M_EPSILON);
+
+  while (rayQueryProceedEXT(rayQuery)) {
+    if (alphaTest(scene, rayQuery)) {
+      rayQueryConfirmIntersectionEXT(rayQuery);
+    }
+  }
 
-  rayQueryProceedEXT(rayQuery);
   return rayQueryGetIntersectionTypeEXT(rayQuery, true) != gl_RayQueryCommittedIntersectionNoneEXT;
 }
 
-bool traceRay(Ray ray, out Hit hit) {
+bool traceRay(SceneData scene, Ray ray, out Hit hit) {
   rayQueryEXT rayQuery;
-  rayQueryInitializeEXT(rayQuery, gTLAS, gl_RayFlagsOpaqueEXT, 0xFF, ray.origin, M_EPSILON, ray.direction, 10000.0);
+  rayQueryInitializeEXT(rayQuery, gTLAS, gl_RayFlagsNoneEXT, 0xFF, ray.origin, M_EPSILON, ray.direction, 10000.0);
 
   while (rayQueryProceedEXT(rayQuery)) {
-    rayQueryConfirmIntersectionEXT(rayQuery);
+    if (alphaTest(scene, rayQuery)) {
+      rayQueryConfirmIntersectionEXT(rayQuery);
+    }
   }
 
   if (rayQueryGetIntersectionTypeEXT(rayQuery, true) == gl_RayQueryCommittedIntersectionNoneEXT) {
@@ -45,8 +63,8 @@ bool traceRay(Ray ray, out Hit hit) {
 }
 #else
 
-bool traceShadowRay(Ray ray) { return false; }
-bool traceRay(Ray ray, out Hit hit) { return false; }
+bool traceShadowRay(SceneData scene, Ray ray) { return false; }
+bool traceRay(SceneData scene, Ray ray, out Hit hit) { return false; }
 
 #endif
 
@@ -11,6 +11,8 @@
 
 #include "ecs_components.h"
 
+#include <recore/core/cpu_profiler.h>
+
 namespace recore::scene {
 
 // NOLINTNEXTLINE(readability-function-cognitive-complexity) turn your brain on
@@ -117,6 +119,9 @@ void Scene::loadGLTF(const Scene::GLTFLoadDesc& desc) {
     material.alphaMode = gltfMaterial.alphaMode == "OPAQUE"
                              ? MATERIAL_ALPHA_MODE_OPAQUE
                              : MATERIAL_ALPHA_MODE_MASK;
+    material.alphaCutoff = material.alphaMode == MATERIAL_ALPHA_MODE_MASK
+                               ? static_cast<float>(gltfMaterial.alphaCutoff)
+                               : 0.f;
     material.ior = 1.f;
 
     // Handle GLTF extensions:
@@ -264,6 +269,8 @@ void Scene::addLight(const Light& light) {
 }
 
 void Scene::update(float deltaTime) {
+  RECORE_CPU_PROFILE_SCOPE("Scene::update");
+
   mFrameCount++;
   mStaticFrameCount++;
 
@@ -66,6 +66,26 @@ ShadingData queryShadingData(SceneData scene, int instanceID, int primitiveID, v
   return sd;
 }
 
+bool alphaTest(SceneData scene, int instanceID, int primitiveID, vec2 barycentrics) {
+  GeometryInstance instance = deref(scene.geometryInstances, instanceID);
+  Material material = deref(scene.materials, instance.materialID);
+
+  float alpha = material.baseColorFactor.a;
+  if (material.baseColorID != -1) {
+    Mesh mesh = deref(scene.meshes, instance.meshID);
+    vec2 t0 = deref(scene.vertices, deref(scene.indices, 3 * primitiveID + mesh.firstIndex + 0)).texCoord;
+    vec2 t1 = deref(scene.vertices, deref(scene.indices, 3 * primitiveID + mesh.firstIndex + 1)).texCoord;
+    vec2 t2 = deref(scene.vertices, deref(scene.indices, 3 * primitiveID + mesh.firstIndex + 2)).texCoord;
+
+    vec3 b = vec3(1 - barycentrics.x - barycentrics.y, barycentrics.x, barycentrics.y);
+    vec2 texCoord = t0 * b.x + t1 * b.y + t2 * b.z;
+
+    alpha *= textureLod(gTextures[nonuniformEXT(material.baseColorID)], texCoord, 0).a;
+  }
+
+  return alpha >= material.alphaCutoff;
+}
+
 
 vec3 Lambert_eval(ShadingData sd, vec3 wo) {
   return sd.albedo * M_1_PI * max(0.0, dot(sd.N, wo));
@@ -0,0 +1,22 @@
+#ifndef BINDLESS_GLSL
+#define BINDLESS_GLSL
+
+#extension GL_EXT_nonuniform_qualifier : require
+
+// Global heap of vulkan::BindlessHeap, indexed with the handles of images and
+// samplers passed in push constants. Storage images are declared once per
+// format, they alias the same binding.
+
+layout(set = 0, binding = 0) uniform texture2D gBindlessTextures[];
+layout(set = 0, binding = 1) uniform sampler gBindlessSamplers[];
+
+layout(set = 0, binding = 2, rgba32f) uniform image2D gBindlessImages[];
+layout(set = 0, binding = 2, r32f) uniform image2D gBindlessImagesR32f[];
+
+#define bindlessSampler2D(TEXTURE, SAMPLER) \
+sampler2D(gBindlessTextures[TEXTURE], gBindlessSamplers[SAMPLER])
+
+#define bindlessImage2D(IMAGE) gBindlessImages[IMAGE]
+#define bindlessImage2DR32f(IMAGE) gBindlessImagesR32f[IMAGE]
+
+#endif // BINDLESS_GLSL
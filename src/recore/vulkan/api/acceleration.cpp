@@ -1,5 +1,7 @@
 #include "acceleration.h"
 
+#include <exception>
+
 namespace recore::vulkan {
 AccelerationStructure::~AccelerationStructure() {
   vkDestroyAccelerationStructureKHR(mDevice.vkHandle(), mHandle, nullptr);
@@ -22,6 +24,85 @@ void AccelerationStructure::build(const CommandBuffer& commandBuffer) {
   mBuildGeometryInfo.srcAccelerationStructure = mHandle;
 }
 
+void AccelerationStructure::buildOnHost(
+    const std::vector<AccelerationStructure*>& accelerationStructures,
+    core::ThreadPool& threadPool) {
+  // Deferred operations may read the build parameters until they complete, so
+  // keep them alive for the whole function
+  std::vector<VkAccelerationStructureBuildRangeInfoKHR> buildRangeInfos(
+      accelerationStructures.size());
+  std::vector<const VkAccelerationStructureBuildRangeInfoKHR*>
+      pBuildRangeInfos(accelerationStructures.size());
+  std::vector<uPtr<DeferredOperation>> operations;
+  operations.reserve(accelerationStructures.size());
+
+  std::vector<std::future<void>> futures;
+
+  // Joins of started builds keep running on the thread pool, so an error must
+  // not leave the function before all of them returned
+  std::exception_ptr error;
+  try {
+    for (size_t i = 0; i < accelerationStructures.size(); i++) {
+      auto* accelerationStructure = accelerationStructures[i];
+      if (accelerationStructure->mBuildType !=
+          VK_ACCELERATION_STRUCTURE_BUILD_TYPE_HOST_KHR) {
+        throw std::runtime_error(
+            "AccelerationStructure::buildOnHost: not created for host "
+            "builds!");
+      }
+
+      buildRangeInfos[i].primitiveCount =
+          accelerationStructure->mGeometryCount;
+      pBuildRangeInfos[i] = &buildRangeInfos[i];
+
+      const auto& operation = operations.emplace_back(
+          makeUnique<DeferredOperation>(
+              {.device = accelerationStructure->mDevice}));
+
+      auto result = vkBuildAccelerationStructuresKHR(
+          accelerationStructure->mDevice.vkHandle(),
+          operation->vkHandle(),
+          1,
+          &accelerationStructure->mBuildGeometryInfo,
+          &pBuildRangeInfos[i]);
+
+      if (result == VK_OPERATION_DEFERRED_KHR) {
+        auto joins = operation->join(threadPool);
+        std::move(joins.begin(), joins.end(), std::back_inserter(futures));
+      } else if (result != VK_OPERATION_NOT_DEFERRED_KHR) {
+        checkResult(result);
+      }
+    }
+  } catch (...) {
+    error = std::current_exception();
+  }
+
+  // Keeps the first error
+  for (auto& future : futures) {
+    try {
+      future.get();
+    } catch (...) {
+      if (!error) {
+        error = std::current_exception();
+      }
+    }
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+
+  for (const auto& operation : operations) {
+    checkResult(operation->getResult());
+  }
+
+  for (auto* accelerationStructure : accelerationStructures) {
+    auto& buildGeometryInfo = accelerationStructure->mBuildGeometryInfo;
+    buildGeometryInfo.mode = VK_BUILD_ACCELERATION_STRUCTURE_MODE_UPDATE_KHR;
+    buildGeometryInfo.srcAccelerationStructure =
+        accelerationStructure->mHandle;
+  }
+}
+
 void AccelerationStructure::create() {
   VkAccelerationStructureBuildGeometryInfoKHR buildGeometryInfo{};
   buildGeometryInfo.sType =
@@ -42,31 +123,48 @@ void AccelerationStructure::create() {
       VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_SIZES_INFO_KHR;
   vkGetAccelerationStructureBuildSizesKHR(
       mDevice.vkHandle(),
-      VK_ACCELERATION_STRUCTURE_BUILD_TYPE_DEVICE_KHR,
+      mBuildType,
       &buildGeometryInfo,
       &mGeometryCount,
       &buildSizesInfo);
 
-  mASBuffer = makeUnique<Buffer>({
-      .device = mDevice,
-      .size = buildSizesInfo.accelerationStructureSize,
-      .usage = VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR |
-               VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
-      .memoryUsage = VMA_MEMORY_USAGE_GPU_ONLY,
-  });
-
-  mScratchBuffer = makeUnique<Buffer>({
-      .device = mDevice,
-      // TODO: invesitage if max is necessary
-      .size = std::max(buildSizesInfo.buildScratchSize,
-                       buildSizesInfo.updateScratchSize),
-      .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
-               VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
-      .memoryUsage = VMA_MEMORY_USAGE_GPU_ONLY,
-      // TODO: .minAlignment maybe?
-  });
-  buildGeometryInfo.scratchData.deviceAddress =
-      mScratchBuffer->getDeviceAddress();
+  // TODO: invesitage if max is necessary
+  auto scratchSize = std::max(buildSizesInfo.buildScratchSize,
+                              buildSizesInfo.updateScratchSize);
+
+  if (mBuildType == VK_ACCELERATION_STRUCTURE_BUILD_TYPE_HOST_KHR) {
+    // Host builds write through a host mapping, coherent memory makes the
+    // result visible to the device without explicit flushes
+    mASBuffer = makeUnique<Buffer>({
+        .device = mDevice,
+        .size = buildSizesInfo.accelerationStructureSize,
+        .usage = VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR |
+                 VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+        .memoryUsage = VMA_MEMORY_USAGE_CPU_ONLY,
+    });
+
+    mHostScratch.resize(scratchSize);
+    buildGeometryInfo.scratchData.hostAddress = mHostScratch.data();
+  } else {
+    mASBuffer = makeUnique<Buffer>({
+        .device = mDevice,
+        .size = buildSizesInfo.accelerationStructureSize,
+        .usage = VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR |
+                 VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+        .memoryUsage = VMA_MEMORY_USAGE_GPU_ONLY,
+    });
+
+    mScratchBuffer = makeUnique<Buffer>({
+        .device = mDevice,
+        .size = scratchSize,
+        .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                 VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+        .memoryUsage = VMA_MEMORY_USAGE_GPU_ONLY,
+        // TODO: .minAlignment maybe?
+    });
+    buildGeometryInfo.scratchData.deviceAddress =
+        mScratchBuffer->getDeviceAddress();
+  }
 
   VkAccelerationStructureCreateInfoKHR accelerationStructureCreateInfo{};
   accelerationStructureCreateInfo.sType =
@@ -92,6 +190,12 @@ void AccelerationStructure::create() {
   mBuildGeometryInfo.dstAccelerationStructure = mHandle;
 }
 
+static VkGeometryFlagsKHR geometryFlags(bool opaque) {
+  // Any-hit candidates are alpha tested, one test per primitive is enough
+  return opaque ? VK_GEOMETRY_OPAQUE_BIT_KHR
+                : VK_GEOMETRY_NO_DUPLICATE_ANY_HIT_INVOCATION_BIT_KHR;
+}
+
 BLAS::BLAS(const Desc& desc)
     : AccelerationStructure{
           {.device = desc.device,
@@ -99,10 +203,11 @@ BLAS::BLAS(const Desc& desc)
   VkAccelerationStructureGeometryKHR geometry{};
   geometry.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_KHR;
   geometry.geometryType = VK_GEOMETRY_TYPE_TRIANGLES_KHR;
-  geometry.flags = VK_GEOMETRY_OPAQUE_BIT_KHR;
 
   const auto& mesh = desc.mesh;
 
+  geometry.flags = geometryFlags(mesh.opaque);
+
   auto vertexAddress = mesh.vertices.getDeviceAddress();
   auto indexAddress = mesh.indices.getDeviceAddress();
   auto transformAddress = mesh.transforms.getDeviceAddress();
@@ -134,6 +239,38 @@ BLAS::BLAS(const Desc& desc)
   create();
 }
 
+BLAS::BLAS(const HostDesc& desc)
+    : AccelerationStructure{
+          {.device = desc.device,
+           .type = VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR,
+           .buildType = VK_ACCELERATION_STRUCTURE_BUILD_TYPE_HOST_KHR}} {
+  VkAccelerationStructureGeometryKHR geometry{};
+  geometry.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_KHR;
+  geometry.geometryType = VK_GEOMETRY_TYPE_TRIANGLES_KHR;
+
+  const auto& mesh = desc.mesh;
+
+  geometry.flags = geometryFlags(mesh.opaque);
+
+  VkAccelerationStructureGeometryTrianglesDataKHR triangles{};
+  triangles.sType =
+      VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_TRIANGLES_DATA_KHR;
+  triangles.vertexFormat = VK_FORMAT_R32G32B32_SFLOAT;
+  triangles.vertexData.hostAddress = mesh.vertices;
+  triangles.vertexStride = mesh.vertexSize;
+  triangles.maxVertex = mesh.vertexCount;
+  triangles.indexType = VK_INDEX_TYPE_UINT32;
+  triangles.indexData.hostAddress = mesh.indices + mesh.firstIndex;
+  triangles.transformData.hostAddress = mesh.transform;
+
+  geometry.geometry.triangles = triangles;
+
+  mGeometry = geometry;
+  mGeometryCount = mesh.indexCount / 3;
+
+  create();
+}
+
 TLAS::TLAS(const Desc& desc)
     : AccelerationStructure{
           {.device = desc.device,
@@ -153,7 +290,8 @@ TLAS::TLAS(const Desc& desc)
     asInstance.transform = instance.transform;
     asInstance.instanceCustomIndex = instance.instanceID;
     asInstance.mask = 0xFF;
-    asInstance.instanceShaderBindingTableRecordOffset = 0;
+    asInstance.instanceShaderBindingTableRecordOffset =
+        instance.sbtRecordOffset;
     asInstance.flags = instance.flags;
     asInstance.accelerationStructureReference =
         instance.blas.getDeviceAddress();
@@ -2,8 +2,11 @@
 
 #include "buffer.h"
 #include "command.h"
+#include "deferred_operation.h"
 #include "device.h"
 
+#include <recore/core/thread_pool.h>
+
 namespace recore::vulkan {
 
 class AccelerationStructure : public Object<VkAccelerationStructureKHR> {
@@ -11,6 +14,8 @@ class AccelerationStructure : public Object<VkAccelerationStructureKHR> {
   struct Desc {
     const Device& device;
     VkAccelerationStructureTypeKHR type;
+    VkAccelerationStructureBuildTypeKHR buildType =
+        VK_ACCELERATION_STRUCTURE_BUILD_TYPE_DEVICE_KHR;
   };
 
   ~AccelerationStructure() override;
@@ -19,11 +24,26 @@ class AccelerationStructure : public Object<VkAccelerationStructureKHR> {
     return mDeviceAddress;
   }
 
+  [[nodiscard]] VkAccelerationStructureBuildTypeKHR getBuildType() const {
+    return mBuildType;
+  }
+
+  // Storage of the structure, builds and traces synchronize on it
+  [[nodiscard]] const Buffer& getBuffer() const { return *mASBuffer; }
+
   void build(const CommandBuffer& commandBuffer);
 
+  // Builds all acceleration structures on the host with one deferred operation
+  // each, joined from the thread pool. Blocks until all builds are finished.
+  // Requires the accelerationStructureHostCommands feature. The structures
+  // live in host memory, they are meant for host side use and benchmarks.
+  static void buildOnHost(
+      const std::vector<AccelerationStructure*>& accelerationStructures,
+      core::ThreadPool& threadPool);
+
  protected:
   explicit AccelerationStructure(const Desc& desc)
-      : Object{desc.device}, mType{desc.type} {}
+      : Object{desc.device}, mType{desc.type}, mBuildType{desc.buildType} {}
 
   void create();
 
@@ -32,8 +52,10 @@ class AccelerationStructure : public Object<VkAccelerationStructureKHR> {
 
  private:
   const VkAccelerationStructureTypeKHR mType;
+  const VkAccelerationStructureBuildTypeKHR mBuildType;
   uPtr<Buffer> mASBuffer;
   uPtr<Buffer> mScratchBuffer;
+  std::vector<uint8_t> mHostScratch;
 
   VkBuildAccelerationStructureFlagsKHR mBuildFlags =
       VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR |
@@ -55,6 +77,8 @@ class BLAS : public AccelerationStructure {
     uint32_t indexCount = 0;
     uint32_t vertexSize = 0;
     uint32_t transformOffset = 0;
+    // Non-opaque geometry reports candidate hits, e.g. for alpha testing
+    bool opaque = true;
   };
 
   struct Desc {
@@ -63,6 +87,26 @@ class BLAS : public AccelerationStructure {
   };
 
   explicit BLAS(const Desc& desc);
+
+  // Geometry in host memory for host builds. The data has to stay alive until
+  // the build has finished.
+  struct HostMesh {
+    const void* vertices = nullptr;
+    const uint32_t* indices = nullptr;
+    const VkTransformMatrixKHR* transform = nullptr;
+    uint32_t vertexCount = 0;
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+    uint32_t vertexSize = 0;
+    bool opaque = true;
+  };
+
+  struct HostDesc {
+    const Device& device;
+    const HostMesh& mesh;
+  };
+
+  explicit BLAS(const HostDesc& desc);
 };
 
 class TLAS : public AccelerationStructure {
@@ -72,6 +116,8 @@ class TLAS : public AccelerationStructure {
     uint32_t instanceID;
     VkTransformMatrixKHR transform;
     VkGeometryInstanceFlagsKHR flags;
+    // Hit group index for ray tracing pipelines
+    uint32_t sbtRecordOffset = 0;
   };
 
   struct Desc {
@@ -0,0 +1,99 @@
+#include "barrier.h"
+
+namespace recore::vulkan {
+
+BarrierBatch& BarrierBatch::memory(const Access& src, const Access& dst) {
+  mMemoryBarriers.push_back({
+      .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+      .srcStageMask = src.stages,
+      .srcAccessMask = src.access,
+      .dstStageMask = dst.stages,
+      .dstAccessMask = dst.access,
+  });
+  return *this;
+}
+
+BarrierBatch& BarrierBatch::buffer(const Buffer& buffer,
+                                   const Access& src,
+                                   const Access& dst,
+                                   VkDeviceSize offset,
+                                   VkDeviceSize size) {
+  mBufferBarriers.push_back({
+      .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+      .srcStageMask = src.stages,
+      .srcAccessMask = src.access,
+      .dstStageMask = dst.stages,
+      .dstAccessMask = dst.access,
+      .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .buffer = buffer.vkHandle(),
+      .offset = offset,
+      .size = size,
+  });
+  return *this;
+}
+
+BarrierBatch& BarrierBatch::image(const Image& image,
+                                  const Access& src,
+                                  const Access& dst) {
+  mImageBarriers.push_back({
+      .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+      .srcStageMask = src.stages,
+      .srcAccessMask = src.access,
+      .dstStageMask = dst.stages,
+      .dstAccessMask = dst.access,
+      .oldLayout = src.layout,
+      .newLayout = dst.layout,
+      .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .image = image.vkHandle(),
+      .subresourceRange =
+          {
+              .aspectMask = image.getAspect(),
+              .baseMipLevel = 0,
+              .levelCount = image.getMipLevel(),
+              .baseArrayLayer = 0,
+              .layerCount = 1,
+          },
+  });
+  return *this;
+}
+
+BarrierBatch& BarrierBatch::transferOwnership(const Buffer& buffer,
+                                              uint32_t srcQueueFamilyIndex,
+                                              uint32_t dstQueueFamilyIndex,
+                                              const Access& src,
+                                              const Access& dst) {
+  this->buffer(buffer, src, dst);
+  if (srcQueueFamilyIndex != dstQueueFamilyIndex) {
+    auto& barrier = mBufferBarriers.back();
+    barrier.srcQueueFamilyIndex = srcQueueFamilyIndex;
+    barrier.dstQueueFamilyIndex = dstQueueFamilyIndex;
+  }
+  return *this;
+}
+
+void BarrierBatch::flush() {
+  if (empty()) {
+    return;
+  }
+
+  VkDependencyInfo dependencyInfo{};
+  dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+  dependencyInfo.memoryBarrierCount = static_cast<uint32_t>(
+      mMemoryBarriers.size());
+  dependencyInfo.pMemoryBarriers = mMemoryBarriers.data();
+  dependencyInfo.bufferMemoryBarrierCount = static_cast<uint32_t>(
+      mBufferBarriers.size());
+  dependencyInfo.pBufferMemoryBarriers = mBufferBarriers.data();
+  dependencyInfo.imageMemoryBarrierCount = static_cast<uint32_t>(
+      mImageBarriers.size());
+  dependencyInfo.pImageMemoryBarriers = mImageBarriers.data();
+  mCommandBuffer.pipelineBarrier(dependencyInfo);
+
+  mMemoryBarriers.clear();
+  mBufferBarriers.clear();
+  mImageBarriers.clear();
+}
+
+}  // namespace recore::vulkan
@@ -0,0 +1,161 @@
+#pragma once
+
+#include "command.h"
+
+namespace recore::vulkan {
+
+// How a command uses a resource. The layout is ignored for buffers.
+struct Access {
+  VkPipelineStageFlags2 stages{VK_PIPELINE_STAGE_2_NONE};
+  VkAccessFlags2 access{VK_ACCESS_2_NONE};
+  VkImageLayout layout{VK_IMAGE_LAYOUT_UNDEFINED};
+};
+
+namespace access {
+
+// No previous use, or one whose content is discarded
+constexpr Access kNone{};
+
+constexpr Access kComputeSampled{
+    VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+    VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+};
+
+constexpr Access kComputeRead{
+    VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+    VK_ACCESS_2_SHADER_STORAGE_READ_BIT,
+    VK_IMAGE_LAYOUT_GENERAL,
+};
+
+constexpr Access kComputeWrite{
+    VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+    VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+    VK_IMAGE_LAYOUT_GENERAL,
+};
+
+constexpr Access kComputeReadWrite{
+    VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+    VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+    VK_IMAGE_LAYOUT_GENERAL,
+};
+
+constexpr Access kRayTracingSampled{
+    VK_PIPELINE_STAGE_2_RAY_TRACING_SHADER_BIT_KHR,
+    VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+};
+
+constexpr Access kRayTracingWrite{
+    VK_PIPELINE_STAGE_2_RAY_TRACING_SHADER_BIT_KHR,
+    VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+    VK_IMAGE_LAYOUT_GENERAL,
+};
+
+constexpr Access kFragmentSampled{
+    VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+    VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+};
+
+// Scene textures, sampled by the rasterizer, compute and ray tracing passes
+constexpr Access kShaderSampled{
+    VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT |
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT |
+        VK_PIPELINE_STAGE_2_RAY_TRACING_SHADER_BIT_KHR,
+    VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+};
+
+constexpr Access kColorAttachment{
+    VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+    VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT |
+        VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+    VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+};
+
+constexpr Access kDepthAttachment{
+    VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT |
+        VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+    VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+        VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+    VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+};
+
+constexpr Access kTransferRead{
+    VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+    VK_ACCESS_2_TRANSFER_READ_BIT,
+    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+};
+
+constexpr Access kTransferWrite{
+    VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+    VK_ACCESS_2_TRANSFER_WRITE_BIT,
+    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+};
+
+constexpr Access kAccelerationBuild{
+    VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
+    VK_ACCESS_2_ACCELERATION_STRUCTURE_READ_BIT_KHR |
+        VK_ACCESS_2_ACCELERATION_STRUCTURE_WRITE_BIT_KHR,
+};
+
+// The semaphore signaled after the transition orders it with the present
+constexpr Access kPresent{
+    VK_PIPELINE_STAGE_2_NONE,
+    VK_ACCESS_2_NONE,
+    VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+};
+
+}  // namespace access
+
+// Collects barriers and records them with a single vkCmdPipelineBarrier2 on
+// flush. Each barrier waits for exactly the stages and accesses of the
+// previous use, instead of what the layouts suggest.
+class BarrierBatch : public NoCopyMove {
+ public:
+  explicit BarrierBatch(const CommandBuffer& commandBuffer)
+      : mCommandBuffer{commandBuffer} {}
+
+  // Records what was not flushed yet
+  ~BarrierBatch() { flush(); }
+
+  // Global memory dependency, e.g. for resources used by device address
+  BarrierBatch& memory(const Access& src, const Access& dst);
+
+  BarrierBatch& buffer(const Buffer& buffer,
+                       const Access& src,
+                       const Access& dst,
+                       VkDeviceSize offset = 0,
+                       VkDeviceSize size = VK_WHOLE_SIZE);
+
+  // Transitions from the layout of src to the one of dst
+  BarrierBatch& image(const Image& image,
+                      const Access& src,
+                      const Access& dst);
+
+  // Queue family ownership transfer of an exclusive buffer. Record it on the
+  // releasing and afterwards on the acquiring queue. A plain buffer barrier
+  // if both families are the same.
+  BarrierBatch& transferOwnership(const Buffer& buffer,
+                                  uint32_t srcQueueFamilyIndex,
+                                  uint32_t dstQueueFamilyIndex,
+                                  const Access& src,
+                                  const Access& dst);
+
+  void flush();
+
+  [[nodiscard]] bool empty() const {
+    return mMemoryBarriers.empty() && mBufferBarriers.empty() &&
+           mImageBarriers.empty();
+  }
+
+ private:
+  const CommandBuffer& mCommandBuffer;
+
+  std::vector<VkMemoryBarrier2> mMemoryBarriers;
+  std::vector<VkBufferMemoryBarrier2> mBufferBarriers;
+  std::vector<VkImageMemoryBarrier2> mImageBarriers;
+};
+
+}  // namespace recore::vulkan
@@ -0,0 +1,171 @@
+#include "bindless.h"
+
+#include "command.h"
+#include "image.h"
+
+#include <algorithm>
+
+namespace recore::vulkan {
+
+constexpr VkDescriptorBindingFlags kBindingFlags =
+    VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+    VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+    VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+
+BindlessHeap::BindlessHeap(const Desc& desc) : mDevice{desc.device} {
+  // All bindings are visible to every stage, so the per stage limits apply
+  auto limits = mDevice.getPhysicalDevice().getProperties<
+      VkPhysicalDeviceVulkan12Properties,
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES>();
+  mSampledImages.capacity = std::min(
+      {desc.maxSampledImages,
+       limits.maxDescriptorSetUpdateAfterBindSampledImages,
+       limits.maxPerStageDescriptorUpdateAfterBindSampledImages});
+  mStorageImages.capacity = std::min(
+      {desc.maxStorageImages,
+       limits.maxDescriptorSetUpdateAfterBindStorageImages,
+       limits.maxPerStageDescriptorUpdateAfterBindStorageImages});
+  mSamplers.capacity = std::min(
+      {desc.maxSamplers,
+       limits.maxDescriptorSetUpdateAfterBindSamplers,
+       limits.maxPerStageDescriptorUpdateAfterBindSamplers});
+
+  // Samplers do not count towards the resources of a stage
+  auto resources = limits.maxPerStageUpdateAfterBindResources;
+  mSampledImages.capacity = std::min(mSampledImages.capacity, resources);
+  mStorageImages.capacity = std::min(mStorageImages.capacity,
+                                     resources - mSampledImages.capacity);
+
+  mPool = makeUnique<DescriptorPool>({
+      .device = mDevice,
+      .poolSizes =
+          {
+              {VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, mSampledImages.capacity},
+              {VK_DESCRIPTOR_TYPE_SAMPLER, mSamplers.capacity},
+              {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, mStorageImages.capacity},
+          },
+      .flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT,
+  });
+
+  mLayout = makeUnique<DescriptorSetLayout>({
+      .device = mDevice,
+      .bindings =
+          {
+              {
+                  {.binding = kSampledImageBinding,
+                   .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+                   .descriptorCount = mSampledImages.capacity,
+                   .stageFlags = VK_SHADER_STAGE_ALL},
+                  kBindingFlags,
+              },
+              {
+                  {.binding = kSamplerBinding,
+                   .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER,
+                   .descriptorCount = mSamplers.capacity,
+                   .stageFlags = VK_SHADER_STAGE_ALL},
+                  kBindingFlags,
+              },
+              {
+                  {.binding = kStorageImageBinding,
+                   .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+                   .descriptorCount = mStorageImages.capacity,
+                   .stageFlags = VK_SHADER_STAGE_ALL},
+                  kBindingFlags,
+              },
+          },
+      .flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT,
+  });
+
+  mSet = makeUnique<DescriptorSet>({
+      .device = mDevice,
+      .pool = *mPool,
+      .layout = *mLayout,
+  });
+
+  mPipelineLayout = makeUnique<PipelineLayout>({
+      .device = mDevice,
+      .descriptorSetLayouts = {&*mLayout},
+      .pushConstants = {{
+          .stageFlags = VK_SHADER_STAGE_ALL,
+          .size = MAX_PUSH_CONSTANT_SIZE,
+      }},
+  });
+}
+
+uint32_t BindlessHeap::addSampledImage(const ImageView& view) {
+  return add(mSampledImages,
+             kSampledImageBinding,
+             {
+                 .imageView = view.vkHandle(),
+                 .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+             });
+}
+
+uint32_t BindlessHeap::addStorageImage(const ImageView& view) {
+  return add(mStorageImages,
+             kStorageImageBinding,
+             {
+                 .imageView = view.vkHandle(),
+                 .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
+             });
+}
+
+uint32_t BindlessHeap::addSampler(const Sampler& sampler) {
+  return add(mSamplers, kSamplerBinding, {.sampler = sampler.vkHandle()});
+}
+
+void BindlessHeap::removeSampledImage(uint32_t handle) {
+  remove(mSampledImages, handle);
+}
+
+void BindlessHeap::removeStorageImage(uint32_t handle) {
+  remove(mStorageImages, handle);
+}
+
+void BindlessHeap::removeSampler(uint32_t handle) {
+  remove(mSamplers, handle);
+}
+
+void BindlessHeap::bind(const CommandBuffer& commandBuffer,
+                        VkPipelineBindPoint bindPoint) const {
+  commandBuffer.bindDescriptorSet(*mPipelineLayout, *mSet, 0, bindPoint);
+}
+
+uint32_t BindlessHeap::add(Slots& slots,
+                           uint32_t binding,
+                           const VkDescriptorImageInfo& imageInfo) {
+  std::scoped_lock lock{mMutex};
+
+  uint32_t handle = 0;
+  if (!slots.free.empty()) {
+    handle = slots.free.back();
+    slots.free.pop_back();
+  } else if (slots.count < slots.capacity) {
+    handle = slots.count++;
+  } else {
+    throw std::runtime_error("BindlessHeap: out of descriptors!");
+  }
+
+  // Update after bind, the set may be bound in pending command buffers
+  VkWriteDescriptorSet write{};
+  write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+  write.dstSet = mSet->vkHandle();
+  write.dstBinding = binding;
+  write.dstArrayElement = handle;
+  write.descriptorCount = 1;
+  write.descriptorType = mLayout->getBinding(binding).descriptorType;
+  write.pImageInfo = &imageInfo;
+
+  vkUpdateDescriptorSets(mDevice.vkHandle(), 1, &write, 0, nullptr);
+  return handle;
+}
+
+void BindlessHeap::remove(Slots& slots, uint32_t handle) {
+  if (handle == kInvalidHandle) {
+    return;
+  }
+  std::scoped_lock lock{mMutex};
+  slots.free.push_back(handle);
+}
+
+}  // namespace recore::vulkan
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "descriptor.h"
+#include "pipeline.h"
+
+#include <mutex>
+
+namespace recore::vulkan {
+
+class CommandBuffer;
+class ImageView;
+class Sampler;
+
+// Descriptors of all images and samplers of the device in one update after
+// bind set. Shaders index it with handles passed in push constants, see
+// recore/shaders/bindless.glsl. Images and samplers add themselves on
+// creation and remove themselves on destruction, so a handle is stable for
+// the lifetime of its object.
+class BindlessHeap : public NoCopyMove {
+ public:
+  // Clamped to the update after bind limits of the device
+  struct Desc {
+    const Device& device;
+    uint32_t maxSampledImages = 1 << 14;
+    uint32_t maxStorageImages = 1 << 14;
+    uint32_t maxSamplers = 256;
+  };
+
+  static constexpr uint32_t kSampledImageBinding = 0;
+  static constexpr uint32_t kSamplerBinding = 1;
+  static constexpr uint32_t kStorageImageBinding = 2;
+
+  static constexpr uint32_t kInvalidHandle = ~0u;
+
+  explicit BindlessHeap(const Desc& desc);
+
+  [[nodiscard]] uint32_t addSampledImage(const ImageView& view);
+  [[nodiscard]] uint32_t addStorageImage(const ImageView& view);
+  [[nodiscard]] uint32_t addSampler(const Sampler& sampler);
+
+  // Later adds reuse the slot, so the GPU must be done with the object
+  void removeSampledImage(uint32_t handle);
+  void removeStorageImage(uint32_t handle);
+  void removeSampler(uint32_t handle);
+
+  // The heap at set 0 and MAX_PUSH_CONSTANT_SIZE bytes of push constants for
+  // all stages. Pipelines sharing it keep the heap bound across binds.
+  [[nodiscard]] const PipelineLayout& getPipelineLayout() const {
+    return *mPipelineLayout;
+  }
+
+  [[nodiscard]] const DescriptorSetLayout& getLayout() const {
+    return *mLayout;
+  }
+
+  [[nodiscard]] const DescriptorSet& getDescriptorSet() const {
+    return *mSet;
+  }
+
+  void bind(const CommandBuffer& commandBuffer,
+            VkPipelineBindPoint bindPoint) const;
+
+ private:
+  struct Slots {
+    uint32_t capacity{0};
+    uint32_t count{0};
+    std::vector<uint32_t> free;
+  };
+
+  uint32_t add(Slots& slots,
+               uint32_t binding,
+               const VkDescriptorImageInfo& imageInfo);
+  void remove(Slots& slots, uint32_t handle);
+
+  const Device& mDevice;
+
+  uPtr<DescriptorPool> mPool;
+  uPtr<DescriptorSetLayout> mLayout;
+  uPtr<DescriptorSet> mSet;
+  uPtr<PipelineLayout> mPipelineLayout;
+
+  std::mutex mMutex;
+  Slots mSampledImages;
+  Slots mStorageImages;
+  Slots mSamplers;
+};
+
+}  // namespace recore::vulkan
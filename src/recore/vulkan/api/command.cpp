@@ -44,6 +44,7 @@ void CommandBuffer::begin(VkCommandBufferUsageFlags usage) const {
   beginInfo.pInheritanceInfo = nullptr;
 
   checkResult(vkBeginCommandBuffer(mHandle, &beginInfo));
+  mBarrierStatistics = {};
 }
 
 void CommandBuffer::end() const {
@@ -172,6 +173,21 @@ void CommandBuffer::dispatch(DispatchDim dimensions) const {
   vkCmdDispatch(mHandle, dimensions.x, dimensions.y, dimensions.z);
 }
 
+void CommandBuffer::traceRays(const RayTracingPipeline& pipeline,
+                              uint32_t width,
+                              uint32_t height,
+                              uint32_t depth) const {
+  const auto& sbt = pipeline.getShaderBindingTable();
+  vkCmdTraceRaysKHR(mHandle,
+                    &sbt.rayGen,
+                    &sbt.miss,
+                    &sbt.hit,
+                    &sbt.callable,
+                    width,
+                    height,
+                    depth);
+}
+
 void CommandBuffer::copyBufferToBuffer(const Buffer& src,
                                        const Buffer& dst) const {
   VkBufferCopy copyRegion{};
@@ -311,173 +327,14 @@ void CommandBuffer::clearColorImage(const Image& image,
   vkCmdClearColorImage(mHandle, image.vkHandle(), layout, &color, 1, &range);
 }
 
-void CommandBuffer::imageMemoryBarrier(
-    VkPipelineStageFlags srcStage,
-    VkPipelineStageFlags dstStage,
-    VkImageMemoryBarrier imageMemoryBarrier) const {
-  vkCmdPipelineBarrier(mHandle,
-                       srcStage,
-                       dstStage,
-                       0,
-                       0,
-                       nullptr,
-                       0,
-                       nullptr,
-                       1,
-                       &imageMemoryBarrier);
-}
-
-void CommandBuffer::transitionImageLayout(const Image& image,
-                                          VkImageLayout srcLayout,
-                                          VkImageLayout dstLayout,
-                                          VkPipelineStageFlags srcStage,
-                                          VkPipelineStageFlags dstStage) const {
-  // Setup general memory barrier.
-  VkImageMemoryBarrier barrier{};
-  barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-  barrier.oldLayout = srcLayout;
-  barrier.newLayout = dstLayout;
-
-  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-
-  barrier.image = image.vkHandle();
-
-  barrier.subresourceRange.aspectMask = image.getAspect();
-  barrier.subresourceRange.baseMipLevel = 0;
-  barrier.subresourceRange.levelCount = image.getMipLevel();
-  barrier.subresourceRange.baseArrayLayer = 0;
-  barrier.subresourceRange.layerCount = 1;
-
-  // Adapted from github.com/KhronosGroup/Vulkan-Samples -> vk_common.cpp
-  switch (srcLayout) {
-    case VK_IMAGE_LAYOUT_UNDEFINED:
-      // Image layout is undefined (or does not matter)
-      // Only valid as initial layout
-      // No flags required, listed only for completeness
-      barrier.srcAccessMask = 0;
-      break;
-
-    case VK_IMAGE_LAYOUT_PREINITIALIZED:
-      // Image is preinitialized
-      // Only valid as initial layout for linear images, preserves memory
-      // contents Make sure host writes have been finished
-      barrier.srcAccessMask = VK_ACCESS_HOST_WRITE_BIT;
-      break;
-
-    case VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL:
-      // Image is a color attachment
-      // Make sure any writes to the color buffer have been finished
-      barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-      break;
-
-    case VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL:
-      // Image is a depth/stencil attachment
-      // Make sure any writes to the depth/stencil buffer have been finished
-      barrier.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-      break;
-
-    case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
-      // Image is a transfer source
-      // Make sure any reads from the image have been finished
-      barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-      break;
-
-    case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:
-      // Image is a transfer destination
-      // Make sure any writes to the image have been finished
-      barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-      break;
-
-    case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
-      // Image is read by a shader
-      // Make sure any shader reads from the image have been finished
-      barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
-      break;
-
-    case VK_IMAGE_LAYOUT_GENERAL:
-      // Works to sync Compute to Graphics.
-      barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
-      break;
-
-    default:
-      throw VulkanException(
-          VK_ERROR_UNKNOWN,
-          "Image::transitionLayout: Unsupported srcLayout transition!");
-  }
-
-  switch (dstLayout) {
-    case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:
-      // Image will be used as a transfer destination
-      // Make sure any writes to the image have been finished
-      barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-      break;
-
-    case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
-      // Image will be used as a transfer source
-      // Make sure any reads from the image have been finished
-      barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-      break;
-
-    case VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL:
-      // Image will be used as a color attachment
-      // Make sure any writes to the color buffer have been finished
-      barrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-      break;
-
-    case VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL:
-    case VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL:
-      // Image layout will be used as a depth/stencil attachment
-      // Make sure any writes to depth/stencil buffer have been finished
-      barrier.dstAccessMask = barrier.dstAccessMask |
-                              VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-      break;
-
-    case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
-      // Image will be read in a shader (sampler, input attachment)
-      // Make sure any writes to the image have been finished
-      barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-      break;
-
-    case VK_IMAGE_LAYOUT_PRESENT_SRC_KHR:
-      barrier.dstAccessMask = 0;
-      break;
-
-    case VK_IMAGE_LAYOUT_GENERAL:
-      // Works to sync Graphics to Compute.
-      barrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
-      break;
-
-    default:
-      throw VulkanException(
-          VK_ERROR_UNKNOWN,
-          "Image::transitionLayout: Unsupported dstLayout transition!");
-  }
-
-  imageMemoryBarrier(srcStage, dstStage, barrier);
-}
-
-void CommandBuffer::transitionImageLayout(
-    const std::vector<const Image*>& images,
-    VkImageLayout srcLayout,
-    VkImageLayout dstLayout,
-    VkPipelineStageFlags srcStage,
-    VkPipelineStageFlags dstStage) const {
-  for (const auto& image : images) {
-    transitionImageLayout(*image, srcLayout, dstLayout, srcStage, dstStage);
-  }
-}
+void CommandBuffer::pipelineBarrier(
+    const VkDependencyInfo& dependencyInfo) const {
+  vkCmdPipelineBarrier2(mHandle, &dependencyInfo);
 
-void CommandBuffer::memoryBarrier(VkAccessFlags srcAccessMask,
-                                  VkAccessFlags dstAccessMask,
-                                  VkPipelineStageFlagBits srcStage,
-                                  VkPipelineStageFlagBits dstStage) const {
-  VkMemoryBarrier barrier{};
-  barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
-  barrier.srcAccessMask = srcAccessMask;
-  barrier.dstAccessMask = dstAccessMask;
-  vkCmdPipelineBarrier(
-      mHandle, srcStage, dstStage, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+  mBarrierStatistics.batches++;
+  mBarrierStatistics.barriers += dependencyInfo.memoryBarrierCount +
+                                 dependencyInfo.bufferMemoryBarrierCount +
+                                 dependencyInfo.imageMemoryBarrierCount;
 }
 
 };  // namespace recore::vulkan
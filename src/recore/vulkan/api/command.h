@@ -19,6 +19,10 @@ class CommandPool : public Object<VkCommandPool> {
   explicit CommandPool(const Desc& desc);
   ~CommandPool() override;
 
+  [[nodiscard]] uint32_t getQueueFamilyIndex() const {
+    return mQueueFamilyIndex;
+  }
+
  private:
   uint32_t mQueueFamilyIndex{0};
 };
@@ -36,6 +40,10 @@ class CommandBuffer : public Object<VkCommandBuffer> {
   void begin(VkCommandBufferUsageFlags usage = 0) const;
   void end() const;
 
+  [[nodiscard]] uint32_t getQueueFamilyIndex() const {
+    return mCommandPool.getQueueFamilyIndex();
+  }
+
   // Binding:
   void beginRenderPass(const RenderPass& renderPass,
                        const Framebuffer& framebuffer,
@@ -104,6 +112,12 @@ class CommandBuffer : public Object<VkCommandBuffer> {
 
   void dispatch(DispatchDim dimension) const;
 
+  // Ray tracing:
+  void traceRays(const RayTracingPipeline& pipeline,
+                 uint32_t width,
+                 uint32_t height,
+                 uint32_t depth = 1) const;
+
   // Memory:
   void copyBufferToBuffer(const Buffer& src, const Buffer& dst) const;
 
@@ -133,27 +147,19 @@ class CommandBuffer : public Object<VkCommandBuffer> {
                        VkImageLayout layout,
                        const VkClearColorValue& color) const;
 
-  // Synchronization:
-  void imageMemoryBarrier(VkPipelineStageFlags srcStage,
-                          VkPipelineStageFlags dstStage,
-                          VkImageMemoryBarrier imageMemoryBarrier) const;
+  // Synchronization, see BarrierBatch for building the dependency:
+  void pipelineBarrier(const VkDependencyInfo& dependencyInfo) const;
 
-  void transitionImageLayout(const Image& image,
-                             VkImageLayout srcLayout,
-                             VkImageLayout dstLayout,
-                             VkPipelineStageFlags srcStage,
-                             VkPipelineStageFlags dstStage) const;
-
-  void transitionImageLayout(const std::vector<const Image*>& images,
-                             VkImageLayout srcLayout,
-                             VkImageLayout dstLayout,
-                             VkPipelineStageFlags srcStage,
-                             VkPipelineStageFlags dstStage) const;
+  struct BarrierStatistics {
+    // Recorded vkCmdPipelineBarrier2 calls and the barriers in them
+    uint32_t batches = 0;
+    uint32_t barriers = 0;
+  };
 
-  void memoryBarrier(VkAccessFlags srcAccessMask,
-                     VkAccessFlags dstAccessMask,
-                     VkPipelineStageFlagBits srcStage,
-                     VkPipelineStageFlagBits dstStage) const;
+  // Since the last begin()
+  [[nodiscard]] const BarrierStatistics& getBarrierStatistics() const {
+    return mBarrierStatistics;
+  }
 
   // Querys:
   void resetTimestampPool(const TimestampQueryPool& queryPool) const {
@@ -186,6 +192,8 @@ class CommandBuffer : public Object<VkCommandBuffer> {
 
  private:
   const CommandPool& mCommandPool;
+
+  mutable BarrierStatistics mBarrierStatistics;
 };
 
 }  // namespace recore::vulkan
@@ -0,0 +1,43 @@
+#include "deferred_operation.h"
+
+namespace recore::vulkan {
+
+DeferredOperation::DeferredOperation(const Desc& desc) : Object{desc.device} {
+  checkResult(
+      vkCreateDeferredOperationKHR(mDevice.vkHandle(), nullptr, &mHandle));
+}
+
+DeferredOperation::~DeferredOperation() {
+  vkDestroyDeferredOperationKHR(mDevice.vkHandle(), mHandle, nullptr);
+}
+
+std::vector<std::future<void>> DeferredOperation::join(
+    core::ThreadPool& threadPool) const {
+  auto concurrency = std::min(
+      vkGetDeferredOperationMaxConcurrencyKHR(mDevice.vkHandle(), mHandle),
+      threadPool.getThreadCount());
+
+  std::vector<std::future<void>> futures;
+  futures.reserve(concurrency);
+  for (uint32_t i = 0; i < concurrency; i++) {
+    futures.push_back(threadPool.submit([this]() {
+      VkResult result =
+          vkDeferredOperationJoinKHR(mDevice.vkHandle(), mHandle);
+      // VK_THREAD_IDLE_KHR: no work right now, but there might be later
+      while (result == VK_THREAD_IDLE_KHR) {
+        std::this_thread::yield();
+        result = vkDeferredOperationJoinKHR(mDevice.vkHandle(), mHandle);
+      }
+      if (result != VK_THREAD_DONE_KHR) {
+        checkResult(result);
+      }
+    }));
+  }
+  return futures;
+}
+
+VkResult DeferredOperation::getResult() const {
+  return vkGetDeferredOperationResultKHR(mDevice.vkHandle(), mHandle);
+}
+
+}  // namespace recore::vulkan
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "device.h"
+
+#include <recore/core/thread_pool.h>
+
+#include <future>
+
+namespace recore::vulkan {
+
+class DeferredOperation : public Object<VkDeferredOperationKHR> {
+ public:
+  struct Desc {
+    const Device& device;
+  };
+
+  explicit DeferredOperation(const Desc& desc);
+  ~DeferredOperation() override;
+
+  // Joins the operation from as many workers as the implementation can make
+  // use of. The operation is complete once all returned futures are ready.
+  [[nodiscard]] std::vector<std::future<void>> join(
+      core::ThreadPool& threadPool) const;
+
+  [[nodiscard]] VkResult getResult() const;
+};
+
+}  // namespace recore::vulkan
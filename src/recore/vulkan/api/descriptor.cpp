@@ -15,6 +15,7 @@ DescriptorSetLayout::DescriptorSetLayout(const Desc& desc)
 
   VkDescriptorSetLayoutCreateInfo layoutInfo{};
   layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+  layoutInfo.flags = desc.flags;
   layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
   layoutInfo.pBindings = bindings.data();
 
@@ -45,7 +46,7 @@ DescriptorPool::DescriptorPool(const Desc& desc) : Object{desc.device} {
 
   VkDescriptorPoolCreateInfo poolInfo{};
   poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-  poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+  poolInfo.flags = desc.flags;
   poolInfo.maxSets = desc.maxSets;
   poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
   poolInfo.pPoolSizes = poolSizes.data();
@@ -145,4 +146,75 @@ void DescriptorSet::update(const Resources& resources) const {
                          nullptr);
 }
 
+static size_t getDescriptorInfoSize(VkDescriptorType type) {
+  switch (type) {
+    case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+    case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+    case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+    case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
+      return sizeof(VkDescriptorBufferInfo);
+    case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+    case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
+      return sizeof(VkBufferView);
+    case VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR:
+      return sizeof(VkAccelerationStructureKHR);
+    default:
+      return sizeof(VkDescriptorImageInfo);
+  }
+}
+
+DescriptorUpdateTemplate::DescriptorUpdateTemplate(const Desc& desc)
+    : Object{desc.device} {
+  auto entries = rstd::transform<Entry, VkDescriptorUpdateTemplateEntry>(
+      desc.entries, [&](const Entry& entry) {
+        auto type = desc.layout.getBinding(entry.binding).descriptorType;
+        return VkDescriptorUpdateTemplateEntry{
+            .dstBinding = entry.binding,
+            .dstArrayElement = entry.arrayElement,
+            .descriptorCount = entry.count,
+            .descriptorType = type,
+            .offset = entry.offset,
+            .stride = entry.stride != 0 ? entry.stride
+                                        : getDescriptorInfoSize(type),
+        };
+      });
+
+  VkDescriptorUpdateTemplateCreateInfo templateInfo{};
+  templateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO;
+  templateInfo.descriptorUpdateEntryCount = static_cast<uint32_t>(
+      entries.size());
+  templateInfo.pDescriptorUpdateEntries = entries.data();
+  templateInfo.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET;
+  templateInfo.descriptorSetLayout = desc.layout.vkHandle();
+
+  checkResult(vkCreateDescriptorUpdateTemplate(
+      mDevice.vkHandle(), &templateInfo, nullptr, &mHandle));
+}
+
+DescriptorUpdateTemplate::~DescriptorUpdateTemplate() {
+  vkDestroyDescriptorUpdateTemplate(mDevice.vkHandle(), mHandle, nullptr);
+}
+
+void DescriptorUpdateTemplate::update(const DescriptorSet& set,
+                                      const void* data) const {
+  vkUpdateDescriptorSetWithTemplate(
+      mDevice.vkHandle(), set.vkHandle(), mHandle, data);
+}
+
+VkDescriptorImageInfo getStorageImageInfo(const Image& image) {
+  return {
+      .imageView = image.getView().vkHandle(),
+      .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
+  };
+}
+
+VkDescriptorImageInfo getSampledImageInfo(const Image& image,
+                                          const Sampler& sampler) {
+  return {
+      .sampler = sampler.vkHandle(),
+      .imageView = image.getView().vkHandle(),
+      .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+  };
+}
+
 }  // namespace recore::vulkan
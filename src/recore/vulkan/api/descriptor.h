@@ -1,6 +1,7 @@
 #pragma once
 
 #include "device.h"
+#include "image.h"
 
 #include <map>
 
@@ -16,6 +17,7 @@ class DescriptorSetLayout : public Object<VkDescriptorSetLayout> {
   struct Desc {
     const Device& device;
     const std::vector<BindingDesc>& bindings;
+    VkDescriptorSetLayoutCreateFlags flags = 0;
   };
 
   explicit DescriptorSetLayout(const Desc& desc);
@@ -49,6 +51,8 @@ class DescriptorPool : public Object<VkDescriptorPool> {
     uint32_t maxSets = 1;
     uint32_t multiplier = 1;
     bool perSet = false;
+    VkDescriptorPoolCreateFlags flags =
+        VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
 
     [[nodiscard]] std::vector<VkDescriptorPoolSize> getPoolSizes() const {
       uint32_t finalMultiplier = multiplier * (perSet ? maxSets : 1);
@@ -93,9 +97,57 @@ class DescriptorSet : public Object<VkDescriptorSet> {
 
   void update(const Resources& resources) const;
 
+  [[nodiscard]] const DescriptorSetLayout& getLayout() const {
+    return mLayout;
+  }
+
  private:
   const DescriptorPool& mPool;
   const DescriptorSetLayout& mLayout;
 };
 
+// Update of a set layout compiled once, afterwards sets are updated from a
+// flat struct of descriptor infos with a single call
+class DescriptorUpdateTemplate : public Object<VkDescriptorUpdateTemplate> {
+ public:
+  struct Entry {
+    uint32_t binding;
+    // Of the first VkDescriptorImageInfo, VkDescriptorBufferInfo or
+    // VkAccelerationStructureKHR in the struct
+    size_t offset;
+    uint32_t arrayElement = 0;
+    uint32_t count = 1;
+    // Between array elements, 0 if they are tightly packed
+    size_t stride = 0;
+  };
+
+  struct Desc {
+    const Device& device;
+    const DescriptorSetLayout& layout;
+    const std::vector<Entry>& entries;
+  };
+
+  explicit DescriptorUpdateTemplate(const Desc& desc);
+  ~DescriptorUpdateTemplate() override;
+
+  // For a struct of one Info per binding, in binding order from binding 0
+  template <typename T, typename Info = VkDescriptorImageInfo>
+  [[nodiscard]] static std::vector<Entry> getEntries() {
+    static_assert(sizeof(T) % sizeof(Info) == 0);
+    std::vector<Entry> entries;
+    for (uint32_t binding = 0; binding < sizeof(T) / sizeof(Info); binding++) {
+      entries.push_back({.binding = binding, .offset = binding * sizeof(Info)});
+    }
+    return entries;
+  }
+
+  // The set has to use the layout of the template
+  void update(const DescriptorSet& set, const void* data) const;
+};
+
+// Infos of images in the data of an update template
+[[nodiscard]] VkDescriptorImageInfo getStorageImageInfo(const Image& image);
+[[nodiscard]] VkDescriptorImageInfo getSampledImageInfo(
+    const Image& image, const Sampler& sampler);
+
 }  // namespace recore::vulkan
@@ -2,14 +2,95 @@
 #define VMA_IMPLEMENTATION
 
 #include "device.h"
+#include "bindless.h"
 #include "command.h"
+#include "immediate_context.h"
+#include "pipeline_cache.h"
+#include "synchronization.h"
+
+#include <recore/core/cpu_profiler.h>
 
 namespace recore::vulkan {
 
+// Enables the features the wrapper itself relies on. Missing support is
+// reported by name, vkCreateDevice only returns VK_ERROR_FEATURE_NOT_PRESENT.
+static void enableRequiredFeatures(const PhysicalDevice& gpu,
+                                   Device::Features& features) {
+  using Features12 = VkPhysicalDeviceVulkan12Features;
+  using Features13 = VkPhysicalDeviceVulkan13Features;
+  const auto& supported = gpu.getFeatures();
+  auto supported12 = gpu.getFeatures<
+      Features12,
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES>();
+  auto supported13 = gpu.getFeatures<
+      Features13,
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES>();
+
+  std::vector<std::string> missing;
+  auto require = [&](auto& enabled,
+                     const auto& available,
+                     auto feature,
+                     const char* name) {
+    enabled.*feature = VK_TRUE;
+    if (available.*feature == VK_FALSE) {
+      missing.emplace_back(name);
+    }
+  };
+
+  // Queues track their submits with timeline semaphores, core since 1.2
+  require(features.features12,
+          supported12,
+          &Features12::timelineSemaphore,
+          "timelineSemaphore");
+  // Render graph barriers use vkCmdPipelineBarrier2, core since 1.3
+  require(features.features13,
+          supported13,
+          &Features13::synchronization2,
+          "synchronization2");
+  // Profiler queries are reset on the host, core since 1.2
+  require(features.features12,
+          supported12,
+          &Features12::hostQueryReset,
+          "hostQueryReset");
+
+  // Bindless heap of all images and samplers, indexed with push constants
+  require(features.features,
+          supported,
+          &VkPhysicalDeviceFeatures::shaderSampledImageArrayDynamicIndexing,
+          "shaderSampledImageArrayDynamicIndexing");
+  require(features.features,
+          supported,
+          &VkPhysicalDeviceFeatures::shaderStorageImageArrayDynamicIndexing,
+          "shaderStorageImageArrayDynamicIndexing");
+  for (auto [feature, name] :
+       {std::pair{&Features12::descriptorIndexing, "descriptorIndexing"},
+        std::pair{&Features12::runtimeDescriptorArray,
+                  "runtimeDescriptorArray"},
+        std::pair{&Features12::descriptorBindingPartiallyBound,
+                  "descriptorBindingPartiallyBound"},
+        std::pair{&Features12::descriptorBindingSampledImageUpdateAfterBind,
+                  "descriptorBindingSampledImageUpdateAfterBind"},
+        std::pair{&Features12::descriptorBindingStorageImageUpdateAfterBind,
+                  "descriptorBindingStorageImageUpdateAfterBind"},
+        std::pair{&Features12::descriptorBindingUpdateUnusedWhilePending,
+                  "descriptorBindingUpdateUnusedWhilePending"}}) {
+    require(features.features12, supported12, feature, name);
+  }
+
+  if (!missing.empty()) {
+    std::string message = "Device: missing required features:";
+    for (const auto& name : missing) {
+      message += " " + name;
+    }
+    throw std::runtime_error(message);
+  }
+}
+
 Device::Device(const Desc& desc)
     : Object{*this},
       mInstance{desc.instance},
-      mPhysicalDevice{desc.physicalDevice} {
+      mPhysicalDevice{desc.physicalDevice},
+      mEnabledExtensions{desc.extensions} {
   const auto& queueFamilies = desc.physicalDevice.getQueueFamilies();
 
   // Give all queues same priority for now
@@ -36,6 +117,7 @@ Device::Device(const Desc& desc)
   deviceInfo.pQueueCreateInfos = queueInfos.data();
 
   auto features = desc.features;
+  enableRequiredFeatures(mPhysicalDevice, features);
   features.finalize();
   VkPhysicalDeviceFeatures2 features2{};
   if (mInstance.isExtensionEnabled(
@@ -106,13 +188,44 @@ Device::Device(const Desc& desc)
   }
 
   checkResult(vmaCreateAllocator(&allocatorInfo, &mMemoryAllocator));
+
+  mPipelineCache = makeUnique<PipelineCache>(
+      {.device = *this, .path = desc.pipelineCachePath});
+
+  mImmediateContext = makeUnique<ImmediateContext>(
+      {.device = *this, .queue = getGraphicsQueue()});
+
+  mBindlessHeap = makeUnique<BindlessHeap>({.device = *this});
 }
 
 Device::~Device() {
+  mImmediateContext.reset();
+  mBindlessHeap.reset();
+
+  mPipelineCache->save();
+  mPipelineCache.reset();
+
+  queues.clear();
+
   vmaDestroyAllocator(mMemoryAllocator);
   vkDestroyDevice(mHandle, nullptr);
 }
 
+void Device::registerPipeline(const Pipeline& pipeline) const {
+  std::scoped_lock lock{mPipelinesMutex};
+  mPipelines.push_back(&pipeline);
+}
+
+void Device::unregisterPipeline(const Pipeline& pipeline) const {
+  std::scoped_lock lock{mPipelinesMutex};
+  std::erase(mPipelines, &pipeline);
+}
+
+std::vector<const Pipeline*> Device::getPipelines() const {
+  std::scoped_lock lock{mPipelinesMutex};
+  return mPipelines;
+}
+
 Queue& Device::getGraphicsQueue() const {
   for (const auto& queue : queues) {
     const auto& first = queue[0];
@@ -134,20 +247,42 @@ Queue& Device::getComputeQueue() const {
   throw VulkanException(VK_INCOMPLETE, "No compute queue found.");
 }
 
+Queue& Device::getAsyncComputeQueue() const {
+  for (const auto& queue : queues) {
+    const auto& first = queue[0];
+    auto flags = first->getProperties().queueFlags;
+    if (first->getProperties().queueCount > 0 &&
+        (flags & VK_QUEUE_COMPUTE_BIT) && !(flags & VK_QUEUE_GRAPHICS_BIT)) {
+      return *first;
+    }
+  }
+
+  const auto& graphicsQueue = getGraphicsQueue();
+  const auto& graphicsFamily = queues[graphicsQueue.getFamilyIndex()];
+  if (graphicsFamily.size() > 1) {
+    return *graphicsFamily[1];
+  }
+  return graphicsQueue;
+}
+
 VkResult Device::waitIdle() const {
   return vkDeviceWaitIdle(mHandle);
 }
 
-void Device::submitAndWait(const CommandRecorder& recorder) const {
-  const auto& queue = getGraphicsQueue();
-  CommandPool commandPool{
-      {.device = *this, .queueFamilyIndex = queue.getFamilyIndex()}};
-  CommandBuffer commandBuffer{{.device = *this, .commandPool = commandPool}};
-  commandBuffer.begin();
-  recorder(commandBuffer);
-  commandBuffer.end();
-  vulkan::checkResult(queue.submit(commandBuffer));
-  vulkan::checkResult(queue.waitIdle());
+ImmediateContext& Device::getImmediateContext() const {
+  return *mImmediateContext;
+}
+
+BindlessHeap& Device::getBindlessHeap() const {
+  return *mBindlessHeap;
+}
+
+bool SyncPoint::isReached() const {
+  return queue->getTimeline().getValue() >= value;
+}
+
+void SyncPoint::wait() const {
+  queue->getTimeline().wait(value);
 }
 
 Queue::Queue(const Desc& desc)
@@ -157,25 +292,86 @@ Queue::Queue(const Desc& desc)
       mQueueIndex{desc.queueIndex},
       mCanPresent{desc.canPresent} {
   vkGetDeviceQueue(mDevice.vkHandle(), mFamilyIndex, mQueueIndex, &mHandle);
+
+  mTimeline = makeUnique<TimelineSemaphore>({.device = mDevice});
 }
 
-VkResult Queue::submit(const CommandBuffer& commandBuffer,
-                       VkFence fence) const {
+Queue::~Queue() = default;
+
+void Queue::Submit::wait(const SyncPoint& point, VkPipelineStageFlags stage) {
+  waits.push_back({
+      .semaphore = point.queue->getTimeline().vkHandle(),
+      .stage = stage,
+      .value = point.value,
+  });
+}
+
+SyncPoint Queue::submit(const Submit& submit) const {
+  RECORE_CPU_PROFILE_SCOPE("Queue::submit");
+
+  std::vector<VkSemaphore> waitSemaphores;
+  std::vector<VkPipelineStageFlags> waitStages;
+  std::vector<uint64_t> waitValues;
+  for (const auto& wait : submit.waits) {
+    waitSemaphores.push_back(wait.semaphore);
+    waitStages.push_back(wait.stage);
+    waitValues.push_back(wait.value);
+  }
+
+  std::vector<VkSemaphore> signalSemaphores;
+  std::vector<uint64_t> signalValues;
+  for (const auto& signal : submit.signals) {
+    signalSemaphores.push_back(signal.semaphore);
+    signalValues.push_back(signal.value);
+  }
+
+  // Values have to increase in submission order
+  std::scoped_lock lock{mSubmitMutex};
+  SyncPoint point{.queue = this, .value = mSubmitValue + 1};
+  signalSemaphores.push_back(mTimeline->vkHandle());
+  signalValues.push_back(point.value);
+
+  VkTimelineSemaphoreSubmitInfo timelineInfo{};
+  timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+  timelineInfo.waitSemaphoreValueCount = static_cast<uint32_t>(
+      waitValues.size());
+  timelineInfo.pWaitSemaphoreValues = waitValues.data();
+  timelineInfo.signalSemaphoreValueCount = static_cast<uint32_t>(
+      signalValues.size());
+  timelineInfo.pSignalSemaphoreValues = signalValues.data();
+
   VkSubmitInfo submitInfo{};
   submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-  submitInfo.commandBufferCount = 1;
-  submitInfo.pCommandBuffers = commandBuffer.vkPtr();
+  submitInfo.pNext = &timelineInfo;
+  submitInfo.waitSemaphoreCount = static_cast<uint32_t>(
+      waitSemaphores.size());
+  submitInfo.pWaitSemaphores = waitSemaphores.data();
+  submitInfo.pWaitDstStageMask = waitStages.data();
+  submitInfo.commandBufferCount = static_cast<uint32_t>(
+      submit.commandBuffers.size());
+  submitInfo.pCommandBuffers = submit.commandBuffers.data();
+  submitInfo.signalSemaphoreCount = static_cast<uint32_t>(
+      signalSemaphores.size());
+  submitInfo.pSignalSemaphores = signalSemaphores.data();
 
-  return submit({submitInfo}, fence);
+  checkResult(vkQueueSubmit(mHandle, 1, &submitInfo, VK_NULL_HANDLE));
+  mSubmitValue = point.value;
+  return point;
 }
 
-VkResult Queue::submit(const std::vector<VkSubmitInfo>& submits,
-                       VkFence fence) const {
-  return vkQueueSubmit(
-      mHandle, static_cast<uint32_t>(submits.size()), submits.data(), fence);
+SyncPoint Queue::submit(const CommandBuffer& commandBuffer) const {
+  return submit(Submit{.commandBuffers = {commandBuffer.vkHandle()}});
+}
+
+SyncPoint Queue::getLastSubmit() const {
+  std::scoped_lock lock{mSubmitMutex};
+  return {.queue = this, .value = mSubmitValue};
 }
 
 VkResult Queue::present(const VkPresentInfoKHR& presentInfo) const {
+  RECORE_CPU_PROFILE_SCOPE("Queue::present");
+
+  std::scoped_lock lock{mSubmitMutex};
   return vkQueuePresentKHR(mHandle, &presentInfo);
 }
 
@@ -8,13 +8,34 @@
 // #define VK_NO_PROTOTYPES
 #include <vk_mem_alloc.h>
 
+#include <atomic>
+#include <filesystem>
 #include <map>
+#include <mutex>
 #include <optional>
 
 namespace recore::vulkan {
 
+class BindlessHeap;
 class CommandBuffer;
+class ImmediateContext;
+class Pipeline;
+class PipelineCache;
 class Queue;
+class TimelineSemaphore;
+
+// Point on the timeline of a queue, reached once all work submitted to the
+// queue up to it has finished. Resources used by a submit are free again
+// after its point, e.g. for destruction or reading back results.
+struct SyncPoint {
+  const Queue* queue{nullptr};
+  uint64_t value{0};
+
+  [[nodiscard]] bool isReached() const;
+
+  // Blocks the calling thread until the point is reached
+  void wait() const;
+};
 
 // Cursed feature map inspired by:
 // https://github.com/KhronosGroup/Vulkan-Samples/blob/main/framework/core/physical_device.h
@@ -77,6 +98,8 @@ class Device : public Object<VkDevice> {
     std::optional<VkSurfaceKHR> surface;
     std::vector<std::string> extensions;
     Features features;
+    // Pipeline cache file, loaded on creation and saved on destruction
+    std::filesystem::path pipelineCachePath;
     // TODO: debug utils
   };
 
@@ -89,26 +112,68 @@ class Device : public Object<VkDevice> {
     return mPhysicalDevice;
   }
 
+  [[nodiscard]] bool isExtensionEnabled(const char* extensionName) const {
+    return std::ranges::contains(mEnabledExtensions, extensionName);
+  }
+
   [[nodiscard]] VmaAllocator getMemoryAllocator() const {
     return mMemoryAllocator;
   }
 
+  [[nodiscard]] const PipelineCache& getPipelineCache() const {
+    return *mPipelineCache;
+  }
+
+  // Live pipelines, for tools that inspect all of them (e.g. statistics)
+  void registerPipeline(const Pipeline& pipeline) const;
+  void unregisterPipeline(const Pipeline& pipeline) const;
+  [[nodiscard]] std::vector<const Pipeline*> getPipelines() const;
+
+  // Pipelines created while set keep their driver statistics. Off by default,
+  // capturing costs compile time and pipeline cache hits on some drivers.
+  void setCaptureStatistics(bool capture) const {
+    mCaptureStatistics = capture;
+  }
+  [[nodiscard]] bool isCapturingStatistics() const {
+    return mCaptureStatistics &&
+           isExtensionEnabled(
+               VK_KHR_PIPELINE_EXECUTABLE_PROPERTIES_EXTENSION_NAME);
+  }
+
   [[nodiscard]] Queue& getGraphicsQueue() const;
   [[nodiscard]] Queue& getComputeQueue() const;
 
+  // Compute queue that runs concurrently to the graphics queue: a dedicated
+  // compute family, else a second graphics family queue, else the graphics
+  // queue itself
+  [[nodiscard]] Queue& getAsyncComputeQueue() const;
+
   [[nodiscard]] VkResult waitIdle() const;
 
-  using CommandRecorder =
-      std::function<void(const CommandBuffer& commandBuffer)>;
-  void submitAndWait(const CommandRecorder& recorder) const;
+  // Batched one-off work on the graphics queue
+  [[nodiscard]] ImmediateContext& getImmediateContext() const;
+
+  // Global descriptors of all images and samplers
+  [[nodiscard]] BindlessHeap& getBindlessHeap() const;
 
  private:
   const Instance& mInstance;
   const PhysicalDevice& mPhysicalDevice;
 
+  std::vector<std::string> mEnabledExtensions;
+
   VmaAllocator mMemoryAllocator{VK_NULL_HANDLE};
 
+  uPtr<PipelineCache> mPipelineCache;
+
+  mutable std::mutex mPipelinesMutex;
+  mutable std::vector<const Pipeline*> mPipelines;
+  mutable std::atomic<bool> mCaptureStatistics{false};
+
   std::vector<std::vector<uPtr<Queue>>> queues;
+
+  uPtr<ImmediateContext> mImmediateContext;
+  uPtr<BindlessHeap> mBindlessHeap;
 };
 
 class Queue : public Object<VkQueue> {
@@ -122,7 +187,7 @@ class Queue : public Object<VkQueue> {
   };
 
   explicit Queue(const Desc& desc);
-  ~Queue() override = default;
+  ~Queue() override;
 
   [[nodiscard]] VkQueueFamilyProperties getProperties() const {
     return mProperties;
@@ -132,12 +197,42 @@ class Queue : public Object<VkQueue> {
 
   [[nodiscard]] uint32_t getFamilyIndex() const { return mFamilyIndex; }
 
-  [[nodiscard]] VkResult submit(const CommandBuffer& commandBuffer,
-                                VkFence fence = VK_NULL_HANDLE) const;
-  [[nodiscard]] VkResult submit(const std::vector<VkSubmitInfo>& submits,
-                                VkFence fence = VK_NULL_HANDLE) const;
+  struct SemaphoreWait {
+    VkSemaphore semaphore;
+    VkPipelineStageFlags stage;
+    // Ignored for binary semaphores
+    uint64_t value = 0;
+  };
+
+  struct SemaphoreSignal {
+    VkSemaphore semaphore;
+    uint64_t value = 0;
+  };
+
+  struct Submit {
+    std::vector<VkCommandBuffer> commandBuffers;
+    std::vector<SemaphoreWait> waits;
+    std::vector<SemaphoreSignal> signals;
+
+    // Waits for the point of another submit, e.g. on another queue
+    void wait(const SyncPoint& point, VkPipelineStageFlags stage);
+  };
+
+  // Every submit also signals the next value of the queue's timeline
+  // semaphore. Thread safe.
+  SyncPoint submit(const Submit& submit) const;
+
+  SyncPoint submit(const CommandBuffer& commandBuffer) const;
+
   [[nodiscard]] VkResult present(const VkPresentInfoKHR& presentInfo) const;
 
+  [[nodiscard]] const TimelineSemaphore& getTimeline() const {
+    return *mTimeline;
+  }
+
+  // Point of the latest submit, waiting for it is like waiting for idle
+  [[nodiscard]] SyncPoint getLastSubmit() const;
+
   [[nodiscard]] VkResult waitIdle() const;
 
  private:
@@ -145,6 +240,10 @@ class Queue : public Object<VkQueue> {
   VkQueueFamilyProperties mProperties{};
   uint32_t mQueueIndex{0};
   bool mCanPresent{false};
+
+  uPtr<TimelineSemaphore> mTimeline;
+  mutable std::mutex mSubmitMutex;
+  mutable uint64_t mSubmitValue{0};
 };
 
 }  // namespace recore::vulkan
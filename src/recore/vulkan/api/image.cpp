@@ -1,4 +1,5 @@
 #include "image.h"
+#include "bindless.h"
 
 #include <cmath>
 
@@ -81,6 +82,14 @@ Image::Image(const Desc& desc)
   // Create default image view for ease of use
   mView = std::make_unique<ImageView>(
       ImageView::Desc{.device = mDevice, .image = *this});
+
+  auto& heap = mDevice.getBindlessHeap();
+  if (mUsage & VK_IMAGE_USAGE_SAMPLED_BIT) {
+    mSampledHandle = heap.addSampledImage(*mView);
+  }
+  if (mUsage & VK_IMAGE_USAGE_STORAGE_BIT) {
+    mStorageHandle = heap.addStorageImage(*mView);
+  }
 }
 
 Image::Image(const Desc& desc, VkImage handle)
@@ -96,6 +105,10 @@ Image::Image(const Desc& desc, VkImage handle)
 }
 
 Image::~Image() {
+  auto& heap = mDevice.getBindlessHeap();
+  heap.removeSampledImage(mSampledHandle);
+  heap.removeStorageImage(mStorageHandle);
+
   // Only delete if image is actually owned
   if (mHandle != VK_NULL_HANDLE && mMemory != VK_NULL_HANDLE) {
     vmaDestroyImage(mDevice.getMemoryAllocator(), mHandle, mMemory);
@@ -166,9 +179,12 @@ Sampler::Sampler(const Desc& desc) : Object{desc.device} {
 
   checkResult(
       vkCreateSampler(mDevice.vkHandle(), &samplerInfo, nullptr, &mHandle));
+
+  mBindlessHandle = mDevice.getBindlessHeap().addSampler(*this);
 }
 
 Sampler::~Sampler() {
+  mDevice.getBindlessHeap().removeSampler(mBindlessHandle);
   vkDestroySampler(mDevice.vkHandle(), mHandle, nullptr);
 }
 
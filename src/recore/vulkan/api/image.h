@@ -46,6 +46,11 @@ class Image : public Object<VkImage> {
 
   [[nodiscard]] const ImageView& getView() const { return *mView; }
 
+  // Handles of the view in the bindless heap, BindlessHeap::kInvalidHandle
+  // without sampled or storage usage
+  [[nodiscard]] uint32_t getSampledHandle() const { return mSampledHandle; }
+  [[nodiscard]] uint32_t getStorageHandle() const { return mStorageHandle; }
+
  private:
   VmaAllocation mMemory{VK_NULL_HANDLE};
 
@@ -58,6 +63,9 @@ class Image : public Object<VkImage> {
   VkImageSubresource mSubresource{VK_IMAGE_ASPECT_NONE, 1, 1};
 
   uPtr<ImageView> mView;
+
+  uint32_t mSampledHandle{~0u};
+  uint32_t mStorageHandle{~0u};
 };
 
 class ImageView : public Object<VkImageView> {
@@ -92,6 +100,12 @@ class Sampler : public Object<VkSampler> {
 
   explicit Sampler(const Desc& desc);
   ~Sampler() override;
+
+  // Handle in the bindless heap
+  [[nodiscard]] uint32_t getHandle() const { return mBindlessHandle; }
+
+ private:
+  uint32_t mBindlessHandle{~0u};
 };
 
 }  // namespace recore::vulkan
@@ -0,0 +1,98 @@
+#include "immediate_context.h"
+
+#include <recore/core/cpu_profiler.h>
+
+namespace recore::vulkan {
+
+ImmediateContext::Batch::Batch(const Device& device, uint32_t queueFamilyIndex)
+    : commandPool{{.device = device, .queueFamilyIndex = queueFamilyIndex}},
+      commandBuffer{{.device = device, .commandPool = commandPool}} {}
+
+ImmediateContext::ImmediateContext(const Desc& desc)
+    : mDevice{desc.device}, mQueue{desc.queue} {}
+
+ImmediateContext::~ImmediateContext() {
+  std::scoped_lock lock{mMutex};
+  flushBatch();
+  for (const auto& [index, inFlight] : mInFlight) {
+    inFlight.submit.wait();
+  }
+}
+
+ImmediateContext::Ticket ImmediateContext::record(const Recorder& recorder) {
+  std::scoped_lock lock{mMutex};
+  if (mRecording == nullptr) {
+    mRecording = requestBatch();
+    mRecording->commandBuffer.begin(
+        VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+  }
+
+  recorder(mRecording->commandBuffer);
+  return {.batch = mRecordingIndex};
+}
+
+std::optional<SyncPoint> ImmediateContext::flush() {
+  std::scoped_lock lock{mMutex};
+  return flushBatch();
+}
+
+bool ImmediateContext::isComplete(Ticket ticket) const {
+  std::scoped_lock lock{mMutex};
+  if (ticket.batch >= mRecordingIndex) {
+    return false;
+  }
+  // Batches are forgotten once they finished and got reused
+  auto it = mInFlight.find(ticket.batch);
+  return it == mInFlight.end() || it->second.submit.isReached();
+}
+
+void ImmediateContext::wait(Ticket ticket) {
+  RECORE_CPU_PROFILE_SCOPE("ImmediateContext::wait");
+
+  SyncPoint submit;
+  {
+    std::scoped_lock lock{mMutex};
+    if (ticket.batch >= mRecordingIndex) {
+      flushBatch();
+    }
+    auto it = mInFlight.find(ticket.batch);
+    if (it == mInFlight.end()) {
+      return;
+    }
+    submit = it->second.submit;
+  }
+  submit.wait();
+}
+
+std::optional<SyncPoint> ImmediateContext::flushBatch() {
+  if (mRecording == nullptr) {
+    return std::nullopt;
+  }
+
+  mRecording->commandBuffer.end();
+  auto submit = mQueue.submit(mRecording->commandBuffer);
+  mInFlight.emplace(mRecordingIndex,
+                    InFlight{.submit = submit, .batch = std::move(mRecording)});
+  mRecordingIndex++;
+  return submit;
+}
+
+uPtr<ImmediateContext::Batch> ImmediateContext::requestBatch() {
+  for (auto it = mInFlight.begin(); it != mInFlight.end();) {
+    if (it->second.submit.isReached()) {
+      mFree.push_back(std::move(it->second.batch));
+      it = mInFlight.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  if (mFree.empty()) {
+    return makeUnique<Batch>(mDevice, mQueue.getFamilyIndex());
+  }
+  auto batch = std::move(mFree.back());
+  mFree.pop_back();
+  return batch;
+}
+
+}  // namespace recore::vulkan
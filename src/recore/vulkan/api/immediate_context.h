@@ -0,0 +1,76 @@
+#pragma once
+
+#include "command.h"
+#include "device.h"
+
+#include <map>
+#include <mutex>
+#include <optional>
+
+namespace recore::vulkan {
+
+// One-off work outside of frames, e.g. layout transitions after a resize or
+// uploads. Work recorded by many callers is batched into one submit, command
+// pools are reused once their batch finished. Thread safe.
+class ImmediateContext : public NoCopyMove {
+ public:
+  struct Desc {
+    const Device& device;
+    const Queue& queue;
+  };
+
+  using Recorder = std::function<void(const CommandBuffer& commandBuffer)>;
+
+  // Completion token of recorded work
+  struct Ticket {
+    uint64_t batch{0};
+  };
+
+  explicit ImmediateContext(const Desc& desc);
+  ~ImmediateContext();
+
+  [[nodiscard]] const Queue& getQueue() const { return mQueue; }
+
+  // Records into the current batch without submitting it. The batch goes out
+  // with the next flush(), e.g. right before the next frame is submitted.
+  Ticket record(const Recorder& recorder);
+
+  // Submits the current batch, nothing if it is empty
+  std::optional<SyncPoint> flush();
+
+  [[nodiscard]] bool isComplete(Ticket ticket) const;
+
+  // Flushes if needed and blocks until the ticket's batch finished
+  void wait(Ticket ticket);
+
+  void submitAndWait(const Recorder& recorder) { wait(record(recorder)); }
+
+ private:
+  struct Batch : public NoCopyMove {
+    Batch(const Device& device, uint32_t queueFamilyIndex);
+
+    CommandPool commandPool;
+    CommandBuffer commandBuffer;
+  };
+
+  // Expects mMutex to be locked
+  std::optional<SyncPoint> flushBatch();
+  [[nodiscard]] uPtr<Batch> requestBatch();
+
+  const Device& mDevice;
+  const Queue& mQueue;
+
+  mutable std::mutex mMutex;
+
+  uPtr<Batch> mRecording;
+  uint64_t mRecordingIndex{1};
+
+  struct InFlight {
+    SyncPoint submit;
+    uPtr<Batch> batch;
+  };
+  std::map<uint64_t, InFlight> mInFlight;
+  std::vector<uPtr<Batch>> mFree;
+};
+
+}  // namespace recore::vulkan
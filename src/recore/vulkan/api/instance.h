@@ -119,6 +119,36 @@ class PhysicalDevice {
     return mProperties;
   }
 
+  // Of an extension or core properties struct, e.g.
+  // VkPhysicalDeviceVulkan12Properties
+  template <typename PropertiesType, VkStructureType sType>
+  [[nodiscard]] PropertiesType getProperties() const {
+    PropertiesType properties{.sType = sType};
+    VkPhysicalDeviceProperties2 properties2{
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+        .pNext = &properties,
+    };
+    vkGetPhysicalDeviceProperties2(mDevice, &properties2);
+    return properties;
+  }
+
+  [[nodiscard]] const VkPhysicalDeviceFeatures& getFeatures() const {
+    return mFeatures;
+  }
+
+  // Support of an extension or core feature struct, e.g.
+  // VkPhysicalDeviceVulkan12Features
+  template <typename FeatureType, VkStructureType sType>
+  [[nodiscard]] FeatureType getFeatures() const {
+    FeatureType features{.sType = sType};
+    VkPhysicalDeviceFeatures2 features2{
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+        .pNext = &features,
+    };
+    vkGetPhysicalDeviceFeatures2(mDevice, &features2);
+    return features;
+  }
+
  private:
   VkPhysicalDevice mDevice{VK_NULL_HANDLE};
   VkPhysicalDeviceProperties mProperties{};
@@ -1,11 +1,31 @@
 #include "pipeline.h"
 
 #include <algorithm>
+#include <cstring>
 
 namespace recore::vulkan {
 
 Shader::Shader(const Desc& desc)
-    : Object{desc.device}, mStage{desc.stage}, mSpirv{desc.spriv} {
+    : Object{desc.device},
+      mStage{desc.stage},
+      mSpirv{desc.spriv},
+      mName{desc.name},
+      mSpecialization{desc.specialization} {
+  for (const auto& [id, value] : mSpecialization) {
+    mSpecializationEntries.push_back({
+        .constantID = id,
+        .offset = static_cast<uint32_t>(mSpecializationData.size() *
+                                        sizeof(uint32_t)),
+        .size = sizeof(uint32_t),
+    });
+    mSpecializationData.push_back(value);
+  }
+  mSpecializationInfo.mapEntryCount =
+      static_cast<uint32_t>(mSpecializationEntries.size());
+  mSpecializationInfo.pMapEntries = mSpecializationEntries.data();
+  mSpecializationInfo.dataSize = mSpecializationData.size() * sizeof(uint32_t);
+  mSpecializationInfo.pData = mSpecializationData.data();
+
   VkShaderModuleCreateInfo moduleInfo{};
   moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
   moduleInfo.codeSize = mSpirv.size() * sizeof(uint32_t);
@@ -25,6 +45,8 @@ VkPipelineShaderStageCreateInfo Shader::getStageInfo() const {
   info.stage = mStage;
   info.module = mHandle;
   info.pName = "main";
+  info.pSpecializationInfo =
+      mSpecialization.empty() ? nullptr : &mSpecializationInfo;
   return info;
 }
 
@@ -54,15 +76,115 @@ PipelineLayout::~PipelineLayout() {
 
 Pipeline::Pipeline(const Device& device,
                    const PipelineLayout& layout,
-                   VkPipelineBindPoint bindPoint)
-    : Object{device}, mLayout{layout}, mBindPoint{bindPoint} {}
+                   VkPipelineBindPoint bindPoint,
+                   std::string name)
+    : Object{device},
+      mLayout{layout},
+      mBindPoint{bindPoint},
+      mName{std::move(name)} {}
 
 Pipeline::~Pipeline() {
+  mDevice.unregisterPipeline(*this);
   vkDestroyPipeline(mDevice.vkHandle(), mHandle, nullptr);
 }
 
+VkPipelineCreateFlags Pipeline::getCreateFlags() {
+  mCapturesStatistics = mDevice.isCapturingStatistics();
+  if (mCapturesStatistics) {
+    return VK_PIPELINE_CREATE_CAPTURE_STATISTICS_BIT_KHR;
+  }
+  return 0;
+}
+
+static Pipeline::ExecutableStatistics::Statistic toStatistic(
+    const VkPipelineExecutableStatisticKHR& statistic) {
+  Pipeline::ExecutableStatistics::Statistic result{
+      .name = statistic.name,
+      .description = statistic.description,
+  };
+  switch (statistic.format) {
+    case VK_PIPELINE_EXECUTABLE_STATISTIC_FORMAT_BOOL32_KHR:
+      result.value = statistic.value.b32 == VK_TRUE;
+      break;
+    case VK_PIPELINE_EXECUTABLE_STATISTIC_FORMAT_INT64_KHR:
+      result.value = statistic.value.i64;
+      break;
+    case VK_PIPELINE_EXECUTABLE_STATISTIC_FORMAT_UINT64_KHR:
+      result.value = statistic.value.u64;
+      break;
+    case VK_PIPELINE_EXECUTABLE_STATISTIC_FORMAT_FLOAT64_KHR:
+      result.value = statistic.value.f64;
+      break;
+    default:
+      break;
+  }
+  return result;
+}
+
+const std::vector<Pipeline::ExecutableStatistics>&
+Pipeline::getExecutableStatistics() const {
+  std::call_once(mStatisticsQueried, [&]() {
+    if (!mCapturesStatistics) {
+      return;
+    }
+
+    VkPipelineInfoKHR pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_INFO_KHR;
+    pipelineInfo.pipeline = mHandle;
+
+    uint32_t executableCount = 0;
+    checkResult(vkGetPipelineExecutablePropertiesKHR(
+        mDevice.vkHandle(), &pipelineInfo, &executableCount, nullptr));
+    std::vector<VkPipelineExecutablePropertiesKHR> properties(
+        executableCount,
+        {.sType = VK_STRUCTURE_TYPE_PIPELINE_EXECUTABLE_PROPERTIES_KHR});
+    checkResult(vkGetPipelineExecutablePropertiesKHR(
+        mDevice.vkHandle(), &pipelineInfo, &executableCount,
+        properties.data()));
+
+    for (uint32_t i = 0; i < executableCount; i++) {
+      VkPipelineExecutableInfoKHR executableInfo{};
+      executableInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_EXECUTABLE_INFO_KHR;
+      executableInfo.pipeline = mHandle;
+      executableInfo.executableIndex = i;
+
+      uint32_t statisticCount = 0;
+      checkResult(vkGetPipelineExecutableStatisticsKHR(
+          mDevice.vkHandle(), &executableInfo, &statisticCount, nullptr));
+      std::vector<VkPipelineExecutableStatisticKHR> statistics(
+          statisticCount,
+          {.sType = VK_STRUCTURE_TYPE_PIPELINE_EXECUTABLE_STATISTIC_KHR});
+      checkResult(vkGetPipelineExecutableStatisticsKHR(
+          mDevice.vkHandle(), &executableInfo, &statisticCount,
+          statistics.data()));
+
+      mStatistics.push_back({
+          .name = properties[i].name,
+          .description = properties[i].description,
+          .stages = properties[i].stages,
+          .subgroupSize = properties[i].subgroupSize,
+          .statistics = rstd::transform<VkPipelineExecutableStatisticKHR,
+                                        ExecutableStatistics::Statistic>(
+              statistics, toStatistic),
+      });
+    }
+  });
+  return mStatistics;
+}
+
+static std::string getPipelineName(const std::vector<const Shader*>& shaders) {
+  std::string name;
+  for (const auto* shader : shaders) {
+    name += (name.empty() ? "" : "+") + shader->getName();
+  }
+  return name;
+}
+
 RasterPipeline::RasterPipeline(const Desc& desc)
-    : Pipeline{desc.device, desc.layout, VK_PIPELINE_BIND_POINT_GRAPHICS} {
+    : Pipeline{desc.device,
+               desc.layout,
+               VK_PIPELINE_BIND_POINT_GRAPHICS,
+               getPipelineName(desc.shaders)} {
   std::vector<VkPipelineShaderStageCreateInfo> shaderStages{
       desc.shaders.size()};
   std::transform(desc.shaders.begin(),
@@ -154,6 +276,7 @@ RasterPipeline::RasterPipeline(const Desc& desc)
 
   VkGraphicsPipelineCreateInfo pipelineInfo{};
   pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+  pipelineInfo.flags = getCreateFlags();
   pipelineInfo.stageCount = static_cast<uint32_t>(shaderStages.size());
   pipelineInfo.pStages = shaderStages.data();
   pipelineInfo.pVertexInputState = &vertexInputState;
@@ -174,8 +297,166 @@ RasterPipeline::RasterPipeline(const Desc& desc)
   pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
   pipelineInfo.basePipelineIndex = -1;
 
-  checkResult(vkCreateGraphicsPipelines(
-      mDevice.vkHandle(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &mHandle));
+  checkResult(mDevice.getPipelineCache().create([&](VkPipelineCache cache) {
+    return vkCreateGraphicsPipelines(
+        mDevice.vkHandle(), cache, 1, &pipelineInfo, nullptr, &mHandle);
+  }));
+  mDevice.registerPipeline(*this);
+}
+
+static VkPhysicalDeviceRayTracingPipelinePropertiesKHR
+getRayTracingPipelineProperties(const Device& device) {
+  VkPhysicalDeviceRayTracingPipelinePropertiesKHR rayTracingProperties{};
+  rayTracingProperties.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_RAY_TRACING_PIPELINE_PROPERTIES_KHR;
+
+  VkPhysicalDeviceProperties2 properties{};
+  properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+  properties.pNext = &rayTracingProperties;
+  vkGetPhysicalDeviceProperties2(device.getPhysicalDevice().vkHandle(),
+                                 &properties);
+
+  return rayTracingProperties;
+}
+
+static VkDeviceSize alignUp(VkDeviceSize size, VkDeviceSize alignment) {
+  return (size + alignment - 1) & ~(alignment - 1);
+}
+
+RayTracingPipeline::RayTracingPipeline(const Desc& desc)
+    : Pipeline{desc.device,
+               desc.layout,
+               VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR,
+               desc.rayGen.getName()} {
+  std::vector<VkPipelineShaderStageCreateInfo> shaderStages;
+  std::vector<VkRayTracingShaderGroupCreateInfoKHR> shaderGroups;
+
+  auto addStage = [&](const Shader* shader) {
+    if (shader == nullptr) {
+      return VK_SHADER_UNUSED_KHR;
+    }
+    shaderStages.push_back(shader->getStageInfo());
+    return static_cast<uint32_t>(shaderStages.size() - 1);
+  };
+
+  auto generalGroup = [](uint32_t stage) {
+    VkRayTracingShaderGroupCreateInfoKHR group{};
+    group.sType = VK_STRUCTURE_TYPE_RAY_TRACING_SHADER_GROUP_CREATE_INFO_KHR;
+    group.type = VK_RAY_TRACING_SHADER_GROUP_TYPE_GENERAL_KHR;
+    group.generalShader = stage;
+    group.closestHitShader = VK_SHADER_UNUSED_KHR;
+    group.anyHitShader = VK_SHADER_UNUSED_KHR;
+    group.intersectionShader = VK_SHADER_UNUSED_KHR;
+    return group;
+  };
+
+  shaderGroups.push_back(generalGroup(addStage(&desc.rayGen)));
+
+  for (const auto* miss : desc.miss) {
+    shaderGroups.push_back(generalGroup(addStage(miss)));
+  }
+
+  for (const auto& hitGroup : desc.hitGroups) {
+    VkRayTracingShaderGroupCreateInfoKHR group{};
+    group.sType = VK_STRUCTURE_TYPE_RAY_TRACING_SHADER_GROUP_CREATE_INFO_KHR;
+    group.type = VK_RAY_TRACING_SHADER_GROUP_TYPE_TRIANGLES_HIT_GROUP_KHR;
+    group.generalShader = VK_SHADER_UNUSED_KHR;
+    group.closestHitShader = addStage(hitGroup.closestHit);
+    group.anyHitShader = addStage(hitGroup.anyHit);
+    group.intersectionShader = VK_SHADER_UNUSED_KHR;
+    shaderGroups.push_back(group);
+  }
+
+  auto properties = getRayTracingPipelineProperties(mDevice);
+
+  VkRayTracingPipelineCreateInfoKHR pipelineInfo{};
+  pipelineInfo.sType = VK_STRUCTURE_TYPE_RAY_TRACING_PIPELINE_CREATE_INFO_KHR;
+  pipelineInfo.flags = getCreateFlags();
+  pipelineInfo.stageCount = static_cast<uint32_t>(shaderStages.size());
+  pipelineInfo.pStages = shaderStages.data();
+  pipelineInfo.groupCount = static_cast<uint32_t>(shaderGroups.size());
+  pipelineInfo.pGroups = shaderGroups.data();
+  pipelineInfo.maxPipelineRayRecursionDepth =
+      std::min(desc.maxRecursionDepth, properties.maxRayRecursionDepth);
+  pipelineInfo.layout = mLayout.vkHandle();
+
+  checkResult(mDevice.getPipelineCache().create([&](VkPipelineCache cache) {
+    return vkCreateRayTracingPipelinesKHR(mDevice.vkHandle(),
+                                          VK_NULL_HANDLE,
+                                          cache,
+                                          1,
+                                          &pipelineInfo,
+                                          nullptr,
+                                          &mHandle);
+  }));
+
+  createShaderBindingTable(static_cast<uint32_t>(desc.miss.size()),
+                           static_cast<uint32_t>(desc.hitGroups.size()));
+  mDevice.registerPipeline(*this);
+}
+
+void RayTracingPipeline::createShaderBindingTable(uint32_t missCount,
+                                                  uint32_t hitGroupCount) {
+  auto properties = getRayTracingPipelineProperties(mDevice);
+
+  const uint32_t handleSize = properties.shaderGroupHandleSize;
+  const VkDeviceSize handleStride =
+      alignUp(handleSize, properties.shaderGroupHandleAlignment);
+  const VkDeviceSize baseAlignment = properties.shaderGroupBaseAlignment;
+
+  const uint32_t groupCount = 1 + missCount + hitGroupCount;
+
+  std::vector<uint8_t> handles(static_cast<size_t>(groupCount) * handleSize);
+  checkResult(vkGetRayTracingShaderGroupHandlesKHR(mDevice.vkHandle(),
+                                                   mHandle,
+                                                   0,
+                                                   groupCount,
+                                                   handles.size(),
+                                                   handles.data()));
+
+  // Each region starts at the base alignment, the ray gen stride has to
+  // equal its size
+  auto& sbt = mShaderBindingTable;
+  sbt.rayGen.stride = alignUp(handleStride, baseAlignment);
+  sbt.rayGen.size = sbt.rayGen.stride;
+  sbt.miss.stride = handleStride;
+  sbt.miss.size = alignUp(missCount * handleStride, baseAlignment);
+  sbt.hit.stride = handleStride;
+  sbt.hit.size = alignUp(hitGroupCount * handleStride, baseAlignment);
+
+  mShaderBindingTableBuffer = makeUnique<Buffer>({
+      .device = mDevice,
+      .size = sbt.rayGen.size + sbt.miss.size + sbt.hit.size,
+      .usage = VK_BUFFER_USAGE_SHADER_BINDING_TABLE_BIT_KHR |
+               VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+      .memoryUsage = VMA_MEMORY_USAGE_CPU_TO_GPU,
+      .minAlignment = baseAlignment,
+  });
+
+  std::vector<uint8_t> data(mShaderBindingTableBuffer->getSize(), 0);
+  auto copyHandles = [&](VkDeviceSize offset,
+                         VkDeviceSize stride,
+                         uint32_t firstGroup,
+                         uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+      std::memcpy(data.data() + offset + i * stride,
+                  handles.data() + (firstGroup + i) * handleSize,
+                  handleSize);
+    }
+  };
+
+  VkDeviceSize missOffset = sbt.rayGen.size;
+  VkDeviceSize hitOffset = missOffset + sbt.miss.size;
+  copyHandles(0, sbt.rayGen.stride, 0, 1);
+  copyHandles(missOffset, sbt.miss.stride, 1, missCount);
+  copyHandles(hitOffset, sbt.hit.stride, 1 + missCount, hitGroupCount);
+
+  mShaderBindingTableBuffer->upload(data.data());
+
+  auto address = mShaderBindingTableBuffer->getDeviceAddress();
+  sbt.rayGen.deviceAddress = address;
+  sbt.miss.deviceAddress = missCount > 0 ? address + missOffset : 0;
+  sbt.hit.deviceAddress = hitGroupCount > 0 ? address + hitOffset : 0;
 }
 
 }  // namespace recore::vulkan
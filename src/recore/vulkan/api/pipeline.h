@@ -1,19 +1,30 @@
 #pragma once
 
+#include "buffer.h"
 #include "descriptor.h"
 #include "device.h"
+#include "pipeline_cache.h"
 #include "renderpass.h"
 
+#include <map>
+#include <mutex>
+#include <variant>
+
 namespace recore::vulkan {
 
 constexpr uint32_t MAX_PUSH_CONSTANT_SIZE = 128;
 
 class Shader : public Object<VkShaderModule> {
  public:
+  // Specialization constant id -> 32 bit value (use std::bit_cast for floats)
+  using Specialization = std::map<uint32_t, uint32_t>;
+
   struct Desc {
     const Device& device;
     VkShaderStageFlagBits stage;
     std::vector<uint32_t> spriv;
+    Specialization specialization;
+    std::string name;
   };
 
   explicit Shader(const Desc& desc);
@@ -21,9 +32,21 @@ class Shader : public Object<VkShaderModule> {
 
   [[nodiscard]] VkPipelineShaderStageCreateInfo getStageInfo() const;
 
+  [[nodiscard]] const std::string& getName() const { return mName; }
+
+  [[nodiscard]] const Specialization& getSpecialization() const {
+    return mSpecialization;
+  }
+
  private:
   VkShaderStageFlagBits mStage{};
   std::vector<uint32_t> mSpirv;
+  std::string mName;
+
+  Specialization mSpecialization;
+  std::vector<VkSpecializationMapEntry> mSpecializationEntries;
+  std::vector<uint32_t> mSpecializationData;
+  VkSpecializationInfo mSpecializationInfo{};
 };
 
 class PipelineLayout : public Object<VkPipelineLayout> {
@@ -42,16 +65,49 @@ class Pipeline : public Object<VkPipeline> {
  public:
   Pipeline(const Device& device,
            const PipelineLayout& layout,
-           VkPipelineBindPoint bindPoint);
+           VkPipelineBindPoint bindPoint,
+           std::string name);
   ~Pipeline() override;
 
   [[nodiscard]] const PipelineLayout& getLayout() const { return mLayout; }
 
   [[nodiscard]] VkPipelineBindPoint getBindPoint() const { return mBindPoint; }
 
+  [[nodiscard]] const std::string& getName() const { return mName; }
+
+  // Driver statistics of one compiled executable, the available statistics
+  // (registers, spills, shared memory, instructions, ...) depend on the vendor
+  struct ExecutableStatistics {
+    struct Statistic {
+      std::string name;
+      std::string description;
+      std::variant<bool, int64_t, uint64_t, double> value;
+    };
+
+    std::string name;
+    std::string description;
+    VkShaderStageFlags stages{};
+    uint32_t subgroupSize{0};
+    std::vector<Statistic> statistics;
+  };
+
+  // Empty unless the pipeline was created while the device captured
+  // statistics, see Device::setCaptureStatistics(). Queried once on first use.
+  [[nodiscard]] const std::vector<ExecutableStatistics>&
+  getExecutableStatistics() const;
+
  protected:
+  // Remembers whether the pipeline captures statistics
+  [[nodiscard]] VkPipelineCreateFlags getCreateFlags();
+
   const PipelineLayout& mLayout;
   const VkPipelineBindPoint mBindPoint{};
+  const std::string mName;
+
+ private:
+  bool mCapturesStatistics{false};
+  mutable std::once_flag mStatisticsQueried;
+  mutable std::vector<ExecutableStatistics> mStatistics;
 };
 
 class RasterPipeline : public Pipeline {
@@ -142,24 +198,63 @@ class ComputePipeline : public Pipeline {
   };
 
   explicit ComputePipeline(const Desc& desc)
-      : Pipeline{desc.device, desc.layout, VK_PIPELINE_BIND_POINT_COMPUTE} {
+      : Pipeline{desc.device,
+                 desc.layout,
+                 VK_PIPELINE_BIND_POINT_COMPUTE,
+                 desc.shader.getName()} {
     VkComputePipelineCreateInfo pipelineInfo{};
     pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.flags = getCreateFlags();
     pipelineInfo.stage = desc.shader.getStageInfo();
     pipelineInfo.layout = mLayout.vkHandle();
 
     pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
     pipelineInfo.basePipelineIndex = -1;
 
-    checkResult(vkCreateComputePipelines(mDevice.vkHandle(),
-                                         VK_NULL_HANDLE,
-                                         1,
-                                         &pipelineInfo,
-                                         nullptr,
-                                         &mHandle));
+    checkResult(mDevice.getPipelineCache().create([&](VkPipelineCache cache) {
+      return vkCreateComputePipelines(
+          mDevice.vkHandle(), cache, 1, &pipelineInfo, nullptr, &mHandle);
+    }));
+    mDevice.registerPipeline(*this);
   }
 };
 
-class RayTracingPipeline {};
+class RayTracingPipeline : public Pipeline {
+ public:
+  struct HitGroup {
+    const Shader* closestHit = nullptr;
+    const Shader* anyHit = nullptr;
+  };
+
+  // Shader groups are laid out as [rayGen][miss...][hitGroups...], the miss
+  // and hit group indices in shaders refer to the order given here
+  struct Desc {
+    const Device& device;
+    const PipelineLayout& layout;
+    const Shader& rayGen;
+    std::vector<const Shader*> miss;
+    std::vector<HitGroup> hitGroups;
+    uint32_t maxRecursionDepth = 1;
+  };
+
+  explicit RayTracingPipeline(const Desc& desc);
+
+  struct ShaderBindingTable {
+    VkStridedDeviceAddressRegionKHR rayGen{};
+    VkStridedDeviceAddressRegionKHR miss{};
+    VkStridedDeviceAddressRegionKHR hit{};
+    VkStridedDeviceAddressRegionKHR callable{};
+  };
+
+  [[nodiscard]] const ShaderBindingTable& getShaderBindingTable() const {
+    return mShaderBindingTable;
+  }
+
+ private:
+  void createShaderBindingTable(uint32_t missCount, uint32_t hitGroupCount);
+
+  uPtr<Buffer> mShaderBindingTableBuffer;
+  ShaderBindingTable mShaderBindingTable;
+};
 
 }  // namespace recore::vulkan
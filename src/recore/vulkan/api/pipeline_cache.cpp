@@ -0,0 +1,105 @@
+#include "pipeline_cache.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace recore::vulkan {
+
+PipelineCache::PipelineCache(const Desc& desc)
+    : Object{desc.device}, mPath{desc.path} {
+  auto data = loadData();
+  mWarm = !data.empty();
+
+  VkPipelineCacheCreateInfo cacheInfo{};
+  cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+  cacheInfo.initialDataSize = data.size();
+  cacheInfo.pInitialData = data.empty() ? nullptr : data.data();
+
+  checkResult(
+      vkCreatePipelineCache(mDevice.vkHandle(), &cacheInfo, nullptr, &mHandle));
+}
+
+PipelineCache::~PipelineCache() {
+  vkDestroyPipelineCache(mDevice.vkHandle(), mHandle, nullptr);
+}
+
+void PipelineCache::save() const {
+  if (mPath.empty()) {
+    return;
+  }
+
+  // Also called from the device destructor, e.g. after a device loss, so
+  // errors are reported but not thrown
+  size_t size = 0;
+  auto result =
+      vkGetPipelineCacheData(mDevice.vkHandle(), mHandle, &size, nullptr);
+  std::vector<char> data(size);
+  if (result == VK_SUCCESS) {
+    result = vkGetPipelineCacheData(
+        mDevice.vkHandle(), mHandle, &size, data.data());
+  }
+  if (result != VK_SUCCESS) {
+    std::cerr << "PipelineCache: could not get the cache data, "
+              << to_string(result) << std::endl;
+    return;
+  }
+
+  std::error_code error;
+  std::filesystem::create_directories(mPath.parent_path(), error);
+
+  // Replace the old file only once the new one is complete
+  auto tempPath = mPath;
+  tempPath += ".tmp";
+  {
+    std::ofstream file{tempPath, std::ios::binary | std::ios::trunc};
+    if (!file.is_open()) {
+      std::cerr << "PipelineCache: could not write " << tempPath << std::endl;
+      return;
+    }
+    file.write(data.data(), static_cast<std::streamsize>(size));
+  }
+
+  std::filesystem::rename(tempPath, mPath, error);
+  if (error) {
+    std::filesystem::remove(tempPath, error);
+  }
+}
+
+std::vector<char> PipelineCache::loadData() const {
+  if (mPath.empty()) {
+    return {};
+  }
+
+  std::ifstream file{mPath, std::ios::binary};
+  if (!file.is_open()) {
+    return {};
+  }
+  std::vector<char> data{(std::istreambuf_iterator<char>(file)),
+                         (std::istreambuf_iterator<char>())};
+
+  // Drivers should reject foreign data themselves, but not all of them do. A
+  // cache from another GPU or driver version is useless anyway.
+  VkPipelineCacheHeaderVersionOne header{};
+  if (data.size() < sizeof(header)) {
+    return {};
+  }
+  std::memcpy(&header, data.data(), sizeof(header));
+
+  const auto& properties = mDevice.getPhysicalDevice().getProperties();
+  if (header.headerSize < sizeof(header) ||
+      header.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE ||
+      header.vendorID != properties.vendorID ||
+      header.deviceID != properties.deviceID ||
+      std::memcmp(header.pipelineCacheUUID,
+                  properties.pipelineCacheUUID,
+                  VK_UUID_SIZE) != 0) {
+    std::cout << "PipelineCache: discarding " << mPath
+              << ", it was created for another device or driver" << std::endl;
+    return {};
+  }
+
+  return data;
+}
+
+}  // namespace recore::vulkan
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "device.h"
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+
+namespace recore::vulkan {
+
+// Driver pipeline cache shared by all pipelines of a device. Persisted to disk
+// so pipelines compiled in an earlier run skip the ISA compilation.
+class PipelineCache : public Object<VkPipelineCache> {
+ public:
+  struct Desc {
+    const Device& device;
+    // Empty path keeps the cache in memory only
+    std::filesystem::path path;
+  };
+
+  explicit PipelineCache(const Desc& desc);
+  ~PipelineCache() override;
+
+  // Writes the current cache data to disk, best effort. Errors are printed
+  // and not thrown.
+  void save() const;
+
+  // True if valid data from a previous run was loaded
+  [[nodiscard]] bool isWarm() const { return mWarm; }
+
+  struct Statistics {
+    uint32_t pipelineCount = 0;
+    std::chrono::nanoseconds creationTime{0};
+
+    Statistics operator-(const Statistics& other) const {
+      return {
+          .pipelineCount = pipelineCount - other.pipelineCount,
+          .creationTime = creationTime - other.creationTime,
+      };
+    }
+  };
+
+  [[nodiscard]] Statistics getStatistics() const {
+    return {
+        .pipelineCount = mPipelineCount.load(),
+        .creationTime = std::chrono::nanoseconds{mCreationTime.load()},
+    };
+  }
+
+  // Calls create(cache) and accounts its duration to the statistics. Safe to
+  // call from multiple threads, the cache is internally synchronized.
+  template <typename Create>
+  VkResult create(Create&& create) const {
+    auto start = std::chrono::high_resolution_clock::now();
+    VkResult result = create(mHandle);
+    auto end = std::chrono::high_resolution_clock::now();
+
+    mPipelineCount++;
+    mCreationTime += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         end - start)
+                         .count();
+    return result;
+  }
+
+ private:
+  [[nodiscard]] std::vector<char> loadData() const;
+
+  std::filesystem::path mPath;
+  bool mWarm{false};
+
+  mutable std::atomic<uint32_t> mPipelineCount{0};
+  mutable std::atomic<int64_t> mCreationTime{0};
+};
+
+}  // namespace recore::vulkan
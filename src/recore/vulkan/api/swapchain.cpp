@@ -1,5 +1,7 @@
 #include "swapchain.h"
 
+#include <recore/core/cpu_profiler.h>
+
 namespace recore::vulkan {
 
 static std::vector<VkPresentModeKHR> getPresentModes(
@@ -84,7 +86,8 @@ Swapchain::Swapchain(const Desc& desc)
   VkSurfaceCapabilitiesKHR capabilities = physicalDevice.getSurfaceCapabilities(
       surface);
 
-  mPresentMode = choosePresentMode(mPresentModes, mPresentModePriorities);
+  mPresentMode = choosePresentMode(
+      mPresentModes, {desc.presentMode, VK_PRESENT_MODE_FIFO_KHR});
   mSurfaceFormat = chooseSurfaceFormat(mSurfaceFormats,
                                        mSurfaceFormatPriorities);
 
@@ -148,6 +151,8 @@ Swapchain::~Swapchain() {
 
 VkResult Swapchain::acquireNextImage(uint32_t* pImageIndex,
                                      const Semaphore& imageAvailableSemaphore) {
+  RECORE_CPU_PROFILE_SCOPE("Swapchain::acquireNextImage");
+
   VkResult result = vkAcquireNextImageKHR(mDevice.vkHandle(),
                                           mHandle,
                                           std::numeric_limits<uint64_t>::max(),
@@ -13,6 +13,8 @@ class Swapchain : public Object<VkSwapchainKHR> {
     const Surface& surface;
     uint32_t width{0};
     uint32_t height{0};
+    // Falls back to FIFO, the only mode every device supports
+    VkPresentModeKHR presentMode{VK_PRESENT_MODE_FIFO_KHR};
     Swapchain* oldSwapchain{nullptr};
   };
 
@@ -25,6 +27,11 @@ class Swapchain : public Object<VkSwapchainKHR> {
 
   [[nodiscard]] VkPresentModeKHR getPresentMode() const { return mPresentMode; }
 
+  [[nodiscard]] const std::vector<VkPresentModeKHR>& getSupportedPresentModes()
+      const {
+    return mPresentModes;
+  }
+
   [[nodiscard]] VkExtent2D getExtent() const { return mSwapchainExtent; }
 
   [[nodiscard]] uint32_t getWidth() const { return mSwapchainExtent.width; }
@@ -54,12 +61,6 @@ class Swapchain : public Object<VkSwapchainKHR> {
   std::vector<VkPresentModeKHR> mPresentModes;
   std::vector<VkSurfaceFormatKHR> mSurfaceFormats;
 
-  std::vector<VkPresentModeKHR> mPresentModePriorities = {
-      // VK_PRESENT_MODE_IMMEDIATE_KHR,
-      VK_PRESENT_MODE_FIFO_KHR,
-      VK_PRESENT_MODE_MAILBOX_KHR,
-      VK_PRESENT_MODE_IMMEDIATE_KHR};
-
   std::vector<VkSurfaceFormatKHR> mSurfaceFormatPriorities = {
       {VK_FORMAT_B8G8R8A8_UNORM, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR},
       {VK_FORMAT_R8G8B8A8_UNORM, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR},
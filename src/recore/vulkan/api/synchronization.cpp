@@ -70,6 +70,51 @@ Semaphore::~Semaphore() {
   vkDestroySemaphore(mDevice.vkHandle(), mHandle, nullptr);
 }
 
+TimelineSemaphore::TimelineSemaphore(const Desc& desc) : Object{desc.device} {
+  VkSemaphoreTypeCreateInfo typeInfo{};
+  typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+  typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+  typeInfo.initialValue = desc.initialValue;
+
+  VkSemaphoreCreateInfo semaphoreInfo{};
+  semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+  semaphoreInfo.pNext = &typeInfo;
+
+  checkResult(
+      vkCreateSemaphore(mDevice.vkHandle(), &semaphoreInfo, nullptr, &mHandle));
+}
+
+TimelineSemaphore::~TimelineSemaphore() {
+  vkDestroySemaphore(mDevice.vkHandle(), mHandle, nullptr);
+}
+
+uint64_t TimelineSemaphore::getValue() const {
+  uint64_t value = 0;
+  checkResult(
+      vkGetSemaphoreCounterValue(mDevice.vkHandle(), mHandle, &value));
+  return value;
+}
+
+void TimelineSemaphore::wait(uint64_t value) const {
+  VkSemaphoreWaitInfo waitInfo{};
+  waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+  waitInfo.semaphoreCount = 1;
+  waitInfo.pSemaphores = &mHandle;
+  waitInfo.pValues = &value;
+
+  checkResult(vkWaitSemaphores(
+      mDevice.vkHandle(), &waitInfo, std::numeric_limits<uint64_t>::max()));
+}
+
+void TimelineSemaphore::signal(uint64_t value) const {
+  VkSemaphoreSignalInfo signalInfo{};
+  signalInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SIGNAL_INFO;
+  signalInfo.semaphore = mHandle;
+  signalInfo.value = value;
+
+  checkResult(vkSignalSemaphore(mDevice.vkHandle(), &signalInfo));
+}
+
 SemaphorePool::SemaphorePool(const Device& device) : mDevice{device} {}
 
 SemaphorePool::~SemaphorePool() {
@@ -47,6 +47,25 @@ class Semaphore : public Object<VkSemaphore> {
   ~Semaphore() override;
 };
 
+// Semaphore with a monotonically increasing 64 bit counter. Submits wait
+// for and signal specific values, the host can do the same.
+class TimelineSemaphore : public Object<VkSemaphore> {
+ public:
+  struct Desc {
+    const Device& device;
+    uint64_t initialValue = 0;
+  };
+
+  explicit TimelineSemaphore(const Desc& desc);
+  ~TimelineSemaphore() override;
+
+  [[nodiscard]] uint64_t getValue() const;
+
+  void wait(uint64_t value) const;
+
+  void signal(uint64_t value) const;
+};
+
 class SemaphorePool {
  public:
   explicit SemaphorePool(const Device& device);
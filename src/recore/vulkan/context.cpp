@@ -2,31 +2,125 @@
 
 #include <recore/vulkan/debug.h>
 
+#include <algorithm>
+
 namespace recore::vulkan {
 
-RenderFrame::RenderFrame(const Device& device)
+// Presents can go untimed, e.g. with an outdated swapchain
+constexpr size_t kMaxPendingPresents = 32;
+
+// Records one command buffer per recorder. The first one is recorded on the
+// calling thread, the others on the thread pool. The prologue goes in front
+// of the first recorder and the epilogue behind the last one, it is recorded
+// on the calling thread once all recorders are done. Returns the command
+// buffers in submit order.
+static std::vector<VkCommandBuffer> recordFrame(
+    RenderFrame& frame,
+    const std::vector<FrameRecorder>& recorders,
+    core::ThreadPool* threadPool,
+    const FrameRecorder& prologue,
+    const FrameRecorder& epilogue) {
+  auto count = std::max(static_cast<uint32_t>(recorders.size()), 1u);
+  frame.prepareCommandBuffers(count);
+
+  auto record = [&](uint32_t index) {
+    RECORE_CPU_PROFILE_SCOPE("RenderFrame::record");
+
+    const auto& commandBuffer = frame.getCommandBuffer(index);
+    commandBuffer.begin();
+    if (index == 0) {
+      prologue(commandBuffer);
+    }
+    if (index < recorders.size()) {
+      recorders[index](commandBuffer);
+    }
+  };
+
+  if (threadPool == nullptr || count == 1) {
+    for (uint32_t i = 0; i < count; i++) {
+      record(i);
+    }
+  } else {
+    std::vector<std::future<void>> futures;
+    for (uint32_t i = 1; i < count; i++) {
+      futures.push_back(threadPool->submit([&record, i]() { record(i); }));
+    }
+    record(0);
+    for (auto& future : futures) {
+      future.get();
+    }
+  }
+
+  epilogue(frame.getCommandBuffer(count - 1));
+
+  std::vector<VkCommandBuffer> commandBuffers;
+  for (uint32_t i = 0; i < count; i++) {
+    const auto& commandBuffer = frame.getCommandBuffer(i);
+    commandBuffer.end();
+    frame.addBarrierStatistics(commandBuffer);
+    commandBuffers.push_back(commandBuffer.vkHandle());
+  }
+  return commandBuffers;
+}
+
+RenderFrame::ThreadCommands::ThreadCommands(const Device& device,
+                                            uint32_t queueFamilyIndex)
+    : commandPool{{.device = device, .queueFamilyIndex = queueFamilyIndex}},
+      commandBuffer{{.device = device, .commandPool = commandPool}} {}
+
+RenderFrame::RenderFrame(const Device& device, GPUProfiler& profiler)
     : mDevice{device},
-      mCommandPool{
-          {.device = mDevice,
-           .queueFamilyIndex = mDevice.getGraphicsQueue().getFamilyIndex()}},
-      mCommandBuffer{{.device = mDevice, .commandPool = mCommandPool}},
       mSemaphorePool{device},
-      mFencePool{device},
-      mTimestampQueryPool{{.device = mDevice}} {
-  device.submitAndWait([&](const CommandBuffer& commandBuffer) {
-    commandBuffer.resetTimestampPool(mTimestampQueryPool);
-  });
+      mGPUProfile{{.device = mDevice, .profiler = profiler}} {
+  prepareCommandBuffers(1);
+  mAsyncComputeCommands = makeUnique<ThreadCommands>(
+      mDevice, mDevice.getAsyncComputeQueue().getFamilyIndex());
+}
+
+RenderFrame::~RenderFrame() {
+  waitForSubmits();
+  destroyGarbage();
 }
 
 void RenderFrame::reset() {
   mSemaphorePool.reset();
 
-  mFencePool.wait();
-  mFencePool.reset();
+  {
+    // Waiting here means the CPU is ahead of the GPU
+    RECORE_CPU_PROFILE_SCOPE("RenderFrame::waitForSubmits");
+    waitForSubmits();
+  }
+  destroyGarbage();
 
-  mGarbage.buffers.clear();
+  mGPUProfile.resolve();
+  mBarrierStatistics = {};
+}
+
+void RenderFrame::addBarrierStatistics(const CommandBuffer& commandBuffer) {
+  const auto& statistics = commandBuffer.getBarrierStatistics();
+  mBarrierStatistics.batches += statistics.batches;
+  mBarrierStatistics.barriers += statistics.barriers;
+}
+
+void RenderFrame::waitForSubmits() {
+  for (const auto& point : mSubmits) {
+    point.wait();
+  }
+  mSubmits.clear();
+}
 
-  mTimestampQueryPool.loadResults();
+void RenderFrame::destroyGarbage() {
+  // Reverse order of retirement, e.g. a framebuffer before its images
+  while (!mGarbage.empty()) {
+    mGarbage.pop_back();
+  }
+}
+
+void RenderFrame::prepareCommandBuffers(uint32_t count) {
+  while (mCommandBuffers.size() < count) {
+    mCommandBuffers.push_back(makeUnique<ThreadCommands>(
+        mDevice, mDevice.getGraphicsQueue().getFamilyIndex()));
+  }
 }
 
 Semaphore& RenderFrame::requestSemaphore() {
@@ -41,103 +135,234 @@ void RenderFrame::releaseOwnedSemaphore(uPtr<Semaphore> semaphore) {
   mSemaphorePool.releaseOwned(std::move(semaphore));
 }
 
-Fence& RenderFrame::requestFence() {
-  return mFencePool.request();
+AsyncComputeScheduler::AsyncComputeScheduler(const Desc& desc)
+    : mQueue{desc.device.getAsyncComputeQueue()},
+      mWaitStage{desc.waitStage} {}
+
+void AsyncComputeScheduler::submit(FrameRecorder&& recorder) {
+  mRecorders.push_back(std::move(recorder));
+}
+
+void AsyncComputeScheduler::addGraphicsWaits(Queue::Submit& submit) const {
+  if (mLastSubmit.has_value()) {
+    submit.wait(*mLastSubmit, mWaitStage);
+  }
+}
+
+void AsyncComputeScheduler::submitFrame(RenderFrame& frame,
+                                        const SyncPoint& graphicsSubmit) {
+  if (mRecorders.empty()) {
+    return;
+  }
+
+  const auto& commandBuffer = frame.getAsyncComputeCommandBuffer();
+  commandBuffer.begin();
+  for (auto& recorder : mRecorders) {
+    recorder(commandBuffer);
+  }
+  commandBuffer.end();
+  frame.addBarrierStatistics(commandBuffer);
+  mRecorders.clear();
+
+  Queue::Submit submit{.commandBuffers = {commandBuffer.vkHandle()}};
+  submit.wait(graphicsSubmit, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+
+  mLastSubmit = mQueue.submit(submit);
+  frame.addSubmit(*mLastSubmit);
 }
 
 RenderContext::RenderContext(const Desc& desc)
     : mDevice{desc.device},
       mSurface{desc.surface},
       mSurfaceExtent{desc.width, desc.height},
-      mNumFramesInFlight{desc.numFramesInFlight} {
+      mPresentMode{desc.presentMode},
+      mGPUProfiler{{.device = desc.device}},
+      mNumFramesInFlight{
+          std::clamp(desc.numFramesInFlight, 1u, kMaxFramesInFlight)},
+      mThreadPool{desc.threadPool},
+      mAsyncCompute{{.device = desc.device}} {
   mSwapchain = makeUnique<Swapchain>({.device = mDevice,
                                       .surface = desc.surface,
                                       .width = desc.width,
-                                      .height = desc.height});
+                                      .height = desc.height,
+                                      .presentMode = mPresentMode});
+
+  mDisplayTiming = mDevice.isExtensionEnabled(
+      VK_GOOGLE_DISPLAY_TIMING_EXTENSION_NAME);
 
   mRenderFrames.resize(mNumFramesInFlight);
   for (auto& frame : mRenderFrames) {
-    frame = makeUnique<RenderFrame>(mDevice);
+    frame = makeUnique<RenderFrame>(mDevice, mGPUProfiler);
+  }
+}
+
+void RenderContext::setNumFramesInFlight(uint32_t count) {
+  mNumFramesInFlight = std::clamp(count, 1u, kMaxFramesInFlight);
+}
+
+void RenderContext::setPresentMode(VkPresentModeKHR presentMode) {
+  if (presentMode != mPresentMode) {
+    mPresentMode = presentMode;
+    mPresentModeChanged = true;
   }
 }
 
 RenderFrame& RenderContext::beginFrame() {
   mFrameRecordBuffer.clear();
 
+  if (mRenderFrames.size() != mNumFramesInFlight) {
+    updateFramesInFlight();
+  }
+
   mCurrentFrameIndex = (mCurrentFrameIndex + 1) % mRenderFrames.size();
   auto& frame = getCurrentFrame();
   frame.reset();
+  updateLatency(frame);
+
+  // The old swapchain is retired with this frame, like on a resize
+  if (mPresentModeChanged) {
+    mPresentModeChanged = false;
+    recreateSwapchain();
+  }
 
   return frame;
 }
 
+void RenderContext::updateFramesInFlight() {
+  // New frames are used next, they have nothing to wait for
+  while (mRenderFrames.size() < mNumFramesInFlight) {
+    mRenderFrames.insert(mRenderFrames.begin() + mCurrentFrameIndex + 1,
+                         makeUnique<RenderFrame>(mDevice, mGPUProfiler));
+  }
+
+  // Removes the oldest frames, destroying them waits for their submits. The
+  // current frame stays, objects deferred between frames live in it.
+  while (mRenderFrames.size() > mNumFramesInFlight) {
+    uint32_t oldest = (mCurrentFrameIndex + 1) % mRenderFrames.size();
+    mRenderFrames.erase(mRenderFrames.begin() + oldest);
+    if (oldest < mCurrentFrameIndex) {
+      mCurrentFrameIndex--;
+    }
+  }
+}
+
+void RenderContext::updateLatency(RenderFrame& frame) {
+  // The frame was reset, its profile holds the results of its last use
+  const auto& profile = frame.getGPUProfile();
+  if (auto time = profile.getRootTime()) {
+    mLatency.gpuTime = *time;
+  }
+
+  // GPU timestamps are on the CPU timeline once calibrated
+  auto gpuEnd = profile.getRootEnd();
+  if (gpuEnd.has_value() && profile.getProfiler().isCalibrated() &&
+      frame.getInputTime() != Clock::time_point{}) {
+    auto input = core::CPUProfiler::toNanoseconds(frame.getInputTime());
+    mLatency.inputToGPU = static_cast<float>(*gpuEnd - input) * 1e-6f;
+  }
+
+  if (!mDisplayTiming) {
+    return;
+  }
+
+  uint32_t count = 0;
+  vkGetPastPresentationTimingGOOGLE(
+      mDevice.vkHandle(), mSwapchain->vkHandle(), &count, nullptr);
+  std::vector<VkPastPresentationTimingGOOGLE> timings(count);
+  vkGetPastPresentationTimingGOOGLE(
+      mDevice.vkHandle(), mSwapchain->vkHandle(), &count, timings.data());
+
+  for (const auto& timing : timings) {
+    auto it = std::ranges::find(
+        mPendingPresents, timing.presentID, &PendingPresent::id);
+    if (it == mPendingPresents.end()) {
+      continue;
+    }
+
+    // Display timing uses CLOCK_MONOTONIC, which steady_clock uses on Linux
+    auto input = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                     it->input.time_since_epoch())
+                     .count();
+    mLatency.inputToPresent =
+        static_cast<float>(static_cast<int64_t>(timing.actualPresentTime) -
+                           input) *
+        1e-6f;
+
+    // Timings come in present order, earlier ones are not reported anymore
+    mPendingPresents.erase(mPendingPresents.begin(), std::next(it));
+  }
+}
+
 void RenderContext::submit(FrameRecorder&& recorder) {
   mFrameRecordBuffer.push_back(std::move(recorder));
 }
 
 void RenderContext::endFrame(const Image& finalImage) {
-  RenderFrame& frame = getCurrentFrame();
-  const auto& commandBuffer = frame.getCommandBuffer();
+  RECORE_CPU_PROFILE_SCOPE("RenderContext::endFrame");
 
-  // Record command buffer
-  commandBuffer.begin();
-  commandBuffer.resetTimestampPool(frame.getTimestampQueryPool());
-  for (auto& recorder : mFrameRecordBuffer) {
-    recorder(commandBuffer);
-  }
+  RenderFrame& frame = getCurrentFrame();
+  frame.setInputTime(mInputTime);
 
   auto& imageAcquireSemaphore = frame.requestSemaphore();
   uint32_t nextSwapchainImageIndex = 0;
-  checkResult(mSwapchain->acquireNextImage(&nextSwapchainImageIndex,
-                                           imageAcquireSemaphore));
 
-  {  // Blit to swapchain image
+  auto beginProfile = [&](const CommandBuffer& commandBuffer) {
+    frame.getGPUProfile().beginRoot(commandBuffer);
+  };
+
+  // Acquire as late as possible, after recording the frame
+  auto blitToSwapchain = [&](const CommandBuffer& commandBuffer) {
+    checkResult(mSwapchain->acquireNextImage(&nextSwapchainImageIndex,
+                                             imageAcquireSemaphore));
+
     const auto& swapchainImage = mSwapchain->getImage(nextSwapchainImageIndex);
 
-    commandBuffer.transitionImageLayout(
-        finalImage,
-        VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
-        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-        VK_PIPELINE_STAGE_TRANSFER_BIT);
+    // Chained to the acquire semaphore wait, which is at the transfer stage
+    constexpr Access kAcquired{VK_PIPELINE_STAGE_2_TRANSFER_BIT};
 
-    commandBuffer.transitionImageLayout(swapchainImage,
-                                        VK_IMAGE_LAYOUT_UNDEFINED,
-                                        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                                        VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
-                                        VK_PIPELINE_STAGE_TRANSFER_BIT);
+    BarrierBatch{commandBuffer}
+        .image(finalImage, access::kColorAttachment, access::kTransferRead)
+        .image(swapchainImage, kAcquired, access::kTransferWrite);
 
     commandBuffer.blitImage(finalImage, swapchainImage);
 
-    commandBuffer.transitionImageLayout(swapchainImage,
-                                        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                                        VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
-                                        VK_PIPELINE_STAGE_TRANSFER_BIT,
-                                        VK_PIPELINE_STAGE_HOST_BIT);
-  }
+    BarrierBatch{commandBuffer}.image(
+        swapchainImage, access::kTransferWrite, access::kPresent);
 
-  commandBuffer.end();
+    frame.getGPUProfile().endRoot(commandBuffer);
+  };
+
+  auto commandBuffers = recordFrame(frame,
+                                    mFrameRecordBuffer,
+                                    mThreadPool,
+                                    beginProfile,
+                                    blitToSwapchain);
 
   // Submit
   Semaphore& renderFinishedSemaphore = frame.requestSemaphore();
-  Fence& inFlightFence = frame.requestFence();
 
-  VkSubmitInfo submitInfo{};
-  submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+  Queue::Submit submit{
+      .commandBuffers = std::move(commandBuffers),
+      .waits = {{.semaphore = imageAcquireSemaphore.vkHandle(),
+                 .stage = VK_PIPELINE_STAGE_TRANSFER_BIT}},
+      .signals = {{.semaphore = renderFinishedSemaphore.vkHandle()}},
+  };
+  mAsyncCompute.addGraphicsWaits(submit);
+  // One-off work recorded since the last frame, e.g. resize transitions
+  if (auto pending = mDevice.getImmediateContext().flush()) {
+    submit.wait(*pending, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+  }
 
-  VkPipelineStageFlags waitStage =
-      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-  submitInfo.pWaitDstStageMask = &waitStage;
-  submitInfo.waitSemaphoreCount = 1;
-  submitInfo.pWaitSemaphores = imageAcquireSemaphore.vkPtr();
-  submitInfo.signalSemaphoreCount = 1;
-  submitInfo.pSignalSemaphores = renderFinishedSemaphore.vkPtr();
+  auto graphicsSubmit = mDevice.getGraphicsQueue().submit(submit);
+  frame.addSubmit(graphicsSubmit);
 
-  submitInfo.commandBufferCount = 1;
-  submitInfo.pCommandBuffers = commandBuffer.vkPtr();
+  mAsyncCompute.submitFrame(frame, graphicsSubmit);
 
-  checkResult(mDevice.getGraphicsQueue().submit({submitInfo},
-                                                inFlightFence.vkHandle()));
+  if (mInputTime != Clock::time_point{}) {
+    mLatency.inputToSubmit =
+        std::chrono::duration<float, std::milli>(Clock::now() - mInputTime)
+            .count();
+  }
 
   // Present
 
@@ -150,6 +375,20 @@ void RenderContext::endFrame(const Image& finalImage) {
   presentInfo.pImageIndices = &nextSwapchainImageIndex;
   presentInfo.pResults = nullptr;
 
+  VkPresentTimeGOOGLE presentTime{.presentID = ++mPresentId};
+  VkPresentTimesInfoGOOGLE presentTimes{};
+  presentTimes.sType = VK_STRUCTURE_TYPE_PRESENT_TIMES_INFO_GOOGLE;
+  presentTimes.swapchainCount = 1;
+  presentTimes.pTimes = &presentTime;
+
+  if (mDisplayTiming) {
+    presentInfo.pNext = &presentTimes;
+    mPendingPresents.push_back({mPresentId, mInputTime});
+    if (mPendingPresents.size() > kMaxPendingPresents) {
+      mPendingPresents.pop_front();
+    }
+  }
+
   checkResult(mDevice.getGraphicsQueue().present(presentInfo));
 }
 
@@ -191,24 +430,34 @@ void RenderContext::recreateSwapchain() {
     return;
   }
 
-  // Before recreating, make sure the device is not used anymore.
-  vulkan::checkResult(mDevice.waitIdle());
-
-  // Recreate swapchain.
+  // Earlier frames may still present from the old swapchain, it is destroyed
+  // once the current frame finished
   if (mSwapchain != nullptr) {
-    mSwapchain = makeUnique<Swapchain>({.device = mDevice,
-                                        .surface = mSurface,
-                                        .width = mSurfaceExtent.width,
-                                        .height = mSurfaceExtent.height,
-                                        .oldSwapchain = mSwapchain.get()});
+    auto swapchain = makeUnique<Swapchain>({.device = mDevice,
+                                            .surface = mSurface,
+                                            .width = mSurfaceExtent.width,
+                                            .height = mSurfaceExtent.height,
+                                            .presentMode = mPresentMode,
+                                            .oldSwapchain = mSwapchain.get()});
+    std::swap(mSwapchain, swapchain);
+    getCurrentFrame().deferDestroy(std::move(swapchain));
+
+    // Timings of the old swapchain are not queried anymore
+    mPendingPresents.clear();
   }
 }
 
 HeadlessContext::HeadlessContext(const Desc& desc)
-    : mDevice{desc.device}, mNumFramesInFlight{desc.numFramesInFlight} {
+    : mDevice{desc.device},
+      mGPUProfiler{{.device = desc.device}},
+      mNumFramesInFlight{std::clamp(desc.numFramesInFlight,
+                                    1u,
+                                    RenderContext::kMaxFramesInFlight)},
+      mThreadPool{desc.threadPool},
+      mAsyncCompute{{.device = desc.device}} {
   mRenderFrames.resize(mNumFramesInFlight);
   for (auto& frame : mRenderFrames) {
-    frame = makeUnique<RenderFrame>(mDevice);
+    frame = makeUnique<RenderFrame>(mDevice, mGPUProfiler);
   }
 }
 
@@ -227,18 +476,32 @@ void HeadlessContext::submit(FrameRecorder&& recorder) {
 }
 
 void HeadlessContext::endFrame(const Image& finalImage) {
+  RECORE_CPU_PROFILE_SCOPE("HeadlessContext::endFrame");
+
   RenderFrame& frame = getCurrentFrame();
-  const auto& commandBuffer = frame.getCommandBuffer();
 
-  // Record command buffer
-  commandBuffer.begin();
-  for (auto& recorder : mFrameRecordBuffer) {
-    recorder(commandBuffer);
+  auto commandBuffers = recordFrame(
+      frame,
+      mFrameRecordBuffer,
+      mThreadPool,
+      [&](const CommandBuffer& commandBuffer) {
+        frame.getGPUProfile().beginRoot(commandBuffer);
+      },
+      [&](const CommandBuffer& commandBuffer) {
+        frame.getGPUProfile().endRoot(commandBuffer);
+      });
+
+  Queue::Submit submit{.commandBuffers = std::move(commandBuffers)};
+  mAsyncCompute.addGraphicsWaits(submit);
+  // One-off work recorded since the last frame, e.g. resize transitions
+  if (auto pending = mDevice.getImmediateContext().flush()) {
+    submit.wait(*pending, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
   }
-  commandBuffer.end();
 
-  checkResult(mDevice.getGraphicsQueue().submit(
-      {commandBuffer}, frame.requestFence().vkHandle()));
+  auto graphicsSubmit = mDevice.getGraphicsQueue().submit(submit);
+  frame.addSubmit(graphicsSubmit);
+
+  mAsyncCompute.submitFrame(frame, graphicsSubmit);
 }
 
 }  // namespace recore::vulkan
@@ -1,20 +1,35 @@
 #pragma once
 
+#include <recore/vulkan/api/barrier.h>
 #include <recore/vulkan/api/command.h>
 #include <recore/vulkan/api/device.h>
 #include <recore/vulkan/api/image.h>
+#include <recore/vulkan/api/immediate_context.h>
 #include <recore/vulkan/api/instance.h>
-#include <recore/vulkan/api/queries.h>
+#include <recore/vulkan/api/pipeline.h>
 #include <recore/vulkan/api/renderpass.h>
 #include <recore/vulkan/api/swapchain.h>
 #include <recore/vulkan/api/synchronization.h>
 
+#include <recore/vulkan/gpu_profiler.h>
+
+#include <recore/core/thread_pool.h>
+
+#include <chrono>
+#include <deque>
+#include <mutex>
+
 namespace recore::vulkan {
 
+using FrameRecorder = std::function<void(const CommandBuffer& commandBuffer)>;
+
+// Hands a recorder to the frame, e.g. to RenderContext::submit()
+using FrameSubmit = std::function<void(FrameRecorder&& recorder)>;
+
 class RenderFrame : public NoCopyMove {
  public:
-  explicit RenderFrame(const Device& device);
-  ~RenderFrame() = default;
+  RenderFrame(const Device& device, GPUProfiler& profiler);
+  ~RenderFrame();
 
   void reset();
 
@@ -22,32 +37,125 @@ class RenderFrame : public NoCopyMove {
   [[nodiscard]] uPtr<Semaphore> requestSemaphoreWithOwnership();
   void releaseOwnedSemaphore(uPtr<Semaphore> semaphore);
 
-  [[nodiscard]] Fence& requestFence();
+  // Submits of this frame, reset() waits for them before reusing the frame
+  void addSubmit(const SyncPoint& point) { mSubmits.push_back(point); }
+
+  [[nodiscard]] const std::vector<SyncPoint>& getSubmits() const {
+    return mSubmits;
+  }
+
+  [[nodiscard]] CommandBuffer& getCommandBuffer() {
+    return getCommandBuffer(0);
+  }
+
+  // Each command buffer has its own command pool, so different command
+  // buffers can be recorded on different threads at the same time
+  [[nodiscard]] CommandBuffer& getCommandBuffer(uint32_t index) {
+    return mCommandBuffers[index]->commandBuffer;
+  }
+
+  // Creates missing command buffers, call before recording in parallel
+  void prepareCommandBuffers(uint32_t count);
+
+  [[nodiscard]] CommandBuffer& getAsyncComputeCommandBuffer() {
+    return mAsyncComputeCommands->commandBuffer;
+  }
 
-  [[nodiscard]] CommandBuffer& getCommandBuffer() { return mCommandBuffer; }
+  // Scopes recorded in this frame, resolved by reset()
+  [[nodiscard]] GPUFrameProfile& getGPUProfile() { return mGPUProfile; }
+
+  // Of the input the frame was recorded for, see RenderContext::markInput()
+  void setInputTime(std::chrono::steady_clock::time_point time) {
+    mInputTime = time;
+  }
+
+  [[nodiscard]] std::chrono::steady_clock::time_point getInputTime() const {
+    return mInputTime;
+  }
 
-  [[nodiscard]] TimestampQueryPool& getTimestampQueryPool() {
-    return mTimestampQueryPool;
+  // Barriers of all command buffers of the frame, valid after endFrame()
+  // until the frame is reused
+  [[nodiscard]] const CommandBuffer::BarrierStatistics& getBarrierStatistics()
+      const {
+    return mBarrierStatistics;
   }
 
-  void deferDestroy(uPtr<Buffer>&& buffer) {
-    mGarbage.buffers.push_back(std::move(buffer));
+  void addBarrierStatistics(const CommandBuffer& commandBuffer);
+
+  // Keeps any object alive until the GPU finished this frame, reset()
+  // destroys it after waiting for the frame's submits
+  template <typename T>
+  void deferDestroy(uPtr<T>&& object) {
+    if (object == nullptr) {
+      return;
+    }
+    std::scoped_lock lock{mGarbageMutex};
+    mGarbage.emplace_back(std::move(object));
   }
 
  private:
+  void waitForSubmits();
+  void destroyGarbage();
+
   const Device& mDevice;
 
-  CommandPool mCommandPool;
-  CommandBuffer mCommandBuffer;
+  struct ThreadCommands : public NoCopyMove {
+    ThreadCommands(const Device& device, uint32_t queueFamilyIndex);
+
+    CommandPool commandPool;
+    CommandBuffer commandBuffer;
+  };
 
+  std::vector<uPtr<ThreadCommands>> mCommandBuffers;
+  uPtr<ThreadCommands> mAsyncComputeCommands;
+
+  // Binary semaphores, only for the swapchain
   SemaphorePool mSemaphorePool;
-  FencePool mFencePool;
+  std::vector<SyncPoint> mSubmits;
 
-  TimestampQueryPool mTimestampQueryPool;
+  GPUFrameProfile mGPUProfile;
+  std::chrono::steady_clock::time_point mInputTime;
+  CommandBuffer::BarrierStatistics mBarrierStatistics;
 
-  struct {
-    std::vector<uPtr<Buffer>> buffers;
-  } mGarbage;
+  // Type erased, the shared pointer keeps the deleter of the original type
+  std::vector<sPtr<void>> mGarbage;
+  std::mutex mGarbageMutex;
+};
+
+// Async compute part of the frames. It is submitted after the graphics work
+// of its frame and waits for it, the graphics work of the next frame waits
+// for the async work in turn. Graphics stages not in the wait stage, e.g.
+// the raster stages, overlap with the async work of the previous frame.
+class AsyncComputeScheduler : public NoCopyMove {
+ public:
+  struct Desc {
+    const Device& device;
+    // Stages of the next frame's graphics work that wait for the async work
+    VkPipelineStageFlags waitStage =
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
+  };
+
+  explicit AsyncComputeScheduler(const Desc& desc);
+  ~AsyncComputeScheduler() = default;
+
+  [[nodiscard]] const Queue& getQueue() const { return mQueue; }
+
+  void submit(FrameRecorder&& recorder);
+
+  // Makes the graphics submit wait for the previous async work
+  void addGraphicsWaits(Queue::Submit& submit) const;
+
+  // Records the async work of this frame and submits it after the graphics
+  // submit, if there is any
+  void submitFrame(RenderFrame& frame, const SyncPoint& graphicsSubmit);
+
+ private:
+  const Queue& mQueue;
+  VkPipelineStageFlags mWaitStage;
+
+  std::optional<SyncPoint> mLastSubmit;
+
+  std::vector<FrameRecorder> mRecorders;
 };
 
 class RenderContext : public NoCopyMove {
@@ -58,9 +166,31 @@ class RenderContext : public NoCopyMove {
     uint32_t width;
     uint32_t height;
     uint32_t numFramesInFlight = 2;
+    VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR;
+    // Records the submitted recorders in parallel, serial if null
+    core::ThreadPool* threadPool = nullptr;
   };
 
-  using FrameRecorder = std::function<void(const CommandBuffer& commandBuffer)>;
+  using FrameRecorder = vulkan::FrameRecorder;
+  using Clock = std::chrono::steady_clock;
+
+  // Per frame resources like the GUI's have to be sized for this many frames
+  static constexpr uint32_t kMaxFramesInFlight = 4;
+
+  // Input to photon latency in milliseconds, of the latest frame for which
+  // the value is known
+  struct Latency {
+    // From the input of a frame to its submit
+    float inputToSubmit{0.0f};
+    // Of the graphics work of a frame on the GPU
+    float gpuTime{0.0f};
+    // From the input of a frame to its presentation on the display, only
+    // with VK_GOOGLE_display_timing
+    std::optional<float> inputToPresent;
+    // From the input of a frame until the GPU finished it, only with
+    // VK_EXT_calibrated_timestamps
+    std::optional<float> inputToGPU;
+  };
 
   explicit RenderContext(const Desc& desc);
   ~RenderContext() = default;
@@ -75,29 +205,95 @@ class RenderContext : public NoCopyMove {
     return mNumFramesInFlight;
   }
 
+  [[nodiscard]] const GPUProfiler& getGPUProfiler() const {
+    return mGPUProfiler;
+  }
+
+  // Clamped to kMaxFramesInFlight, applied by the next beginFrame()
+  void setNumFramesInFlight(uint32_t count);
+
+  [[nodiscard]] VkPresentModeKHR getPresentMode() const {
+    return mPresentMode;
+  }
+
+  // Applied by the next beginFrame(), falls back to FIFO if not supported
+  void setPresentMode(VkPresentModeKHR presentMode);
+
+  [[nodiscard]] const std::vector<VkPresentModeKHR>& getSupportedPresentModes()
+      const {
+    return mSwapchain->getSupportedPresentModes();
+  }
+
+  // Call when the input for the next frame is sampled
+  void markInput() { mInputTime = Clock::now(); }
+
+  [[nodiscard]] const Latency& getLatency() const { return mLatency; }
+
   [[nodiscard]] RenderFrame& beginFrame();
 
+  // Every recorder gets its own command buffer. They are submitted in the
+  // order of the submit calls, so later recorders see the results of
+  // earlier ones just as if they shared a command buffer.
   void submit(FrameRecorder&& recorder);
 
+  // Work for the async compute queue, see AsyncComputeScheduler
+  void submitAsyncCompute(FrameRecorder&& recorder) {
+    mAsyncCompute.submit(std::move(recorder));
+  }
+
+  [[nodiscard]] const Queue& getAsyncComputeQueue() const {
+    return mAsyncCompute.getQueue();
+  }
+
   void endFrame(const Image& finalImage);
 
+  // Call between beginFrame() and endFrame(), doesn't wait for the device
   void resize(uint32_t width, uint32_t height);
 
+  // Retires an object that submitted frames may still use. Also valid between
+  // frames, the object lives until the latest frame finished.
+  template <typename T>
+  void deferDestroy(uPtr<T>&& object) {
+    getCurrentFrame().deferDestroy(std::move(object));
+  }
+
  private:
   bool checkSurfaceUpdate();
   void recreateSwapchain();
+  void updateFramesInFlight();
+  void updateLatency(RenderFrame& frame);
 
   const Device& mDevice;
   const Surface& mSurface;
 
   uPtr<Swapchain> mSwapchain;
   VkExtent2D mSurfaceExtent{};
+  VkPresentModeKHR mPresentMode;
+  bool mPresentModeChanged{false};
 
+  // Outlives the frames, which hand their scopes to it
+  GPUProfiler mGPUProfiler;
   std::vector<uPtr<RenderFrame>> mRenderFrames;
   uint32_t mNumFramesInFlight{1};
   uint32_t mCurrentFrameIndex{0};
 
+  // Input times of the presents whose display timing is still unknown
+  struct PendingPresent {
+    uint32_t id;
+    Clock::time_point input;
+  };
+
+  bool mDisplayTiming{false};
+  uint32_t mPresentId{0};
+  std::deque<PendingPresent> mPendingPresents;
+
+  Clock::time_point mInputTime;
+  Latency mLatency;
+
+  core::ThreadPool* mThreadPool{nullptr};
   std::vector<FrameRecorder> mFrameRecordBuffer;
+
+  AsyncComputeScheduler mAsyncCompute;
 };
 
 class HeadlessContext : public NoCopyMove {
@@ -107,9 +303,11 @@ class HeadlessContext : public NoCopyMove {
     uint32_t width;
     uint32_t height;
     uint32_t numFramesInFlight = 2;
+    // Records the submitted recorders in parallel, serial if null
+    core::ThreadPool* threadPool = nullptr;
   };
 
-  using FrameRecorder = std::function<void(const CommandBuffer& commandBuffer)>;
+  using FrameRecorder = vulkan::FrameRecorder;
 
   explicit HeadlessContext(const Desc& desc);
   ~HeadlessContext() = default;
@@ -124,20 +322,48 @@ class HeadlessContext : public NoCopyMove {
     return mNumFramesInFlight;
   }
 
+  [[nodiscard]] const GPUProfiler& getGPUProfiler() const {
+    return mGPUProfiler;
+  }
+
   [[nodiscard]] RenderFrame& beginFrame();
 
+  // Every recorder gets its own command buffer. They are submitted in the
+  // order of the submit calls, so later recorders see the results of
+  // earlier ones just as if they shared a command buffer.
   void submit(FrameRecorder&& recorder);
 
+  // Work for the async compute queue, see AsyncComputeScheduler
+  void submitAsyncCompute(FrameRecorder&& recorder) {
+    mAsyncCompute.submit(std::move(recorder));
+  }
+
+  [[nodiscard]] const Queue& getAsyncComputeQueue() const {
+    return mAsyncCompute.getQueue();
+  }
+
   void endFrame(const Image& finalImage);
 
+  // Retires an object that submitted frames may still use. Also valid between
+  // frames, the object lives until the latest frame finished.
+  template <typename T>
+  void deferDestroy(uPtr<T>&& object) {
+    getCurrentFrame().deferDestroy(std::move(object));
+  }
+
  private:
   const Device& mDevice;
 
+  // Outlives the frames, which hand their scopes to it
+  GPUProfiler mGPUProfiler;
   std::vector<uPtr<RenderFrame>> mRenderFrames;
   uint32_t mNumFramesInFlight{1};
   uint32_t mCurrentFrameIndex{0};
 
+  core::ThreadPool* mThreadPool{nullptr};
   std::vector<FrameRecorder> mFrameRecordBuffer;
+
+  AsyncComputeScheduler mAsyncCompute;
 };
 
 }  // namespace recore::vulkan
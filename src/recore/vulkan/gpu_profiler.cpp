@@ -0,0 +1,459 @@
+#include "gpu_profiler.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <set>
+
+namespace recore::vulkan {
+
+constexpr auto kRootName = "Frame";
+
+// The clock of std::chrono::steady_clock on Linux
+constexpr VkTimeDomainEXT kHostTimeDomain = VK_TIME_DOMAIN_CLOCK_MONOTONIC_EXT;
+
+static double getTimestampPeriod(const Device& device) {
+  return device.getPhysicalDevice().getProperties().limits.timestampPeriod;
+}
+
+static std::string escapeJSON(const std::string& string) {
+  std::string escaped;
+  for (char c : string) {
+    if (c == '"' || c == '\\') {
+      escaped += '\\';
+    }
+    escaped += c;
+  }
+  return escaped;
+}
+
+GPUProfiler::GPUProfiler(const Desc& desc)
+    : mDevice{desc.device}, mHistorySize{desc.historySize} {
+  mScopes.push_back({.name = kRootName});
+
+  if (mDevice.isExtensionEnabled(VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME)) {
+    auto gpu = mDevice.getPhysicalDevice().vkHandle();
+    uint32_t count = 0;
+    vkGetPhysicalDeviceCalibrateableTimeDomainsEXT(gpu, &count, nullptr);
+    std::vector<VkTimeDomainEXT> domains(count);
+    vkGetPhysicalDeviceCalibrateableTimeDomainsEXT(
+        gpu, &count, domains.data());
+
+    mCalibrated = std::ranges::contains(domains, VK_TIME_DOMAIN_DEVICE_EXT) &&
+                  std::ranges::contains(domains, kHostTimeDomain);
+  }
+}
+
+int64_t GPUProfiler::calibrate() const {
+  if (!mCalibrated) {
+    return 0;
+  }
+
+  std::array<VkCalibratedTimestampInfoEXT, 2> infos{};
+  infos[0].sType = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT;
+  infos[0].timeDomain = VK_TIME_DOMAIN_DEVICE_EXT;
+  infos[1].sType = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT;
+  infos[1].timeDomain = kHostTimeDomain;
+
+  std::array<uint64_t, 2> timestamps{};
+  uint64_t maxDeviation = 0;
+  checkResult(vkGetCalibratedTimestampsEXT(mDevice.vkHandle(),
+                                           infos.size(),
+                                           infos.data(),
+                                           timestamps.data(),
+                                           &maxDeviation));
+
+  auto device = static_cast<int64_t>(static_cast<double>(timestamps[0]) *
+                                     getTimestampPeriod(mDevice));
+  return static_cast<int64_t>(timestamps[1]) - device;
+}
+
+uint32_t GPUProfiler::requestScope(uint32_t parent, const std::string& name) {
+  std::scoped_lock lock{mMutex};
+
+  for (uint32_t child : mScopes[parent].children) {
+    if (mScopes[child].name == name) {
+      return child;
+    }
+  }
+
+  auto scope = static_cast<uint32_t>(mScopes.size());
+  mScopes.push_back({
+      .name = name,
+      .parent = parent,
+      .depth = mScopes[parent].depth + 1,
+  });
+  mScopes[parent].children.push_back(scope);
+  return scope;
+}
+
+void GPUProfiler::addFrame(std::vector<Event> events) {
+  std::scoped_lock lock{mMutex};
+
+  std::unordered_map<uint32_t, int64_t> durations;
+  for (const auto& event : events) {
+    durations[event.scope] += event.end - event.begin;
+  }
+  for (const auto& [scope, duration] : durations) {
+    auto& times = mScopes[scope].times;
+    times.push_back(static_cast<float>(duration) * 1e-6f);
+    if (times.size() > mHistorySize) {
+      times.pop_front();
+    }
+  }
+
+  mFrames.push_back({.index = mFrameCount++, .events = std::move(events)});
+  if (mFrames.size() > mHistorySize) {
+    mFrames.pop_front();
+  }
+}
+
+GPUProfiler::Scope GPUProfiler::getScope(uint32_t scope) const {
+  std::scoped_lock lock{mMutex};
+  return mScopes[scope];
+}
+
+std::string GPUProfiler::getName(uint32_t scope) const {
+  std::scoped_lock lock{mMutex};
+  return mScopes[scope].name;
+}
+
+std::string GPUProfiler::getPath(uint32_t scope) const {
+  std::scoped_lock lock{mMutex};
+  return buildPath(scope);
+}
+
+GPUProfiler::Statistics GPUProfiler::getStatistics(uint32_t scope) const {
+  std::scoped_lock lock{mMutex};
+  return computeStatistics(scope);
+}
+
+std::string GPUProfiler::buildPath(uint32_t scope) const {
+  std::string path = mScopes[scope].name;
+  while (scope != kRootScope) {
+    scope = mScopes[scope].parent;
+    path = mScopes[scope].name + "/" + path;
+  }
+  return path;
+}
+
+GPUProfiler::Statistics GPUProfiler::computeStatistics(uint32_t scope) const {
+  const auto& times = mScopes[scope].times;
+  if (times.empty()) {
+    return {};
+  }
+
+  std::vector<float> sorted{times.begin(), times.end()};
+  std::ranges::sort(sorted);
+
+  auto percentile = [&](float p) {
+    auto rank = static_cast<size_t>(
+        std::ceil(p * static_cast<float>(sorted.size())));
+    return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+  };
+
+  return {
+      .count = static_cast<uint32_t>(sorted.size()),
+      .last = times.back(),
+      .min = sorted.front(),
+      .avg = std::accumulate(sorted.begin(), sorted.end(), 0.0f) /
+             static_cast<float>(sorted.size()),
+      .p95 = percentile(0.95f),
+      .p99 = percentile(0.99f),
+  };
+}
+
+void GPUProfiler::exportTrace(const std::filesystem::path& path) const {
+  std::ofstream file{path, std::ios::trunc};
+  if (!file.is_open()) {
+    std::cerr << "GPUProfiler: could not write " << path << std::endl;
+    return;
+  }
+
+  std::scoped_lock lock{mMutex};
+
+  // Relative to the oldest GPU event, the clocks have no meaningful origin
+  int64_t origin = std::numeric_limits<int64_t>::max();
+  std::set<uint32_t> queueFamilies;
+  for (const auto& frame : mFrames) {
+    for (const auto& event : frame.events) {
+      origin = std::min(origin, event.begin);
+      queueFamilies.insert(event.queueFamilyIndex);
+    }
+  }
+
+  // Uncalibrated GPU events have a clock of their own, the CPU events are
+  // left out then
+  std::vector<core::CPUProfiler::Event> cpuEvents;
+  if (mCalibrated && !mFrames.empty()) {
+    cpuEvents = core::CPUProfiler::get().getEvents();
+    std::erase_if(cpuEvents, [&](const auto& event) {
+      return event.end < origin;
+    });
+  }
+
+  file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+  file << R"({"name":"process_name","ph":"M","pid":0,)"
+       << R"("args":{"name":"GPU"}},)" << "\n"
+       << R"({"name":"process_name","ph":"M","pid":1,)"
+       << R"("args":{"name":"CPU"}})";
+  for (const auto& [thread, name] :
+       core::CPUProfiler::get().getThreadNames()) {
+    file << std::format(
+        ",\n{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":{},"
+        "\"args\":{{\"name\":\"{}\"}}}}",
+        thread,
+        escapeJSON(name));
+  }
+  for (uint32_t queueFamily : queueFamilies) {
+    file << std::format(
+        ",\n{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":{},"
+        "\"args\":{{\"name\":\"Queue family {}\"}}}}",
+        queueFamily,
+        queueFamily);
+  }
+
+  for (const auto& frame : mFrames) {
+    for (const auto& event : frame.events) {
+      file << std::format(
+          ",\n{{\"name\":\"{}\",\"cat\":\"gpu\",\"ph\":\"X\",\"pid\":0,"
+          "\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f},"
+          "\"args\":{{\"frame\":{},\"path\":\"{}\"}}}}",
+          escapeJSON(mScopes[event.scope].name),
+          event.queueFamilyIndex,
+          static_cast<double>(event.begin - origin) * 1e-3,
+          static_cast<double>(event.end - event.begin) * 1e-3,
+          frame.index,
+          escapeJSON(buildPath(event.scope)));
+    }
+  }
+
+  for (const auto& event : cpuEvents) {
+    file << std::format(
+        ",\n{{\"name\":\"{}\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,"
+        "\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f}}}",
+        escapeJSON(event.name),
+        event.thread,
+        static_cast<double>(event.begin - origin) * 1e-3,
+        static_cast<double>(event.end - event.begin) * 1e-3);
+  }
+  file << "\n]}\n";
+}
+
+void GPUProfiler::exportCSV(const std::filesystem::path& path) const {
+  std::ofstream file{path, std::ios::trunc};
+  if (!file.is_open()) {
+    std::cerr << "GPUProfiler: could not write " << path << std::endl;
+    return;
+  }
+
+  file << "scope,count,last_ms,min_ms,avg_ms,p95_ms,p99_ms\n";
+
+  std::scoped_lock lock{mMutex};
+
+  // Depth first, children in the order they were first recorded
+  std::vector<uint32_t> stack{kRootScope};
+  while (!stack.empty()) {
+    uint32_t scope = stack.back();
+    stack.pop_back();
+
+    auto statistics = computeStatistics(scope);
+    file << std::format("\"{}\",{},{:.4f},{:.4f},{:.4f},{:.4f},{:.4f}\n",
+                        buildPath(scope),
+                        statistics.count,
+                        statistics.last,
+                        statistics.min,
+                        statistics.avg,
+                        statistics.p95,
+                        statistics.p99);
+
+    const auto& children = mScopes[scope].children;
+    stack.insert(stack.end(), children.rbegin(), children.rend());
+  }
+}
+
+GPUFrameProfile::GPUFrameProfile(const Desc& desc)
+    : mDevice{desc.device},
+      mProfiler{desc.profiler},
+      mPoolSize{desc.poolSize} {
+  for (const auto& family : mDevice.getPhysicalDevice().getQueueFamilies()) {
+    auto bits = family.timestampValidBits;
+    mTimestampMasks.push_back(bits >= 64 ? ~0ull : (1ull << bits) - 1);
+  }
+}
+
+void GPUFrameProfile::beginScope(const CommandBuffer& commandBuffer,
+                                 const std::string& name) {
+  if (!hasTimestamps(commandBuffer)) {
+    return;
+  }
+
+  std::scoped_lock lock{mMutex};
+
+  auto& open = mOpenScopes[&commandBuffer];
+  auto parent = open.empty() ? GPUProfiler::kRootScope
+                             : mRecords[open.back()].scope;
+
+  open.push_back(mRecords.size());
+  auto& record = mRecords.emplace_back(Record{
+      .scope = mProfiler.requestScope(parent, name),
+      .queueFamilyIndex = commandBuffer.getQueueFamilyIndex(),
+      .begin = requestQuery(),
+  });
+  writeTimestamp(
+      commandBuffer, record.begin, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+}
+
+void GPUFrameProfile::endScope(const CommandBuffer& commandBuffer) {
+  if (!hasTimestamps(commandBuffer)) {
+    return;
+  }
+
+  std::scoped_lock lock{mMutex};
+
+  auto& open = mOpenScopes[&commandBuffer];
+  auto& record = mRecords[open.back()];
+  open.pop_back();
+
+  record.end = requestQuery();
+  writeTimestamp(
+      commandBuffer, record.end, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+}
+
+void GPUFrameProfile::beginRoot(const CommandBuffer& commandBuffer) {
+  if (!hasTimestamps(commandBuffer)) {
+    return;
+  }
+
+  std::scoped_lock lock{mMutex};
+
+  mRootRecord = mRecords.size();
+  auto& record = mRecords.emplace_back(Record{
+      .scope = GPUProfiler::kRootScope,
+      .queueFamilyIndex = commandBuffer.getQueueFamilyIndex(),
+      .begin = requestQuery(),
+  });
+  writeTimestamp(
+      commandBuffer, record.begin, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+}
+
+void GPUFrameProfile::endRoot(const CommandBuffer& commandBuffer) {
+  std::scoped_lock lock{mMutex};
+  if (!mRootRecord.has_value() || !hasTimestamps(commandBuffer)) {
+    return;
+  }
+
+  auto& record = mRecords[*mRootRecord];
+  record.end = requestQuery();
+  writeTimestamp(
+      commandBuffer, record.end, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+}
+
+void GPUFrameProfile::resolve() {
+  std::scoped_lock lock{mMutex};
+
+  mEvents.clear();
+  mTimes.clear();
+  if (mRecords.empty()) {
+    return;
+  }
+
+  std::vector<uint64_t> timestamps;
+  for (const auto& pool : mPools) {
+    auto count = std::min<size_t>(mPoolSize, mQueryCount - timestamps.size());
+    auto results = pool->getResults(static_cast<uint32_t>(count));
+    timestamps.insert(timestamps.end(), results.begin(), results.end());
+  }
+
+  // Nanoseconds per tick
+  double period = getTimestampPeriod(mDevice);
+  int64_t offset = mProfiler.calibrate();
+  auto toNanoseconds = [&](uint64_t ticks) {
+    return static_cast<int64_t>(static_cast<double>(ticks) * period);
+  };
+
+  for (const auto& record : mRecords) {
+    if (record.end == kNoQuery) {
+      continue;
+    }
+    // Only the valid bits count, the difference is taken modulo them in case
+    // the counter wrapped within the scope
+    auto mask = mTimestampMasks[record.queueFamilyIndex];
+    auto begin = timestamps[record.begin] & mask;
+    auto ticks = (timestamps[record.end] - begin) & mask;
+    mEvents.push_back({
+        .scope = record.scope,
+        .queueFamilyIndex = record.queueFamilyIndex,
+        .begin = toNanoseconds(begin) + offset,
+        .end = toNanoseconds(begin + ticks) + offset,
+    });
+  }
+  for (const auto& event : mEvents) {
+    mTimes[mProfiler.getName(event.scope)] +=
+        static_cast<float>(event.end - event.begin) * 1e-6f;
+  }
+  mProfiler.addFrame(mEvents);
+
+  for (const auto& pool : mPools) {
+    pool->reset();
+  }
+  mQueryCount = 0;
+  mRecords.clear();
+  mRootRecord.reset();
+  mOpenScopes.clear();
+}
+
+std::optional<float> GPUFrameProfile::getTime(const std::string& name) const {
+  if (auto it = mTimes.find(name); it != mTimes.end()) {
+    return it->second;
+  }
+  return std::nullopt;
+}
+
+std::optional<float> GPUFrameProfile::getRootTime() const {
+  for (const auto& event : mEvents) {
+    if (event.scope == GPUProfiler::kRootScope) {
+      return static_cast<float>(event.end - event.begin) * 1e-6f;
+    }
+  }
+  return std::nullopt;
+}
+
+std::optional<int64_t> GPUFrameProfile::getRootEnd() const {
+  for (const auto& event : mEvents) {
+    if (event.scope == GPUProfiler::kRootScope) {
+      return event.end;
+    }
+  }
+  return std::nullopt;
+}
+
+bool GPUFrameProfile::hasTimestamps(const CommandBuffer& commandBuffer) const {
+  return mTimestampMasks[commandBuffer.getQueueFamilyIndex()] != 0;
+}
+
+void GPUFrameProfile::writeTimestamp(const CommandBuffer& commandBuffer,
+                                     uint32_t query,
+                                     VkPipelineStageFlagBits stage) {
+  commandBuffer.writeTimestamp(
+      *mPools[query / mPoolSize], query % mPoolSize, stage);
+}
+
+uint32_t GPUFrameProfile::requestQuery() {
+  // The new pool is reset on creation, recorded commands keep using the old
+  // ones
+  if (mQueryCount == mPools.size() * mPoolSize) {
+    mPools.push_back(makeUnique<TimestampQueryPool>({
+        .device = mDevice,
+        .queryCount = mPoolSize,
+    }));
+  }
+  return mQueryCount++;
+}
+
+}  // namespace recore::vulkan
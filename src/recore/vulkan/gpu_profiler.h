@@ -0,0 +1,215 @@
+#pragma once
+
+#include <recore/vulkan/api/command.h>
+#include <recore/vulkan/api/queries.h>
+#include <recore/vulkan/debug.h>
+
+#include <recore/core/cpu_profiler.h>
+
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+
+namespace recore::vulkan {
+
+// Tree of the GPU scopes of all frames with rolling statistics. A scope is
+// identified by its path from the root, which spans the graphics work of a
+// frame, so the same name in different parents gives different scopes.
+// Frames record into their own GPUFrameProfile, which hands its timings to
+// the profiler once the GPU finished the frame.
+//
+// With VK_EXT_calibrated_timestamps the GPU timestamps are converted to the
+// steady clock of core::CPUProfiler, so both share one timeline.
+class GPUProfiler : public NoCopyMove {
+ public:
+  struct Desc {
+    const Device& device;
+    // Frames covered by the statistics and the exported trace
+    uint32_t historySize = 256;
+  };
+
+  static constexpr uint32_t kRootScope = 0;
+
+  struct Scope {
+    std::string name;
+    uint32_t parent{kRootScope};
+    uint32_t depth{0};
+    std::vector<uint32_t> children;
+    // Milliseconds per frame that recorded the scope, oldest first
+    std::deque<float> times;
+  };
+
+  // Milliseconds over the frames of the history that recorded the scope
+  struct Statistics {
+    uint32_t count{0};
+    float last{0.0f};
+    float min{0.0f};
+    float avg{0.0f};
+    float p95{0.0f};
+    float p99{0.0f};
+  };
+
+  // One recording of a scope in nanoseconds, of the steady clock if
+  // calibrated and of the device clock otherwise
+  struct Event {
+    uint32_t scope;
+    uint32_t queueFamilyIndex;
+    int64_t begin;
+    int64_t end;
+  };
+
+  explicit GPUProfiler(const Desc& desc);
+
+  [[nodiscard]] const Device& getDevice() const { return mDevice; }
+
+  [[nodiscard]] bool isCalibrated() const { return mCalibrated; }
+
+  // Nanoseconds from the device clock to the steady clock right now, 0 if
+  // not calibrated. Sampled again for every frame, the clocks drift apart.
+  [[nodiscard]] int64_t calibrate() const;
+
+  // Thread safe, creates the scope on first use
+  [[nodiscard]] uint32_t requestScope(uint32_t parent, const std::string& name);
+
+  // Events of one frame, recordings of the same scope add up
+  void addFrame(std::vector<Event> events);
+
+  // Copies, recording threads keep adding scopes
+  [[nodiscard]] Scope getScope(uint32_t scope) const;
+
+  [[nodiscard]] std::string getName(uint32_t scope) const;
+
+  // Names from the root, separated by '/'
+  [[nodiscard]] std::string getPath(uint32_t scope) const;
+
+  [[nodiscard]] Statistics getStatistics(uint32_t scope) const;
+
+  // Chrome trace event format, opens in chrome://tracing and Perfetto. One
+  // track per queue family and one per CPU thread, the CPU scopes are
+  // limited to the time of the GPU history.
+  void exportTrace(const std::filesystem::path& path) const;
+
+  // Statistics of all scopes, one row per scope
+  void exportCSV(const std::filesystem::path& path) const;
+
+ private:
+  struct Frame {
+    uint64_t index;
+    std::vector<Event> events;
+  };
+
+  // Require the lock
+  [[nodiscard]] std::string buildPath(uint32_t scope) const;
+  [[nodiscard]] Statistics computeStatistics(uint32_t scope) const;
+
+  const Device& mDevice;
+  uint32_t mHistorySize;
+  bool mCalibrated{false};
+
+  // A deque keeps references valid while recording threads add scopes
+  std::deque<Scope> mScopes;
+  std::deque<Frame> mFrames;
+  uint64_t mFrameCount{0};
+  mutable std::mutex mMutex;
+};
+
+// Timestamp queries of the scopes of one frame. Pools are added when the
+// existing ones are used up, so the number of scopes is not limited.
+class GPUFrameProfile : public NoCopyMove {
+ public:
+  struct Desc {
+    const Device& device;
+    GPUProfiler& profiler;
+    uint32_t poolSize = 256;
+  };
+
+  explicit GPUFrameProfile(const Desc& desc);
+
+  [[nodiscard]] GPUProfiler& getProfiler() const { return mProfiler; }
+
+  // Thread safe. Scopes nest per command buffer, the outermost ones of each
+  // command buffer are children of the root. Scopes on queue families
+  // without timestamps are skipped.
+  void beginScope(const CommandBuffer& commandBuffer, const std::string& name);
+  void endScope(const CommandBuffer& commandBuffer);
+
+  // The root may begin and end in different command buffers of the frame
+  void beginRoot(const CommandBuffer& commandBuffer);
+  void endRoot(const CommandBuffer& commandBuffer);
+
+  // Call once the GPU finished the frame. Hands the timings to the profiler
+  // and makes the queries available for the next use of the frame.
+  void resolve();
+
+  // Milliseconds of all scopes with the name in the last resolved frame
+  [[nodiscard]] std::optional<float> getTime(const std::string& name) const;
+
+  [[nodiscard]] std::optional<float> getRootTime() const;
+
+  // Nanoseconds when the root ended, see GPUProfiler::Event
+  [[nodiscard]] std::optional<int64_t> getRootEnd() const;
+
+ private:
+  static constexpr uint32_t kNoQuery = ~0u;
+
+  struct Record {
+    uint32_t scope;
+    uint32_t queueFamilyIndex;
+    uint32_t begin;
+    uint32_t end{kNoQuery};
+  };
+
+  [[nodiscard]] bool hasTimestamps(const CommandBuffer& commandBuffer) const;
+
+  // Requires the lock
+  void writeTimestamp(const CommandBuffer& commandBuffer,
+                      uint32_t query,
+                      VkPipelineStageFlagBits stage);
+  [[nodiscard]] uint32_t requestQuery();
+
+  const Device& mDevice;
+  GPUProfiler& mProfiler;
+  uint32_t mPoolSize;
+  // Of the valid timestamp bits per queue family, 0 without timestamps
+  std::vector<uint64_t> mTimestampMasks;
+
+  std::vector<uPtr<TimestampQueryPool>> mPools;
+  uint32_t mQueryCount{0};
+
+  std::vector<Record> mRecords;
+  std::optional<size_t> mRootRecord;
+  // Records of the open scopes per command buffer, innermost last
+  std::unordered_map<const CommandBuffer*, std::vector<size_t>> mOpenScopes;
+  std::mutex mMutex;
+
+  // Of the last resolve, the names are looked up there so that reading them
+  // does not race with threads adding scopes
+  std::vector<GPUProfiler::Event> mEvents;
+  std::unordered_map<std::string, float> mTimes;
+};
+
+class ScopedGPUProfile : public NoCopyMove {
+ public:
+  ScopedGPUProfile(GPUFrameProfile& profile,
+                   const CommandBuffer& commandBuffer,
+                   const std::string& name)
+      : mProfile{profile}, mCommandBuffer{commandBuffer} {
+    mProfile.beginScope(mCommandBuffer, name);
+  }
+
+  ~ScopedGPUProfile() { mProfile.endScope(mCommandBuffer); }
+
+ private:
+  GPUFrameProfile& mProfile;
+  const CommandBuffer& mCommandBuffer;
+};
+
+}  // namespace recore::vulkan
+
+// NOLINTNEXTLINE(cppcoreguidelines-macro-usage)
+#define RECORE_GPU_PROFILE_SCOPE(FRAME, COMMAND_BUFFER, NAME) \
+  RECORE_DEBUG_SCOPE(COMMAND_BUFFER, NAME)                    \
+  recore::vulkan::ScopedGPUProfile ___gpuProfileScope{        \
+      (FRAME).getGPUProfile(), COMMAND_BUFFER, NAME};
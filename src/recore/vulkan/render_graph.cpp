@@ -0,0 +1,243 @@
+#include "render_graph.h"
+
+#include <algorithm>
+#include <unordered_set>
+
+namespace recore::vulkan {
+
+constexpr VkAccessFlags2 kWriteAccess =
+    VK_ACCESS_2_SHADER_WRITE_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT |
+    VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT |
+    VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+    VK_ACCESS_2_TRANSFER_WRITE_BIT | VK_ACCESS_2_HOST_WRITE_BIT |
+    VK_ACCESS_2_MEMORY_WRITE_BIT |
+    VK_ACCESS_2_ACCELERATION_STRUCTURE_WRITE_BIT_KHR;
+
+template <typename T>
+void RenderGraph::PassBuilder::use(
+    std::vector<std::pair<const T*, Use>>& uses,
+    const T* resource,
+    const Access& access,
+    bool write,
+    bool discard) {
+  auto it = std::ranges::find(uses, resource, &std::pair<const T*, Use>::first);
+  if (it == uses.end()) {
+    uses.push_back({resource, Use{.access = access}});
+    it = std::prev(uses.end());
+  } else {
+    if (it->second.access.layout != access.layout) {
+      throw std::runtime_error(
+          "RenderGraph: " + mPass.name +
+          " uses an image in two different layouts!");
+    }
+    it->second.access.stages |= access.stages;
+    it->second.access.access |= access.access;
+  }
+
+  auto& use = it->second;
+  use.read |= !write;
+  use.write |= write;
+  // Reading the previous content contradicts discarding it
+  use.discard = use.write && !use.read && (discard || use.discard);
+}
+
+void RenderGraph::PassBuilder::read(const Image& image, const Access& access) {
+  use(mPass.images, &image, access, false, false);
+}
+
+void RenderGraph::PassBuilder::read(const Buffer& buffer,
+                                    const Access& access) {
+  use(mPass.buffers, &buffer, access, false, false);
+}
+
+void RenderGraph::PassBuilder::write(const Image& image,
+                                     const Access& access,
+                                     bool discard) {
+  use(mPass.images, &image, access, true, discard);
+}
+
+void RenderGraph::PassBuilder::write(const Buffer& buffer,
+                                     const Access& access) {
+  use(mPass.buffers, &buffer, access, true, false);
+}
+
+void RenderGraph::addPass(const std::string& name,
+                          const Setup& setup,
+                          const Execute& execute) {
+  auto& pass = mPasses.emplace_back();
+  pass.name = name;
+  pass.execute = execute;
+
+  PassBuilder builder{pass};
+  setup(builder);
+}
+
+void RenderGraph::exportImage(const Image& image, const Access& access) {
+  mExports.insert_or_assign(&image, access);
+}
+
+std::optional<RenderGraph::Barrier> RenderGraph::transition(State& state,
+                                                            const Use& use,
+                                                            bool isImage) {
+  const auto& access = use.access;
+  const bool layoutChange = isImage && state.layout != access.layout;
+
+  Barrier barrier{.dst = access};
+  barrier.src.layout = use.discard ? VK_IMAGE_LAYOUT_UNDEFINED : state.layout;
+
+  if (!use.write && !layoutChange) {
+    state.readStages |= access.stages;
+
+    // Reads only wait for a write that is not visible to them yet
+    if (state.writeStages == VK_PIPELINE_STAGE_2_NONE ||
+        ((access.stages & ~state.visibleStages) == 0 &&
+         (access.access & ~state.visibleAccess) == 0)) {
+      return std::nullopt;
+    }
+    barrier.src.stages = state.writeStages;
+    barrier.src.access = state.writeAccess;
+    state.visibleStages |= access.stages;
+    state.visibleAccess |= access.access;
+    return barrier;
+  }
+
+  // Writes and layout transitions wait for all previous users. Reads only
+  // need an execution dependency, the last write has to be made available.
+  barrier.src.stages = state.writeStages | state.readStages;
+  barrier.src.access = state.writeAccess;
+
+  // A layout transition is a write, visible to the stages of this use
+  state.layout = isImage ? access.layout : VK_IMAGE_LAYOUT_UNDEFINED;
+  state.writeStages = access.stages;
+  state.writeAccess = use.write ? access.access & kWriteAccess
+                                : VK_ACCESS_2_NONE;
+  state.readStages = use.read ? access.stages : VK_PIPELINE_STAGE_2_NONE;
+  state.visibleStages = use.write ? VK_PIPELINE_STAGE_2_NONE : access.stages;
+  state.visibleAccess = use.write ? VK_ACCESS_2_NONE : access.access;
+
+  if (!layoutChange && barrier.src.stages == VK_PIPELINE_STAGE_2_NONE) {
+    return std::nullopt;
+  }
+  return barrier;
+}
+
+std::vector<bool> RenderGraph::cull() const {
+  std::unordered_set<const void*> needed;
+  for (const auto& [image, access] : mExports) {
+    needed.insert(image);
+  }
+
+  // Walk backwards, a pass is needed if a needed pass reads what it writes
+  std::vector<bool> keep(mPasses.size(), false);
+  for (size_t i = mPasses.size(); i-- > 0;) {
+    const auto& pass = mPasses[i];
+
+    bool used = pass.sideEffects;
+    auto visitWrites = [&](const auto& uses) {
+      for (const auto& [resource, use] : uses) {
+        used |= use.write && needed.contains(resource);
+      }
+    };
+    visitWrites(pass.images);
+    visitWrites(pass.buffers);
+    if (!used) {
+      continue;
+    }
+    keep[i] = true;
+
+    auto visitReads = [&](const auto& uses) {
+      for (const auto& [resource, use] : uses) {
+        // Earlier writes to a discarded resource are dead
+        if (use.discard) {
+          needed.erase(resource);
+        }
+        if (use.read) {
+          needed.insert(resource);
+        }
+      }
+    };
+    visitReads(pass.images);
+    visitReads(pass.buffers);
+  }
+
+  return keep;
+}
+
+void RenderGraph::execute(RenderFrame& frame,
+                          const FrameSubmit& submit,
+                          const FrameRecorder& begin) {
+  auto keep = cull();
+
+  mBarrierCount = 0;
+  mCulledCount = 0;
+
+  for (size_t i = 0; i < mPasses.size(); i++) {
+    if (!keep[i]) {
+      mCulledCount++;
+      continue;
+    }
+
+    // Shared, the recorder has to be copyable
+    auto recording = makeShared<Recording>();
+    recording->pass = std::move(mPasses[i]);
+    const auto& pass = recording->pass;
+
+    for (const auto& [image, use] : pass.images) {
+      if (auto barrier = transition(mImageStates[image], use, true)) {
+        recording->imageBarriers.emplace_back(image, *barrier);
+        mBarrierCount++;
+      }
+    }
+    for (const auto& [buffer, use] : pass.buffers) {
+      if (auto barrier = transition(mBufferStates[buffer], use, false)) {
+        recording->bufferBarriers.emplace_back(buffer, *barrier);
+        mBarrierCount++;
+      }
+    }
+
+    submit([recording, begin, &frame](const CommandBuffer& commandBuffer) {
+      if (begin) {
+        begin(commandBuffer);
+      }
+
+      // All barriers of a pass go out in one batch
+      BarrierBatch barriers{commandBuffer};
+      for (const auto& [image, barrier] : recording->imageBarriers) {
+        barriers.image(*image, barrier.src, barrier.dst);
+      }
+      for (const auto& [buffer, barrier] : recording->bufferBarriers) {
+        barriers.buffer(*buffer, barrier.src, barrier.dst);
+      }
+      barriers.flush();
+
+      recording->pass.execute(commandBuffer, frame);
+    });
+  }
+
+  // Work outside of the graph is the last user of exported images
+  for (const auto& [image, access] : mExports) {
+    mImageStates.insert_or_assign(
+        image,
+        State{
+            .writeStages = access.stages,
+            .writeAccess = access.access & kWriteAccess,
+            .readStages = access.stages,
+            .layout = access.layout,
+        });
+  }
+
+  mPasses.clear();
+  mExports.clear();
+}
+
+void RenderGraph::execute(const CommandBuffer& commandBuffer,
+                          RenderFrame& frame) {
+  execute(frame, [&](FrameRecorder&& recorder) { recorder(commandBuffer); });
+}
+
+void RenderGraph::reset() {
+  mImageStates.clear();
+  mBufferStates.clear();
+}
+
+}  // namespace recore::vulkan
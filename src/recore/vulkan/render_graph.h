@@ -0,0 +1,155 @@
+#pragma once
+
+#include <recore/vulkan/context.h>
+
+#include <functional>
+#include <optional>
+#include <unordered_map>
+
+namespace recore::vulkan {
+
+namespace access {
+
+// Result of a frame, the GUI draws on it and it is copied to the swapchain.
+// The contexts leave it in different layouts.
+constexpr Access kFrameResult{
+    VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT |
+        VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+    VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_2_TRANSFER_READ_BIT,
+    VK_IMAGE_LAYOUT_UNDEFINED,
+};
+
+}  // namespace access
+
+// Orders the passes of a frame by the resources they declare. Barriers and
+// layout transitions between passes are derived from the declared accesses
+// and recorded as one batch per pass, passes whose results are never used
+// are culled. Resource states persist across frames, so the first pass of a
+// frame synchronizes with the last users of the previous one.
+//
+// Resources are owned by the passes. Barriers inside a pass are still the
+// pass's own business, it has to leave its resources in the declared state.
+//
+// Every kept pass can be recorded into its own command buffer with its
+// barrier batch at the start, so the passes of a frame are recorded in
+// parallel and executed in graph order.
+class RenderGraph : public NoCopyMove {
+ public:
+  class PassBuilder {
+   public:
+    void read(const Image& image, const Access& access);
+    void read(const Buffer& buffer, const Access& access);
+
+    // Discarding writes overwrite the whole resource, its previous content
+    // and layout do not matter
+    void write(const Image& image, const Access& access, bool discard = false);
+    void write(const Buffer& buffer, const Access& access);
+
+    // Kept even if nothing reads its writes, e.g. for state in the pass
+    void setSideEffects() { mPass.sideEffects = true; }
+
+   private:
+    friend class RenderGraph;
+
+    struct Use {
+      Access access;
+      bool read{false};
+      bool write{false};
+      bool discard{false};
+    };
+
+    struct Pass {
+      std::string name;
+      std::function<void(const CommandBuffer&, RenderFrame&)> execute;
+      std::vector<std::pair<const Image*, Use>> images;
+      std::vector<std::pair<const Buffer*, Use>> buffers;
+      bool sideEffects{false};
+    };
+
+    explicit PassBuilder(Pass& pass) : mPass{pass} {}
+
+    template <typename T>
+    void use(std::vector<std::pair<const T*, Use>>& uses,
+             const T* resource,
+             const Access& access,
+             bool write,
+             bool discard);
+
+    Pass& mPass;
+  };
+
+  using Setup = std::function<void(PassBuilder& builder)>;
+  using Execute = std::function<void(const CommandBuffer& commandBuffer,
+                                     RenderFrame& frame)>;
+
+  void addPass(const std::string& name,
+               const Setup& setup,
+               const Execute& execute);
+
+  // Keeps the passes producing the image. After the graph it is used outside
+  // of it with the given access, an undefined layout if that is not known.
+  void exportImage(const Image& image, const Access& access);
+
+  // Culls the passes added since the last execute and submits one recorder
+  // per kept pass in graph order, then clears them. Barriers are derived
+  // right away, the recorders may run later on other threads. begin is
+  // recorded first into every command buffer, e.g. for dynamic state.
+  void execute(RenderFrame& frame,
+               const FrameSubmit& submit,
+               const FrameRecorder& begin = nullptr);
+
+  // Records all kept passes serially into one command buffer
+  void execute(const CommandBuffer& commandBuffer, RenderFrame& frame);
+
+  // Forgets all tracked states, required after resources were recreated
+  void reset();
+
+  // Barriers recorded by the last execute, for debugging and profiling
+  [[nodiscard]] uint32_t getBarrierCount() const { return mBarrierCount; }
+  [[nodiscard]] uint32_t getCulledPassCount() const { return mCulledCount; }
+
+ private:
+  using Pass = PassBuilder::Pass;
+  using Use = PassBuilder::Use;
+
+  // Last write and the reads since then
+  struct State {
+    VkPipelineStageFlags2 writeStages{VK_PIPELINE_STAGE_2_NONE};
+    VkAccessFlags2 writeAccess{VK_ACCESS_2_NONE};
+    VkPipelineStageFlags2 readStages{VK_PIPELINE_STAGE_2_NONE};
+    // Stages and accesses the last write is already visible to
+    VkPipelineStageFlags2 visibleStages{VK_PIPELINE_STAGE_2_NONE};
+    VkAccessFlags2 visibleAccess{VK_ACCESS_2_NONE};
+    VkImageLayout layout{VK_IMAGE_LAYOUT_UNDEFINED};
+  };
+
+  struct Barrier {
+    Access src;
+    Access dst;
+  };
+
+  // Kept pass with the barriers in front of it
+  struct Recording {
+    Pass pass;
+    std::vector<std::pair<const Image*, Barrier>> imageBarriers;
+    std::vector<std::pair<const Buffer*, Barrier>> bufferBarriers;
+  };
+
+  // Updates the state for the use, returns the barrier it needs if any
+  [[nodiscard]] static std::optional<Barrier> transition(State& state,
+                                                         const Use& use,
+                                                         bool isImage);
+
+  [[nodiscard]] std::vector<bool> cull() const;
+
+  std::vector<Pass> mPasses;
+  std::unordered_map<const Image*, Access> mExports;
+
+  std::unordered_map<const Image*, State> mImageStates;
+  std::unordered_map<const Buffer*, State> mBufferStates;
+
+  uint32_t mBarrierCount{0};
+  uint32_t mCulledCount{0};
+};
+
+}  // namespace recore::vulkan
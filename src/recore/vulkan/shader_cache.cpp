@@ -0,0 +1,151 @@
+#include "shader_cache.h"
+
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+namespace recore::vulkan {
+
+constexpr uint32_t kCacheMagic = 0x43534352;  // "RCSC"
+// Bump when the entry layout changes
+constexpr uint32_t kCacheVersion = 1;
+
+template <typename T>
+static void writeValue(std::ofstream& file, const T& value) {
+  file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+static bool readValue(std::ifstream& file, T& value) {
+  file.read(reinterpret_cast<char*>(&value), sizeof(T));
+  return file.good();
+}
+
+ShaderCache::ShaderCache(const Desc& desc) : mDirectory{desc.directory} {
+  std::error_code error;
+  std::filesystem::create_directories(mDirectory, error);
+  if (error) {
+    std::cerr << "ShaderCache: could not create " << mDirectory << ": "
+              << error.message() << std::endl;
+  }
+}
+
+std::optional<ShaderCache::Entry> ShaderCache::load(uint64_t key) const {
+  std::ifstream file{getEntryPath(key), std::ios::binary};
+  if (!file.is_open()) {
+    return std::nullopt;
+  }
+
+  uint32_t magic = 0;
+  uint32_t version = 0;
+  if (!readValue(file, magic) || !readValue(file, version) ||
+      magic != kCacheMagic || version != kCacheVersion) {
+    return std::nullopt;
+  }
+
+  Entry entry;
+
+  uint32_t dependencyCount = 0;
+  if (!readValue(file, dependencyCount)) {
+    return std::nullopt;
+  }
+  for (uint32_t i = 0; i < dependencyCount; i++) {
+    uint32_t pathLength = 0;
+    if (!readValue(file, pathLength)) {
+      return std::nullopt;
+    }
+    std::string path(pathLength, '\0');
+    file.read(path.data(), pathLength);
+
+    uint64_t dependencyHash = 0;
+    if (!readValue(file, dependencyHash)) {
+      return std::nullopt;
+    }
+
+    // Stale as soon as one include changed
+    if (hashFile(path) != dependencyHash) {
+      return std::nullopt;
+    }
+    entry.dependencies.push_back({.path = path, .hash = dependencyHash});
+  }
+
+  uint32_t wordCount = 0;
+  if (!readValue(file, wordCount) || wordCount == 0) {
+    return std::nullopt;
+  }
+  entry.spirv.resize(wordCount);
+  file.read(reinterpret_cast<char*>(entry.spirv.data()),
+            static_cast<std::streamsize>(wordCount * sizeof(uint32_t)));
+  if (!file.good()) {
+    return std::nullopt;
+  }
+
+  return entry;
+}
+
+void ShaderCache::store(uint64_t key, const Entry& entry) const {
+  // Write to a temporary file first, so concurrent readers and writers never
+  // see a partially written entry
+  auto entryPath = getEntryPath(key);
+  auto tempPath = entryPath;
+  tempPath += std::format(
+      ".{}.tmp", std::hash<std::thread::id>{}(std::this_thread::get_id()));
+
+  {
+    std::ofstream file{tempPath, std::ios::binary | std::ios::trunc};
+    if (!file.is_open()) {
+      return;  // Caching is best effort
+    }
+
+    writeValue(file, kCacheMagic);
+    writeValue(file, kCacheVersion);
+
+    writeValue(file, static_cast<uint32_t>(entry.dependencies.size()));
+    for (const auto& dependency : entry.dependencies) {
+      writeValue(file, static_cast<uint32_t>(dependency.path.size()));
+      file.write(dependency.path.data(),
+                 static_cast<std::streamsize>(dependency.path.size()));
+      writeValue(file, dependency.hash);
+    }
+
+    writeValue(file, static_cast<uint32_t>(entry.spirv.size()));
+    file.write(
+        reinterpret_cast<const char*>(entry.spirv.data()),
+        static_cast<std::streamsize>(entry.spirv.size() * sizeof(uint32_t)));
+  }
+
+  std::error_code error;
+  std::filesystem::rename(tempPath, entryPath, error);
+  if (error) {
+    std::filesystem::remove(tempPath, error);
+  }
+}
+
+uint64_t ShaderCache::hash(std::string_view data, uint64_t seed) {
+  constexpr uint64_t kPrime = 0x100000001b3ull;
+
+  uint64_t result = seed;
+  for (char c : data) {
+    result ^= static_cast<uint8_t>(c);
+    result *= kPrime;
+  }
+  return result;
+}
+
+std::optional<uint64_t> ShaderCache::hashFile(
+    const std::filesystem::path& path) {
+  std::ifstream file{path, std::ios::binary};
+  if (!file.is_open()) {
+    return std::nullopt;
+  }
+  std::string content{(std::istreambuf_iterator<char>(file)),
+                      (std::istreambuf_iterator<char>())};
+  return hash(content);
+}
+
+std::filesystem::path ShaderCache::getEntryPath(uint64_t key) const {
+  return mDirectory / std::format("{:016x}.spv", key);
+}
+
+}  // namespace recore::vulkan
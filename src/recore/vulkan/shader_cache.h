@@ -0,0 +1,57 @@
+#pragma once
+
+#include <recore/core/base.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace recore::vulkan {
+
+// Persistent cache of compiled SPIR-V. Entries are keyed by a hash of the
+// source and compile options, and remember the content hash of every file
+// that was included. An entry is only used while all of them are unchanged.
+class ShaderCache : public NoCopyMove {
+ public:
+  struct Desc {
+    std::filesystem::path directory;
+  };
+
+  struct Dependency {
+    std::string path;
+    uint64_t hash;
+  };
+
+  struct Entry {
+    std::vector<Dependency> dependencies;
+    std::vector<uint32_t> spirv;
+  };
+
+  explicit ShaderCache(const Desc& desc);
+
+  [[nodiscard]] std::optional<Entry> load(uint64_t key) const;
+
+  void store(uint64_t key, const Entry& entry) const;
+
+  [[nodiscard]] const std::filesystem::path& getDirectory() const {
+    return mDirectory;
+  }
+
+  // FNV-1a, stable across runs and platforms
+  static uint64_t hash(std::string_view data, uint64_t seed = kHashSeed);
+
+  // Hash of the file contents, nullopt if it cannot be read
+  static std::optional<uint64_t> hashFile(const std::filesystem::path& path);
+
+ private:
+  static constexpr uint64_t kHashSeed = 0xcbf29ce484222325ull;
+
+  [[nodiscard]] std::filesystem::path getEntryPath(uint64_t key) const;
+
+  std::filesystem::path mDirectory;
+};
+
+}  // namespace recore::vulkan
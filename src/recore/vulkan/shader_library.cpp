@@ -1,5 +1,9 @@
 #include "shader_library.h"
 
+#include <recore/core/cpu_profiler.h>
+
+#include <algorithm>
+#include <format>
 #include <fstream>
 #include <iostream>
 
@@ -7,6 +11,8 @@
 #include <libshaderc_util/io_shaderc.h>
 #include <shaderc/shaderc.hpp>
 
+#include <glslang/build_info.h>
+
 #include <spirv_glsl.hpp>
 
 // NOLINTBEGIN ugly shaderc includer
@@ -131,6 +137,14 @@ static shaderc_shader_kind getShadercKind(VkShaderStageFlags stage) {
       return shaderc_fragment_shader;
     case VK_SHADER_STAGE_COMPUTE_BIT:
       return shaderc_compute_shader;
+    case VK_SHADER_STAGE_RAYGEN_BIT_KHR:
+      return shaderc_raygen_shader;
+    case VK_SHADER_STAGE_MISS_BIT_KHR:
+      return shaderc_miss_shader;
+    case VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR:
+      return shaderc_closesthit_shader;
+    case VK_SHADER_STAGE_ANY_HIT_BIT_KHR:
+      return shaderc_anyhit_shader;
     default:
       throw std::runtime_error("getShadercKind: invalid type!");
   }
@@ -141,6 +155,10 @@ VkShaderStageFlagBits getShaderFromExtension(const std::string& filename) {
       {".vert.", VK_SHADER_STAGE_VERTEX_BIT},
       {".frag.", VK_SHADER_STAGE_FRAGMENT_BIT},
       {".comp.", VK_SHADER_STAGE_COMPUTE_BIT},
+      {".rgen.", VK_SHADER_STAGE_RAYGEN_BIT_KHR},
+      {".rmiss.", VK_SHADER_STAGE_MISS_BIT_KHR},
+      {".rchit.", VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR},
+      {".rahit.", VK_SHADER_STAGE_ANY_HIT_BIT_KHR},
   };
 
   for (const auto& [key, value] : extensionDict) {
@@ -159,32 +177,54 @@ ShaderReflectionData reflectShader(const std::vector<uint32_t>& spirv) {
   // Get workgroup size
   if (compiler.get_execution_model() ==
       spv::ExecutionModel::ExecutionModelGLCompute) {
-    auto workgroupSize = compiler.get_execution_mode_argument(
-        spv::ExecutionModeLocalSize);
     reflection.workgroupSize = {.x = compiler.get_execution_mode_argument(
                                     spv::ExecutionModeLocalSize, 0),
                                 .y = compiler.get_execution_mode_argument(
                                     spv::ExecutionModeLocalSize, 1),
                                 .z = compiler.get_execution_mode_argument(
                                     spv::ExecutionModeLocalSize, 2)};
+
+    spirv_cross::SpecializationConstant x;
+    spirv_cross::SpecializationConstant y;
+    spirv_cross::SpecializationConstant z;
+    compiler.get_work_group_size_specialization_constants(x, y, z);
+    if (x.id != 0 && x.constant_id == WORKGROUP_SIZE_X_ID) {
+      reflection.tunableDimensions = 1;
+      if (y.id != 0 && y.constant_id == WORKGROUP_SIZE_Y_ID) {
+        reflection.tunableDimensions = 2;
+      }
+    }
   }
 
   return reflection;
 }
 
-ShaderLibrary::ShaderLibrary(const Device& device,
-                             std::filesystem::path rootDir)
-    : mDevice{device}, mRootDir{std::move(rootDir)} {}
+// Adds the tuned workgroup size to the specialization, unless it sets one
+// already, and updates the reflected size dispatches are computed with
+static void specializeWorkgroupSize(
+    ShaderReflectionData& reflection,
+    Shader::Specialization& specialization,
+    const std::optional<ShaderReflectionData::WorkgroupSize>& tunedSize) {
+  if (reflection.tunableDimensions == 0) {
+    return;
+  }
 
-void ShaderLibrary::loadShaderBinary(const LoadData& loadData) {
-  auto stage = loadData.stage.value_or(
-      getShaderFromExtension(loadData.path.filename().string()));
-  auto spirv = readSpirvBinary(mRootDir / loadData.path);
-  auto shader = makeUnique<Shader>(
-      {.device = mDevice, .stage = stage, .spriv = spirv});
+  auto& size = reflection.workgroupSize.value();
+  if (tunedSize.has_value()) {
+    specialization.try_emplace(WORKGROUP_SIZE_X_ID, tunedSize->x);
+    if (reflection.tunableDimensions > 1) {
+      specialization.try_emplace(WORKGROUP_SIZE_Y_ID, tunedSize->y);
+    }
+  }
 
-  ShaderData data{.path = loadData.path, .shader = std::move(shader)};
-  mShaders.insert_or_assign(loadData.getName(), std::move(data));
+  if (auto it = specialization.find(WORKGROUP_SIZE_X_ID);
+      it != specialization.end()) {
+    size.x = it->second;
+  }
+  if (auto it = specialization.find(WORKGROUP_SIZE_Y_ID);
+      it != specialization.end() && reflection.tunableDimensions > 1) {
+    size.y = it->second;
+  }
 }
 
 class CompilationException : public std::exception {
@@ -200,86 +240,408 @@ class CompilationException : public std::exception {
   std::string mErrorMessage;
 };
 
+// A compiler update may change the output for the same source
+static const std::string& getCompilerVersion() {
+  static const std::string version = []() {
+    unsigned int spirvVersion = 0;
+    unsigned int spirvRevision = 0;
+    shaderc_get_spv_version(&spirvVersion, &spirvRevision);
+    return std::format("glslang_{}.{}.{}{};spirv_{}.{}",
+                       GLSLANG_VERSION_MAJOR,
+                       GLSLANG_VERSION_MINOR,
+                       GLSLANG_VERSION_PATCH,
+                       GLSLANG_VERSION_FLAVOR,
+                       spirvVersion,
+                       spirvRevision);
+  }();
+  return version;
+}
+
+// Compiles GLSL to SPIR-V and returns it with the included files, cache hits
+// skip shaderc entirely
+static ShaderCache::Entry compileSpirv(const std::filesystem::path& rootDir,
+                                       const std::filesystem::path& path,
+                                       VkShaderStageFlagBits stage,
+                                       const ShaderDefines& defines,
+                                       const ShaderCache* cache) {
+  auto shaderPath = rootDir / path;
+  auto source = readShaderSourceToString(shaderPath);
+
+  // Everything that affects the output besides the includes goes into the key
+  auto optionsKey = std::format("{};vulkan_1_3;performance;{};{}",
+                                getCompilerVersion(),
+                                static_cast<uint32_t>(stage),
+                                path.generic_string());
+  for (const auto& [define, value] : defines) {
+    optionsKey += std::format(";{}={}", define, value);
+  }
+  uint64_t key = ShaderCache::hash(source, ShaderCache::hash(optionsKey));
+
+  if (cache != nullptr) {
+    if (auto entry = cache->load(key)) {
+      return std::move(*entry);
+    }
+  }
+
+  // Cache misses only
+  RECORE_CPU_PROFILE_SCOPE("Compile " + path.generic_string());
+
+  shaderc::Compiler compiler{};
+  shaderc::CompileOptions options{};
+  options.SetTargetEnvironment(shaderc_target_env_vulkan,
+                               shaderc_env_version_vulkan_1_3);
+  // options.SetOptimizationLevel(shaderc_optimization_level_zero);
+  options.SetOptimizationLevel(shaderc_optimization_level_performance);
+
+  for (const auto& [define, value] : defines) {
+    options.AddMacroDefinition(define, value);
+  }
+
+  shaderc_util::FileFinder fileFinder{};
+  fileFinder.search_path().push_back(shaderPath.parent_path().string());
+  fileFinder.search_path().push_back(rootDir.string());
+  auto includer = std::make_unique<FileIncluder>(&fileFinder);
+  const auto& includedFiles = includer->file_path_trace();
+  options.SetIncluder(std::move(includer));
+
+  auto result = compiler.CompileGlslToSpv(
+      source, getShadercKind(stage), path.string().c_str(), options);
+
+  if (result.GetCompilationStatus() != shaderc_compilation_status_success) {
+    throw CompilationException{result};
+  }
+
+  ShaderCache::Entry entry{.spirv = {result.cbegin(), result.cend()}};
+  for (const auto& includedFile : includedFiles) {
+    if (auto hash = ShaderCache::hashFile(includedFile)) {
+      entry.dependencies.push_back({.path = includedFile, .hash = *hash});
+    }
+  }
+
+  if (cache != nullptr) {
+    cache->store(key, entry);
+  }
+
+  return entry;
+}
+
+ShaderLibrary::ShaderLibrary(const Device& device,
+                             std::filesystem::path rootDir,
+                             const std::filesystem::path& cacheDir)
+    : mDevice{device}, mRootDir{std::move(rootDir)} {
+  if (!cacheDir.empty()) {
+    mCache = makeUnique<ShaderCache>({.directory = cacheDir});
+
+    // Tuned sizes are only valid for the device and driver they were measured
+    // on
+    const auto& properties = mDevice.getPhysicalDevice().getProperties();
+    mWorkgroupSizesPath =
+        cacheDir / std::format("workgroup_sizes_{:x}_{:x}_{:x}.txt",
+                               properties.vendorID,
+                               properties.deviceID,
+                               properties.driverVersion);
+    loadWorkgroupSizes();
+  }
+}
+
+void ShaderLibrary::loadShaderBinary(const LoadData& loadData) {
+  auto stage = loadData.stage.value_or(
+      getShaderFromExtension(loadData.path.filename().string()));
+  auto spirv = readSpirvBinary(mRootDir / loadData.path);
+  auto shader = makeUnique<Shader>({
+      .device = mDevice,
+      .stage = stage,
+      .spriv = spirv,
+      .specialization = loadData.specialization,
+      .name = loadData.getName(),
+  });
+
+  ShaderData data{.path = loadData.path,
+                  .specialization = loadData.specialization,
+                  .shader = std::move(shader)};
+  std::scoped_lock lock{mMutex};
+  mShaders.insert_or_assign(loadData.getName(), std::move(data));
+}
+
 const ShaderData& ShaderLibrary::loadShaderSource(const LoadData& loadData,
                                                   bool reload) {
-  if (!mShaders.contains(loadData.getName()) || reload) {
-    ShaderData shaderData = compileShader(loadData);
-    mShaders.insert_or_assign(loadData.getName(), std::move(shaderData));
+  std::scoped_lock lock{mMutex};
+  auto name = loadData.getName();
+
+  // Resolve a compilation that was requested earlier
+  if (auto pending = mPending.extract(name)) {
+    storeShader(name, pending.mapped().get());
+  }
+
+  if (!mShaders.contains(name) || reload) {
+    storeShader(name, compileShader(loadData));
+  }
+  return mShaders.at(name);
+}
+
+void ShaderLibrary::requestShaderSource(const LoadData& loadData) {
+  std::scoped_lock lock{mMutex};
+  auto name = loadData.getName();
+  if (mShaders.contains(name) || mPending.contains(name)) {
+    return;
+  }
+
+  mPending.emplace(name, mThreadPool.submit([this, loadData]() {
+    return compileShader(loadData);
+  }));
+}
+
+void ShaderLibrary::waitForPending() {
+  std::scoped_lock lock{mMutex};
+  while (!mPending.empty()) {
+    auto pending = mPending.extract(mPending.begin());
+    storeShader(pending.key(), pending.mapped().get());
   }
-  return mShaders.at(loadData.getName());
 }
 
 const ShaderData& ShaderLibrary::getShaderData(const std::string& name) const {
+  std::scoped_lock lock{mMutex};
   return mShaders.at(name);
 }
 
 const Shader& ShaderLibrary::getShader(const std::string& name) const {
+  std::scoped_lock lock{mMutex};
   return *mShaders.at(name).shader;
 }
 
 const ShaderReflectionData& ShaderLibrary::getReflection(
     const std::string& name) const {
+  std::scoped_lock lock{mMutex};
   return mShaders.at(name).reflection;
 }
 
-void ShaderLibrary::reload() {
-  // TODO: only reload those that have actually changed
+std::unordered_set<std::string> ShaderLibrary::reload() {
+  std::unique_lock lock{mMutex};
+  waitForPending();
+
+  // Find the files that changed since they were last seen. The modification
+  // time is cheap to check, the content hash filters out touched files.
+  std::unordered_set<std::string> dirtyShaders;
+  for (auto& [path, state] : mFiles) {
+    std::error_code error;
+    auto lastWriteTime = std::filesystem::last_write_time(path, error);
+    if (error || lastWriteTime == state.lastWriteTime) {
+      continue;
+    }
+    state.lastWriteTime = lastWriteTime;
 
-  for (auto& [name, data] : mShaders) {
-    if (data.path.extension() == ".spv") {
+    auto hash = ShaderCache::hashFile(path).value_or(0);
+    if (hash == state.hash) {
       continue;
     }
+    state.hash = hash;
 
-    auto shader = std::move(data.shader);
+    const auto& dependents = mDependents.at(path);
+    dirtyShaders.insert(dependents.begin(), dependents.end());
+  }
+
+  std::vector<std::pair<std::string, std::future<ShaderData>>> compilations;
+  for (const auto& name : dirtyShaders) {
+    auto loadData = getLoadData(name);
+    compilations.emplace_back(name, mThreadPool.submit([this, loadData]() {
+      return compileShader(loadData);
+    }));
+  }
+
+  // Other threads may use the library while the shaders compile
+  lock.unlock();
+  std::vector<std::pair<std::string, ShaderData>> compiled;
+  for (auto& [name, compilation] : compilations) {
+    // Shaders that fail to compile keep their previous version, this includes
+    // sources that could not be read while an editor saves them
     try {
-      loadShaderSource({.name = name, .path = data.path}, true);
-    } catch (CompilationException& e) {
-      data.shader = std::move(shader);
+      compiled.emplace_back(name, compilation.get());
+    } catch (const std::exception& e) {
       std::cerr << e.what() << std::endl;
-      continue;
     }
   }
+
+  lock.lock();
+  std::unordered_set<std::string> reloaded;
+  for (auto& [name, data] : compiled) {
+    storeShader(name, std::move(data));
+    reloaded.insert(name);
+  }
+  return reloaded;
 }
 
-ShaderData ShaderLibrary::compileShader(const LoadData& loadData) const {
-  shaderc::Compiler compiler{};
-  shaderc::CompileOptions options{};
-  options.SetTargetEnvironment(shaderc_target_env_vulkan,
-                               shaderc_env_version_vulkan_1_3);
-  // options.SetOptimizationLevel(shaderc_optimization_level_zero);
-  options.SetOptimizationLevel(shaderc_optimization_level_performance);
+void ShaderLibrary::storeShader(const std::string& name, ShaderData&& data) {
+  // Update the dependency graph, the includes may have changed
+  if (auto it = mShaders.find(name); it != mShaders.end()) {
+    for (const auto& dependency : it->second.dependencies) {
+      mDependents[dependency.string()].erase(name);
+    }
+  }
 
-  // TODO: macros, defines
+  for (const auto& dependency : data.dependencies) {
+    auto path = dependency.string();
+    mDependents[path].insert(name);
 
-  auto shaderPath = mRootDir / loadData.path;
+    if (!mFiles.contains(path)) {
+      std::error_code error;
+      mFiles[path] = {
+          .lastWriteTime = std::filesystem::last_write_time(path, error),
+          .hash = ShaderCache::hashFile(path).value_or(0),
+      };
+    }
+  }
 
-  shaderc_util::FileFinder fileFinder{};
-  fileFinder.search_path().push_back(shaderPath.parent_path().string());
-  fileFinder.search_path().push_back(mRootDir.string());
-  options.SetIncluder(std::make_unique<FileIncluder>(&fileFinder));
+  mShaders.insert_or_assign(name, std::move(data));
+}
 
+ShaderData ShaderLibrary::compileShader(const LoadData& loadData) const {
   auto stage = loadData.stage.value_or(
       getShaderFromExtension(loadData.path.filename().string()));
-  auto source = readShaderSourceToString(shaderPath);
-  auto result = compiler.CompileGlslToSpv(
-      source, getShadercKind(stage), loadData.path.string().c_str(), options);
-
-  if (result.GetCompilationStatus() != shaderc_compilation_status_success) {
-    throw CompilationException{result};
-  }
-
-  std::vector<uint32_t> spirv = {result.cbegin(), result.cend()};
-  auto reflection = reflectShader(spirv);
-
-  auto shader = makeUnique<Shader>(
-      {.device = mDevice, .stage = stage, .spriv = spirv});
+  auto compiled = compileSpirv(
+      mRootDir, loadData.path, stage, loadData.defines, mCache.get());
+  auto reflection = reflectShader(compiled.spirv);
+
+  auto specialization = loadData.specialization;
+  specializeWorkgroupSize(
+      reflection, specialization, getWorkgroupSize(loadData.getName()));
+
+  auto shader = makeUnique<Shader>({
+      .device = mDevice,
+      .stage = stage,
+      .spriv = compiled.spirv,
+      .specialization = specialization,
+      .name = loadData.getName(),
+  });
 
   ShaderData shaderData = {
       .path = loadData.path,
+      .defines = loadData.defines,
+      .specialization = loadData.specialization,
       .shader = std::move(shader),
       .reflection = reflection,
   };
+
+  shaderData.dependencies.push_back(
+      (mRootDir / loadData.path).lexically_normal());
+  for (const auto& dependency : compiled.dependencies) {
+    shaderData.dependencies.push_back(
+        std::filesystem::path{dependency.path}.lexically_normal());
+  }
+
   return shaderData;
 }
 
+ShaderLibrary::LoadData ShaderLibrary::getLoadData(
+    const std::string& name) const {
+  const auto& data = mShaders.at(name);
+  return {
+      .name = name,
+      .path = data.path,
+      .stage = data.shader->getStageInfo().stage,
+      .defines = data.defines,
+      .specialization = data.specialization,
+  };
+}
+
+void ShaderLibrary::setWorkgroupSize(const std::string& name,
+                                     const WorkgroupSize& size) {
+  {
+    std::scoped_lock lock{mWorkgroupSizesMutex};
+    mWorkgroupSizes.insert_or_assign(name, size);
+  }
+
+  std::scoped_lock lock{mMutex};
+  waitForPending();
+  if (mShaders.contains(name)) {
+    storeShader(name, compileShader(getLoadData(name)));
+  }
+}
+
+std::optional<ShaderLibrary::WorkgroupSize> ShaderLibrary::getWorkgroupSize(
+    const std::string& name) const {
+  std::scoped_lock lock{mWorkgroupSizesMutex};
+  if (auto it = mWorkgroupSizes.find(name); it != mWorkgroupSizes.end()) {
+    return it->second;
+  }
+  return std::nullopt;
+}
+
+std::vector<std::string> ShaderLibrary::getTunableShaders() const {
+  std::scoped_lock lock{mMutex};
+  std::vector<std::string> names;
+  for (const auto& [name, data] : mShaders) {
+    if (data.reflection.tunableDimensions > 0) {
+      names.push_back(name);
+    }
+  }
+  std::ranges::sort(names);
+  return names;
+}
+
+// One "x y z name" line per shader
+void ShaderLibrary::loadWorkgroupSizes() {
+  std::ifstream file{mWorkgroupSizesPath};
+  WorkgroupSize size{};
+  std::string name;
+  while (file >> size.x >> size.y >> size.z &&
+         std::getline(file >> std::ws, name)) {
+    mWorkgroupSizes.insert_or_assign(name, size);
+  }
+}
+
+void ShaderLibrary::saveWorkgroupSizes() const {
+  if (mWorkgroupSizesPath.empty()) {
+    return;
+  }
+
+  std::scoped_lock lock{mWorkgroupSizesMutex};
+  std::ofstream file{mWorkgroupSizesPath, std::ios::trunc};
+  if (!file.is_open()) {
+    std::cerr << "ShaderLibrary: could not write " << mWorkgroupSizesPath
+              << std::endl;
+    return;
+  }
+  for (const auto& [name, size] : mWorkgroupSizes) {
+    file << size.x << " " << size.y << " " << size.z << " " << name << "\n";
+  }
+}
+
+size_t ShaderLibrary::warmCache(const std::filesystem::path& rootDir,
+                                const std::filesystem::path& cacheDir) {
+  ShaderCache cache{{.directory = cacheDir}};
+  core::ThreadPool threadPool;
+
+  std::vector<std::future<void>> compilations;
+  for (const auto& entry :
+       std::filesystem::recursive_directory_iterator(rootDir)) {
+    const auto& path = entry.path();
+    if (!entry.is_regular_file() || path.extension() != ".glsl") {
+      continue;
+    }
+
+    VkShaderStageFlagBits stage{};
+    try {
+      stage = getShaderFromExtension(path.filename().string());
+    } catch (const std::runtime_error&) {
+      continue;  // Include file
+    }
+
+    compilations.push_back(threadPool.submit(
+        [&, relativePath = std::filesystem::relative(path, rootDir), stage]() {
+          (void)compileSpirv(rootDir, relativePath, stage, {}, &cache);
+        }));
+  }
+
+  size_t compiled = 0;
+  for (auto& compilation : compilations) {
+    try {
+      compilation.get();
+      compiled++;
+    } catch (const CompilationException& e) {
+      std::cerr << e.what() << std::endl;
+    }
+  }
+  return compiled;
+}
+
 }  // namespace recore::vulkan
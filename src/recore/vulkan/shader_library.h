@@ -1,10 +1,17 @@
 #pragma once
 
 #include <filesystem>
+#include <future>
+#include <map>
+#include <mutex>
 #include <optional>
 #include <unordered_map>
+#include <unordered_set>
 
+#include <recore/core/thread_pool.h>
+#include <recore/shaders/workgroup_size.glslh>
 #include <recore/vulkan/api/pipeline.h>
+#include <recore/vulkan/shader_cache.h>
 
 namespace recore::vulkan {
 
@@ -13,15 +20,29 @@ struct ShaderReflectionData {
     uint32_t x;
     uint32_t y;
     uint32_t z;
+
+    bool operator==(const WorkgroupSize&) const = default;
   };
 
-  std::optional<WorkgroupSize> workgroupSize;  // only for compute
+  // Only for compute, with the specialization applied
+  std::optional<WorkgroupSize> workgroupSize;
+  // Number of workgroup dimensions (x, then y) that are specialization
+  // constants, see workgroup_size.glslh
+  uint32_t tunableDimensions{0};
 };
 
+// Preprocessor defines, ordered so equal sets produce the same permutation
+using ShaderDefines = std::map<std::string, std::string>;
+
 struct ShaderData {
   std::filesystem::path path;
+  ShaderDefines defines;
+  // As requested, without the tuned workgroup size
+  Shader::Specialization specialization;
   uPtr<Shader> shader;
   ShaderReflectionData reflection;
+  // Source and all included files
+  std::vector<std::filesystem::path> dependencies;
 
   // NOLINTNEXTLINE(hicpp-explicit-conversions)
   operator Shader*() const { return &*shader; }
@@ -33,16 +54,40 @@ class ShaderLibrary {
     std::optional<std::string> name;
     std::filesystem::path path;
     std::optional<VkShaderStageFlagBits> stage;
+    ShaderDefines defines;
+    Shader::Specialization specialization;
 
+    // Each permutation of defines and specialization constants is a separate
+    // shader, unless a name is given explicitly
     [[nodiscard]] std::string getName() const {
       if (name.has_value()) {
         return name.value();
       }
-      return path.filename().string();
+      return path.filename().string() + getPermutationKey();
+    }
+
+    [[nodiscard]] std::string getPermutationKey() const {
+      if (defines.empty() && specialization.empty()) {
+        return {};
+      }
+
+      std::string key = "[";
+      for (const auto& [define, value] : defines) {
+        key += define + "=" + value + ";";
+      }
+      for (const auto& [id, value] : specialization) {
+        key += "#" + std::to_string(id) + "=" + std::to_string(value) + ";";
+      }
+      return key + "]";
     }
   };
 
-  ShaderLibrary(const Device& device, std::filesystem::path rootDir);
+  // Compiled SPIR-V is cached in cacheDir across runs, an empty path disables
+  // the cache
+  ShaderLibrary(
+      const Device& device,
+      std::filesystem::path rootDir,
+      const std::filesystem::path& cacheDir = RECORE_SHADER_CACHE_DIR);
   ~ShaderLibrary() = default;
 
   ShaderLibrary(const ShaderLibrary&) = delete;
@@ -50,6 +95,9 @@ class ShaderLibrary {
   ShaderLibrary(ShaderLibrary&&) = delete;
   ShaderLibrary& operator=(ShaderLibrary&&) = delete;
 
+  // All methods are thread safe, e.g. for reloading on a background thread.
+  // Returned references stay valid until the same shader is stored again by
+  // a reload or a load with reload set.
   void loadShaderBinary(const LoadData& loadData);
   const ShaderData& loadShaderSource(const LoadData& loadData,
                                      bool reload = false);
@@ -58,20 +106,86 @@ class ShaderLibrary {
     return loadShaderSource({.path = path});
   }
 
-  void reload();
+  // Starts compiling the shader on the thread pool. loadShaderSource() with
+  // the same name picks up the result, so passes can request all their
+  // shaders up front and load them afterwards.
+  void requestShaderSource(const LoadData& loadData);
+
+  void requestShader(const std::filesystem::path& path) {
+    requestShaderSource({.path = path});
+  }
+
+  // Waits for all requested shaders. Rethrows the first compilation error.
+  void waitForPending();
+
+  // Recompiles the shaders whose source or includes changed since they were
+  // compiled. Returns the names of the successfully reloaded shaders.
+  std::unordered_set<std::string> reload();
+
+  // Compiles all shader sources below rootDir into the cache without creating
+  // shader modules. Returns the number of successfully compiled shaders.
+  // Only the permutation without defines is compiled, permutations are
+  // chosen by the passes at runtime and compile on first use.
+  static size_t warmCache(const std::filesystem::path& rootDir,
+                          const std::filesystem::path& cacheDir);
 
   [[nodiscard]] const ShaderData& getShaderData(const std::string& name) const;
   [[nodiscard]] const Shader& getShader(const std::string& name) const;
   [[nodiscard]] const ShaderReflectionData& getReflection(
       const std::string& name) const;
 
+  using WorkgroupSize = ShaderReflectionData::WorkgroupSize;
+
+  // Workgroup size for a compute shader with a tunable size, used unless its
+  // specialization sets one. Rebuilds the shader if it is loaded, the passes
+  // using it have to recreate their pipelines.
+  void setWorkgroupSize(const std::string& name, const WorkgroupSize& size);
+  [[nodiscard]] std::optional<WorkgroupSize> getWorkgroupSize(
+      const std::string& name) const;
+
+  // Tuned sizes are stored per device next to the SPIR-V cache
+  void saveWorkgroupSizes() const;
+
+  // Names of the loaded shaders with a tunable workgroup size
+  [[nodiscard]] std::vector<std::string> getTunableShaders() const;
+
  private:
   [[nodiscard]] ShaderData compileShader(const LoadData& loadData) const;
+  // Require the lock
+  [[nodiscard]] LoadData getLoadData(const std::string& name) const;
+
+  void loadWorkgroupSizes();
+
+  void storeShader(const std::string& name, ShaderData&& data);
 
   const Device& mDevice;
   std::filesystem::path mRootDir;
+  uPtr<ShaderCache> mCache;
+
+  // Guards the shaders, the pending compilations and the file states.
+  // Recursive, public methods call each other.
+  mutable std::recursive_mutex mMutex;
 
   std::unordered_map<std::string, ShaderData> mShaders;
+  std::unordered_map<std::string, std::future<ShaderData>> mPending;
+
+  // Last seen state of every source and include file
+  struct FileState {
+    std::filesystem::file_time_type lastWriteTime;
+    uint64_t hash;
+  };
+  std::unordered_map<std::string, FileState> mFiles;
+  // Include dependency graph: file -> shaders that use it
+  std::unordered_map<std::string, std::unordered_set<std::string>> mDependents;
+
+  std::filesystem::path mWorkgroupSizesPath;
+  std::map<std::string, WorkgroupSize> mWorkgroupSizes;
+  // Compilations on the thread pool read the tuned sizes
+  mutable std::mutex mWorkgroupSizesMutex;
+
+  // Last member, so queued compilations finish before anything they use is
+  // destroyed
+  core::ThreadPool mThreadPool;
 };
 
 }  // namespace recore::vulkan
@@ -0,0 +1,163 @@
+#include "workgroup_size_tuner.h"
+
+#include <algorithm>
+#include <format>
+#include <iostream>
+
+namespace recore::vulkan {
+
+constexpr ShaderReflectionData::WorkgroupSize kCandidates1D[] = {
+    {32, 1, 1},
+    {64, 1, 1},
+    {128, 1, 1},
+    {256, 1, 1},
+    {512, 1, 1},
+    {1024, 1, 1},
+};
+
+constexpr ShaderReflectionData::WorkgroupSize kCandidates2D[] = {
+    {8, 4, 1},
+    {8, 8, 1},
+    {16, 4, 1},
+    {16, 8, 1},
+    {16, 16, 1},
+    {32, 4, 1},
+    {32, 8, 1},
+    {32, 16, 1},
+    {32, 32, 1},
+};
+
+WorkgroupSizeTuner::WorkgroupSizeTuner(const Desc& desc)
+    : mDevice{desc.device},
+      mShaderLibrary{desc.shaderLibrary},
+      mProfileScope{desc.profileScope},
+      mWarmupFrames{desc.warmupFrames},
+      mMeasureFrames{std::max(desc.measureFrames, 1u)},
+      mShaders{desc.shaderLibrary.getTunableShaders()} {}
+
+std::vector<WorkgroupSizeTuner::WorkgroupSize>
+WorkgroupSizeTuner::getCandidates(const std::string& name) const {
+  const auto& limits = mDevice.getPhysicalDevice().getProperties().limits;
+  const auto& reflection = mShaderLibrary.getReflection(name);
+
+  std::vector<WorkgroupSize> sizes;
+  if (reflection.tunableDimensions == 1) {
+    sizes.assign(std::begin(kCandidates1D), std::end(kCandidates1D));
+  } else {
+    sizes.assign(std::begin(kCandidates2D), std::end(kCandidates2D));
+  }
+
+  // The current size might be a hand picked one outside the default set
+  if (!std::ranges::contains(sizes, *reflection.workgroupSize)) {
+    sizes.push_back(*reflection.workgroupSize);
+  }
+
+  std::erase_if(sizes, [&](const WorkgroupSize& size) {
+    return size.x > limits.maxComputeWorkGroupSize[0] ||
+           size.y > limits.maxComputeWorkGroupSize[1] ||
+           size.x * size.y * size.z > limits.maxComputeWorkGroupInvocations;
+  });
+  return sizes;
+}
+
+std::unordered_set<std::string> WorkgroupSizeTuner::update(
+    RenderFrame& frame) {
+  if (isDone()) {
+    return {};
+  }
+
+  // The query results of this frame object are from its previous use, only
+  // count them if that was with the current candidate
+  auto it = mFrameCandidates.find(&frame);
+  if (it != mFrameCandidates.end() && it->second == mCandidateID) {
+    const auto& profile = frame.getGPUProfile();
+    auto time = mProfileScope.empty() ? profile.getRootTime()
+                                      : profile.getTime(mProfileScope);
+    if (time) {
+      if (mSkipped < mWarmupFrames) {
+        mSkipped++;
+      } else {
+        mTimes.push_back(*time);
+      }
+    }
+  }
+
+  std::unordered_set<std::string> changed;
+  if (mCandidates.empty() || mTimes.size() >= mMeasureFrames) {
+    changed = advance();
+  }
+
+  mFrameCandidates.insert_or_assign(&frame, mCandidateID);
+  return changed;
+}
+
+std::unordered_set<std::string> WorkgroupSizeTuner::advance() {
+  std::unordered_set<std::string> changed;
+
+  if (!mCandidates.empty()) {
+    std::ranges::nth_element(mTimes, mTimes.begin() + mTimes.size() / 2);
+    mMedianTimes.push_back(mTimes[mTimes.size() / 2]);
+    mCandidateIndex++;
+  }
+  mTimes.clear();
+  mSkipped = 0;
+  mCandidateID++;
+
+  // Done with the current shader, keep the winner
+  if (!mCandidates.empty() && mCandidateIndex >= mCandidates.size()) {
+    const auto& name = mShaders[mShaderIndex];
+    auto best = std::distance(mMedianTimes.begin(),
+                              std::ranges::min_element(mMedianTimes));
+    const auto& size = mCandidates[best];
+    std::cout << std::format("WorkgroupSizeTuner: {} -> {}x{} ({:.3f} ms)",
+                             name,
+                             size.x,
+                             size.y,
+                             mMedianTimes[best])
+              << std::endl;
+    mShaderLibrary.setWorkgroupSize(name, size);
+    changed.insert(name);
+
+    mShaderIndex++;
+    mCandidates.clear();
+    mMedianTimes.clear();
+    mCandidateIndex = 0;
+  }
+
+  while (mCandidates.empty() && !isDone()) {
+    mCandidates = getCandidates(mShaders[mShaderIndex]);
+    if (mCandidates.empty()) {
+      mShaderIndex++;
+    }
+  }
+
+  if (isDone()) {
+    mShaderLibrary.saveWorkgroupSizes();
+    return changed;
+  }
+
+  const auto& name = mShaders[mShaderIndex];
+  mShaderLibrary.setWorkgroupSize(name, mCandidates[mCandidateIndex]);
+  changed.insert(name);
+  return changed;
+}
+
+std::string WorkgroupSizeTuner::getStatus() const {
+  if (isDone()) {
+    return std::format("Tuned {} shaders", mShaders.size());
+  }
+  if (mCandidates.empty()) {
+    return "Starting";
+  }
+  const auto& size = mCandidates[mCandidateIndex];
+  return std::format("{} ({}/{}): {}x{}, candidate {}/{}",
+                     mShaders[mShaderIndex],
+                     mShaderIndex + 1,
+                     mShaders.size(),
+                     size.x,
+                     size.y,
+                     mCandidateIndex + 1,
+                     mCandidates.size());
+}
+
+}  // namespace recore::vulkan
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <recore/vulkan/context.h>
+#include <recore/vulkan/shader_library.h>
+
+#include <unordered_map>
+
+namespace recore::vulkan {
+
+// Finds the fastest workgroup size of every tunable compute shader on the
+// workload that is rendered anyway. Each candidate size is used for a number
+// of frames while a GPU profile scope is measured, the one with the lowest
+// median time wins. Winners are stored in the shader library and saved for
+// the device once all shaders are tuned.
+class WorkgroupSizeTuner {
+ public:
+  struct Desc {
+    const Device& device;
+    ShaderLibrary& shaderLibrary;
+    // Profile scope that is minimized, should contain all tuned dispatches.
+    // Empty for the whole frame.
+    std::string profileScope;
+    // Measurements discarded after switching, e.g. for cache warmup
+    uint32_t warmupFrames = 2;
+    uint32_t measureFrames = 16;
+  };
+
+  explicit WorkgroupSizeTuner(const Desc& desc);
+
+  // Call once per frame before recording it. Returns the shaders whose
+  // workgroup size changed, their pipelines have to be recreated.
+  [[nodiscard]] std::unordered_set<std::string> update(RenderFrame& frame);
+
+  [[nodiscard]] bool isDone() const { return mShaderIndex >= mShaders.size(); }
+
+  // Human readable progress, e.g. for the GUI
+  [[nodiscard]] std::string getStatus() const;
+
+ private:
+  using WorkgroupSize = ShaderReflectionData::WorkgroupSize;
+
+  [[nodiscard]] std::vector<WorkgroupSize> getCandidates(
+      const std::string& name) const;
+
+  // Moves on to the next candidate or shader, returns the changed shader
+  [[nodiscard]] std::unordered_set<std::string> advance();
+
+  const Device& mDevice;
+  ShaderLibrary& mShaderLibrary;
+  std::string mProfileScope;
+  uint32_t mWarmupFrames;
+  uint32_t mMeasureFrames;
+
+  std::vector<std::string> mShaders;
+  size_t mShaderIndex{0};
+
+  std::vector<WorkgroupSize> mCandidates;
+  std::vector<float> mMedianTimes;
+  size_t mCandidateIndex{0};
+
+  // Candidates are numbered globally, so a frame knows what it measured
+  uint64_t mCandidateID{0};
+  std::unordered_map<const RenderFrame*, uint64_t> mFrameCandidates;
+  uint32_t mSkipped{0};
+  std::vector<float> mTimes;
+};
+
+}  // namespace recore::vulkan
@@ -3,12 +3,14 @@
 #include <recore/core/utils.h>
 
 #include <recore/scene/gpu_scene.h>
+#include <recore/vulkan/render_graph.h>
 #include <recore/vulkan/shader_library.h>
 
 #include <recore/passes/accumulator/accumulator.h>
 #include <recore/passes/gbuffer/gbuffer.h>
 #include <recore/passes/gui/gui.h>
 #include <recore/passes/guided_pathtracer/guided_pathtracer.h>
+#include <recore/passes/pass_group.h>
 #include <recore/passes/svgf/svgf.h>
 #include <recore/passes/taa/taa.h>
 #include <recore/passes/tone_mapping/tone_mapping.h>
@@ -21,8 +23,7 @@ namespace recore {
 
 static std::vector<float> downloadImage(const vulkan::Device& device,
                                         const vulkan::Image& image,
-                                        VkImageLayout srcLayout,
-                                        VkPipelineStageFlagBits srcStage) {
+                                        const vulkan::Access& access) {
   // Store screenshot
   auto buffer = makeUnique<vulkan::Buffer>({
       .device = device,
@@ -32,20 +33,14 @@ static std::vector<float> downloadImage(const vulkan::Device& device,
       .memoryUsage = VMA_MEMORY_USAGE_GPU_TO_CPU,
   });
 
-  device.submitAndWait([&](const auto& commandBuffer) {
-    commandBuffer.transitionImageLayout(image,
-                                        srcLayout,
-                                        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-                                        srcStage,
-                                        VK_PIPELINE_STAGE_TRANSFER_BIT);
+  device.getImmediateContext().submitAndWait([&](const auto& commandBuffer) {
+    vulkan::BarrierBatch{commandBuffer}.image(
+        image, access, vulkan::access::kTransferRead);
 
     commandBuffer.copyImageToBuffer(image, *buffer);
 
-    commandBuffer.transitionImageLayout(image,
-                                        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-                                        srcLayout,
-                                        VK_PIPELINE_STAGE_TRANSFER_BIT,
-                                        srcStage);
+    vulkan::BarrierBatch{commandBuffer}.image(
+        image, vulkan::access::kTransferRead, access);
   });
 
   std::vector<float> data;
@@ -73,11 +68,10 @@ static void saveImage(const std::filesystem::path& outputDirectory,
 
 static void downloadAndSaveImage(const vulkan::Device& device,
                                  const vulkan::Image& image,
-                                 VkImageLayout srcLayout,
-                                 VkPipelineStageFlagBits srcStage,
+                                 const vulkan::Access& access,
                                  const std::filesystem::path& outputDirectory,
                                  const std::string& name) {
-  auto imageData = downloadImage(device, image, srcLayout, srcStage);
+  auto imageData = downloadImage(device, image, access);
 
   saveImage(
       outputDirectory, name, imageData, image.getWidth(), image.getHeight());
@@ -91,101 +85,51 @@ class GuidingRenderer : public core::Renderer {
       : mDevice{device}, mResolution{resolution} {
     mShaderLibrary = makeUnique<vulkan::ShaderLibrary>(mDevice,
                                                        RECORE_PROJECT_DIR);
+    mPassGroup = makeUnique<passes::PassGroup>({
+        .device = mDevice,
+        .shaderLibrary = *mShaderLibrary,
+        .resolution = mResolution,
+    });
 
     setScene(std::move(scene));
   }
 
   void update(float deltaTime) override { mScene->update(deltaTime); }
 
-  void render(const vulkan::CommandBuffer& commandBuffer,
+  void render(const vulkan::FrameSubmit& submit,
               vulkan::RenderFrame& frame) override {
-    RECORE_GPU_PROFILE_SCOPE(frame, commandBuffer, "Total");
-
-    mGPUScene->update(commandBuffer, frame);
-
-    {
-      RECORE_GPU_PROFILE_SCOPE(frame, commandBuffer, "Rendering");
-      commandBuffer.setFramebufferSize(mResolution.width, mResolution.height);
-
-      // Render GBuffer
-      mGBufferPass->execute(commandBuffer, frame);
-      {
-        const auto& gbuffer = mGBufferPass->getGBuffer();
-        commandBuffer.transitionImageLayout(
-            {
-                &*gbuffer.position,
-                &*gbuffer.normal,
-                &*gbuffer.albedo,
-                &*gbuffer.emission,
-                &*gbuffer.motion,
-            },
-            VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
-            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
-      }
-
-      mGuidedPathTracerPass->execute(commandBuffer, frame);
-
-      {
-        commandBuffer.transitionImageLayout(
-            mGuidedPathTracerPass->getOutputImage(),
-            VK_IMAGE_LAYOUT_GENERAL,
-            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
-      }
-
-      mSVGFPass->execute(commandBuffer, frame);
-
-      {
-        commandBuffer.transitionImageLayout(
-            mSVGFPass->getOutputImage(),
-            VK_IMAGE_LAYOUT_GENERAL,
-            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
-      }
-
-      mTAAPass->execute(commandBuffer, frame);
-
-      {
-        commandBuffer.transitionImageLayout(
-            mTAAPass->getOutputImage(),
-            VK_IMAGE_LAYOUT_GENERAL,
-            VK_IMAGE_LAYOUT_GENERAL,
-            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
-      }
-
-      mAccumulatorPass->execute(commandBuffer, frame);
-
-      commandBuffer.transitionImageLayout(
-          mAccumulatorPass->getAccumulatorImage(),
-          VK_IMAGE_LAYOUT_GENERAL,
-          VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-          VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-          VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+    mPassGroup->update(frame);
+
+    // Every pass is recorded into its own command buffer
+    addGraphPasses();
+    mRenderGraph.execute(
+        frame,
+        submit,
+        [width = mResolution.width,
+         height = mResolution.height](const auto& commandBuffer) {
+          commandBuffer.setFramebufferSize(width, height);
+        });
+  }
 
-      mToneMappingPass->execute(commandBuffer, frame);
+  // Guiding training overlaps with the start of the next frame
+  [[nodiscard]] bool hasAsyncCompute() const override {
+    return mGuidedPathTracerPass->hasTrainingQueue();
+  }
 
-      commandBuffer.transitionImageLayout(
-          mAccumulatorPass->getAccumulatorImage(),
-          VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-          VK_IMAGE_LAYOUT_GENERAL,
-          VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-          VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
-    }
+  void renderAsyncCompute(const vulkan::CommandBuffer& commandBuffer,
+                          vulkan::RenderFrame& frame) override {
+    mGuidedPathTracerPass->executeTraining(commandBuffer, frame);
   }
 
-  void resize(uint32_t width, uint32_t height) override {
+  void resize(uint32_t width,
+              uint32_t height,
+              vulkan::RenderFrame& frame) override {
     mResolution = {width, height};
 
     mScene->getCamera().setAspect(width, height);
 
-    for (auto& pass : mPasses) {
-      pass->resize(width, height);
-    }
+    mPassGroup->resize(width, height, frame);
+    mRenderGraph.reset();
 
     // Update dependencies
     buildPassDepencencies();
@@ -197,56 +141,158 @@ class GuidingRenderer : public core::Renderer {
 
   void setScene(uPtr<scene::Scene>&& scene) {
     vulkan::checkResult(mDevice.waitIdle());
+    mPassGroup->finishReload();
     mScene = std::move(scene);
 
     mScene->getCamera().setAspect(mResolution.width, mResolution.height);
 
     mGPUScene = makeUnique<scene::GPUScene>(mDevice, *mScene, true);
     mGPUScene->upload();
+    mRenderGraph.reset();
 
     buildPasses();
   }
 
   [[nodiscard]] scene::Scene& getScene() { return *mScene; }
 
-  void reload() {
-    vulkan::checkResult(mDevice.waitIdle());
+  [[nodiscard]] bool getAsyncTraining() const { return mAsyncTraining; }
 
-    mShaderLibrary->reload();
-    for (auto& pass : mPasses) {
-      pass->reloadShaders(*mShaderLibrary);
-    }
+  void setAsyncTraining(bool asyncTraining) {
+    mAsyncTraining = asyncTraining;
+    mGuidedPathTracerPass->setTrainingQueue(
+        mAsyncTraining ? &mDevice.getAsyncComputeQueue() : nullptr);
   }
 
- private:
-  template <typename T, typename... Args>
-    requires std::is_base_of_v<passes::Pass, T>
-  [[nodiscard]] uPtr<T> addPass(Args&&... args) {
-    auto pass = makeUnique<T>(std::forward<Args>(args)...);
-    pass->resize(mResolution.width, mResolution.height);
-    pass->reloadShaders(*mShaderLibrary);
-    mPasses.push_back(&*pass);
-    return pass;
-  }
+  [[nodiscard]] passes::PassGroup& getPassGroup() { return *mPassGroup; }
 
+ private:
   void buildPasses() {
-    mPasses.clear();
+    mPassGroup->build([&]() {
+      auto& group = *mPassGroup;
+      mGBufferPass = group.addPass<passes::GBufferPass>(mDevice, *mGPUScene);
+      mGuidedPathTracerPass =
+          group.addPass<passes::GuidedPathTracerPass>(mDevice, *mGPUScene);
+      setAsyncTraining(mAsyncTraining);
+      mSVGFPass = group.addPass<passes::SVGFPass>(mDevice);
 
-    mGBufferPass = addPass<passes::GBufferPass>(mDevice, *mGPUScene);
-    mGuidedPathTracerPass = addPass<passes::GuidedPathTracerPass>(mDevice,
-                                                                  *mGPUScene);
-    mSVGFPass = addPass<passes::SVGFPass>(mDevice);
+      mAccumulatorPass =
+          group.addPass<passes::AccumulatorPass>(mDevice, *mScene);
 
-    mAccumulatorPass = addPass<passes::AccumulatorPass>(mDevice, *mScene);
+      mTAAPass = group.addPass<passes::TAAPass>(mDevice);
+      mGPUScene->enableCameraJitter();
 
-    mTAAPass = addPass<passes::TAAPass>(mDevice);
-    mGPUScene->enableCameraJitter();
-
-    mToneMappingPass = addPass<passes::ToneMappingPass>(mDevice);
+      mToneMappingPass = group.addPass<passes::ToneMappingPass>(mDevice);
+    });
 
     buildPassDepencencies();
   }
 
+  // Declares what the passes of a frame read and write, the render graph
+  // derives the barriers and layout transitions between them
+  void addGraphPasses() {
+    using namespace vulkan::access;
+    const auto& gBuffer = mGBufferPass->getGBuffer();
+
+    mRenderGraph.addPass(
+        "GPUScene",
+        [&](auto& builder) { mGPUScene->declareUpdate(builder); },
+        [&](const auto& commandBuffer, auto& frame) {
+          mGPUScene->update(commandBuffer, frame);
+        });
+
+    mRenderGraph.addPass(
+        "GBuffer",
+        [&](auto& builder) {
+          mGPUScene->declareReads(builder,
+                                  VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT |
+                                      VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT);
+          for (const auto* image : {&*gBuffer.position,
+                                    &*gBuffer.normal,
+                                    &*gBuffer.albedo,
+                                    &*gBuffer.emission,
+                                    &*gBuffer.motion,
+                                    &*gBuffer.material}) {
+            builder.write(*image, kColorAttachment, true);
+          }
+          builder.write(*gBuffer.depth, kDepthAttachment, true);
+        },
+        [&](const auto& commandBuffer, auto& frame) {
+          mGBufferPass->execute(commandBuffer, frame);
+        });
+
+    mRenderGraph.addPass(
+        "GuidedPathTracer",
+        [&](auto& builder) {
+          mGPUScene->declareReads(builder,
+                                  VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT);
+          for (const auto* image : {&*gBuffer.position,
+                                    &*gBuffer.normal,
+                                    &*gBuffer.albedo,
+                                    &*gBuffer.emission}) {
+            builder.read(*image, kComputeSampled);
+          }
+          builder.write(
+              mGuidedPathTracerPass->getOutputImage(), kComputeWrite, true);
+        },
+        [&](const auto& commandBuffer, auto& frame) {
+          mGuidedPathTracerPass->execute(commandBuffer, frame);
+        });
+
+    mRenderGraph.addPass(
+        "SVGF",
+        [&](auto& builder) {
+          for (const auto* image : {&*gBuffer.position,
+                                    &*gBuffer.normal,
+                                    &*gBuffer.albedo,
+                                    &*gBuffer.motion}) {
+            builder.read(*image, kComputeSampled);
+          }
+          builder.read(mGuidedPathTracerPass->getOutputImage(),
+                       kComputeSampled);
+          builder.write(mSVGFPass->getOutputImage(), kComputeWrite, true);
+        },
+        [&](const auto& commandBuffer, auto& frame) {
+          mSVGFPass->execute(commandBuffer, frame);
+        });
+
+    mRenderGraph.addPass(
+        "TAA",
+        [&](auto& builder) {
+          builder.read(*gBuffer.motion, kComputeSampled);
+          builder.read(mSVGFPass->getOutputImage(), kComputeSampled);
+          builder.write(mTAAPass->getOutputImage(), kComputeWrite, true);
+        },
+        [&](const auto& commandBuffer, auto& frame) {
+          mTAAPass->execute(commandBuffer, frame);
+        });
+
+    mRenderGraph.addPass(
+        "Accumulator",
+        [&](auto& builder) {
+          builder.read(mTAAPass->getOutputImage(), kComputeRead);
+          builder.read(mAccumulatorPass->getAccumulatorImage(), kComputeRead);
+          builder.write(mAccumulatorPass->getAccumulatorImage(),
+                        kComputeWrite);
+        },
+        [&](const auto& commandBuffer, auto& frame) {
+          mAccumulatorPass->execute(commandBuffer, frame);
+        });
+
+    mRenderGraph.addPass(
+        "ToneMapping",
+        [&](auto& builder) {
+          builder.read(mAccumulatorPass->getAccumulatorImage(),
+                       kFragmentSampled);
+          builder.write(
+              mToneMappingPass->getOutputImage(), kColorAttachment, true);
+        },
+        [&](const auto& commandBuffer, auto& frame) {
+          mToneMappingPass->execute(commandBuffer, frame);
+        });
+
+    mRenderGraph.exportImage(getResultImage(), kFrameResult);
+  }
+
   void buildPassDepencencies() {
     const auto& gBuffer = mGBufferPass->getGBuffer();
 
@@ -285,15 +331,18 @@ class GuidingRenderer : public core::Renderer {
   uPtr<scene::Scene> mScene;
   uPtr<scene::GPUScene> mGPUScene;
 
-  // Passes
-  uPtr<passes::GBufferPass> mGBufferPass;
-  uPtr<passes::GuidedPathTracerPass> mGuidedPathTracerPass;
-  uPtr<passes::SVGFPass> mSVGFPass;
-  uPtr<passes::AccumulatorPass> mAccumulatorPass;
-  uPtr<passes::TAAPass> mTAAPass;
-  uPtr<passes::ToneMappingPass> mToneMappingPass;
+  // Passes, owned by the group
+  uPtr<passes::PassGroup> mPassGroup;
+  passes::GBufferPass* mGBufferPass{nullptr};
+  passes::GuidedPathTracerPass* mGuidedPathTracerPass{nullptr};
+  passes::SVGFPass* mSVGFPass{nullptr};
+  passes::AccumulatorPass* mAccumulatorPass{nullptr};
+  passes::TAAPass* mTAAPass{nullptr};
+  passes::ToneMappingPass* mToneMappingPass{nullptr};
 
-  std::vector<passes::Pass*> mPasses;
+  vulkan::RenderGraph mRenderGraph;
+
+  bool mAsyncTraining{true};
 
   friend class GuidingGUI;
 };
@@ -311,7 +360,7 @@ class GuidingGUI : public core::GUI {
         mDebugMessenger{debugMessenger},
         mRenderContext{renderContext},
         mGuiPass{device, window.glfwHandle(), numFramesInFlight} {
-    setFramebuffer(mRenderer.getResultImage());
+    setFramebuffer(mRenderer.getResultImage(), nullptr);
   }
 
   void update() override {
@@ -320,7 +369,7 @@ class GuidingGUI : public core::GUI {
     updateCamera();
 
     if (ImGui::IsKeyReleased(ImGuiKey_F5)) {
-      mRenderer.reload();
+      mRenderer.getPassGroup().reload();
     }
 
     if (ImGui::IsKeyReleased(ImGuiKey_F10)) {
@@ -328,8 +377,7 @@ class GuidingGUI : public core::GUI {
 
       downloadAndSaveImage(mDevice,
                            mRenderer.mToneMappingPass->getOutputImage(),
-                           VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
-                           VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                           vulkan::access::kTransferRead,
                            ".",
                            "guiding");
     }
@@ -350,22 +398,37 @@ class GuidingGUI : public core::GUI {
     mGuiPass.draw(commandBuffer);
   }
 
-  void setFramebuffer(const vulkan::Image& image) override {
-    mGuiPass.setFramebuffer(image);
+  void setFramebuffer(const vulkan::Image& image,
+                      vulkan::RenderFrame* frame) override {
+    mGuiPass.setFramebuffer(image, frame);
   }
 
  private:
   void renderMainGUI() {
     ImGui::Begin("Guiding");
     ImGui::Text("Framerate: %.1f FPS", ImGui::GetIO().Framerate);
+    const auto& barriers =
+        mRenderContext.getCurrentFrame().getBarrierStatistics();
+    ImGui::Text("Barriers: %u in %u batches",
+                barriers.barriers,
+                barriers.batches);
 
     if (ImGui::CollapsingHeader("Path Tracer")) {
       auto& settings = mRenderer.mGuidedPathTracerPass->settings();
 
       ImGui::Checkbox("Train", &settings.train);
       ImGui::Checkbox("Guide", &settings.guide);
+
+      bool asyncTraining = mRenderer.getAsyncTraining();
+      if (ImGui::Checkbox("Async compute training", &asyncTraining)) {
+        vulkan::checkResult(mDevice.waitIdle());
+        mRenderer.setAsyncTraining(asyncTraining);
+      }
     }
 
+    passes::drawRendererSections(
+        mDevice, mRenderContext, mRenderer.getPassGroup());
+
     ImGui::End();
   }
 
@@ -518,6 +581,7 @@ void launchSimplePathTracer() {
                                 return featureMap;
                               }(),
                       },
+                  .pipelineStatistics = true,
               },
       }};
 
@@ -550,12 +614,13 @@ void launchSimplePathTracer() {
   auto renderer = makeUnique<GuidingRenderer>(
       app->getDevice(), appSettings.resolution, std::move(scene));
 
-  auto gui = makeUnique<GuidingGUI>(app->getDevice(),
-                                    *renderer,
-                                    app->getWindow(),
-                                    debugMessenger,
-                                    app->getRenderContext(),
-                                    3);
+  auto gui = makeUnique<GuidingGUI>(
+      app->getDevice(),
+      *renderer,
+      app->getWindow(),
+      debugMessenger,
+      app->getRenderContext(),
+      vulkan::RenderContext::kMaxFramesInFlight);
 
   app->setRenderer(&*renderer);
   app->setGui(&*gui);
@@ -3,12 +3,15 @@
 #include <recore/core/utils.h>
 
 #include <recore/scene/gpu_scene.h>
+#include <recore/vulkan/render_graph.h>
 #include <recore/vulkan/shader_library.h>
 
 #include <recore/passes/accumulator/accumulator.h>
 #include <recore/passes/diffuse_pathtracer/diffuse_pathtracer.h>
+#include <recore/passes/diffuse_pathtracer/diffuse_pathtracer_rt.h>
 #include <recore/passes/gbuffer/gbuffer.h>
 #include <recore/passes/gui/gui.h>
+#include <recore/passes/pass_group.h>
 #include <recore/passes/svgf/svgf.h>
 #include <recore/passes/taa/taa.h>
 #include <recore/passes/tone_mapping/tone_mapping.h>
@@ -25,101 +28,41 @@ class SimplePathTracerRenderer : public core::Renderer {
       : mDevice{device}, mResolution{resolution} {
     mShaderLibrary = makeUnique<vulkan::ShaderLibrary>(mDevice,
                                                        RECORE_PROJECT_DIR);
+    mPassGroup = makeUnique<passes::PassGroup>({
+        .device = mDevice,
+        .shaderLibrary = *mShaderLibrary,
+        .resolution = mResolution,
+    });
 
     setScene(std::move(scene));
   }
 
   void update(float deltaTime) override { mScene->update(deltaTime); }
 
-  void render(const vulkan::CommandBuffer& commandBuffer,
+  void render(const vulkan::FrameSubmit& submit,
               vulkan::RenderFrame& frame) override {
-    RECORE_GPU_PROFILE_SCOPE(frame, commandBuffer, "Total");
-
-    mGPUScene->update(commandBuffer, frame);
-
-    {
-      RECORE_GPU_PROFILE_SCOPE(frame, commandBuffer, "Rendering");
-      commandBuffer.setFramebufferSize(mResolution.width, mResolution.height);
-
-      // Render GBuffer
-      mGBufferPass->execute(commandBuffer, frame);
-      {
-        const auto& gbuffer = mGBufferPass->getGBuffer();
-        commandBuffer.transitionImageLayout(
-            {
-                &*gbuffer.position,
-                &*gbuffer.normal,
-                &*gbuffer.albedo,
-                &*gbuffer.emission,
-                &*gbuffer.motion,
-            },
-            VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
-            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
-      }
-
-      mDiffusePathTracerPass->execute(commandBuffer, frame);
-
-      {
-        commandBuffer.transitionImageLayout(
-            mDiffusePathTracerPass->getOutputImage(),
-            VK_IMAGE_LAYOUT_GENERAL,
-            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
-      }
-
-      mSVGFPass->execute(commandBuffer, frame);
-
-      {
-        commandBuffer.transitionImageLayout(
-            mSVGFPass->getOutputImage(),
-            VK_IMAGE_LAYOUT_GENERAL,
-            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
-      }
-
-      mTAAPass->execute(commandBuffer, frame);
-
-      {
-        commandBuffer.transitionImageLayout(
-            mTAAPass->getOutputImage(),
-            VK_IMAGE_LAYOUT_GENERAL,
-            VK_IMAGE_LAYOUT_GENERAL,
-            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
-      }
-
-      mAccumulatorPass->execute(commandBuffer, frame);
-
-      commandBuffer.transitionImageLayout(
-          mAccumulatorPass->getAccumulatorImage(),
-          VK_IMAGE_LAYOUT_GENERAL,
-          VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-          VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-          VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
-
-      mToneMappingPass->execute(commandBuffer, frame);
-
-      commandBuffer.transitionImageLayout(
-          mAccumulatorPass->getAccumulatorImage(),
-          VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-          VK_IMAGE_LAYOUT_GENERAL,
-          VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-          VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
-    }
+    mPassGroup->update(frame);
+
+    // Every pass is recorded into its own command buffer
+    addGraphPasses();
+    mRenderGraph.execute(
+        frame,
+        submit,
+        [width = mResolution.width,
+         height = mResolution.height](const auto& commandBuffer) {
+          commandBuffer.setFramebufferSize(width, height);
+        });
   }
 
-  void resize(uint32_t width, uint32_t height) override {
+  void resize(uint32_t width,
+              uint32_t height,
+              vulkan::RenderFrame& frame) override {
     mResolution = {width, height};
 
     mScene->getCamera().setAspect(width, height);
 
-    for (auto& pass : mPasses) {
-      pass->resize(width, height);
-    }
+    mPassGroup->resize(width, height, frame);
+    mRenderGraph.reset();
 
     // Update dependencies
     buildPassDepencencies();
@@ -131,54 +74,197 @@ class SimplePathTracerRenderer : public core::Renderer {
 
   void setScene(uPtr<scene::Scene>&& scene) {
     vulkan::checkResult(mDevice.waitIdle());
+    mPassGroup->finishReload();
     mScene = std::move(scene);
 
     mScene->getCamera().setAspect(mResolution.width, mResolution.height);
 
     mGPUScene = makeUnique<scene::GPUScene>(mDevice, *mScene, true);
     mGPUScene->upload();
+    mRenderGraph.reset();
 
     buildPasses();
   }
 
   [[nodiscard]] scene::Scene& getScene() { return *mScene; }
 
-  void reload() {
-    vulkan::checkResult(mDevice.waitIdle());
+  // Switches between the ray query and the ray tracing pipeline path tracer
+  void setUseRayTracingPipeline(bool useRayTracingPipeline) {
+    mUseRayTracingPipeline = useRayTracingPipeline;
+    buildPassDepencencies();
+  }
 
-    mShaderLibrary->reload();
-    for (auto& pass : mPasses) {
-      pass->reloadShaders(*mShaderLibrary);
-    }
+  [[nodiscard]] bool getUseRayTracingPipeline() const {
+    return mUseRayTracingPipeline;
   }
 
- private:
-  template <typename T, typename... Args>
-    requires std::is_base_of_v<passes::Pass, T>
-  [[nodiscard]] uPtr<T> addPass(Args&&... args) {
-    auto pass = makeUnique<T>(std::forward<Args>(args)...);
-    pass->resize(mResolution.width, mResolution.height);
-    pass->reloadShaders(*mShaderLibrary);
-    mPasses.push_back(&*pass);
-    return pass;
+  // Switches the ray query path tracer to another shader permutation, the old
+  // pipelines are retired into the frame
+  void setMaxBounces(uint32_t maxBounces, vulkan::RenderFrame& frame) {
+    mPassGroup->finishReload(&frame);
+    mDiffusePathTracerPass->setMaxBounces(maxBounces);
+    mDiffusePathTracerPass->registerShaders(*mShaderLibrary);
+    mDiffusePathTracerPass->reloadShaders(*mShaderLibrary, &frame);
   }
 
-  void buildPasses() {
-    mPasses.clear();
+  [[nodiscard]] uint32_t getMaxBounces() const {
+    return mDiffusePathTracerPass->getMaxBounces();
+  }
+
+  [[nodiscard]] passes::PassGroup& getPassGroup() { return *mPassGroup; }
 
-    mGBufferPass = addPass<passes::GBufferPass>(mDevice, *mGPUScene);
-    mDiffusePathTracerPass = addPass<passes::DiffusePathTracerPass>(mDevice,
-                                                                    *mGPUScene);
-    mSVGFPass = addPass<passes::SVGFPass>(mDevice);
+ private:
+  void buildPasses() {
+    mPassGroup->build([&]() {
+      auto& group = *mPassGroup;
+      mGBufferPass = group.addPass<passes::GBufferPass>(mDevice, *mGPUScene);
+      mDiffusePathTracerPass =
+          group.addPass<passes::DiffusePathTracerPass>(mDevice, *mGPUScene);
+      mDiffusePathTracerRTPass =
+          group.addPass<passes::DiffusePathTracerRTPass>(mDevice, *mGPUScene);
+      mSVGFPass = group.addPass<passes::SVGFPass>(mDevice);
+
+      mAccumulatorPass =
+          group.addPass<passes::AccumulatorPass>(mDevice, *mScene);
+
+      mTAAPass = group.addPass<passes::TAAPass>(mDevice);
+      mGPUScene->enableCameraJitter();
+
+      mToneMappingPass = group.addPass<passes::ToneMappingPass>(mDevice);
+    });
 
-    mAccumulatorPass = addPass<passes::AccumulatorPass>(mDevice, *mScene);
+    buildPassDepencencies();
+  }
 
-    mTAAPass = addPass<passes::TAAPass>(mDevice);
-    mGPUScene->enableCameraJitter();
+  // Declares what the passes of a frame read and write, the render graph
+  // derives the barriers and layout transitions between them
+  void addGraphPasses() {
+    using namespace vulkan::access;
+    const auto& gBuffer = mGBufferPass->getGBuffer();
 
-    mToneMappingPass = addPass<passes::ToneMappingPass>(mDevice);
+    mRenderGraph.addPass(
+        "GPUScene",
+        [&](auto& builder) { mGPUScene->declareUpdate(builder); },
+        [&](const auto& commandBuffer, auto& frame) {
+          mGPUScene->update(commandBuffer, frame);
+        });
+
+    mRenderGraph.addPass(
+        "GBuffer",
+        [&](auto& builder) {
+          mGPUScene->declareReads(builder,
+                                  VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT |
+                                      VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT);
+          for (const auto* image : {&*gBuffer.position,
+                                    &*gBuffer.normal,
+                                    &*gBuffer.albedo,
+                                    &*gBuffer.emission,
+                                    &*gBuffer.motion,
+                                    &*gBuffer.material}) {
+            builder.write(*image, kColorAttachment, true);
+          }
+          builder.write(*gBuffer.depth, kDepthAttachment, true);
+        },
+        [&](const auto& commandBuffer, auto& frame) {
+          mGBufferPass->execute(commandBuffer, frame);
+        });
+
+    if (mUseRayTracingPipeline) {
+      mRenderGraph.addPass(
+          "DiffusePathTracerRT",
+          [&](auto& builder) {
+            mGPUScene->declareReads(
+                builder, VK_PIPELINE_STAGE_2_RAY_TRACING_SHADER_BIT_KHR);
+            for (const auto* image : {&*gBuffer.position,
+                                      &*gBuffer.normal,
+                                      &*gBuffer.albedo,
+                                      &*gBuffer.emission}) {
+              builder.read(*image, kRayTracingSampled);
+            }
+            builder.write(mDiffusePathTracerRTPass->getOutputImage(),
+                          kRayTracingWrite,
+                          true);
+          },
+          [&](const auto& commandBuffer, auto& frame) {
+            mDiffusePathTracerRTPass->execute(commandBuffer, frame);
+          });
+    } else {
+      mRenderGraph.addPass(
+          "DiffusePathTracer",
+          [&](auto& builder) {
+            mGPUScene->declareReads(builder,
+                                    VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT);
+            for (const auto* image : {&*gBuffer.position,
+                                      &*gBuffer.normal,
+                                      &*gBuffer.albedo,
+                                      &*gBuffer.emission}) {
+              builder.read(*image, kComputeSampled);
+            }
+            builder.write(mDiffusePathTracerPass->getOutputImage(),
+                          kComputeWrite,
+                          true);
+          },
+          [&](const auto& commandBuffer, auto& frame) {
+            mDiffusePathTracerPass->execute(commandBuffer, frame);
+          });
+    }
 
-    buildPassDepencencies();
+    const auto& pathTracerImage =
+        mUseRayTracingPipeline ? mDiffusePathTracerRTPass->getOutputImage()
+                               : mDiffusePathTracerPass->getOutputImage();
+
+    mRenderGraph.addPass(
+        "SVGF",
+        [&](auto& builder) {
+          for (const auto* image : {&*gBuffer.position,
+                                    &*gBuffer.normal,
+                                    &*gBuffer.albedo,
+                                    &*gBuffer.motion}) {
+            builder.read(*image, kComputeSampled);
+          }
+          builder.read(pathTracerImage, kComputeSampled);
+          builder.write(mSVGFPass->getOutputImage(), kComputeWrite, true);
+        },
+        [&](const auto& commandBuffer, auto& frame) {
+          mSVGFPass->execute(commandBuffer, frame);
+        });
+
+    mRenderGraph.addPass(
+        "TAA",
+        [&](auto& builder) {
+          builder.read(*gBuffer.motion, kComputeSampled);
+          builder.read(mSVGFPass->getOutputImage(), kComputeSampled);
+          builder.write(mTAAPass->getOutputImage(), kComputeWrite, true);
+        },
+        [&](const auto& commandBuffer, auto& frame) {
+          mTAAPass->execute(commandBuffer, frame);
+        });
+
+    mRenderGraph.addPass(
+        "Accumulator",
+        [&](auto& builder) {
+          builder.read(mTAAPass->getOutputImage(), kComputeRead);
+          builder.read(mAccumulatorPass->getAccumulatorImage(), kComputeRead);
+          builder.write(mAccumulatorPass->getAccumulatorImage(),
+                        kComputeWrite);
+        },
+        [&](const auto& commandBuffer, auto& frame) {
+          mAccumulatorPass->execute(commandBuffer, frame);
+        });
+
+    mRenderGraph.addPass(
+        "ToneMapping",
+        [&](auto& builder) {
+          builder.read(mAccumulatorPass->getAccumulatorImage(),
+                       kFragmentSampled);
+          builder.write(
+              mToneMappingPass->getOutputImage(), kColorAttachment, true);
+        },
+        [&](const auto& commandBuffer, auto& frame) {
+          mToneMappingPass->execute(commandBuffer, frame);
+        });
+
+    mRenderGraph.exportImage(getResultImage(), kFrameResult);
   }
 
   void buildPassDepencencies() {
@@ -190,13 +276,23 @@ class SimplePathTracerRenderer : public core::Renderer {
         .gAlbedo = *gBuffer.albedo,
         .gEmissive = *gBuffer.emission,
     });
+    mDiffusePathTracerRTPass->setInput({
+        .gPosition = *gBuffer.position,
+        .gNormal = *gBuffer.normal,
+        .gAlbedo = *gBuffer.albedo,
+        .gEmissive = *gBuffer.emission,
+    });
+
+    const auto& pathTracerImage =
+        mUseRayTracingPipeline ? mDiffusePathTracerRTPass->getOutputImage()
+                               : mDiffusePathTracerPass->getOutputImage();
 
     mSVGFPass->setInput({
         .gPosition = *gBuffer.position,
         .gNormal = *gBuffer.normal,
         .gAlbedo = *gBuffer.albedo,
         .gMotion = *gBuffer.motion,
-        .noisyImage = mDiffusePathTracerPass->getOutputImage(),
+        .noisyImage = pathTracerImage,
     });
 
     mTAAPass->setInput({
@@ -219,15 +315,19 @@ class SimplePathTracerRenderer : public core::Renderer {
   uPtr<scene::Scene> mScene;
   uPtr<scene::GPUScene> mGPUScene;
 
-  // Passes
-  uPtr<passes::GBufferPass> mGBufferPass;
-  uPtr<passes::DiffusePathTracerPass> mDiffusePathTracerPass;
-  uPtr<passes::SVGFPass> mSVGFPass;
-  uPtr<passes::AccumulatorPass> mAccumulatorPass;
-  uPtr<passes::TAAPass> mTAAPass;
-  uPtr<passes::ToneMappingPass> mToneMappingPass;
+  // Passes, owned by the group
+  uPtr<passes::PassGroup> mPassGroup;
+  passes::GBufferPass* mGBufferPass{nullptr};
+  passes::DiffusePathTracerPass* mDiffusePathTracerPass{nullptr};
+  passes::DiffusePathTracerRTPass* mDiffusePathTracerRTPass{nullptr};
+  passes::SVGFPass* mSVGFPass{nullptr};
+  passes::AccumulatorPass* mAccumulatorPass{nullptr};
+  passes::TAAPass* mTAAPass{nullptr};
+  passes::ToneMappingPass* mToneMappingPass{nullptr};
+
+  vulkan::RenderGraph mRenderGraph;
 
-  std::vector<passes::Pass*> mPasses;
+  bool mUseRayTracingPipeline = false;
 };
 
 class SimplePathTracerGUI : public core::GUI {
@@ -243,7 +343,7 @@ class SimplePathTracerGUI : public core::GUI {
         mDebugMessenger{debugMessenger},
         mRenderContext{renderContext},
         mGuiPass{device, window.glfwHandle(), numFramesInFlight} {
-    setFramebuffer(mRenderer.getResultImage());
+    setFramebuffer(mRenderer.getResultImage(), nullptr);
   }
 
   void update() override {
@@ -252,7 +352,7 @@ class SimplePathTracerGUI : public core::GUI {
     updateCamera();
 
     if (ImGui::IsKeyReleased(ImGuiKey_F5)) {
-      mRenderer.reload();
+      mRenderer.getPassGroup().reload();
     }
 
     renderMainGUI();
@@ -271,14 +371,35 @@ class SimplePathTracerGUI : public core::GUI {
     mGuiPass.draw(commandBuffer);
   }
 
-  void setFramebuffer(const vulkan::Image& image) override {
-    mGuiPass.setFramebuffer(image);
+  void setFramebuffer(const vulkan::Image& image,
+                      vulkan::RenderFrame* frame) override {
+    mGuiPass.setFramebuffer(image, frame);
   }
 
  private:
   void renderMainGUI() {
     ImGui::Begin("SimplePathTracerGUI");
     ImGui::Text("Framerate: %.1f FPS", ImGui::GetIO().Framerate);
+    const auto& barriers =
+        mRenderContext.getCurrentFrame().getBarrierStatistics();
+    ImGui::Text("Barriers: %u in %u batches",
+                barriers.barriers,
+                barriers.batches);
+
+    bool useRayTracingPipeline = mRenderer.getUseRayTracingPipeline();
+    if (ImGui::Checkbox("Ray tracing pipeline", &useRayTracingPipeline)) {
+      vulkan::checkResult(mDevice.waitIdle());
+      mRenderer.setUseRayTracingPipeline(useRayTracingPipeline);
+    }
+
+    int maxBounces = static_cast<int>(mRenderer.getMaxBounces());
+    if (ImGui::SliderInt("Max bounces", &maxBounces, 1, 16)) {
+      mRenderer.setMaxBounces(static_cast<uint32_t>(maxBounces),
+                              mRenderContext.getCurrentFrame());
+    }
+
+    passes::drawRendererSections(
+        mDevice, mRenderContext, mRenderer.getPassGroup());
 
     ImGui::End();
   }
@@ -392,6 +513,7 @@ void launchSimplePathTracer() {
                           VK_KHR_ACCELERATION_STRUCTURE_EXTENSION_NAME,
                           VK_KHR_DEFERRED_HOST_OPERATIONS_EXTENSION_NAME,
                           VK_KHR_RAY_QUERY_EXTENSION_NAME,
+                          VK_KHR_RAY_TRACING_PIPELINE_EXTENSION_NAME,
                           VK_EXT_SHADER_ATOMIC_FLOAT_EXTENSION_NAME,
                       },
                   .features =
@@ -419,6 +541,11 @@ void launchSimplePathTracer() {
                                     VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_RAY_QUERY_FEATURES_KHR>(
                                     &VkPhysicalDeviceRayQueryFeaturesKHR::
                                         rayQuery);
+                                featureMap.addFeature<
+                                    VkPhysicalDeviceRayTracingPipelineFeaturesKHR,
+                                    VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_RAY_TRACING_PIPELINE_FEATURES_KHR>(
+                                    &VkPhysicalDeviceRayTracingPipelineFeaturesKHR::
+                                        rayTracingPipeline);
 
                                 featureMap.addFeatures<
                                     VkPhysicalDeviceShaderAtomicFloatFeaturesEXT,
@@ -432,6 +559,7 @@ void launchSimplePathTracer() {
                                 return featureMap;
                               }(),
                       },
+                  .pipelineStatistics = true,
               },
       }};
 
@@ -464,12 +592,13 @@ void launchSimplePathTracer() {
   auto renderer = makeUnique<SimplePathTracerRenderer>(
       app->getDevice(), appSettings.resolution, std::move(scene));
 
-  auto gui = makeUnique<SimplePathTracerGUI>(app->getDevice(),
-                                             *renderer,
-                                             app->getWindow(),
-                                             debugMessenger,
-                                             app->getRenderContext(),
-                                             3);
+  auto gui = makeUnique<SimplePathTracerGUI>(
+      app->getDevice(),
+      *renderer,
+      app->getWindow(),
+      debugMessenger,
+      app->getRenderContext(),
+      vulkan::RenderContext::kMaxFramesInFlight);
 
   app->setRenderer(&*renderer);
   app->setGui(&*gui);
@@ -0,0 +1,251 @@
+#include <recore/core/application.h>
+
+#include <recore/scene/gpu_scene.h>
+#include <recore/vulkan/shader_library.h>
+
+#include <recore/passes/accumulator/accumulator.h>
+#include <recore/passes/diffuse_pathtracer/diffuse_pathtracer.h>
+#include <recore/passes/diffuse_pathtracer/diffuse_pathtracer_rt.h>
+#include <recore/passes/gbuffer/gbuffer.h>
+#include <recore/passes/guided_pathtracer/guided_pathtracer.h>
+#include <recore/passes/photontracer/photontracer.h>
+#include <recore/passes/pm_pathtracer/pm_pathtracer.h>
+#include <recore/passes/svgf/svgf.h>
+#include <recore/passes/taa/taa.h>
+#include <recore/passes/tone_mapping/tone_mapping.h>
+#include <recore/passes/volume_pathtracer/volume_pathtracer.h>
+
+#include <argparse/argparse.hpp>
+
+#include <algorithm>
+#include <format>
+#include <fstream>
+#include <iostream>
+
+namespace recore {
+
+static std::string escapeJSON(const std::string& string) {
+  std::string escaped;
+  for (char c : string) {
+    switch (c) {
+      case '"':
+        escaped += "\\\"";
+        break;
+      case '\\':
+        escaped += "\\\\";
+        break;
+      case '\n':
+        escaped += "\\n";
+        break;
+      case '\t':
+        escaped += "\\t";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          escaped += std::format("\\u{:04x}", static_cast<int>(c));
+        } else {
+          escaped += c;
+        }
+    }
+  }
+  return escaped;
+}
+
+static void writeJSON(std::ostream& out, const vulkan::Device& device) {
+  auto pipelines = device.getPipelines();
+  std::ranges::sort(pipelines, {}, &vulkan::Pipeline::getName);
+
+  out << "{\n";
+  out << std::format(
+      "  \"device\": \"{}\",\n",
+      escapeJSON(device.getPhysicalDevice().getProperties().deviceName));
+  out << "  \"pipelines\": [";
+  for (size_t p = 0; p < pipelines.size(); p++) {
+    const auto& pipeline = *pipelines[p];
+    out << (p > 0 ? ",\n" : "\n");
+    out << std::format("    {{\n      \"name\": \"{}\",\n",
+                       escapeJSON(pipeline.getName()));
+    out << "      \"executables\": [";
+
+    const auto& executables = pipeline.getExecutableStatistics();
+    for (size_t e = 0; e < executables.size(); e++) {
+      const auto& executable = executables[e];
+      out << (e > 0 ? ",\n" : "\n");
+      out << std::format(
+          "        {{\n"
+          "          \"name\": \"{}\",\n"
+          "          \"description\": \"{}\",\n"
+          "          \"stages\": {},\n"
+          "          \"subgroupSize\": {},\n"
+          "          \"statistics\": {{",
+          escapeJSON(executable.name),
+          escapeJSON(executable.description),
+          executable.stages,
+          executable.subgroupSize);
+
+      for (size_t s = 0; s < executable.statistics.size(); s++) {
+        const auto& statistic = executable.statistics[s];
+        auto value = std::visit(
+            [](auto v) { return std::format("{}", v); }, statistic.value);
+        out << (s > 0 ? ",\n" : "\n");
+        out << std::format("            \"{}\": {}",
+                           escapeJSON(statistic.name),
+                           value);
+      }
+      out << "\n          }\n        }";
+    }
+    out << "\n      ]\n    }";
+  }
+  out << "\n  ]\n}\n";
+}
+
+}  // namespace recore
+
+void writePipelineStatistics(const std::string& scenePath,
+                             const std::string& outputPath) {
+  using namespace recore;
+  using namespace recore::core;
+
+  ApplicationSettings appSettings = {
+      .vulkan = {
+          .instance = {.enableValidation = false},
+          .device =
+              {
+                  .deviceExtensions =
+                      {
+                          VK_KHR_ACCELERATION_STRUCTURE_EXTENSION_NAME,
+                          VK_KHR_DEFERRED_HOST_OPERATIONS_EXTENSION_NAME,
+                          VK_KHR_RAY_QUERY_EXTENSION_NAME,
+                          VK_KHR_RAY_TRACING_PIPELINE_EXTENSION_NAME,
+                          VK_EXT_SHADER_ATOMIC_FLOAT_EXTENSION_NAME,
+                      },
+                  .features =
+                      {
+                          .features = {.geometryShader = VK_TRUE,
+                                       .shaderInt64 = VK_TRUE},
+                          .features12 =
+                              {
+                                  .descriptorIndexing = VK_TRUE,
+                                  .descriptorBindingPartiallyBound = VK_TRUE,
+                                  .runtimeDescriptorArray = VK_TRUE,
+                                  .scalarBlockLayout = VK_TRUE,
+                                  .bufferDeviceAddress = VK_TRUE,
+                              },
+                          .featureMap =
+                              []() {
+                                vulkan::FeatureMap featureMap;
+                                featureMap.addFeature<
+                                    VkPhysicalDeviceAccelerationStructureFeaturesKHR,
+                                    VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ACCELERATION_STRUCTURE_FEATURES_KHR>(
+                                    &VkPhysicalDeviceAccelerationStructureFeaturesKHR::
+                                        accelerationStructure);
+                                featureMap.addFeature<
+                                    VkPhysicalDeviceRayQueryFeaturesKHR,
+                                    VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_RAY_QUERY_FEATURES_KHR>(
+                                    &VkPhysicalDeviceRayQueryFeaturesKHR::
+                                        rayQuery);
+                                featureMap.addFeature<
+                                    VkPhysicalDeviceRayTracingPipelineFeaturesKHR,
+                                    VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_RAY_TRACING_PIPELINE_FEATURES_KHR>(
+                                    &VkPhysicalDeviceRayTracingPipelineFeaturesKHR::
+                                        rayTracingPipeline);
+
+                                featureMap.addFeatures<
+                                    VkPhysicalDeviceShaderAtomicFloatFeaturesEXT,
+                                    VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_ATOMIC_FLOAT_FEATURES_EXT>(
+                                    {
+                                        &VkPhysicalDeviceShaderAtomicFloatFeaturesEXT::
+                                            shaderBufferFloat32Atomics,
+                                        &VkPhysicalDeviceShaderAtomicFloatFeaturesEXT::
+                                            shaderBufferFloat32AtomicAdd,
+                                    });
+                                return featureMap;
+                              }(),
+                      },
+                  .pipelineStatistics = true,
+              },
+      }};
+
+  auto app = makeUnique<HeadlessApplication>(appSettings);
+  const auto& device = app->getDevice();
+
+  if (!device.isExtensionEnabled(
+          VK_KHR_PIPELINE_EXECUTABLE_PROPERTIES_EXTENSION_NAME)) {
+    throw std::runtime_error(
+        "VK_KHR_pipeline_executable_properties is not supported");
+  }
+  device.setCaptureStatistics(true);
+
+  // Passes need a scene for their descriptor layouts and specializations
+  scene::Scene scene;
+  scene.loadGLTF({.path = scenePath});
+  scene::GPUScene gpuScene{device, scene, true};
+  gpuScene.upload();
+
+  vulkan::ShaderLibrary shaderLibrary{device, RECORE_PROJECT_DIR};
+
+  std::vector<uPtr<passes::Pass>> passes;
+  passes.push_back(makeUnique<passes::GBufferPass>(device, gpuScene));
+  passes.push_back(makeUnique<passes::DiffusePathTracerPass>(device, gpuScene));
+  passes.push_back(
+      makeUnique<passes::DiffusePathTracerRTPass>(device, gpuScene));
+  passes.push_back(makeUnique<passes::GuidedPathTracerPass>(device, gpuScene));
+  passes.push_back(makeUnique<passes::PhotonTracerPass>(device, gpuScene));
+  passes.push_back(
+      makeUnique<passes::PhotonMappingPathTracerPass>(device, gpuScene));
+  passes.push_back(makeUnique<passes::VolumePathTracerPass>(device, gpuScene));
+  passes.push_back(makeUnique<passes::SVGFPass>(device));
+  passes.push_back(makeUnique<passes::TAAPass>(device));
+  passes.push_back(makeUnique<passes::AccumulatorPass>(device, scene));
+  passes.push_back(makeUnique<passes::ToneMappingPass>(device));
+
+  const core::Resolution resolution{.width = 1280, .height = 720};
+  for (auto& pass : passes) {
+    pass->resize(resolution.width, resolution.height).commit();
+    pass->registerShaders(shaderLibrary);
+  }
+  for (auto& pass : passes) {
+    pass->reloadShaders(shaderLibrary);
+  }
+
+  if (outputPath.empty()) {
+    writeJSON(std::cout, device);
+  } else {
+    std::ofstream file{outputPath};
+    if (!file.is_open()) {
+      throw std::runtime_error("Could not write " + outputPath);
+    }
+    writeJSON(file, device);
+    std::cout << std::format("Wrote statistics of {} pipelines to {}",
+                             device.getPipelines().size(),
+                             outputPath)
+              << std::endl;
+  }
+
+  passes.clear();
+  app->terminate();
+}
+
+int main(int argc, char* argv[]) {
+  argparse::ArgumentParser program("pipeline_statistics");
+  program.add_description(
+      "Builds the pipelines of all passes and writes their driver statistics "
+      "(registers, spills, shared memory, ...) as JSON.");
+  program.add_argument("scene").default_value(
+      std::string{"sponza/Sponza.gltf"});
+  program.add_argument("-o", "--output")
+      .help("JSON file, stdout if not given")
+      .default_value(std::string{});
+
+  try {
+    program.parse_args(argc, argv);
+
+    writePipelineStatistics(program.get<std::string>("scene"),
+                            program.get<std::string>("--output"));
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
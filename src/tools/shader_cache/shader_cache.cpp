@@ -0,0 +1,41 @@
+#include <recore/vulkan/shader_library.h>
+
+#include <argparse/argparse.hpp>
+
+#include <chrono>
+#include <format>
+#include <iostream>
+
+int main(int argc, char* argv[]) {
+  argparse::ArgumentParser program("shader_cache");
+  program.add_description(
+      "Compiles all shaders into the SPIR-V cache, so the first launch of a "
+      "sample does not have to run the compiler.");
+  program.add_argument("--root").default_value(
+      std::string{RECORE_PROJECT_DIR});
+  program.add_argument("--cache").default_value(
+      std::string{RECORE_SHADER_CACHE_DIR});
+
+  try {
+    program.parse_args(argc, argv);
+
+    auto root = program.get<std::string>("--root");
+    auto cache = program.get<std::string>("--cache");
+
+    auto start = std::chrono::high_resolution_clock::now();
+    auto compiled = recore::vulkan::ShaderLibrary::warmCache(root, cache);
+    auto end = std::chrono::high_resolution_clock::now();
+
+    std::cout << std::format(
+                     "Cached {} shaders in {} ({:.2f} s)",
+                     compiled,
+                     cache,
+                     std::chrono::duration<double>(end - start).count())
+              << std::endl;
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}